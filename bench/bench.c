@@ -0,0 +1,394 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "bench.h"
+#include "pico/stdlib.h"
+#include "hardware/i2c.h"
+#include "aht20.h"
+#include "bmp280.h"
+#include "sensors.h"
+#include "ssd1306.h"
+#include "font.h"
+#include "np_led.h"
+#include "perf.h"
+#include "tsdb.h"
+
+// Entradas fixas, iguais em toda execução: 16 variações de cada uma, para que
+// o compilador não dobre as contas e os desvios não fiquem sempre iguais
+#define INPUTS 16
+
+// Calibração do exemplo do datasheet do BMP280 (seção 3.12)
+static struct bmp280_calib_param calib = {
+    .dig_t1 = 27504, .dig_t2 = 26435, .dig_t3 = -1000,
+    .dig_p1 = 36477, .dig_p2 = -10685, .dig_p3 = 3024, .dig_p4 = 2855, .dig_p5 = 140,
+    .dig_p6 = -7, .dig_p7 = 15500, .dig_p8 = -14600, .dig_p9 = 6000,
+};
+
+static int32_t raw_temp[INPUTS], raw_press[INPUTS];
+static float pressure_pa[INPUTS];
+static uint8_t aht_frames[INPUTS][6];
+static ssd1306_t oled;
+
+// Série sintética no formato de uma gravação da placa, para o histórico:
+// leituras no instante agendado, a cada 1 s, com a agenda recomeçando depois
+// de uma volta atrasada do laço (1 em 64), de temperatura (°C), pressão (kPa)
+// e umidade (%). Cada grandeza deriva em passeio aleatório e leva um ruído
+// novo a cada leitura; as amplitudes foram escolhidas à mão, perto da
+// resolução de cada sensor, e não vêm de uma gravação real
+#define SERIES_LEN 1024
+#define SERIES_CHANNELS 3
+static uint16_t series_dt[SERIES_LEN];
+static float series_value[SERIES_CHANNELS][SERIES_LEN];
+static uint32_t series_clock_ms;
+
+static const struct
+{
+    float start, drift, noise; // Valor inicial, passo máximo da deriva e ruído máximo por leitura
+} SERIES_SHAPE[SERIES_CHANNELS] = {
+    {24.0f, 0.002f, 0.02f},  // Temperatura do BMP280 (resolução de 0,01 °C)
+    {101.3f, 0.0005f, 0.003f}, // Pressão do BMP280 (~1,3 Pa de ruído)
+    {55.0f, 0.01f, 0.08f},   // Umidade do AHT20 (resolução de 0,024 %)
+};
+
+static volatile int32_t sink_i;
+static volatile float sink_f;
+
+// Valor uniforme em [-1, 1]
+static float unit_noise(uint32_t *rng)
+{
+    *rng = *rng * 1664525u + 1013904223u;
+    return (float)(*rng >> 8) / (float)(1u << 23) - 1.0f;
+}
+
+static void setup_inputs(void)
+{
+    for (uint i = 0; i < INPUTS; i++)
+    {
+        raw_temp[i] = 519888 + (int32_t)i * 997;   // ~25 °C
+        raw_press[i] = 415148 - (int32_t)i * 1531; // ~100 kPa
+        pressure_pa[i] = 95000.0f + i * 500.0f;
+        // Quadro do AHT20: status calibrado, umidade e temperatura de 20 bits
+        uint32_t hum = 0x80000 + i * 4099, temp = 0x60000 + i * 2053;
+        uint8_t *f = aht_frames[i];
+        f[0] = 0x1C;
+        f[1] = (uint8_t)(hum >> 12);
+        f[2] = (uint8_t)(hum >> 4);
+        f[3] = (uint8_t)((hum << 4) | (temp >> 16));
+        f[4] = (uint8_t)(temp >> 8);
+        f[5] = (uint8_t)temp;
+    }
+
+    uint32_t rng = 12345;
+    for (uint i = 0; i < SERIES_LEN; i++)
+    {
+        rng = rng * 1664525u + 1013904223u;
+        series_dt[i] = (uint16_t)((rng >> 26) ? 1000 : 1000 + (rng >> 16) % 250);
+    }
+    for (uint c = 0; c < SERIES_CHANNELS; c++)
+    {
+        float base = SERIES_SHAPE[c].start;
+        for (uint i = 0; i < SERIES_LEN; i++)
+        {
+            base += SERIES_SHAPE[c].drift * unit_noise(&rng);
+            series_value[c][i] = base + SERIES_SHAPE[c].noise * unit_noise(&rng);
+        }
+    }
+}
+
+// --- Kernels: cada um roda iters vezes e deixa o resultado em um volatile ---
+
+static void k_bmp280_convert_temp(uint32_t iters)
+{
+    int32_t acc = 0;
+    for (uint32_t i = 0; i < iters; i++)
+        acc += bmp280_convert_temp(raw_temp[i % INPUTS], &calib);
+    sink_i = acc;
+}
+
+static void k_bmp280_convert_pressure(uint32_t iters)
+{
+    int32_t acc = 0;
+    for (uint32_t i = 0; i < iters; i++)
+        acc += bmp280_convert_pressure(raw_press[i % INPUTS], raw_temp[i % INPUTS], &calib);
+    sink_i = acc;
+}
+
+static void k_calculate_altitude(uint32_t iters)
+{
+    float acc = 0;
+    for (uint32_t i = 0; i < iters; i++)
+        acc += calculate_altitude_func(pressure_pa[i % INPUTS]);
+    sink_f = acc;
+}
+
+static void k_aht20_convert(uint32_t iters)
+{
+    float acc = 0;
+    for (uint32_t i = 0; i < iters; i++)
+    {
+        AHT20_Data data;
+        aht20_convert(aht_frames[i % INPUTS], &data);
+        acc += data.temperature + data.humidity;
+    }
+    sink_f = acc;
+}
+
+// Um registro de canal de /sensordata, com o mesmo formato do main.c
+static void k_json_channel(uint32_t iters)
+{
+    static const char *const KINDS[4] = {"temp", "pressure", "altitude", "humidity"};
+    char buf[160];
+    int32_t acc = 0;
+    for (uint32_t i = 0; i < iters; i++)
+    {
+        uint k = i % 4;
+        acc += snprintf(buf, sizeof(buf),
+                        "%s{\"id\":%u,\"kind\":\"%s\",\"sensor\":\"%s\",\"value\":%.2f,\"valid\":%s,\"alarm\":%s}",
+                        k ? "," : "", k, KINDS[k], "bmp280@76", pressure_pa[i % INPUTS] / 1000.0f, "true",
+                        "false");
+    }
+    sink_i = acc;
+}
+
+// Uma linha inteira de texto da tela principal (16 caracteres)
+static void k_ssd1306_draw_string(uint32_t iters)
+{
+    static const char *const LINES[4] = {"T 25.31C  60.2%", "P 101.32 kPa", "Alt 152.4 m", "IP 192.168.0.42"};
+    for (uint32_t i = 0; i < iters; i++)
+        ssd1306_draw_string(&oled, LINES[i % 4], 0, (uint8_t)(8 * (i % 8)));
+    sink_i = oled.ram_buffer[1];
+}
+
+// Tela de status do OLED redesenhada inteira, como render_status em
+// lib/oled_screens.c: apaga o quadro e escreve cinco linhas fora do alinhamento
+// das páginas. A versão por pixel refaz o mesmo quadro com o fill e o
+// draw_char antigos (um ssd1306_pixel por pixel), como referência.
+static void status_line(char *buf, size_t size, uint line, uint i)
+{
+    float p = pressure_pa[i % INPUTS];
+    switch (line)
+    {
+    case 0:
+        snprintf(buf, size, "192.168.0.42");
+        break;
+    case 1:
+        snprintf(buf, size, "T:%.1fC", 20.0f + (i % INPUTS) * 0.37f);
+        break;
+    case 2:
+        snprintf(buf, size, "P:%.1fkPa", p / 1000.0f);
+        break;
+    case 3:
+        snprintf(buf, size, "U:%.1f%%", 40.0f + (i % INPUTS) * 1.3f);
+        break;
+    default:
+        snprintf(buf, size, "Alt:%.0fm", calculate_altitude_func(p));
+        break;
+    }
+}
+
+static void k_oled_status_redraw(uint32_t iters)
+{
+    char buf[20];
+    for (uint32_t i = 0; i < iters; i++)
+    {
+        ssd1306_fill(&oled, false);
+        for (uint line = 0; line < 5; line++)
+        {
+            status_line(buf, sizeof(buf), line, i);
+            ssd1306_draw_string(&oled, buf, 0, (uint8_t)(5 + 10 * line));
+        }
+    }
+    sink_i = oled.ram_buffer[1];
+}
+
+static void draw_string_pixels(const char *str, uint8_t x, uint8_t y)
+{
+    for (; *str && x + 8 < oled.width; str++, x += 8)
+    {
+        const uint8_t *columns = &font[(*str >= ' ' && *str <= '~' ? *str - ' ' : 0) * 8];
+        for (uint8_t i = 0; i < 8; ++i)
+            for (uint8_t j = 0; j < 8; ++j)
+                ssd1306_pixel(&oled, x + i, y + j, columns[i] & (1 << j));
+    }
+}
+
+static void k_oled_status_redraw_pixel(uint32_t iters)
+{
+    char buf[20];
+    for (uint32_t i = 0; i < iters; i++)
+    {
+        for (uint8_t y = 0; y < oled.height; ++y)
+            for (uint8_t x = 0; x < oled.width; ++x)
+                ssd1306_pixel(&oled, x, y, false);
+        for (uint line = 0; line < 5; line++)
+        {
+            status_line(buf, sizeof(buf), line, i);
+            draw_string_pixels(buf, 0, (uint8_t)(5 + 10 * line));
+        }
+    }
+    sink_i = oled.ram_buffer[1];
+}
+
+// Caminho da matriz: desenho do glifo, gama e brilho no empacotamento e
+// agendamento do quadro (os quadros seguidos ao primeiro são agrupados)
+static void k_matrix_glyph(uint32_t iters)
+{
+    static const np_glyph_t GLYPHS[4] = {NP_GLYPH_T, NP_GLYPH_P, NP_GLYPH_A, NP_GLYPH_SMILE};
+    static const np_color_t COLORS[4] = {NP_RED, NP_ORANGE, NP_WHITE, NP_GREEN};
+    for (uint32_t i = 0; i < iters; i++)
+        npShowGlyph(GLYPHS[i % 4], COLORS[i % 4], NP_ANIM_STATIC);
+    sink_i = leds[0].R;
+}
+
+// Histórico: anexa a série dos três canais ao tsdb, que descarta os blocos mais
+// antigos quando a memória enche, como no uso contínuo. Cada iteração é uma
+// amostra de um canal.
+static void setup_tsdb_append(void)
+{
+    tsdb_init();
+    series_clock_ms = 0;
+}
+
+static void k_tsdb_append(uint32_t iters)
+{
+    static uint32_t i;
+    for (uint32_t n = 0; n < iters; n++, i++)
+    {
+        uint c = i % SERIES_CHANNELS, r = (i / SERIES_CHANNELS) % SERIES_LEN;
+        if (c == 0)
+            series_clock_ms += series_dt[r];
+        tsdb_append((uint8_t)c, series_clock_ms, series_value[c][r]);
+    }
+}
+
+// Bytes por amostra no estado em que o append deixou o histórico: só os bits
+// codificados e a RAM dos blocos em uso, com o cabeçalho (um float e um
+// timestamp sem compressão seriam 8)
+static void report_tsdb(FILE *out)
+{
+    tsdb_stats_t st;
+    tsdb_get_stats(&st);
+    if (st.samples == 0)
+        return;
+    fprintf(out, ",\"bytes_per_sample\":%.3f,\"ram_bytes_per_sample\":%.3f", (double)st.bytes_used / st.samples,
+            (double)st.blocks_used * sizeof(tsdb_block_t) / st.samples);
+}
+
+// Leitura em streaming, canal por canal, de um histórico com a série inteira
+// uma vez, gravado antes da medição
+static void setup_tsdb_decode(void)
+{
+    tsdb_init();
+    uint32_t ts = 0;
+    for (uint r = 0; r < SERIES_LEN; r++)
+    {
+        ts += series_dt[r];
+        for (uint c = 0; c < SERIES_CHANNELS; c++)
+            tsdb_append((uint8_t)c, ts, series_value[c][r]);
+    }
+}
+
+static void k_tsdb_decode(uint32_t iters)
+{
+    static tsdb_iter_t it;
+    static uint8_t channel = SERIES_CHANNELS - 1;
+    static bool open = false;
+    uint32_t ts = 0, acc = 0;
+    float value;
+    for (uint32_t i = 0; i < iters; i++)
+    {
+        if (!open || !tsdb_iter_next(&it, &ts, &value))
+        {
+            channel = (uint8_t)((channel + 1) % SERIES_CHANNELS);
+            tsdb_iter_init(&it, channel, 0);
+            open = tsdb_iter_next(&it, &ts, &value);
+        }
+        acc += ts;
+    }
+    sink_i = (int32_t)acc;
+}
+
+typedef struct
+{
+    const char *name;
+    void (*run)(uint32_t iters);
+    void (*report)(FILE *out); // Campos extras da linha do kernel (opcional)
+    void (*setup)(void);       // Prepara a entrada antes da medição (opcional)
+} kernel_t;
+
+static const kernel_t KERNELS[] = {
+    {"bmp280_convert_temp", k_bmp280_convert_temp, NULL, NULL},
+    {"bmp280_convert_pressure", k_bmp280_convert_pressure, NULL, NULL},
+    {"calculate_altitude_func", k_calculate_altitude, NULL, NULL},
+    {"aht20_convert", k_aht20_convert, NULL, NULL},
+    {"json_channel_snprintf", k_json_channel, NULL, NULL},
+    {"ssd1306_draw_string", k_ssd1306_draw_string, NULL, NULL},
+    {"oled_status_redraw", k_oled_status_redraw, NULL, NULL},
+    {"oled_status_redraw_pixel", k_oled_status_redraw_pixel, NULL, NULL},
+    {"matrix_show_glyph", k_matrix_glyph, NULL, NULL},
+    {"tsdb_append", k_tsdb_append, report_tsdb, setup_tsdb_append},
+    {"tsdb_decode", k_tsdb_decode, NULL, setup_tsdb_decode},
+};
+
+// --- Medição ---
+
+#define WARMUP_SAMPLES 3
+#define MAX_SAMPLES 101
+
+static uint64_t time_batch(const kernel_t *k, uint32_t iters)
+{
+    uint64_t start = bench_now_ns();
+    k->run(iters);
+    return bench_now_ns() - start;
+}
+
+static int compare_u64(const void *a, const void *b)
+{
+    uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+    return (x > y) - (x < y);
+}
+
+static void measure(const bench_config_t *config, const kernel_t *k, FILE *out)
+{
+    if (k->setup)
+        k->setup();
+    // Dobra as iterações até uma amostra durar min_sample_ns; isso também aquece caches e preditores
+    uint32_t iters = 1;
+    while (iters < (1u << 30) && time_batch(k, iters) < config->min_sample_ns)
+        iters *= 2;
+    for (uint i = 0; i < WARMUP_SAMPLES; i++)
+        time_batch(k, iters);
+
+    uint64_t samples[MAX_SAMPLES];
+    uint32_t n = config->samples < 1 ? 1 : config->samples < MAX_SAMPLES ? config->samples : MAX_SAMPLES;
+    for (uint i = 0; i < n; i++)
+        samples[i] = time_batch(k, iters);
+    qsort(samples, n, sizeof(samples[0]), compare_u64);
+    uint64_t median = n % 2 ? samples[n / 2] : (samples[n / 2 - 1] + samples[n / 2]) / 2;
+
+    fprintf(out, "{\"kernel\":\"%s\",\"iters\":%lu,\"samples\":%lu,\"median_ns\":%.1f,\"min_ns\":%.1f", k->name,
+            (unsigned long)iters, (unsigned long)n, (double)median / iters, (double)samples[0] / iters);
+    if (k->report)
+        k->report(out);
+    fprintf(out, "}\n");
+}
+
+// Mesmos pinos e endereço da placa (main.c); o OLED só é desenhado na RAM
+#define MATRIX_LED_PIN 7
+#define DISP_ADDR 0x3C
+
+unsigned bench_run_all(const bench_config_t *config, FILE *out)
+{
+    setup_inputs();
+    ssd1306_init(&oled, WIDTH, HEIGHT, false, DISP_ADDR, i2c1);
+    npInit(MATRIX_LED_PIN);
+
+    fprintf(out, "{\"bench\":\"monitor\",\"platform\":\"%s\",\"compiler\":\"%s\",\"perf\":%d}\n", config->platform,
+            __VERSION__, PERF_ENABLED);
+    for (uint i = 0; i < count_of(KERNELS); i++)
+        measure(config, &KERNELS[i], out);
+    fflush(out);
+    npClear();
+    npWrite();
+    return count_of(KERNELS);
+}
@@ -0,0 +1,25 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+// Microbenchmarks dos kernels de cada amostra. bench.c tem os kernels e a
+// estatística; bench_host.c e bench_pico.c dão o relógio e o main() de cada
+// plataforma.
+
+// Relógio monotônico em ns (na placa, com resolução de 1 us)
+uint64_t bench_now_ns(void);
+
+typedef struct
+{
+    const char *platform;
+    uint32_t samples;        // Amostras medidas por kernel, depois do aquecimento
+    uint64_t min_sample_ns;  // Duração mínima de uma amostra; define as iterações por amostra
+} bench_config_t;
+
+// Roda todos os kernels e escreve uma linha JSON por kernel, mais o cabeçalho.
+// Retorna o número de kernels.
+unsigned bench_run_all(const bench_config_t *config, FILE *out);
+
+#endif // BENCH_H
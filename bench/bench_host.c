@@ -0,0 +1,31 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdlib.h>
+#include <time.h>
+
+#include "bench.h"
+#include "sim.h"
+
+// Benchmark no host: os kernels rodam sobre a placa simulada (só o relógio de
+// medição é o do host).
+//   monitor_bench [amostras] [ms_por_amostra] > resultado.jsonl
+
+uint64_t bench_now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+int main(int argc, char **argv)
+{
+    bench_config_t config = {
+        .platform = "host",
+        .samples = argc > 1 ? (uint32_t)atoi(argv[1]) : 31,
+        .min_sample_ns = (uint64_t)((argc > 2 ? atof(argv[2]) : 2.0) * 1e6),
+    };
+    sim_time_init();
+    sim_opts.speed = 0;
+    bench_run_all(&config, stdout);
+    return 0;
+}
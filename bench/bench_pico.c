@@ -0,0 +1,33 @@
+#include "bench.h"
+#include "pico/stdlib.h"
+#include "pico/stdio_usb.h"
+
+// Benchmark na placa: espera o terminal USB, roda os kernels e imprime o
+// resultado; qualquer tecla repete a rodada.
+
+#define BENCH_SAMPLES 31
+#define BENCH_SAMPLE_MS 10 // time_us_64 tem resolução de 1 us: 0,01 % por amostra
+
+uint64_t bench_now_ns(void)
+{
+    return time_us_64() * 1000u;
+}
+
+int main(void)
+{
+    stdio_init_all();
+    const bench_config_t config = {
+        .platform = "rp2040",
+        .samples = BENCH_SAMPLES,
+        .min_sample_ns = (uint64_t)BENCH_SAMPLE_MS * 1000000u,
+    };
+    while (true)
+    {
+        while (!stdio_usb_connected())
+            sleep_ms(100);
+        sleep_ms(500); // Dá tempo ao terminal de abrir a porta
+        bench_run_all(&config, stdout);
+        printf("# tecla para repetir\n");
+        getchar();
+    }
+}
@@ -0,0 +1,102 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdlib.h>
+#include <time.h>
+
+#include "sim.h"
+#include "flash_io.h"
+#include "sample_log.h"
+#include "tsdb.h"
+
+// Log de amostras (lib/sample_log.c) sobre a flash simulada: dias de leituras
+// de 1 s de cinco canais, como na placa, com os blocos fechados pelo tsdb e o
+// fechamento por idade do laço principal. Mede a amplificação de escrita (bytes
+// programados na flash por byte comprimido útil e por amostra), o desgaste por
+// segmento, quantas amostras por segundo a flash da placa sustenta (pelos
+// tempos de apagamento e programação do modelo) e quanto custa a recuperação
+// no boot. Só no host: na placa, o log de verdade seria apagado.
+//
+//   sample_log_bench [dias] > resultado.jsonl
+
+#define CHANNELS 5
+#define INTERVAL_MS 1000
+#define MAX_BLOCK_AGE_MS (5 * 60 * 1000) // SAMPLE_LOG_MAX_BLOCK_AGE_MS do main.c
+#define ERASE_CYCLES 100000              // Ciclos garantidos por setor da W25Q16
+
+// Passo e ruído de cada canal, na resolução do sensor: temperatura e pressão
+// do BMP280, altitude, temperatura e umidade do AHT20
+static const float STEP[CHANNELS] = {0.01f, 0.01f, 0.1f, 0.01f, 0.05f};
+static const float START[CHANNELS] = {24.0f, 101.3f, 2.0f, 24.1f, 55.0f};
+
+static double host_s(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+int main(int argc, char **argv)
+{
+    double days = argc > 1 ? atof(argv[1]) : 7.0;
+    sim_time_init();
+    sim_opts.speed = 0;
+    if (!sim_flash_init(NULL))
+        return 2;
+
+    tsdb_init();
+    uint32_t last_ts;
+    sample_log_init(&last_ts);
+
+    float value[CHANNELS];
+    for (uint c = 0; c < CHANNELS; c++)
+        value[c] = START[c];
+    uint32_t rng = 12345;
+    uint64_t samples = 0;
+    uint32_t seconds = (uint32_t)(days * 86400);
+
+    uint64_t flash_start_us = sim_now_us();
+    double start = host_s();
+    for (uint32_t s = 1; s <= seconds; s++)
+    {
+        uint32_t now_ms = s * INTERVAL_MS;
+        for (uint c = 0; c < CHANNELS; c++)
+        {
+            rng = rng * 1664525u + 1013904223u;
+            value[c] += (float)((int)((rng >> 20) % 7) - 3) * STEP[c];
+            tsdb_append((uint8_t)c, now_ms, value[c]);
+            samples++;
+        }
+        tsdb_seal_older_than(now_ms - MAX_BLOCK_AGE_MS);
+    }
+    double host_elapsed = host_s() - start;
+    // Sem esperas nem periféricos, o relógio virtual só anda com a flash ocupada
+    double flash_busy_s = (sim_now_us() - flash_start_us) / 1e6;
+
+    sample_log_stats_t st;
+    sample_log_get_stats(&st);
+    sim_flash_stats_t fl;
+    sim_flash_get_stats(&fl);
+    double programmed = (double)fl.pages * FLASH_PAGE_SIZE;
+    uint segments = FLASH_SAMPLE_LOG_SIZE / SAMPLE_LOG_SEGMENT_SIZE;
+    double erases_per_segment_day = (double)fl.erases / segments / days;
+
+    // Boot: varredura limitada e recarga do histórico em RAM
+    tsdb_init();
+    double boot_start = host_s();
+    sample_log_init(&last_ts);
+    double boot_ms = (host_s() - boot_start) * 1e3;
+    sample_log_stats_t after;
+    sample_log_get_stats(&after);
+
+    printf("{\"bench\":\"sample_log\",\"days\":%.1f,\"channels\":%u,\"samples\":%llu,\"pages\":%lu,\"erases\":%lu,"
+           "\"write_amplification\":%.3f,\"flash_bytes_per_sample\":%.3f,\"erases_per_segment_day\":%.2f,"
+           "\"wear_years\":%.0f,\"device_samples_per_s\":%.0f,\"host_samples_per_s\":%.0f,"
+           "\"boot_scanned_pages\":%lu,\"boot_restored_pages\":%lu,\"boot_host_ms\":%.2f}\n",
+           days, CHANNELS, (unsigned long long)samples, (unsigned long)fl.pages, (unsigned long)fl.erases,
+           st.payload_bytes ? programmed / st.payload_bytes : 0.0, programmed / (double)samples,
+           erases_per_segment_day, erases_per_segment_day > 0 ? ERASE_CYCLES / erases_per_segment_day / 365 : 0.0,
+           flash_busy_s > 0 ? st.samples_logged / flash_busy_s : 0.0, samples / host_elapsed,
+           (unsigned long)(after.scanned_pages - st.scanned_pages),
+           (unsigned long)(after.restored_pages - st.restored_pages), boot_ms);
+    return st.write_errors ? 1 : 0;
+}
@@ -10,31 +10,54 @@
 #define AHT20_STATUS_BUSY   0x80  // Bit de status ocupado
 #define AHT20_STATUS_CALIBRATED 0x08  // Bit de calibração
 
+// Espera apenas o que falta do tempo de estabilização após a energização
+void aht20_wait_power_on(void) {
+    sleep_until(from_us_since_boot(AHT20_POWER_ON_MS * 1000));
+}
+
 bool aht20_init(i2c_inst_t *i2c) {
+    aht20_wait_power_on();
+
+    // Já calibrado (o normal depois da energização): nada a enviar
+    uint8_t status;
+    if (i2c_read_blocking(i2c, AHT20_I2C_ADDR, &status, 1, false) == 1 &&
+        (status & AHT20_STATUS_CALIBRATED) == AHT20_STATUS_CALIBRATED) {
+        return true;
+    }
+
     uint8_t init_cmd[3] = {AHT20_CMD_INIT, 0x08, 0x00};
     i2c_write_blocking(i2c, AHT20_I2C_ADDR, init_cmd, 3, false);
-    sleep_ms(50);  // Aguarda o sensor inicializar
 
-    // Verifica status até que o sensor esteja pronto
-    uint8_t status;
+    // Verifica status até que o sensor esteja pronto (o datasheet pede 10 ms)
     for (int i = 0; i < 10; i++) {
+        sleep_ms(10);
         i2c_read_blocking(i2c, AHT20_I2C_ADDR, &status, 1, false);
         if ((status & AHT20_STATUS_CALIBRATED) == AHT20_STATUS_CALIBRATED) {
             return true;  // Sensor calibrado e pronto
         }
-        sleep_ms(10);
     }
 
     return false;  // Falhou na calibração
 }
 
-bool aht20_read(i2c_inst_t *i2c, AHT20_Data *data) {
+// Dispara uma medição sem aguardar o resultado
+bool aht20_trigger(i2c_inst_t *i2c) {
     uint8_t trigger_cmd[3] = {AHT20_CMD_TRIGGER, 0x33, 0x00};
-    uint8_t buffer[6];
+    return i2c_write_blocking(i2c, AHT20_I2C_ADDR, trigger_cmd, 3, false) == 3;
+}
 
-    // Envia comando de medição
-    i2c_write_blocking(i2c, AHT20_I2C_ADDR, trigger_cmd, 3, false);
-    
+void aht20_convert(const uint8_t frame[6], AHT20_Data *data) {
+    // Processa os dados de umidade (20 bits)
+    uint32_t raw_humidity = ((uint32_t)frame[1] << 12) | ((uint32_t)frame[2] << 4) | (frame[3] >> 4);
+    data->humidity = (float)raw_humidity * 100.0 / 1048576.0;
+
+    // Processa os dados de temperatura (20 bits)
+    uint32_t raw_temp = ((uint32_t)(frame[3] & 0x0F) << 16) | ((uint32_t)frame[4] << 8) | frame[5];
+    data->temperature = ((float)raw_temp * 200.0 / 1048576.0) - 50.0;
+}
+
+// Aguarda o fim da medição disparada por aht20_trigger e lê o quadro bruto
+bool aht20_fetch_frame(i2c_inst_t *i2c, uint8_t frame[6]) {
     // Aguarda até o sensor estar pronto
     uint8_t status;
     for (int i = 0; i < 10; i++) {
@@ -51,21 +74,27 @@ bool aht20_read(i2c_inst_t *i2c, AHT20_Data *data) {
     }
 
     // Lê os 6 bytes de dados
-    if (i2c_read_blocking(i2c, AHT20_I2C_ADDR, buffer, 6, false) != 6) {
+    return i2c_read_blocking(i2c, AHT20_I2C_ADDR, frame, 6, false) == 6;
+}
+
+// Aguarda o fim da medição disparada por aht20_trigger e converte o resultado
+bool aht20_fetch(i2c_inst_t *i2c, AHT20_Data *data) {
+    uint8_t frame[6];
+    if (!aht20_fetch_frame(i2c, frame)) {
         return false;
     }
-
-    // Processa os dados de umidade (20 bits)
-    uint32_t raw_humidity = ((uint32_t)buffer[1] << 12) | ((uint32_t)buffer[2] << 4) | (buffer[3] >> 4);
-    data->humidity = (float)raw_humidity * 100.0 / 1048576.0;
-
-    // Processa os dados de temperatura (20 bits)
-    uint32_t raw_temp = ((uint32_t)(buffer[3] & 0x0F) << 16) | ((uint32_t)buffer[4] << 8) | buffer[5];
-    data->temperature = ((float)raw_temp * 200.0 / 1048576.0) - 50.0;
-
+    aht20_convert(frame, data);
     return true;
 }
 
+bool aht20_read(i2c_inst_t *i2c, AHT20_Data *data) {
+    // Envia comando de medição
+    if (!aht20_trigger(i2c)) {
+        return false;
+    }
+    return aht20_fetch(i2c, data);
+}
+
 void aht20_reset(i2c_inst_t *i2c) {
     uint8_t reset_cmd = AHT20_CMD_RESET;
     i2c_write_blocking(i2c, AHT20_I2C_ADDR, &reset_cmd, 1, false);
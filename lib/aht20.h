@@ -16,13 +16,31 @@ typedef struct {
     float humidity;
 } AHT20_Data;
 
-// Inicializa o sensor AHT20
+// Tempo após a energização antes do primeiro comando (datasheet)
+#define AHT20_POWER_ON_MS 40
+
+// Bloqueia só até completar AHT20_POWER_ON_MS desde o boot
+void aht20_wait_power_on(void);
+
+// Inicializa o sensor AHT20; se ele já estiver calibrado, só lê o status
 bool aht20_init(i2c_inst_t *i2c);
 
 // Faz a leitura de temperatura e umidade do AHT20
 bool aht20_read(i2c_inst_t *i2c, AHT20_Data *data);
 
-// Reseta o sensor AHT20
+// Leitura em duas etapas: dispara a medição e busca o resultado depois,
+// permitindo intercalar outras transações no barramento durante a conversão
+bool aht20_trigger(i2c_inst_t *i2c);
+bool aht20_fetch(i2c_inst_t *i2c, AHT20_Data *data);
+// Igual a aht20_fetch, mas devolve o quadro bruto de 6 bytes (veja aht20_convert)
+bool aht20_fetch_frame(i2c_inst_t *i2c, uint8_t frame[6]);
+
+// Converte o quadro de 6 bytes lido do sensor (status, 20 bits de umidade,
+// 20 bits de temperatura); não acessa o barramento
+void aht20_convert(const uint8_t frame[6], AHT20_Data *data);
+
+// Reseta o sensor AHT20 (reset por software e nova inicialização); usado
+// só para recuperar um sensor que parou de responder
 void aht20_reset(i2c_inst_t *i2c);
 
 bool aht20_check(i2c_inst_t *i2c);
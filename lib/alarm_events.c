@@ -0,0 +1,209 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "pico/cyw43_arch.h"
+#include "lwip/udp.h"
+
+#include "alarm_events.h"
+
+// Datagrama de evento (texto JSON, uma linha) e confirmação do coletor:
+//   -> {"boot":..,"seq":12,"ts":..,"event":"raise","type":"range","rule":0,"ch":0,...}
+//   <- ACK 12
+#define ALARM_EVENTS_DATAGRAM_MAX 256
+
+static alarm_event_t events[ALARM_EVENTS_CAPACITY];
+static uint32_t last_seq = 0;
+static uint32_t boot = 0;
+static alarm_events_stats_t stats;
+
+static struct udp_pcb *pcb = NULL;
+static ip_addr_t collector_addr;
+static uint16_t collector_port = 0;
+
+static alarm_event_t *slot_of(uint32_t seq)
+{
+    return &events[seq % ALARM_EVENTS_CAPACITY];
+}
+
+// Confirmações chegam no contexto do lwIP: só marcam o evento, se ele ainda
+// estiver no registro. Uma confirmação depois da desistência ainda conta como
+// entrega. O laço principal mexe nos mesmos eventos e contadores dentro de
+// cyw43_arch_lwip_begin/end.
+static void on_ack(void *arg, struct udp_pcb *upcb, struct pbuf *p, const ip_addr_t *addr, u16_t port)
+{
+    char buf[24];
+    uint16_t len = pbuf_copy_partial(p, buf, sizeof(buf) - 1, 0);
+    buf[len] = '\0';
+    pbuf_free(p);
+
+    if (strncmp(buf, "ACK ", 4) != 0)
+        return;
+    uint32_t seq = strtoul(buf + 4, NULL, 10);
+    alarm_event_t *e = slot_of(seq);
+    if (seq != 0 && e->seq == seq && !e->acked)
+    {
+        e->acked = true;
+        stats.acked++;
+        if (e->given_up)
+            stats.dropped--;
+    }
+}
+
+bool alarm_events_init(uint32_t boot_id)
+{
+    boot = boot_id;
+    memset(events, 0, sizeof(events));
+
+    cyw43_arch_lwip_begin();
+    pcb = udp_new();
+    if (pcb)
+    {
+        // Porta local efêmera: o coletor responde para a origem do datagrama
+        udp_bind(pcb, IP_ADDR_ANY, 0);
+        udp_recv(pcb, on_ack, NULL);
+    }
+    cyw43_arch_lwip_end();
+    return pcb != NULL;
+}
+
+void alarm_events_set_collector(uint32_t ip, uint16_t port)
+{
+    IP_ADDR4(&collector_addr, (ip >> 24) & 0xFF, (ip >> 16) & 0xFF, (ip >> 8) & 0xFF, ip & 0xFF);
+    collector_port = port;
+}
+
+static int format_event(char *buf, size_t size, const alarm_event_t *e)
+{
+    const alarm_rule_t *rule = alarms_rule(e->rule);
+    const sensor_channel_t *ch = sensors_channel(e->channel);
+    return snprintf(buf, size,
+                    "{\"boot\":%lu,\"seq\":%lu,\"ts\":%lu,\"event\":\"%s\",\"type\":\"%s\",\"rule\":%u,"
+                    "\"ch\":%u,\"kind\":\"%s\",\"sensor\":\"%s\",\"value\":%.2f,\"threshold\":%.2f}",
+                    (unsigned long)boot, (unsigned long)e->seq, (unsigned long)e->ts,
+                    e->raised ? "raise" : "clear", rule->type == ALARM_RULE_RATE ? "rate" : "range", e->rule,
+                    e->channel, sensors_kind_name(ch->kind), sensors_instance(ch->instance)->label,
+                    e->value, e->threshold);
+}
+
+static bool send_event(const alarm_event_t *e)
+{
+    char buf[ALARM_EVENTS_DATAGRAM_MAX];
+    int len = format_event(buf, sizeof(buf), e);
+    if (len < 0 || len >= (int)sizeof(buf))
+        return false;
+
+    err_t err = ERR_MEM;
+    cyw43_arch_lwip_begin();
+    struct pbuf *p = pbuf_alloc(PBUF_TRANSPORT, (u16_t)len, PBUF_RAM);
+    if (p)
+    {
+        memcpy(p->payload, buf, len);
+        err = udp_sendto(pcb, p, &collector_addr, collector_port);
+        pbuf_free(p);
+    }
+    cyw43_arch_lwip_end();
+    return err == ERR_OK;
+}
+
+// Envia um evento devido e agenda a próxima tentativa
+static void try_send(alarm_event_t *e, uint32_t now_ms)
+{
+    if (e->attempts > 0)
+        stats.retries++;
+    e->attempts++;
+    if (send_event(e))
+        stats.sent++;
+    else
+        stats.send_errors++;
+
+    uint32_t backoff = ALARM_EVENTS_RETRY_MIN_MS << (e->attempts - 1);
+    if (e->attempts > 8 || backoff > ALARM_EVENTS_RETRY_MAX_MS)
+        backoff = ALARM_EVENTS_RETRY_MAX_MS;
+    e->next_try_ms = now_ms + backoff;
+}
+
+void alarm_events_record(uint32_t ts, alarm_mask_t before, alarm_mask_t after)
+{
+    alarm_mask_t changed = before ^ after;
+    cyw43_arch_lwip_begin();
+    for (uint i = 0; changed; i++, changed >>= 1)
+    {
+        if (!(changed & 1))
+            continue;
+
+        const alarm_rule_t *rule = alarms_rule(i);
+        uint32_t seq = ++last_seq;
+        alarm_event_t *e = slot_of(seq);
+
+        // Evento sobrescrito antes de ser confirmado
+        if (e->seq != 0 && !e->acked && !e->given_up && collector_port)
+            stats.dropped++;
+
+        *e = (alarm_event_t){
+            .seq = seq,
+            .ts = ts,
+            .rule = (uint8_t)i,
+            .channel = rule->channel,
+            .raised = (after >> i) & 1,
+            .value = rule->event_value,
+            .threshold = rule->event_threshold,
+        };
+        stats.recorded++;
+
+        // Envio imediato: a latência até o coletor é a do próprio laço
+        if (pcb && collector_port)
+            try_send(e, ts);
+    }
+    cyw43_arch_lwip_end();
+}
+
+void alarm_events_task(uint32_t now_ms)
+{
+    if (!pcb || !collector_port)
+        return;
+
+    cyw43_arch_lwip_begin();
+    uint count = alarm_events_count();
+    for (uint i = 0; i < count; i++)
+    {
+        alarm_event_t *e = slot_of(last_seq - count + 1 + i);
+        if (e->acked || e->given_up)
+            continue;
+        if (e->attempts > 0 && (int32_t)(now_ms - e->next_try_ms) < 0)
+            continue;
+
+        // A última tentativa também tem o seu prazo para a confirmação chegar
+        if (e->attempts >= ALARM_EVENTS_MAX_ATTEMPTS)
+        {
+            e->given_up = true;
+            stats.dropped++;
+            continue;
+        }
+        try_send(e, now_ms);
+    }
+    cyw43_arch_lwip_end();
+}
+
+uint alarm_events_count(void)
+{
+    return last_seq < ALARM_EVENTS_CAPACITY ? last_seq : ALARM_EVENTS_CAPACITY;
+}
+
+const alarm_event_t *alarm_events_get(uint index)
+{
+    uint count = alarm_events_count();
+    return index < count ? slot_of(last_seq - count + 1 + index) : NULL;
+}
+
+uint32_t alarm_events_last_seq(void)
+{
+    return last_seq;
+}
+
+void alarm_events_get_stats(alarm_events_stats_t *out)
+{
+    cyw43_arch_lwip_begin();
+    *out = stats;
+    cyw43_arch_lwip_end();
+}
@@ -0,0 +1,63 @@
+#ifndef ALARM_EVENTS_H
+#define ALARM_EVENTS_H
+
+#include "pico/stdlib.h"
+#include "alarms.h"
+
+// Eventos mantidos no registro; os mais antigos são sobrescritos
+#define ALARM_EVENTS_CAPACITY 64
+
+// Reenvio sem confirmação: o intervalo dobra a cada tentativa, até o máximo
+#define ALARM_EVENTS_RETRY_MIN_MS 250
+#define ALARM_EVENTS_RETRY_MAX_MS 30000
+#define ALARM_EVENTS_MAX_ATTEMPTS 10
+
+typedef struct
+{
+    uint32_t seq;       // Crescente no boot; o coletor descarta duplicados por (boot_id, seq)
+    uint32_t ts;        // Tempo do dispositivo
+    uint8_t rule;
+    uint8_t channel;
+    bool raised;        // true ao disparar, false ao limpar
+    float value;
+    float threshold;
+
+    // Estado de envio
+    uint8_t attempts;
+    bool acked;
+    bool given_up;      // Prazo da última tentativa vencido sem confirmação
+    uint32_t next_try_ms;
+} alarm_event_t;
+
+typedef struct
+{
+    uint32_t recorded;
+    uint32_t sent;      // Datagramas enviados, incluindo reenvios
+    uint32_t retries;
+    uint32_t acked;
+    uint32_t dropped;   // Sem confirmação depois de ALARM_EVENTS_MAX_ATTEMPTS, ou sobrescritos antes
+    uint32_t send_errors;
+} alarm_events_stats_t;
+
+// Abre o socket UDP local que recebe as confirmações do coletor. boot_id
+// distingue as sequências de boots diferentes (o seq recomeça em 1 a cada boot);
+// o main.c usa um número aleatório, porque o tempo do boot se repete entre boots.
+bool alarm_events_init(uint32_t boot_id);
+
+// Porta 0 desativa o envio; eventos continuam sendo registrados
+void alarm_events_set_collector(uint32_t ip, uint16_t port);
+
+// Registra as transições entre duas máscaras de alarmes e envia cada uma na hora
+void alarm_events_record(uint32_t ts, alarm_mask_t before, alarm_mask_t after);
+
+// Reenvia eventos ainda sem confirmação cujo prazo venceu
+void alarm_events_task(uint32_t now_ms);
+
+// Acesso ao registro, do evento mais antigo (índice 0) para o mais novo
+uint alarm_events_count(void);
+const alarm_event_t *alarm_events_get(uint index);
+uint32_t alarm_events_last_seq(void);
+
+void alarm_events_get_stats(alarm_events_stats_t *stats);
+
+#endif // ALARM_EVENTS_H
@@ -0,0 +1,67 @@
+#include "alarm_rules.h"
+
+// Regras de alarme por grandeza: histerese para limpar, amostras consecutivas
+// para mudar de estado e variação máxima por minuto (0 desativa a regra de taxa).
+// O debounce vale para as regras de faixa. A de taxa decide uma vez por janela
+// de ALARMS_RATE_WINDOW_MS, cuja média já filtra o ruído, e muda de estado na
+// primeira decisão: dispara até ~2 janelas depois do início da variação (com
+// debounce 3 seriam ~4 min).
+#define RATE_DEBOUNCE 1
+static const struct
+{
+    float hysteresis;
+    uint8_t debounce;
+    float max_rate_per_min;
+    float rate_hysteresis;
+} ALARM_CONFIG[CHANNEL_KIND_COUNT] = {
+    [CHANNEL_TEMPERATURE] = {0.5f, 3, 2.0f, 0.5f},
+    [CHANNEL_PRESSURE] = {0.2f, 3, 0.0f, 0.0f},
+    [CHANNEL_ALTITUDE] = {5.0f, 3, 0.0f, 0.0f},
+    [CHANNEL_HUMIDITY] = {2.0f, 3, 10.0f, 2.0f},
+};
+
+// Limites configurados para a grandeza medida por um canal
+static void get_limits(const settings_t *settings, channel_kind_t kind, const float **min, const float **max)
+{
+    switch (kind)
+    {
+    case CHANNEL_TEMPERATURE:
+        *min = &settings->temp_min;
+        *max = &settings->temp_max;
+        break;
+    case CHANNEL_PRESSURE:
+        *min = &settings->pressure_min;
+        *max = &settings->pressure_max;
+        break;
+    case CHANNEL_ALTITUDE:
+        *min = &settings->altitude_min;
+        *max = &settings->altitude_max;
+        break;
+    default:
+        *min = &settings->humidity_min;
+        *max = &settings->humidity_max;
+        break;
+    }
+}
+
+void alarm_rules_register(const settings_t *settings)
+{
+    alarms_init();
+    for (int kind = 0; kind < CHANNEL_KIND_COUNT; kind++)
+    {
+        const float *min, *max;
+        get_limits(settings, (channel_kind_t)kind, &min, &max);
+        for (uint i = 0; i < sensors_channel_count(); i++)
+        {
+            if (sensors_channel(i)->kind == (channel_kind_t)kind)
+                alarms_add_range((uint8_t)i, min, max, ALARM_CONFIG[kind].hysteresis, ALARM_CONFIG[kind].debounce);
+        }
+    }
+    for (uint i = 0; i < sensors_channel_count(); i++)
+    {
+        channel_kind_t kind = sensors_channel(i)->kind;
+        if (ALARM_CONFIG[kind].max_rate_per_min > 0)
+            alarms_add_rate((uint8_t)i, ALARM_CONFIG[kind].max_rate_per_min,
+                            ALARM_CONFIG[kind].rate_hysteresis, RATE_DEBOUNCE);
+    }
+}
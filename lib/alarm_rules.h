@@ -0,0 +1,13 @@
+#ifndef ALARM_RULES_H
+#define ALARM_RULES_H
+
+#include "alarms.h"
+#include "settings.h"
+
+// Monta a tabela de regras para os canais registrados: uma regra de faixa por
+// canal, na ordem de prioridade das grandezas, seguida das regras de taxa de
+// variação. As regras guardam ponteiros para os limites em settings, então
+// alterações nas configurações valem na hora; settings precisa continuar vivo.
+void alarm_rules_register(const settings_t *settings);
+
+#endif // ALARM_RULES_H
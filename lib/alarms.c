@@ -0,0 +1,176 @@
+#include <math.h>
+
+#include "alarms.h"
+
+static alarm_rule_t rules[ALARMS_MAX_RULES];
+static uint num_rules = 0;
+static alarm_mask_t active_mask = 0;
+
+// Máscara das regras de cada canal, para consultas por canal sem percorrer a tabela
+static alarm_mask_t channel_masks[SENSORS_MAX_CHANNELS];
+
+void alarms_init(void)
+{
+    num_rules = 0;
+    active_mask = 0;
+    for (uint i = 0; i < SENSORS_MAX_CHANNELS; i++)
+        channel_masks[i] = 0;
+}
+
+static alarm_rule_t *add_rule(alarm_rule_type_t type, uint8_t channel, float hysteresis, uint8_t debounce)
+{
+    if (num_rules >= ALARMS_MAX_RULES || channel >= SENSORS_MAX_CHANNELS)
+        return NULL;
+
+    alarm_rule_t *r = &rules[num_rules];
+    *r = (alarm_rule_t){0};
+    r->type = type;
+    r->channel = channel;
+    r->hysteresis = hysteresis;
+    r->debounce = debounce ? debounce : 1;
+    channel_masks[channel] |= (alarm_mask_t)1 << num_rules;
+    num_rules++;
+    return r;
+}
+
+int alarms_add_range(uint8_t channel, const float *min, const float *max, float hysteresis, uint8_t debounce)
+{
+    alarm_rule_t *r = add_rule(ALARM_RULE_RANGE, channel, hysteresis, debounce);
+    if (!r)
+        return -1;
+    r->min = min;
+    r->max = max;
+    return (int)(r - rules);
+}
+
+int alarms_add_rate(uint8_t channel, float max_rate_per_min, float hysteresis, uint8_t debounce)
+{
+    alarm_rule_t *r = add_rule(ALARM_RULE_RATE, channel, hysteresis, debounce);
+    if (!r)
+        return -1;
+    r->max_rate = max_rate_per_min;
+    return (int)(r - rules);
+}
+
+// Condição da regra para o valor atual: 1 viola, 0 está dentro da margem de
+// histerese, -1 sem decisão (leitura inválida, zona de histerese ou janela incompleta)
+static int check_rule(alarm_rule_t *r, const sensor_channel_t *ch, uint32_t now_ms)
+{
+    if (!ch->valid || isnan(ch->value))
+        return -1;
+
+    if (r->type == ALARM_RULE_RANGE)
+    {
+        float min = *r->min, max = *r->max;
+        if (ch->value < min || ch->value > max)
+            return 1;
+        if (ch->value >= min + r->hysteresis && ch->value <= max - r->hysteresis)
+            return 0;
+        return r->active ? -1 : 0;
+    }
+
+    // Taxa de variação: compara com o valor do início da janela
+    if (!r->has_ref)
+    {
+        r->has_ref = true;
+        r->ref_ts = now_ms;
+        r->ref_value = ch->value;
+        return -1;
+    }
+    uint32_t elapsed = now_ms - r->ref_ts;
+    if (elapsed < ALARMS_RATE_WINDOW_MS)
+        return -1;
+
+    r->rate = (ch->value - r->ref_value) * 60000.0f / elapsed;
+    r->ref_ts = now_ms;
+    r->ref_value = ch->value;
+    float rate = fabsf(r->rate);
+    if (rate > r->max_rate)
+        return 1;
+    if (rate <= r->max_rate - r->hysteresis)
+        return 0;
+    return r->active ? -1 : 0;
+}
+
+// Guarda o valor e o limite de uma transição para o registro de eventos
+static void record_transition(alarm_rule_t *r, const sensor_channel_t *ch)
+{
+    if (r->type == ALARM_RULE_RATE)
+    {
+        r->event_value = r->rate;
+        r->event_threshold = r->max_rate;
+        return;
+    }
+    r->event_value = ch->value;
+    // Ao limpar, continua valendo o limite que disparou o alarme
+    if (r->active)
+        r->event_threshold = ch->value < *r->min ? *r->min : *r->max;
+}
+
+alarm_mask_t alarms_evaluate(uint32_t now_ms)
+{
+    alarm_mask_t mask = 0;
+    uint channel_count = sensors_channel_count();
+    for (uint i = 0; i < num_rules; i++)
+    {
+        alarm_rule_t *r = &rules[i];
+        if (r->channel < channel_count)
+        {
+            const sensor_channel_t *ch = sensors_channel(r->channel);
+            int violated = check_rule(r, ch, now_ms);
+            // Só muda de estado depois de debounce amostras seguidas apontando a mudança
+            if (violated >= 0 && (violated == 1) != r->active)
+            {
+                if (++r->streak >= r->debounce)
+                {
+                    r->active = !r->active;
+                    r->streak = 0;
+                    record_transition(r, ch);
+                }
+            }
+            else if (violated >= 0)
+            {
+                r->streak = 0;
+            }
+        }
+        if (r->active)
+            mask |= (alarm_mask_t)1 << i;
+    }
+    active_mask = mask;
+    return mask;
+}
+
+alarm_mask_t alarms_active(void)
+{
+    return active_mask;
+}
+
+uint alarms_rule_count(void)
+{
+    return num_rules;
+}
+
+const alarm_rule_t *alarms_rule(uint index)
+{
+    return index < num_rules ? &rules[index] : NULL;
+}
+
+void alarms_restore_rule(uint index, const alarm_rule_t *state)
+{
+    if (index >= num_rules)
+        return;
+    alarm_rule_t *r = &rules[index];
+    r->active = state->active;
+    r->streak = state->streak;
+    r->has_ref = state->has_ref;
+    r->ref_ts = state->ref_ts;
+    r->ref_value = state->ref_value;
+    r->rate = state->rate;
+    alarm_mask_t bit = (alarm_mask_t)1 << index;
+    active_mask = r->active ? active_mask | bit : active_mask & ~bit;
+}
+
+bool alarms_channel_active(uint8_t channel)
+{
+    return channel < SENSORS_MAX_CHANNELS && (active_mask & channel_masks[channel]) != 0;
+}
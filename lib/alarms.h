@@ -0,0 +1,63 @@
+#ifndef ALARMS_H
+#define ALARMS_H
+
+#include "pico/stdlib.h"
+#include "sensors.h"
+
+// Uma regra de faixa por canal mais as regras de taxa de variação
+#define ALARMS_MAX_RULES 64
+
+// Janela usada pelas regras de taxa de variação
+#define ALARMS_RATE_WINDOW_MS (60 * 1000)
+
+typedef uint64_t alarm_mask_t;
+
+typedef enum
+{
+    ALARM_RULE_RANGE, // Valor fora de [*min, *max]
+    ALARM_RULE_RATE   // Variação por minuto acima de max_rate (em módulo)
+} alarm_rule_type_t;
+
+typedef struct
+{
+    alarm_rule_type_t type;
+    uint8_t channel;
+    uint8_t debounce;   // Amostras consecutivas para disparar ou limpar
+    float hysteresis;   // Margem, para dentro do limite, exigida para limpar
+    // Limites lidos a cada avaliação, de modo que mudanças nas configurações valem na hora
+    const float *min;
+    const float *max;
+    float max_rate;
+
+    // Estado
+    bool active;
+    uint8_t streak;     // Amostras consecutivas contrárias ao estado atual
+    bool has_ref;
+    uint32_t ref_ts;
+    float ref_value;
+    float rate;            // Última taxa medida (por minuto)
+    float event_value;     // Valor medido na última transição
+    float event_threshold; // Limite que provocou o último disparo
+} alarm_rule_t;
+
+void alarms_init(void);
+
+// Retornam o índice da regra (bit na máscara), ou -1 se a tabela estiver cheia
+int alarms_add_range(uint8_t channel, const float *min, const float *max, float hysteresis, uint8_t debounce);
+int alarms_add_rate(uint8_t channel, float max_rate_per_min, float hysteresis, uint8_t debounce);
+
+// Avalia todas as regras em uma passada sobre os valores atuais dos canais
+alarm_mask_t alarms_evaluate(uint32_t now_ms);
+
+alarm_mask_t alarms_active(void);
+uint alarms_rule_count(void);
+const alarm_rule_t *alarms_rule(uint index);
+
+// Copia o estado dinâmico (ativo, contagem, referência da taxa) de uma regra
+// já registrada; usado para retomar a avaliação a partir de um traço
+void alarms_restore_rule(uint index, const alarm_rule_t *state);
+
+// Alarme ativo em qualquer regra do canal
+bool alarms_channel_active(uint8_t channel);
+
+#endif // ALARMS_H
@@ -0,0 +1,19 @@
+#include <stdarg.h>
+#include <stdio.h>
+
+#include "appendf.h"
+
+int appendf(char *buf, size_t size, int len, const char *fmt, ...)
+{
+    if (len < 0 || (size_t)len >= size)
+        return len;
+
+    va_list args;
+    va_start(args, fmt);
+    int n = vsnprintf(buf + len, size - len, fmt, args);
+    va_end(args);
+
+    if (n < 0)
+        return len;
+    return ((size_t)(len + n) >= size) ? (int)size - 1 : len + n;
+}
@@ -0,0 +1,11 @@
+#ifndef APPENDF_H
+#define APPENDF_H
+
+#include <stddef.h>
+
+// Acrescenta texto formatado em buf a partir de len e retorna o novo
+// comprimento. Texto que não cabe é cortado e o comprimento para em size - 1,
+// então chamadas seguidas podem encadear o resultado sem conferir cada uma.
+int appendf(char *buf, size_t size, int len, const char *fmt, ...) __attribute__((format(printf, 4, 5)));
+
+#endif // APPENDF_H
@@ -1,38 +1,69 @@
 #include "bmp280.h"
+#include "pico/stdlib.h"
 #include "hardware/i2c.h"
 
-#define ADDR _u(0x76)
+// Sobreamostragem: temperatura x1, pressão x4
+#define CTRL_MEAS_OVERSAMPLING ((0x01 << 5) | (0x03 << 2))
 
-void bmp280_init(i2c_inst_t *i2c) {
+void bmp280_init(i2c_inst_t *i2c, uint8_t addr) {
     uint8_t buf[2];
     const uint8_t reg_config_val = ((0x04 << 5) | (0x05 << 2)) & 0xFC;
     buf[0] = REG_CONFIG;
     buf[1] = reg_config_val;
    
-    i2c_write_blocking(i2c, ADDR, buf, 2, false);
+    i2c_write_blocking(i2c, addr, buf, 2, false);
 
-    const uint8_t reg_ctrl_meas_val = (0x01 << 5) | (0x03 << 2) | (0x03);
+    const uint8_t reg_ctrl_meas_val = CTRL_MEAS_OVERSAMPLING | BMP280_MODE_NORMAL;
     buf[0] = REG_CTRL_MEAS;
     buf[1] = reg_ctrl_meas_val;
-    i2c_write_blocking(i2c, ADDR, buf, 2, false);
+    i2c_write_blocking(i2c, addr, buf, 2, false);
  //   printf("Ctrl_meas register value: %x\n", reg_ctrl_meas_val);
 }
 
-void bmp280_read_raw(i2c_inst_t *i2c, int32_t* temp, int32_t* pressure) {
+// Verifica se há um BMP280 respondendo no endereço informado
+bool bmp280_check(i2c_inst_t *i2c, uint8_t addr) {
+    uint8_t reg = REG_CHIP_ID;
+    uint8_t id = 0;
+    if (i2c_write_blocking(i2c, addr, &reg, 1, true) != 1)
+        return false;
+    if (i2c_read_blocking(i2c, addr, &id, 1, false) != 1)
+        return false;
+    return id == BMP280_CHIP_ID;
+}
+
+bool bmp280_set_mode(i2c_inst_t *i2c, uint8_t addr, uint8_t mode) {
+    uint8_t buf[2] = { REG_CTRL_MEAS, CTRL_MEAS_OVERSAMPLING | (mode & 0x03) };
+    return i2c_write_blocking(i2c, addr, buf, 2, false) == 2;
+}
+
+bool bmp280_wait_ready(i2c_inst_t *i2c, uint8_t addr) {
+    uint8_t reg = REG_STATUS;
+    uint8_t status = BMP280_STATUS_MEASURING;
+    for (int i = 0; i < 10 && (status & BMP280_STATUS_MEASURING); i++) {
+        if (i > 0)
+            sleep_ms(2);
+        if (i2c_write_blocking(i2c, addr, &reg, 1, true) != 1 ||
+            i2c_read_blocking(i2c, addr, &status, 1, false) != 1)
+            return false;
+    }
+    return !(status & BMP280_STATUS_MEASURING);
+}
+
+bool bmp280_read_raw(i2c_inst_t *i2c, uint8_t addr, int32_t* temp, int32_t* pressure) {
     uint8_t buf[6];
     uint8_t reg = REG_PRESSURE_MSB;
-    i2c_write_blocking(i2c, ADDR, &reg, 1, true);
-    i2c_read_blocking(i2c, ADDR, buf, 6, false);
+    i2c_write_blocking(i2c, addr, &reg, 1, true);
+    if (i2c_read_blocking(i2c, addr, buf, 6, false) != 6)
+        return false;
 
     *pressure = (buf[0] << 12) | (buf[1] << 4) | (buf[2] >> 4);
     *temp = (buf[3] << 12) | (buf[4] << 4) | (buf[5] >> 4);
-
-
+    return true;
 }
 
-void bmp280_reset(i2c_inst_t *i2c) {
+void bmp280_reset(i2c_inst_t *i2c, uint8_t addr) {
     uint8_t buf[2] = { REG_RESET, 0xB6 };
-    i2c_write_blocking(i2c, ADDR, buf, 2, false);
+    i2c_write_blocking(i2c, addr, buf, 2, false);
 }
 
 // função intermediária que calcula a temperatura de resolução fina
@@ -80,11 +111,12 @@ int32_t bmp280_convert_pressure(int32_t pressure, int32_t temp, struct bmp280_ca
     return converted;
 }
 
-void bmp280_get_calib_params(i2c_inst_t *i2c, struct bmp280_calib_param* params) {
+bool bmp280_get_calib_params(i2c_inst_t *i2c, uint8_t addr, struct bmp280_calib_param* params) {
     uint8_t buf[NUM_CALIB_PARAMS] = { 0 };
     uint8_t reg = REG_DIG_T1_LSB;
-    i2c_write_blocking(i2c, ADDR, &reg, 1, true);
-    i2c_read_blocking(i2c, ADDR, buf, NUM_CALIB_PARAMS, false);
+    i2c_write_blocking(i2c, addr, &reg, 1, true);
+    if (i2c_read_blocking(i2c, addr, buf, NUM_CALIB_PARAMS, false) != NUM_CALIB_PARAMS)
+        return false;
 
     params->dig_t1 = (uint16_t)(buf[1] << 8) | buf[0];
     params->dig_t2 = (int16_t)(buf[3] << 8) | buf[2];
@@ -99,6 +131,5 @@ void bmp280_get_calib_params(i2c_inst_t *i2c, struct bmp280_calib_param* params)
     params->dig_p7 = (int16_t)(buf[19] << 8) | buf[18];
     params->dig_p8 = (int16_t)(buf[21] << 8) | buf[20];
     params->dig_p9 = (int16_t)(buf[23] << 8) | buf[22];
-
-
+    return true;
 }
@@ -3,11 +3,18 @@
 
 #include "hardware/i2c.h"
 
-// Defina os endereços e registros conforme o código original
-#define ADDR _u(0x76)
+// Endereços I2C possíveis (pino SDO em GND ou em VCC)
+#define BMP280_I2C_ADDR _u(0x76)
+#define BMP280_I2C_ADDR_ALT _u(0x77)
+
+// Valor fixo do registrador de identificação do BMP280
+#define BMP280_CHIP_ID _u(0x58)
+
+#define REG_CHIP_ID _u(0xD0)
 
 #define REG_CONFIG _u(0xF5)
 #define REG_CTRL_MEAS _u(0xF4)
+#define REG_STATUS _u(0xF3)
 #define REG_RESET _u(0xE0)
 
 #define REG_TEMP_XLSB _u(0xFC)
@@ -45,6 +52,14 @@
 
 #define NUM_CALIB_PARAMS 24
 
+// Modos de operação (bits 1:0 de ctrl_meas)
+#define BMP280_MODE_SLEEP 0x00
+#define BMP280_MODE_FORCED 0x01
+#define BMP280_MODE_NORMAL 0x03
+
+// Bit de conversão em andamento no registrador de status
+#define BMP280_STATUS_MEASURING 0x08
+
 struct bmp280_calib_param {
     uint16_t dig_t1;
     int16_t dig_t2;
@@ -62,11 +77,17 @@ struct bmp280_calib_param {
 };
 
 //void bmp280_init(void);
-void bmp280_init(i2c_inst_t *i2c);
-void bmp280_read_raw(i2c_inst_t *i2c, int32_t* temp, int32_t* pressure);
-void bmp280_reset(i2c_inst_t *i2c);
+void bmp280_init(i2c_inst_t *i2c, uint8_t addr);
+bool bmp280_check(i2c_inst_t *i2c, uint8_t addr);
+// Troca o modo mantendo a sobreamostragem; no modo forçado o chip faz uma
+// conversão e volta a dormir
+bool bmp280_set_mode(i2c_inst_t *i2c, uint8_t addr, uint8_t mode);
+// Espera o fim da conversão do modo forçado (~14 ms no máximo)
+bool bmp280_wait_ready(i2c_inst_t *i2c, uint8_t addr);
+bool bmp280_read_raw(i2c_inst_t *i2c, uint8_t addr, int32_t* temp, int32_t* pressure);
+void bmp280_reset(i2c_inst_t *i2c, uint8_t addr);
 int32_t bmp280_convert_temp(int32_t temp, struct bmp280_calib_param* params);
 int32_t bmp280_convert_pressure(int32_t pressure, int32_t temp, struct bmp280_calib_param* params);
-void bmp280_get_calib_params(i2c_inst_t *i2c, struct bmp280_calib_param* params);
+bool bmp280_get_calib_params(i2c_inst_t *i2c, uint8_t addr, struct bmp280_calib_param* params);
 
 #endif
@@ -0,0 +1,40 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "boot_profile.h"
+
+typedef struct
+{
+    const char *name;
+    uint64_t t_us;
+} boot_phase_t;
+
+static boot_phase_t phases[BOOT_PROFILE_MAX_PHASES];
+static uint num_phases = 0;
+
+void boot_mark(const char *name)
+{
+    if (num_phases < BOOT_PROFILE_MAX_PHASES)
+        phases[num_phases++] = (boot_phase_t){name, time_us_64()};
+}
+
+uint64_t boot_mark_us(const char *name)
+{
+    for (uint i = 0; i < num_phases; i++)
+        if (strcmp(phases[i].name, name) == 0)
+            return phases[i].t_us;
+    return 0;
+}
+
+int boot_format_report(char *buf, size_t size)
+{
+    int len = snprintf(buf, size, "fase                 fim (ms)  duracao (ms)\n");
+    uint64_t prev = 0;
+    for (uint i = 0; i < num_phases && len >= 0 && (size_t)len < size; i++)
+    {
+        len += snprintf(buf + len, size - len, "%-20s %8.1f  %12.1f\n", phases[i].name,
+                        phases[i].t_us / 1000.0, (phases[i].t_us - prev) / 1000.0);
+        prev = phases[i].t_us;
+    }
+    return len;
+}
@@ -0,0 +1,19 @@
+#ifndef BOOT_PROFILE_H
+#define BOOT_PROFILE_H
+
+#include <stddef.h>
+#include "pico/stdlib.h"
+
+#define BOOT_PROFILE_MAX_PHASES 24
+
+// Marca o fim de uma fase do boot com o tempo desde o reset. name deve ser
+// uma string estática; marcas além da capacidade são ignoradas.
+void boot_mark(const char *name);
+
+// Tempo desde o reset da marca com esse nome, ou 0 se ela ainda não existe
+uint64_t boot_mark_us(const char *name);
+
+// Linha do tempo em texto: uma fase por linha, com o instante e a duração
+int boot_format_report(char *buf, size_t size);
+
+#endif // BOOT_PROFILE_H
@@ -0,0 +1,110 @@
+#include "buzzer.h"
+#include "hardware/pwm.h"
+#include "hardware/clocks.h"
+#include "hardware/sync.h"
+
+static const buzzer_step_t RATE_STEPS[] = {{1500, 150}, {0, 150}, {1500, 150}, {0, 1550}};
+static const buzzer_step_t RANGE_STEPS[] = {{1900, 250}, {0, 250}};
+static const buzzer_step_t CRITICAL_STEPS[] = {{2500, 100}, {0, 100}, {2500, 100}, {0, 100}, {2500, 100}, {0, 400}};
+
+#define STEPS(s) s, sizeof(s) / sizeof(s[0])
+
+static const buzzer_pattern_t PATTERNS[BUZZER_PATTERN_COUNT] = {
+    [BUZZER_SILENT] = {NULL, 0, 0},
+    [BUZZER_RATE] = {STEPS(RATE_STEPS), 3},
+    [BUZZER_RANGE] = {STEPS(RANGE_STEPS), 0},
+    [BUZZER_CRITICAL] = {STEPS(CRITICAL_STEPS), 0},
+};
+
+static uint pin;
+static uint slice;
+
+// Estado do sequenciador, alterado só com interrupções desabilitadas ou no próprio alarme
+static const buzzer_pattern_t *current = NULL;
+static uint8_t step_index;
+static uint8_t loops;
+static alarm_id_t alarm = 0;
+
+// Frequência pelo wrap e pelo divisor inteiro do PWM: o menor divisor com wrap de 16 bits
+static void set_tone(uint16_t freq_hz)
+{
+    if (freq_hz == 0)
+    {
+        pwm_set_gpio_level(pin, 0);
+        return;
+    }
+    uint32_t clk = clock_get_hz(clk_sys);
+    uint32_t div = clk / ((uint32_t)freq_hz * 65536) + 1;
+    uint32_t wrap = clk / (div * freq_hz) - 1;
+    pwm_set_clkdiv_int_frac(slice, (uint8_t)div, 0);
+    pwm_set_wrap(slice, (uint16_t)wrap);
+    pwm_set_gpio_level(pin, (uint16_t)((wrap + 1) * BUZZER_DUTY / 4096));
+}
+
+// Fim de um passo: começa o próximo. O retorno negativo reagenda a partir do
+// disparo anterior, e não do momento atual, então a latência da interrupção
+// não se acumula ao longo do padrão.
+static int64_t on_step(alarm_id_t id, void *user_data)
+{
+    if (++step_index >= current->count)
+    {
+        step_index = 0;
+        if (current->repeat && ++loops >= current->repeat)
+        {
+            set_tone(0);
+            current = NULL;
+            alarm = 0;
+            return 0;
+        }
+    }
+    const buzzer_step_t *s = &current->steps[step_index];
+    set_tone(s->freq_hz);
+    return -(int64_t)s->ms * 1000;
+}
+
+void buzzer_init(uint gpio)
+{
+    pin = gpio;
+    gpio_set_function(pin, GPIO_FUNC_PWM);
+    slice = pwm_gpio_to_slice_num(pin);
+    pwm_set_gpio_level(pin, 0);
+    pwm_set_enabled(slice, true);
+}
+
+void buzzer_stop(void)
+{
+    uint32_t irq = save_and_disable_interrupts();
+    if (alarm > 0)
+        cancel_alarm(alarm);
+    alarm = 0;
+    current = NULL;
+    set_tone(0);
+    restore_interrupts(irq);
+}
+
+void buzzer_play(buzzer_pattern_id_t id)
+{
+    buzzer_stop();
+    if (id <= BUZZER_SILENT || id >= BUZZER_PATTERN_COUNT)
+        return;
+
+    uint32_t irq = save_and_disable_interrupts();
+    current = &PATTERNS[id];
+    step_index = 0;
+    loops = 0;
+    set_tone(current->steps[0].freq_hz);
+    alarm = add_alarm_in_us((uint64_t)current->steps[0].ms * 1000, on_step, NULL, true);
+    if (alarm <= 0)
+    {
+        // Sem alarmes livres: melhor ficar em silêncio do que com o tom preso
+        set_tone(0);
+        current = NULL;
+        alarm = 0;
+    }
+    restore_interrupts(irq);
+}
+
+bool buzzer_playing(void)
+{
+    return current != NULL;
+}
@@ -0,0 +1,42 @@
+#ifndef BUZZER_H
+#define BUZZER_H
+
+#include "pico/stdlib.h"
+
+// Intensidade: nível do PWM em 1/4096 do período (a mesma de antes: 300 de 4096)
+#define BUZZER_DUTY 300
+
+typedef struct
+{
+    uint16_t freq_hz; // 0: silêncio
+    uint16_t ms;
+} buzzer_step_t;
+
+typedef struct
+{
+    const buzzer_step_t *steps;
+    uint8_t count;
+    uint8_t repeat; // Vezes que a sequência toca; 0 repete até buzzer_stop
+} buzzer_pattern_t;
+
+// Padrões em ordem crescente de gravidade
+typedef enum
+{
+    BUZZER_SILENT,
+    BUZZER_RATE,     // Taxa de variação: dois bipes curtos, três vezes
+    BUZZER_RANGE,    // Fora da faixa: 250 ms ligado, 250 ms desligado
+    BUZZER_CRITICAL, // Mais de um alarme de faixa: rajadas rápidas e agudas
+    BUZZER_PATTERN_COUNT
+} buzzer_pattern_id_t;
+
+void buzzer_init(uint gpio);
+
+// Toca um padrão do início. Os passos são trocados por um alarme de hardware,
+// então o ritmo não depende do laço principal. Pode ser chamada de interrupções.
+void buzzer_play(buzzer_pattern_id_t id);
+void buzzer_stop(void);
+
+// Padrão em andamento (false depois de buzzer_stop ou do fim das repetições)
+bool buzzer_playing(void);
+
+#endif // BUZZER_H
@@ -0,0 +1,15 @@
+#include "crc32.h"
+
+uint32_t crc32_update(uint32_t crc, const void *data, size_t len)
+{
+    const uint8_t *p = (const uint8_t *)data;
+    crc = ~crc;
+    while (len--)
+    {
+        crc ^= *p++;
+        // Versão sem tabela: os registros gravados são pequenos e raros
+        for (int bit = 0; bit < 8; bit++)
+            crc = (crc >> 1) ^ (0xEDB88320u & -(crc & 1));
+    }
+    return ~crc;
+}
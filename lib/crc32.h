@@ -0,0 +1,11 @@
+#ifndef CRC32_H
+#define CRC32_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// CRC-32 (IEEE 802.3). Para calcular em partes, passe o resultado anterior em crc;
+// comece com 0.
+uint32_t crc32_update(uint32_t crc, const void *data, size_t len);
+
+#endif // CRC32_H
@@ -0,0 +1,77 @@
+#include "duty_cycle.h"
+
+static duty_config_t config;
+static uint32_t next_sample_ms;
+static uint32_t next_service_ms;
+static uint32_t last_activity_ms;
+
+static bool reached(uint32_t now_ms, uint32_t deadline_ms)
+{
+    return (int32_t)(now_ms - deadline_ms) >= 0;
+}
+
+uint32_t duty_sample_interval_ms(void)
+{
+    if (!config.low_power)
+        return DUTY_NORMAL_PERIOD_MS;
+    return config.sample_interval_ms > DUTY_MIN_SAMPLE_MS ? config.sample_interval_ms : DUTY_MIN_SAMPLE_MS;
+}
+
+static uint32_t service_interval_ms(void)
+{
+    return config.low_power ? DUTY_SERVICE_MS : DUTY_NORMAL_PERIOD_MS;
+}
+
+void duty_init(const duty_config_t *cfg, uint32_t now_ms)
+{
+    config = *cfg;
+    next_sample_ms = next_service_ms = now_ms;
+    last_activity_ms = now_ms;
+}
+
+void duty_configure(const duty_config_t *cfg, uint32_t now_ms)
+{
+    if (cfg->low_power == config.low_power && cfg->sample_interval_ms == config.sample_interval_ms)
+        return;
+    config = *cfg;
+    next_sample_ms = next_service_ms = now_ms;
+    // Trocar de modo conta como uso: o OLED não apaga logo em seguida
+    last_activity_ms = now_ms;
+}
+
+// Agenda fixa (sem acumular o atraso de cada volta); se a volta atrasou mais
+// de um período, recomeça a partir de agora
+static bool take(uint32_t *next_ms, uint32_t period_ms, uint32_t now_ms)
+{
+    if (!reached(now_ms, *next_ms))
+        return false;
+    *next_ms += period_ms;
+    if (reached(now_ms, *next_ms))
+        *next_ms = now_ms + period_ms;
+    return true;
+}
+
+uint32_t duty_due(uint32_t now_ms)
+{
+    uint32_t due = 0;
+    if (take(&next_sample_ms, duty_sample_interval_ms(), now_ms))
+        due |= DUTY_SAMPLE;
+    if (take(&next_service_ms, service_interval_ms(), now_ms))
+        due |= DUTY_SERVICE;
+    return due;
+}
+
+uint32_t duty_next_wake_ms(void)
+{
+    return reached(next_sample_ms, next_service_ms) ? next_service_ms : next_sample_ms;
+}
+
+void duty_user_activity(uint32_t now_ms)
+{
+    last_activity_ms = now_ms;
+}
+
+bool duty_display_on(uint32_t now_ms)
+{
+    return !config.low_power || now_ms - last_activity_ms < DUTY_DISPLAY_TIMEOUT_MS;
+}
@@ -0,0 +1,52 @@
+#ifndef DUTY_CYCLE_H
+#define DUTY_CYCLE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Agenda do laço principal. No modo normal tudo roda a cada
+// DUTY_NORMAL_PERIOD_MS, como sempre foi; no modo de baixo consumo os sensores
+// são lidos no intervalo configurado, os serviços rodam a cada DUTY_SERVICE_MS
+// e o núcleo dorme entre os vencimentos. Sem dependência do SDK (o tempo vem
+// de quem chama), para rodar também no host.
+
+#define DUTY_NORMAL_PERIOD_MS 250
+#define DUTY_SERVICE_MS 1000
+
+// Intervalo mínimo entre leituras no modo de baixo consumo
+#define DUTY_MIN_SAMPLE_MS 1000
+
+// O OLED apaga depois desse tempo sem uso dos botões (só no baixo consumo)
+#define DUTY_DISPLAY_TIMEOUT_MS 60000
+
+// Tarefas devolvidas por duty_due
+#define DUTY_SAMPLE (1u << 0)  // Sensores, histórico e alarmes
+#define DUTY_SERVICE (1u << 1) // Wi-Fi, display, envios de rede e configurações
+
+typedef struct
+{
+    bool low_power;
+    uint32_t sample_interval_ms; // Usado só no baixo consumo
+} duty_config_t;
+
+// Começa com todas as tarefas vencidas
+void duty_init(const duty_config_t *config, uint32_t now_ms);
+
+// Troca a configuração; se algo mudou, as tarefas vencem de novo na hora
+void duty_configure(const duty_config_t *config, uint32_t now_ms);
+
+// Tarefas vencidas em now_ms (máscara DUTY_*), já reagendadas
+uint32_t duty_due(uint32_t now_ms);
+
+// Instante do próximo vencimento, para o núcleo dormir até lá
+uint32_t duty_next_wake_ms(void);
+
+// Intervalo entre leituras na configuração atual
+uint32_t duty_sample_interval_ms(void);
+
+// Botão pressionado: reacende o OLED e reinicia a contagem de inatividade
+void duty_user_activity(uint32_t now_ms);
+
+bool duty_display_on(uint32_t now_ms);
+
+#endif // DUTY_CYCLE_H
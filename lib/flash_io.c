@@ -0,0 +1,57 @@
+#include "flash_io.h"
+#include "pico/flash.h"
+#include "hardware/regs/addressmap.h"
+
+// Tempo máximo para obter acesso exclusivo à flash
+#define FLASH_IO_TIMEOUT_MS 100
+
+typedef struct
+{
+    uint32_t offset;
+    const uint8_t *data;
+    uint32_t len;
+} flash_io_op_t;
+
+static void do_erase(void *param)
+{
+    const flash_io_op_t *op = (const flash_io_op_t *)param;
+    flash_range_erase(op->offset, op->len);
+}
+
+static void do_program(void *param)
+{
+    const flash_io_op_t *op = (const flash_io_op_t *)param;
+    flash_range_program(op->offset, op->data, op->len);
+}
+
+const uint8_t *flash_io_ptr(uint32_t offset)
+{
+    return (const uint8_t *)(XIP_BASE + offset);
+}
+
+bool flash_io_erase(uint32_t offset, uint32_t len)
+{
+    if (offset % FLASH_SECTOR_SIZE || len % FLASH_SECTOR_SIZE)
+        return false;
+    flash_io_op_t op = {offset, NULL, len};
+    return flash_safe_execute(do_erase, &op, FLASH_IO_TIMEOUT_MS) == PICO_OK;
+}
+
+bool flash_io_program(uint32_t offset, const uint8_t *data, uint32_t len)
+{
+    if (offset % FLASH_PAGE_SIZE || len % FLASH_PAGE_SIZE)
+        return false;
+    flash_io_op_t op = {offset, data, len};
+    return flash_safe_execute(do_program, &op, FLASH_IO_TIMEOUT_MS) == PICO_OK;
+}
+
+bool flash_io_is_blank(uint32_t offset, uint32_t len)
+{
+    const uint32_t *p = (const uint32_t *)flash_io_ptr(offset);
+    for (uint32_t i = 0; i < len / 4; i++)
+    {
+        if (p[i] != 0xFFFFFFFFu)
+            return false;
+    }
+    return true;
+}
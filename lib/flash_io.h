@@ -0,0 +1,26 @@
+#ifndef FLASH_IO_H
+#define FLASH_IO_H
+
+#include "pico/stdlib.h"
+#include "hardware/flash.h"
+
+// Mapa das regiões reservadas no fim da flash (o programa ocupa o início)
+#define FLASH_SETTINGS_SIZE (4 * FLASH_SECTOR_SIZE)
+#define FLASH_SETTINGS_OFFSET (PICO_FLASH_SIZE_BYTES - FLASH_SETTINGS_SIZE)
+#define FLASH_SAMPLE_LOG_SIZE (512 * 1024)
+#define FLASH_SAMPLE_LOG_OFFSET (FLASH_SETTINGS_OFFSET - FLASH_SAMPLE_LOG_SIZE)
+#define FLASH_TRACE_SIZE (128 * 1024)
+#define FLASH_TRACE_OFFSET (FLASH_SAMPLE_LOG_OFFSET - FLASH_TRACE_SIZE)
+
+// Ponteiro para leitura direta pela XIP de um endereço relativo ao início da flash
+const uint8_t *flash_io_ptr(uint32_t offset);
+
+// Apaga setores inteiros / grava páginas inteiras. As rotinas suspendem as
+// interrupções (inclusive as da pilha de rede) enquanto a flash está ocupada.
+bool flash_io_erase(uint32_t offset, uint32_t len);
+bool flash_io_program(uint32_t offset, const uint8_t *data, uint32_t len);
+
+// Verifica se a faixa está apagada (todos os bytes em 0xFF)
+bool flash_io_is_blank(uint32_t offset, uint32_t len);
+
+#endif // FLASH_IO_H
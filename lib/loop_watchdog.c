@@ -0,0 +1,200 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "hardware/sync.h"
+#include "hardware/watchdog.h"
+#include "loop_watchdog.h"
+#include "appendf.h"
+
+#define STATE_MAGIC 0x57444F47u
+
+// Estado que atravessa o reset pelo watchdog, junto com o traço das etapas
+typedef struct
+{
+    uint32_t magic;
+    uint32_t fed_us; // time_us_32 da última alimentação
+    uint32_t resets;
+} persisted_t;
+
+static persisted_t __uninitialized_ram(persisted);
+static loop_watchdog_stats_t stats;
+static loop_watchdog_stall_t stall;
+static uint32_t begin_us;
+static bool started = false;
+
+void loop_watchdog_init(void)
+{
+    // Reset por watchdog_enable + falta de alimentação, com o estado deste módulo
+    // ainda na RAM (não é power-on nem o reboot do BOOTSEL)
+    stall.valid = persisted.magic == STATE_MAGIC && watchdog_enable_caused_reboot() && perf_trace_get(&stall.trace);
+    if (stall.valid)
+    {
+        stall.resets = persisted.resets + 1;
+        stall.reset_us = persisted.fed_us + LOOP_WATCHDOG_TIMEOUT_MS * 1000u;
+    }
+    persisted = (persisted_t){.magic = STATE_MAGIC, .resets = stall.valid ? stall.resets : 0};
+    perf_trace_reset();
+}
+
+void loop_watchdog_start(void)
+{
+    // Pausa com o depurador parado num breakpoint
+    watchdog_enable(LOOP_WATCHDOG_TIMEOUT_MS, true);
+    persisted.fed_us = time_us_32();
+    started = true;
+}
+
+void loop_watchdog_begin(void)
+{
+    begin_us = time_us_32();
+}
+
+void loop_watchdog_end(uint32_t slo_ms)
+{
+    uint32_t now = time_us_32();
+    uint32_t us = now - begin_us;
+    // O handler HTTP lê as estatísticas em interrupção
+    uint32_t irq = save_and_disable_interrupts();
+    stats.slo_us = slo_ms * 1000u;
+    stats.iterations++;
+    stats.last_us = us;
+    if (us > stats.max_us)
+        stats.max_us = us;
+    if (stats.slo_us && us > stats.slo_us)
+    {
+        stats.over_slo++;
+        if (us > stats.worst_us)
+        {
+            stats.worst_us = us;
+            stats.worst_ms = to_ms_since_boot(get_absolute_time());
+            perf_trace_get(&stats.worst);
+        }
+    }
+    restore_interrupts(irq);
+
+    // Volta completa: o laço está andando. Uma volta lenta conta contra o SLO,
+    // mas reiniciar a placa por ela só deixaria os alarmes mais tempo parados.
+    if (started)
+    {
+        watchdog_update();
+        persisted.fed_us = now;
+    }
+}
+
+void loop_watchdog_get_stats(loop_watchdog_stats_t *out)
+{
+    uint32_t irq = save_and_disable_interrupts();
+    *out = stats;
+    restore_interrupts(irq);
+}
+
+const loop_watchdog_stall_t *loop_watchdog_last_stall(void)
+{
+    return &stall;
+}
+
+static uint open_count(const perf_trace_t *t)
+{
+    return MIN(t->depth, PERF_TRACE_DEPTH);
+}
+
+static uint done_count(const perf_trace_t *t)
+{
+    return MIN(t->closed, PERF_TRACE_LEN);
+}
+
+// i-ésima etapa encerrada, da mais antiga para a mais recente
+static const perf_trace_entry_t *done_entry(const perf_trace_t *t, uint i)
+{
+    return &t->done[(t->closed - done_count(t) + i) % PERF_TRACE_LEN];
+}
+
+// Fim da etapa encerrada mais recente: a referência do traço de uma volta lenta
+static uint32_t last_end_us(const perf_trace_t *t)
+{
+    if (done_count(t) == 0)
+        return 0;
+    const perf_trace_entry_t *e = done_entry(t, done_count(t) - 1);
+    return e->start_us + e->dur_us;
+}
+
+// Etapas abertas (há quanto tempo) e encerradas (quanto antes de ref_us terminaram)
+static int append_trace_json(char *buf, size_t size, int len, const perf_trace_t *t, uint32_t ref_us)
+{
+    len = appendf(buf, size, len, "\"open\":[");
+    for (uint i = 0; i < open_count(t); i++)
+        len = appendf(buf, size, len, "%s{\"stage\":\"%s\",\"depth\":%u,\"ms\":%.1f}", i ? "," : "",
+                      perf_stage_name((perf_stage_t)t->open[i].stage), t->open[i].depth,
+                      (int32_t)(ref_us - t->open[i].start_us) / 1000.0);
+    len = appendf(buf, size, len, "],\"recent\":[");
+    for (uint i = 0; i < done_count(t); i++)
+    {
+        const perf_trace_entry_t *e = done_entry(t, i);
+        len = appendf(buf, size, len, "%s{\"stage\":\"%s\",\"depth\":%u,\"end_ago_ms\":%.1f,\"us\":%lu}",
+                      i ? "," : "", perf_stage_name((perf_stage_t)e->stage), e->depth,
+                      (int32_t)(ref_us - e->start_us - e->dur_us) / 1000.0, (unsigned long)e->dur_us);
+    }
+    return appendf(buf, size, len, "]");
+}
+
+int loop_watchdog_format_json(char *buf, size_t size)
+{
+    loop_watchdog_stats_t s;
+    loop_watchdog_get_stats(&s);
+    int len = appendf(buf, size, 0,
+                      "{\"timeout_ms\":%u,\"slo_ms\":%lu,\"iterations\":%lu,\"over_slo\":%lu,\"last_us\":%lu,"
+                      "\"max_us\":%lu,\"worst\":",
+                      LOOP_WATCHDOG_TIMEOUT_MS, (unsigned long)(s.slo_us / 1000), (unsigned long)s.iterations,
+                      (unsigned long)s.over_slo, (unsigned long)s.last_us, (unsigned long)s.max_us);
+    if (s.worst_us)
+    {
+        len = appendf(buf, size, len, "{\"us\":%lu,\"at_ms\":%lu,", (unsigned long)s.worst_us,
+                      (unsigned long)s.worst_ms);
+        len = append_trace_json(buf, size, len, &s.worst, last_end_us(&s.worst));
+        len = appendf(buf, size, len, "}");
+    }
+    else
+    {
+        len = appendf(buf, size, len, "null");
+    }
+
+    len = appendf(buf, size, len, ",\"stall\":");
+    if (stall.valid)
+    {
+        len = appendf(buf, size, len, "{\"resets\":%lu,", (unsigned long)stall.resets);
+        len = append_trace_json(buf, size, len, &stall.trace, stall.reset_us);
+        len = appendf(buf, size, len, "}");
+    }
+    else
+    {
+        len = appendf(buf, size, len, "null");
+    }
+    return appendf(buf, size, len, "}");
+}
+
+int loop_watchdog_format_text(char *buf, size_t size)
+{
+    if (size > 0)
+        buf[0] = '\0';
+    if (!stall.valid)
+        return 0;
+    const perf_trace_t *t = &stall.trace;
+    int len = appendf(buf, size, 0, "reset pelo watchdog: %u ms sem volta completa do laco (%lu seguido(s))\n",
+                      LOOP_WATCHDOG_TIMEOUT_MS, (unsigned long)stall.resets);
+    len = appendf(buf, size, len, "presa em:");
+    if (open_count(t) == 0)
+        len = appendf(buf, size, len, " (fora das etapas medidas)");
+    for (uint i = 0; i < open_count(t); i++)
+        len = appendf(buf, size, len, "%s %s (%.1f ms)", i ? " >" : "",
+                      perf_stage_name((perf_stage_t)t->open[i].stage),
+                      (int32_t)(stall.reset_us - t->open[i].start_us) / 1000.0);
+    len = appendf(buf, size, len, "\nultimas etapas (fim em ms antes do reset, duracao em us):\n");
+    for (uint i = 0; i < done_count(t); i++)
+    {
+        const perf_trace_entry_t *e = done_entry(t, i);
+        int32_t ago_us = (int32_t)(stall.reset_us - e->start_us - e->dur_us);
+        len = appendf(buf, size, len, "%10.1f  %*s%-16s %8lu\n", -ago_us / 1000.0, e->depth * 2, "",
+                      perf_stage_name((perf_stage_t)e->stage), (unsigned long)e->dur_us);
+    }
+    return len;
+}
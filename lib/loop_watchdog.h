@@ -0,0 +1,59 @@
+#ifndef LOOP_WATCHDOG_H
+#define LOOP_WATCHDOG_H
+
+#include <stddef.h>
+#include "pico/stdlib.h"
+#include "perf.h"
+
+// Watchdog do laço principal: mede cada volta contra o SLO configurado e só
+// alimenta o watchdog de hardware quando a volta termina. Uma transação I2C
+// presa ou um handler HTTP que não retorna deixam de alimentá-lo e a placa
+// reinicia; o traço das etapas (perf.h), em RAM que o reset não zera, diz no
+// boot seguinte onde ela estava presa.
+
+// Sem volta completa nesse tempo, o watchdog reinicia a placa. A espera entre
+// voltas é de no máximo DUTY_SERVICE_MS, mesmo no baixo consumo.
+#define LOOP_WATCHDOG_TIMEOUT_MS 5000
+
+typedef struct
+{
+    uint32_t slo_us;
+    uint32_t iterations;
+    uint32_t over_slo;    // Voltas acima do SLO
+    uint32_t last_us;
+    uint32_t max_us;
+    uint32_t worst_us;    // Volta mais longa acima do SLO, com o traço em worst
+    uint32_t worst_ms;    // Instante (desde o boot) em que ela terminou
+    perf_trace_t worst;
+} loop_watchdog_stats_t;
+
+// Reset anterior causado pelo watchdog, com o traço do momento em que parou
+typedef struct
+{
+    bool valid;
+    uint32_t resets;   // Resets seguidos pelo watchdog desde o último power-on
+    uint32_t reset_us; // time_us_32 do reset, pela última alimentação
+    perf_trace_t trace;
+} loop_watchdog_stall_t;
+
+// No início do main, antes de qualquer PERF_BEGIN: guarda o traço do reset
+// anterior, se houve, e recomeça o traço
+void loop_watchdog_init(void);
+
+// Liga o watchdog de hardware; chamar logo antes do laço
+void loop_watchdog_start(void);
+
+// Delimitam uma volta do laço. end compara com o SLO, guarda o traço da pior
+// volta acima dele e alimenta o watchdog.
+void loop_watchdog_begin(void);
+void loop_watchdog_end(uint32_t slo_ms);
+
+void loop_watchdog_get_stats(loop_watchdog_stats_t *out);
+const loop_watchdog_stall_t *loop_watchdog_last_stall(void);
+
+// SLO, voltas, pior volta e o travamento anterior, com os traços
+int loop_watchdog_format_json(char *buf, size_t size);
+// Travamento anterior em texto, para o terminal USB (vazio se não houve)
+int loop_watchdog_format_text(char *buf, size_t size);
+
+#endif // LOOP_WATCHDOG_H
@@ -35,9 +35,11 @@
 #define LWIP_NETIF_LINK_CALLBACK 1
 #define LWIP_NETIF_HOSTNAME 1
 #define LWIP_NETCONN 0
-#define MEM_STATS 0
+// Heap e pools do lwIP em /debug/mem, também nos builds de release
+#define LWIP_STATS 1
+#define MEM_STATS 1
 #define SYS_STATS 0
-#define MEMP_STATS 0
+#define MEMP_STATS 1
 #define LINK_STATS 0
 // #define ETH_PAD_SIZE                2
 #define LWIP_CHKSUM_ALGORITHM 3
@@ -53,7 +55,6 @@
 
 #ifndef NDEBUG
 #define LWIP_DEBUG 1
-#define LWIP_STATS 1
 #define LWIP_STATS_DISPLAY 1
 #endif
 
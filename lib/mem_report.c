@@ -0,0 +1,176 @@
+#include <malloc.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "hardware/sync.h"
+#include "lwip/stats.h"
+#include "mem_report.h"
+#include "appendf.h"
+
+// Símbolos do linker (memmap_default.ld do Pico SDK). A pilha do núcleo 0 fica
+// no topo do SCRATCH_Y e a do núcleo 1 no do SCRATCH_X; abaixo da reserva, cada
+// uma ainda pode crescer até o fim dos dados .scratch_* do banco sem corromper nada.
+extern uint32_t __scratch_x_end__[], __StackOneBottom[], __StackOneTop[];
+extern uint32_t __scratch_y_end__[], __StackBottom[], __StackTop[];
+extern char __data_start__[], __data_end__[], __bss_start__[], __bss_end__[];
+extern char __end__[], __HeapLimit[];
+
+// Padrão improvável em dados reais; a primeira palavra alterada, de baixo para
+// cima, marca a maior profundidade que a pilha já alcançou
+#define STACK_PAINT 0x5AC3A55Au
+
+// Folga acima da qual um pico novo é avisado (evita uma linha por alocação)
+#define RISE_STEP 128
+
+typedef struct
+{
+    uint32_t *floor;
+    uint32_t *bottom;
+    uint32_t *top;
+} stack_region_t;
+
+static stack_region_t regions[2];
+static uint32_t heap_used_peak = 0;
+static uint32_t reported[4]; // Últimos picos avisados: heap, arena, pilha 0, pilha 1
+
+#if LWIP_STATS && MEMP_STATS
+static const char *const MEMP_NAMES[] = {
+#define LWIP_MEMPOOL(name, num, size, desc) #name,
+#include "lwip/priv/memp_std.h"
+};
+#endif
+
+void mem_report_init(void)
+{
+    regions[0] = (stack_region_t){__scratch_y_end__, __StackBottom, __StackTop};
+    regions[1] = (stack_region_t){__scratch_x_end__, __StackOneBottom, __StackOneTop};
+
+    // Só abaixo do quadro atual, com folga para esta função; as interrupções que
+    // rodarem no meio já terão retornado quando a pintura passar por cima delas
+    uint32_t marker;
+    uint32_t *limit = (uint32_t *)((uintptr_t)&marker - 256);
+    for (uint i = 0; i < 2; i++)
+    {
+        uint32_t *end = regions[i].top;
+        if (limit > regions[i].floor && limit < regions[i].top)
+            end = limit;
+        for (uint32_t *p = regions[i].floor; p < end; p++)
+            *p = STACK_PAINT;
+    }
+}
+
+static uint32_t stack_used(const stack_region_t *r)
+{
+    const uint32_t *p = r->floor;
+    while (p < r->top && *p == STACK_PAINT)
+        p++;
+    return (uint32_t)(r->top - p) * sizeof(uint32_t);
+}
+
+void mem_report_get(mem_report_t *out)
+{
+    // O heap também é usado pelo handler do lwIP; a varredura dos blocos é curta
+    uint32_t irq = save_and_disable_interrupts();
+    struct mallinfo mi = mallinfo();
+    restore_interrupts(irq);
+
+    out->data_bytes = (uint32_t)(__data_end__ - __data_start__);
+    out->bss_bytes = (uint32_t)(__bss_end__ - __bss_start__);
+    out->heap_size = (uint32_t)(__HeapLimit - __end__);
+    out->heap_used = (uint32_t)mi.uordblks;
+    out->heap_arena = (uint32_t)mi.arena;
+    if (out->heap_used > heap_used_peak)
+        heap_used_peak = out->heap_used;
+    out->heap_used_peak = heap_used_peak;
+    for (uint i = 0; i < 2; i++)
+    {
+        const stack_region_t *r = &regions[i];
+        out->stacks[i].reserved = (uint32_t)(r->top - r->bottom) * sizeof(uint32_t);
+        out->stacks[i].limit = (uint32_t)(r->top - r->floor) * sizeof(uint32_t);
+        out->stacks[i].used = stack_used(r);
+    }
+}
+
+bool mem_report_sample(void)
+{
+    mem_report_t m;
+    mem_report_get(&m);
+    const uint32_t now[4] = {m.heap_used_peak, m.heap_arena, m.stacks[0].used, m.stacks[1].used};
+    bool rose = false;
+    for (uint i = 0; i < 4; i++)
+    {
+        if (now[i] >= reported[i] + RISE_STEP)
+        {
+            reported[i] = now[i];
+            rose = true;
+        }
+    }
+    return rose;
+}
+
+int mem_report_format_json(char *buf, size_t size)
+{
+    mem_report_t m;
+    mem_report_get(&m);
+    int len = appendf(buf, size, 0,
+                      "{\"static\":{\"data\":%lu,\"bss\":%lu},"
+                      "\"heap\":{\"size\":%lu,\"used\":%lu,\"used_peak\":%lu,\"arena\":%lu},\"stacks\":[",
+                      (unsigned long)m.data_bytes, (unsigned long)m.bss_bytes, (unsigned long)m.heap_size,
+                      (unsigned long)m.heap_used, (unsigned long)m.heap_used_peak, (unsigned long)m.heap_arena);
+    for (uint i = 0; i < 2; i++)
+        len = appendf(buf, size, len, "%s{\"core\":%u,\"reserved\":%lu,\"limit\":%lu,\"used\":%lu}", i ? "," : "",
+                      i, (unsigned long)m.stacks[i].reserved, (unsigned long)m.stacks[i].limit,
+                      (unsigned long)m.stacks[i].used);
+    len = appendf(buf, size, len, "]");
+#if LWIP_STATS && MEM_STATS
+    const struct stats_mem *heap = &lwip_stats.mem;
+    len = appendf(buf, size, len, ",\"lwip_mem\":{\"avail\":%lu,\"used\":%lu,\"max\":%lu,\"err\":%lu}",
+                  (unsigned long)heap->avail, (unsigned long)heap->used, (unsigned long)heap->max,
+                  (unsigned long)heap->err);
+#endif
+#if LWIP_STATS && MEMP_STATS
+    len = appendf(buf, size, len, ",\"lwip_memp\":{");
+    uint emitted = 0;
+    for (uint i = 0; i < MEMP_MAX; i++)
+    {
+        const struct stats_mem *pool = lwip_stats.memp[i];
+        if (!pool)
+            continue;
+        len = appendf(buf, size, len, "%s\"%s\":{\"avail\":%lu,\"used\":%lu,\"max\":%lu,\"err\":%lu}",
+                      emitted++ ? "," : "", MEMP_NAMES[i], (unsigned long)pool->avail,
+                      (unsigned long)pool->used, (unsigned long)pool->max, (unsigned long)pool->err);
+    }
+    len = appendf(buf, size, len, "}");
+#endif
+    return appendf(buf, size, len, "}");
+}
+
+int mem_report_format_text(char *buf, size_t size)
+{
+    mem_report_t m;
+    mem_report_get(&m);
+    int len = appendf(buf, size, 0, "memoria (bytes)\ndata %lu  bss %lu\n", (unsigned long)m.data_bytes,
+                      (unsigned long)m.bss_bytes);
+    len = appendf(buf, size, len, "heap %lu em uso de %lu, pico %lu, arena %lu\n", (unsigned long)m.heap_used,
+                  (unsigned long)m.heap_size, (unsigned long)m.heap_used_peak, (unsigned long)m.heap_arena);
+    for (uint i = 0; i < 2; i++)
+        len = appendf(buf, size, len, "pilha nucleo %u: %lu usados, reserva %lu, limite %lu\n", i,
+                      (unsigned long)m.stacks[i].used, (unsigned long)m.stacks[i].reserved,
+                      (unsigned long)m.stacks[i].limit);
+#if LWIP_STATS && MEM_STATS
+    len = appendf(buf, size, len, "lwip heap %lu em uso de %lu, pico %lu, falhas %lu\n",
+                  (unsigned long)lwip_stats.mem.used, (unsigned long)lwip_stats.mem.avail,
+                  (unsigned long)lwip_stats.mem.max, (unsigned long)lwip_stats.mem.err);
+#endif
+#if LWIP_STATS && MEMP_STATS
+    for (uint i = 0; i < MEMP_MAX; i++)
+    {
+        const struct stats_mem *pool = lwip_stats.memp[i];
+        if (pool)
+            len = appendf(buf, size, len, "lwip %-16s %3lu/%-3lu pico %3lu, falhas %lu\n", MEMP_NAMES[i],
+                          (unsigned long)pool->used, (unsigned long)pool->avail, (unsigned long)pool->max,
+                          (unsigned long)pool->err);
+    }
+#endif
+    return len;
+}
@@ -0,0 +1,43 @@
+#ifndef MEM_REPORT_H
+#define MEM_REPORT_H
+
+#include <stddef.h>
+#include "pico/stdlib.h"
+
+// Orçamento de RAM em tempo de execução: seções estáticas, heap em uso e pico,
+// marca d'água das pilhas dos dois núcleos (padrão pintado no boot) e o heap e
+// os pools do lwIP. O detalhamento estático por módulo sai do mapa do linker
+// a cada build (tools/size_report.py, em Monitoramento.size.txt).
+
+typedef struct
+{
+    uint32_t reserved; // PICO_STACK_SIZE / PICO_CORE1_STACK_SIZE
+    uint32_t limit;    // Até o fim dos dados do banco de scratch, onde a pilha corromperia algo
+    uint32_t used;     // Maior profundidade desde o boot
+} mem_stack_t;
+
+typedef struct
+{
+    uint32_t data_bytes;
+    uint32_t bss_bytes;
+    uint32_t heap_size;      // Do fim do .bss ao fim da RAM
+    uint32_t heap_used;      // Alocado agora
+    uint32_t heap_used_peak; // Maior valor visto por mem_report_sample
+    uint32_t heap_arena;     // Extensão máxima que o heap já tomou (sbrk)
+    mem_stack_t stacks[2];
+} mem_report_t;
+
+// Pinta as pilhas abaixo do ponto atual; chamar no início do main
+void mem_report_init(void);
+
+// Atualiza os picos; retorna true se algum subiu desde a chamada anterior
+bool mem_report_sample(void);
+
+void mem_report_get(mem_report_t *out);
+
+// Relatório completo, com o heap e os pools do lwIP
+int mem_report_format_json(char *buf, size_t size);
+// O mesmo em texto, para o terminal USB
+int mem_report_format_text(char *buf, size_t size);
+
+#endif // MEM_REPORT_H
@@ -0,0 +1,490 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "pico/cyw43_arch.h"
+#include "lwip/tcp.h"
+
+#include "mqtt.h"
+
+#define CONNECT_TIMEOUT_MS 10000
+#define TX_BUFFER_SIZE 1200
+#define RX_BUFFER_SIZE 512
+#define TOPIC_MAX 48
+
+// Tipos de pacote (nibble alto do primeiro byte)
+#define PKT_CONNECT 1
+#define PKT_CONNACK 2
+#define PKT_PUBLISH 3
+#define PKT_PUBACK 4
+#define PKT_SUBSCRIBE 8
+#define PKT_SUBACK 9
+#define PKT_PINGREQ 12
+#define PKT_PINGRESP 13
+
+typedef struct
+{
+    uint32_t ts;
+    float value;
+    uint8_t channel;
+} queued_sample_t;
+
+// Publicação QoS 1 aguardando PUBACK e a faixa da fila que ela leva
+typedef struct
+{
+    uint16_t packet_id;
+    uint32_t start, end;
+} inflight_t;
+
+// Fila circular com índices crescentes: [tail, sent) em trânsito, [sent, head) a enviar
+static queued_sample_t queue[MQTT_QUEUE_CAPACITY];
+static uint32_t q_head = 0, q_tail = 0, q_sent = 0;
+
+static inflight_t inflight[MQTT_MAX_INFLIGHT];
+static uint inflight_count = 0;
+static uint16_t next_packet_id = 1;
+
+static struct tcp_pcb *pcb = NULL;
+static ip_addr_t broker_addr;
+static uint32_t broker_ip = 0;
+static uint16_t broker_port = 0;
+
+static uint32_t device = 0;
+static mqtt_settings_cb_t settings_cb = NULL;
+static char topic_samples[TOPIC_MAX], topic_status[TOPIC_MAX], topic_settings[TOPIC_MAX];
+static char client_id[24];
+
+static mqtt_state_t state = MQTT_DISABLED;
+static uint32_t retry_delay_ms = MQTT_RETRY_MIN_MS;
+static uint32_t next_try_ms = 0;
+static uint32_t connect_started_ms = 0;
+static uint32_t down_since_ms = 0;
+static uint32_t last_tx_ms = 0, last_rx_ms = 0;
+
+static uint8_t tx[TX_BUFFER_SIZE];
+static uint8_t rx[RX_BUFFER_SIZE];
+static uint rx_len = 0;
+
+static mqtt_stats_t stats;
+
+// Tempo de conexão medido no relógio de boot, que também vale nos callbacks do lwIP
+static uint32_t boot_ms(void)
+{
+    return to_ms_since_boot(get_absolute_time());
+}
+
+static uint8_t *put_u16(uint8_t *p, uint16_t v)
+{
+    p[0] = v >> 8;
+    p[1] = v & 0xFF;
+    return p + 2;
+}
+
+static uint8_t *put_str(uint8_t *p, const char *s)
+{
+    size_t len = strlen(s);
+    p = put_u16(p, (uint16_t)len);
+    memcpy(p, s, len);
+    return p + len;
+}
+
+// Monta o cabeçalho fixo logo antes do corpo, que começa em tx + 5, e envia.
+// Sem espaço no buffer do TCP, nada é escrito e a função retorna false.
+static bool send_packet(uint8_t first_byte, const uint8_t *body_end)
+{
+    uint32_t remaining = body_end - (tx + 5);
+    uint8_t header[5];
+    uint header_len = 0;
+    header[header_len++] = first_byte;
+    do
+    {
+        uint8_t digit = remaining % 128;
+        remaining /= 128;
+        header[header_len++] = digit | (remaining ? 0x80 : 0);
+    } while (remaining);
+
+    uint8_t *start = tx + 5 - header_len;
+    memcpy(start, header, header_len);
+    u16_t len = (u16_t)(body_end - start);
+
+    if (!pcb || tcp_sndbuf(pcb) < len)
+        return false;
+    if (tcp_write(pcb, start, len, TCP_WRITE_FLAG_COPY) != ERR_OK)
+        return false;
+    tcp_output(pcb);
+    last_tx_ms = boot_ms();
+    return true;
+}
+
+static void drop_connection(void)
+{
+    if (pcb)
+    {
+        tcp_arg(pcb, NULL);
+        tcp_recv(pcb, NULL);
+        tcp_err(pcb, NULL);
+        tcp_abort(pcb);
+        pcb = NULL;
+    }
+    if (state == MQTT_CONNECTED)
+    {
+        stats.disconnects++;
+        down_since_ms = boot_ms();
+    }
+    // Publicações sem PUBACK voltam para a fila e serão reenviadas; as amostras
+    // delas que a fila cheia já descartou se perdem aqui
+    if (inflight_count && (int32_t)(q_tail - inflight[0].start) > 0)
+        stats.samples_dropped += MIN(q_tail, inflight[inflight_count - 1].end) - inflight[0].start;
+    inflight_count = 0;
+    q_sent = q_tail;
+    rx_len = 0;
+
+    if (state != MQTT_DISABLED)
+    {
+        state = MQTT_IDLE;
+        next_try_ms = boot_ms() + retry_delay_ms;
+        retry_delay_ms = MIN(retry_delay_ms * 2, MQTT_RETRY_MAX_MS);
+    }
+}
+
+static bool send_connect(void)
+{
+    uint8_t *p = tx + 5;
+    p = put_str(p, "MQTT");
+    *p++ = 4;                                 // Protocolo 3.1.1
+    *p++ = 0x02 | 0x04 | 0x20;                // Sessão limpa, will, will retido (QoS 0)
+    p = put_u16(p, MQTT_KEEPALIVE_S);
+    p = put_str(p, client_id);
+    p = put_str(p, topic_status);             // Tópico do will
+    p = put_str(p, "offline");                // Mensagem do will
+    return send_packet(PKT_CONNECT << 4, p);
+}
+
+static bool send_subscribe(void)
+{
+    uint8_t *p = tx + 5;
+    p = put_u16(p, next_packet_id++);
+    p = put_str(p, topic_settings);
+    *p++ = 1; // QoS máximo
+    return send_packet(PKT_SUBSCRIBE << 4 | 0x02, p);
+}
+
+static bool send_status_online(void)
+{
+    uint8_t *p = tx + 5;
+    p = put_str(p, topic_status);
+    memcpy(p, "online", 6);
+    return send_packet(PKT_PUBLISH << 4 | 0x01, p + 6); // QoS 0, retido
+}
+
+static void send_puback(uint16_t packet_id)
+{
+    uint8_t *p = put_u16(tx + 5, packet_id);
+    send_packet(PKT_PUBACK << 4, p);
+}
+
+static void on_puback(uint16_t packet_id)
+{
+    // O broker confirma na ordem de envio; um id fora de ordem confirma também os anteriores
+    for (uint i = 0; i < inflight_count; i++)
+    {
+        if (inflight[i].packet_id != packet_id)
+            continue;
+        // As faixas são contíguas; as amostras que a fila cheia tirou dela já
+        // tinham saído e também contam como entregues
+        uint32_t end = inflight[i].end;
+        stats.samples_acked += end - inflight[0].start;
+        if ((int32_t)(end - q_tail) > 0)
+            q_tail = end;
+        inflight_count -= i + 1;
+        memmove(inflight, inflight + i + 1, inflight_count * sizeof(inflight_t));
+        return;
+    }
+}
+
+static void on_publish(uint8_t flags, const uint8_t *body, uint32_t len)
+{
+    if (len < 2)
+        return;
+    uint16_t topic_len = body[0] << 8 | body[1];
+    uint qos = (flags >> 1) & 3;
+    uint32_t header = 2 + topic_len + (qos ? 2 : 0);
+    if (header > len)
+        return;
+    if (qos)
+        send_puback(body[2 + topic_len] << 8 | body[3 + topic_len]);
+
+    if (topic_len != strlen(topic_settings) || memcmp(body + 2, topic_settings, topic_len) != 0)
+        return;
+
+    // O parser de configurações espera os parâmetros depois de '?' ou '&'
+    char query[RX_BUFFER_SIZE + 2];
+    uint32_t payload_len = len - header;
+    query[0] = '?';
+    memcpy(query + 1, body + header, payload_len);
+    query[1 + payload_len] = '\0';
+    stats.settings_applied++;
+    if (settings_cb)
+        settings_cb(query);
+}
+
+static void handle_packet(uint8_t first_byte, const uint8_t *body, uint32_t len)
+{
+    switch (first_byte >> 4)
+    {
+    case PKT_CONNACK:
+        if (len >= 2 && body[1] == 0)
+        {
+            state = MQTT_CONNECTED;
+            stats.connects++;
+            stats.last_connect_ms = boot_ms() - down_since_ms;
+            retry_delay_ms = MQTT_RETRY_MIN_MS;
+            send_subscribe();
+            send_status_online();
+        }
+        else
+        {
+            drop_connection(); // Recusado (credenciais, id...): tenta de novo mais tarde
+        }
+        break;
+    case PKT_PUBACK:
+        if (len >= 2)
+            on_puback(body[0] << 8 | body[1]);
+        break;
+    case PKT_PUBLISH:
+        on_publish(first_byte & 0x0F, body, len);
+        break;
+    default: // SUBACK, PINGRESP: só contam como sinal de vida
+        break;
+    }
+}
+
+static err_t on_recv(void *arg, struct tcp_pcb *tpcb, struct pbuf *p, err_t err)
+{
+    if (!p)
+    {
+        drop_connection(); // Fechada pelo broker
+        return ERR_ABRT;
+    }
+
+    u16_t total = p->tot_len;
+    if (rx_len + total > RX_BUFFER_SIZE)
+    {
+        pbuf_free(p);
+        drop_connection(); // Pacote maior que o buffer: nada que este cliente espere
+        return ERR_ABRT;
+    }
+    pbuf_copy_partial(p, rx + rx_len, total, 0);
+    rx_len += total;
+    tcp_recved(tpcb, total);
+    pbuf_free(p);
+    last_rx_ms = boot_ms();
+
+    // Processa todos os pacotes completos do buffer
+    while (rx_len >= 2)
+    {
+        uint32_t remaining = 0, multiplier = 1;
+        uint pos = 1;
+        bool complete = false;
+        while (pos < rx_len && pos <= 4)
+        {
+            uint8_t digit = rx[pos++];
+            remaining += (digit & 0x7F) * multiplier;
+            multiplier *= 128;
+            if (!(digit & 0x80))
+            {
+                complete = true;
+                break;
+            }
+        }
+        if (!complete || pos + remaining > rx_len)
+            break;
+
+        handle_packet(rx[0], rx + pos, remaining);
+        if (!pcb)
+            return ERR_ABRT; // CONNACK recusado derrubou a conexão
+        rx_len -= pos + remaining;
+        memmove(rx, rx + pos + remaining, rx_len);
+    }
+    return ERR_OK;
+}
+
+static void on_error(void *arg, err_t err)
+{
+    pcb = NULL; // O lwIP já liberou o pcb
+    drop_connection();
+}
+
+static err_t on_connected(void *arg, struct tcp_pcb *tpcb, err_t err)
+{
+    if (err != ERR_OK || !send_connect())
+    {
+        drop_connection();
+        return ERR_ABRT;
+    }
+    last_rx_ms = boot_ms();
+    return ERR_OK;
+}
+
+void mqtt_init(uint32_t device_id, mqtt_settings_cb_t on_settings)
+{
+    device = device_id;
+    settings_cb = on_settings;
+    snprintf(client_id, sizeof(client_id), "monitor-%08lx", (unsigned long)device);
+    snprintf(topic_samples, sizeof(topic_samples), MQTT_TOPIC_ROOT "/%08lx/samples", (unsigned long)device);
+    snprintf(topic_status, sizeof(topic_status), MQTT_TOPIC_ROOT "/%08lx/status", (unsigned long)device);
+    snprintf(topic_settings, sizeof(topic_settings), MQTT_TOPIC_ROOT "/%08lx/settings/set", (unsigned long)device);
+    down_since_ms = boot_ms();
+}
+
+void mqtt_set_broker(uint32_t ip, uint16_t port)
+{
+    if (ip == broker_ip && port == broker_port)
+        return;
+
+    cyw43_arch_lwip_begin();
+    broker_ip = ip;
+    broker_port = port;
+    IP_ADDR4(&broker_addr, (ip >> 24) & 0xFF, (ip >> 16) & 0xFF, (ip >> 8) & 0xFF, ip & 0xFF);
+    drop_connection();
+    state = port ? MQTT_IDLE : MQTT_DISABLED;
+    retry_delay_ms = MQTT_RETRY_MIN_MS;
+    next_try_ms = boot_ms();
+    down_since_ms = boot_ms();
+    if (!port)
+        q_head = q_tail = q_sent = 0;
+    cyw43_arch_lwip_end();
+}
+
+void mqtt_add_sample(uint8_t channel, uint32_t ts, float value)
+{
+    if (state == MQTT_DISABLED)
+        return;
+
+    cyw43_arch_lwip_begin();
+    if (q_head - q_tail == MQTT_QUEUE_CAPACITY)
+    {
+        // Fila cheia: perde a amostra mais antiga. Se ela já está em trânsito, a
+        // conta fica para o PUBACK (entregue) ou para a queda da conexão (perdida).
+        uint32_t oldest = q_tail++;
+        if ((int32_t)(oldest - q_sent) >= 0)
+        {
+            q_sent = q_tail;
+            stats.samples_dropped++;
+        }
+    }
+    queue[q_head % MQTT_QUEUE_CAPACITY] = (queued_sample_t){ts, value, channel};
+    q_head++;
+    cyw43_arch_lwip_end();
+}
+
+// Publica o próximo lote da fila; false se a janela ou o buffer do TCP estiverem cheios
+static bool publish_batch(void)
+{
+    if (MQTT_QOS > 0 && inflight_count == MQTT_MAX_INFLIGHT)
+        return false;
+
+    uint8_t *p = tx + 5;
+    p = put_str(p, topic_samples);
+    uint16_t packet_id = next_packet_id;
+    if (MQTT_QOS > 0)
+        p = put_u16(p, packet_id);
+
+    char *json = (char *)p;
+    char *json_end = (char *)tx + TX_BUFFER_SIZE;
+    int n = snprintf(json, json_end - json, "{\"dev\":\"%08lx\",\"samples\":[", (unsigned long)device);
+    uint32_t end = q_sent;
+    while (end != q_head && end - q_sent < MQTT_BATCH_SAMPLES)
+    {
+        const queued_sample_t *s = &queue[end % MQTT_QUEUE_CAPACITY];
+        char item[40];
+        int len = snprintf(item, sizeof(item), "%s[%u,%lu,%.2f]", end != q_sent ? "," : "",
+                           s->channel, (unsigned long)s->ts, s->value);
+        if (json + n + len + 2 >= json_end)
+            break;
+        memcpy(json + n, item, len);
+        n += len;
+        end++;
+    }
+    memcpy(json + n, "]}", 2);
+    p = (uint8_t *)json + n + 2;
+
+    if (!send_packet(PKT_PUBLISH << 4 | MQTT_QOS << 1, p))
+        return false;
+
+    stats.publishes++;
+    if (MQTT_QOS > 0)
+    {
+        next_packet_id = next_packet_id == 0xFFFF ? 1 : next_packet_id + 1;
+        inflight[inflight_count++] = (inflight_t){packet_id, q_sent, end};
+    }
+    else
+    {
+        stats.samples_acked += end - q_tail;
+        q_tail = end;
+    }
+    q_sent = end;
+    return true;
+}
+
+void mqtt_task(uint32_t now_ms)
+{
+    cyw43_arch_lwip_begin();
+    uint32_t now = boot_ms();
+
+    switch (state)
+    {
+    case MQTT_IDLE:
+        if ((int32_t)(now - next_try_ms) < 0)
+            break;
+        pcb = tcp_new();
+        if (!pcb)
+        {
+            drop_connection();
+            break;
+        }
+        tcp_arg(pcb, NULL);
+        tcp_recv(pcb, on_recv);
+        tcp_err(pcb, on_error);
+        state = MQTT_CONNECTING;
+        connect_started_ms = now;
+        if (tcp_connect(pcb, &broker_addr, broker_port, on_connected) != ERR_OK)
+            drop_connection();
+        break;
+
+    case MQTT_CONNECTING:
+        if (now - connect_started_ms >= CONNECT_TIMEOUT_MS)
+            drop_connection();
+        break;
+
+    case MQTT_CONNECTED:
+        if (now - last_rx_ms >= MQTT_KEEPALIVE_S * 1500)
+        {
+            drop_connection(); // Nem PINGRESP em 1,5 keepalive: conexão morta
+            break;
+        }
+        // Lotes cheios saem enquanto houver janela; um lote incompleto espera MQTT_BATCH_MS
+        while (q_sent != q_head)
+        {
+            bool full = q_head - q_sent >= MQTT_BATCH_SAMPLES;
+            bool old = (int32_t)(now_ms - queue[q_sent % MQTT_QUEUE_CAPACITY].ts) >= MQTT_BATCH_MS;
+            if ((!full && !old) || !publish_batch())
+                break;
+        }
+        if (now - last_tx_ms >= MQTT_KEEPALIVE_S * 500)
+            send_packet(PKT_PINGREQ << 4, tx + 5);
+        break;
+
+    case MQTT_DISABLED:
+        break;
+    }
+    cyw43_arch_lwip_end();
+}
+
+void mqtt_get_stats(mqtt_stats_t *out)
+{
+    cyw43_arch_lwip_begin();
+    *out = stats;
+    out->state = state;
+    out->queued = q_head - q_tail;
+    cyw43_arch_lwip_end();
+}
@@ -0,0 +1,64 @@
+#ifndef MQTT_H
+#define MQTT_H
+
+#include "pico/stdlib.h"
+
+// Cliente MQTT 3.1.1 mínimo sobre a API raw TCP do lwIP: publica as amostras
+// em lotes e recebe ajustes de configuração. Tópicos, com <id> em hexadecimal:
+//   monitor/<id>/samples       {"dev":"<id>","samples":[[canal,ts,valor],...]}
+//   monitor/<id>/status        "online" (retido); o will publica "offline"
+//   monitor/<id>/settings/set  query string, como em /set_settings
+#define MQTT_TOPIC_ROOT "monitor"
+
+#define MQTT_QOS 1             // 0 ou 1 nas publicações de amostras
+#define MQTT_KEEPALIVE_S 60
+#define MQTT_BATCH_SAMPLES 32  // Amostras por publicação
+#define MQTT_BATCH_MS 2000     // Espera máxima de um lote incompleto
+#define MQTT_MAX_INFLIGHT 4    // Publicações QoS 1 aguardando PUBACK
+
+// Amostras guardadas enquanto o broker está fora; cheia, a fila descarta as mais antigas
+#define MQTT_QUEUE_CAPACITY 1024
+
+// Espera entre tentativas de conexão: dobra a cada falha, até o máximo
+#define MQTT_RETRY_MIN_MS 1000
+#define MQTT_RETRY_MAX_MS 60000
+
+typedef enum
+{
+    MQTT_DISABLED,
+    MQTT_IDLE,       // Aguardando a próxima tentativa
+    MQTT_CONNECTING, // TCP em andamento ou aguardando CONNACK
+    MQTT_CONNECTED
+} mqtt_state_t;
+
+typedef struct
+{
+    mqtt_state_t state;
+    uint32_t connects;
+    uint32_t disconnects;
+    uint32_t publishes;        // PUBLISH de amostras enviados, incluindo reenvios
+    uint32_t samples_acked;    // Amostras confirmadas (QoS 1) ou entregues ao TCP (QoS 0)
+    uint32_t samples_dropped;  // Descartadas com a fila cheia sem chegar ao broker
+    uint32_t queued;           // Amostras na fila agora, incluindo as em trânsito
+    uint32_t settings_applied; // Mensagens recebidas em settings/set
+    uint32_t last_connect_ms;  // Da queda (ou da primeira tentativa) até o CONNACK
+} mqtt_stats_t;
+
+// Callback chamado no contexto do lwIP com o texto recebido em settings/set
+typedef void (*mqtt_settings_cb_t)(const char *query);
+
+void mqtt_init(uint32_t device_id, mqtt_settings_cb_t on_settings);
+
+// Porta 0 desativa; uma mudança de broker derruba a conexão atual
+void mqtt_set_broker(uint32_t ip, uint16_t port);
+
+// Enfileira uma amostra para o próximo lote
+void mqtt_add_sample(uint8_t channel, uint32_t ts, float value);
+
+// Chamada no laço principal: conexão, keepalive e escoamento da fila com
+// contrapressão (janela de PUBACKs e espaço no buffer de envio do TCP)
+void mqtt_task(uint32_t now_ms);
+
+void mqtt_get_stats(mqtt_stats_t *stats);
+
+#endif // MQTT_H
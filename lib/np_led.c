@@ -1,16 +1,61 @@
+#include <math.h>
+#include <string.h>
+
 #include "np_led.h"
 #include "ws2818b.pio.h"
+#include "hardware/dma.h"
+#include "hardware/sync.h"
+#include "perf.h"
 
 npLED_t leds[LED_COUNT]; // Buffer de LEDs
 PIO np_pio;
 uint sm;
 
-int SORRISO_NORMAL[5][5][3] = {
-    {{0, 0, 0}, {0, 0, 0}, {0, 0, 0}, {0, 0, 0}, {0, 0, 0}},
-    {{0, 0, 0}, {0, 12, 0}, {0, 0, 0}, {0, 12, 0}, {0, 0, 0}},
-    {{0, 0, 0}, {0, 0, 0}, {0, 0, 0}, {0, 0, 0}, {0, 0, 0}},
-    {{0, 12, 0}, {0, 0, 0}, {0, 0, 0}, {0, 0, 0}, {0, 12, 0}},
-    {{0, 0, 0}, {0, 12, 0}, {0, 12, 0}, {0, 12, 0}, {0, 0, 0}}};
+// Quadros já no formato do PIO (GRB << 8). O DMA lê um enquanto npWrite preenche o outro.
+static uint32_t frames[2][LED_COUNT];
+static uint front = 0;            // Quadro em envio (ou o último enviado)
+static int dma_chan = -1;
+static volatile bool busy = false;          // Envio ou latch em andamento
+static volatile bool frame_pending = false; // Quadro de trás pronto esperando o latch
+static bool latch_armed = false;            // Alarme do fim do latch agendado
+static uint64_t latch_until_us;             // Fim do quadro em envio mais o latch
+static np_stats_t stats;
+
+// Posição na fita de cada (linha, coluna): a fita corre em zigue-zague a partir
+// do canto inferior direito
+#define NP_INDEX_OF(x, y) ((y) % 2 == 0 ? 24 - ((y) * 5 + (x)) : 24 - ((y) * 5 + (4 - (x))))
+#define NP_INDEX_ROW(y) {NP_INDEX_OF(0, y), NP_INDEX_OF(1, y), NP_INDEX_OF(2, y), NP_INDEX_OF(3, y), NP_INDEX_OF(4, y)}
+static const uint8_t NP_INDEX[5][5] = {NP_INDEX_ROW(0), NP_INDEX_ROW(1), NP_INDEX_ROW(2), NP_INDEX_ROW(3), NP_INDEX_ROW(4)};
+
+static const npLED_t NP_PALETTE[NP_PALETTE_SIZE] = {
+    [NP_OFF] = {0, 0, 0},
+    [NP_WHITE] = {.R = 64, .G = 64, .B = 64},
+    [NP_GREEN] = {.R = 0, .G = 64, .B = 0},
+    [NP_RED] = {.R = 255, .G = 0, .B = 0},
+    [NP_ORANGE] = {.R = 255, .G = 110, .B = 0},
+};
+
+// Valor de saída para cada nível de cor: gama e brilho global em uma consulta
+static uint8_t output_lut[256];
+
+// Estado da animação, trocado pelo laço principal com interrupções desabilitadas
+typedef struct
+{
+    np_anim_t anim;
+    bool scrolling;
+    uint8_t count;
+    np_glyph_t glyphs[NP_SCROLL_MAX];
+    np_color_t colors[NP_SCROLL_MAX];
+    uint32_t started_ms;
+    bool dirty;
+} np_scene_t;
+
+static np_scene_t scene;
+static repeating_timer_t anim_timer;
+static bool anim_running = false;
+
+static bool anim_tick(repeating_timer_t *t);
+static void schedule_anim(void);
 
 /**
  * Inicializa a máquina PIO para controle da matriz de LEDs.
@@ -29,10 +74,45 @@ void npInit(uint pin)
 
     ws2818b_program_init(np_pio, sm, offset, pin, 800000.f);
 
+    // DMA de palavras de 32 bits do quadro para o FIFO do PIO, no ritmo do DREQ
+    dma_chan = dma_claim_unused_channel(true);
+    dma_channel_config c = dma_channel_get_default_config(dma_chan);
+    channel_config_set_transfer_data_size(&c, DMA_SIZE_32);
+    channel_config_set_read_increment(&c, true);
+    channel_config_set_write_increment(&c, false);
+    channel_config_set_dreq(&c, pio_get_dreq(np_pio, sm, true));
+    dma_channel_configure(dma_chan, &c, &np_pio->txf[sm], NULL, LED_COUNT, false);
+
     for (uint i = 0; i < LED_COUNT; ++i)
     {
         leds[i].R = leds[i].G = leds[i].B = 0;
     }
+    npSetBrightness(255);
+}
+
+static void start_frame(void);
+
+// Fim do quadro mais latch: libera a saída e envia o quadro que ficou pendente
+static int64_t latch_done(alarm_id_t id, void *user_data)
+{
+    busy = false;
+    if (frame_pending)
+        start_frame();
+    return 0;
+}
+
+// Chamada com interrupções desabilitadas ou do próprio alarme
+static void start_frame(void)
+{
+    front ^= 1;
+    frame_pending = false;
+    busy = true;
+    dma_channel_transfer_from_buffer_now(dma_chan, frames[front], LED_COUNT);
+    // Margem de 20 us para o FIFO do PIO esvaziar depois do último DREQ. Sem
+    // alarme livre, busy continua até um npWrite ver o DMA parado e o latch cumprido
+    latch_until_us = time_us_64() + NP_FRAME_US + NP_LATCH_US + 20;
+    latch_armed = add_alarm_in_us(NP_FRAME_US + NP_LATCH_US + 20, latch_done, NULL, true) >= 0;
+    stats.frames_sent++;
 }
 
 /**
@@ -64,174 +144,174 @@ void npClear()
  */
 void npWrite()
 {
+    PERF_BEGIN(MATRIX);
+    uint32_t irq = save_and_disable_interrupts();
+
+    // O quadro de trás é o que não está no DMA; sobrescrevê-lo agrupa as atualizações
+    uint32_t *back = frames[front ^ 1];
     for (uint i = 0; i < LED_COUNT; ++i)
     {
-        pio_sm_put_blocking(np_pio, sm, leds[i].G);
-        pio_sm_put_blocking(np_pio, sm, leds[i].R);
-        pio_sm_put_blocking(np_pio, sm, leds[i].B);
+        back[i] = ((uint32_t)output_lut[leds[i].G] << 24) | ((uint32_t)output_lut[leds[i].R] << 16) |
+                  ((uint32_t)output_lut[leds[i].B] << 8);
     }
-    sleep_us(100); // Espera 100us, sinal de RESET do datasheet.
+    if (frame_pending)
+        stats.frames_coalesced++;
+    frame_pending = true;
+    if (busy && !latch_armed && !dma_channel_is_busy(dma_chan) && time_us_64() >= latch_until_us)
+        busy = false;
+    if (!busy)
+        start_frame();
+
+    restore_interrupts(irq);
+    PERF_END(MATRIX);
 }
 
-/**
- * Aplica um fator de escala para brilho na matriz.
- */
-void applyBrightnessToMatrix(int matriz[5][5][3], float scale)
+void npGetStats(np_stats_t *out)
 {
-    for (int linha = 0; linha < 5; linha++)
+    *out = stats;
+}
+
+void npSetBrightness(uint8_t brightness)
+{
+    uint8_t lut[256];
+    for (uint i = 0; i < 256; i++)
     {
-        for (int coluna = 0; coluna < 5; coluna++)
-        {
-            matriz[linha][coluna][0] = (uint8_t)(matriz[linha][coluna][0] * scale);
-            matriz[linha][coluna][1] = (uint8_t)(matriz[linha][coluna][1] * scale);
-            matriz[linha][coluna][2] = (uint8_t)(matriz[linha][coluna][2] * scale);
-        }
+        lut[i] = (uint8_t)lroundf(powf(i / 255.0f, NP_GAMMA) * brightness);
     }
+    uint32_t irq = save_and_disable_interrupts();
+    memcpy(output_lut, lut, sizeof(output_lut));
+    scene.dirty = true;
+    restore_interrupts(irq);
+    schedule_anim();
 }
 
-/**
- * Converte uma posição na matriz para índice no vetor de LEDs.
- */
-int getIndex(int x, int y)
+void npShowGlyph(np_glyph_t glyph, np_color_t color, np_anim_t anim)
 {
-    return (y % 2 == 0) ? 24 - (y * 5 + x) : 24 - (y * 5 + (4 - x));
+    uint32_t irq = save_and_disable_interrupts();
+    scene.anim = anim;
+    scene.scrolling = false;
+    scene.count = 1;
+    scene.glyphs[0] = glyph;
+    scene.colors[0] = color;
+    scene.started_ms = to_ms_since_boot(get_absolute_time());
+    scene.dirty = true;
+    restore_interrupts(irq);
+    schedule_anim();
 }
 
-/**
- * Atualiza a matriz com base em uma configuração de cores.
- */
-void updateMatrix(int matriz[5][5][3])
+void npScroll(const np_glyph_t *glyphs, const np_color_t *colors, uint count)
 {
-    for (int linha = 0; linha < 5; linha++)
-    {
-        for (int coluna = 0; coluna < 5; coluna++)
-        {
-            int posicao = getIndex(coluna, linha);
-            npSetLED(posicao, matriz[linha][coluna][0], matriz[linha][coluna][1], matriz[linha][coluna][2]);
-        }
-    }
-    npWrite();
+    if (count > NP_SCROLL_MAX)
+        count = NP_SCROLL_MAX;
+
+    uint32_t irq = save_and_disable_interrupts();
+    scene.anim = NP_ANIM_STATIC;
+    scene.scrolling = count > 0;
+    scene.count = (uint8_t)count;
+    memcpy(scene.glyphs, glyphs, count * sizeof(np_glyph_t));
+    memcpy(scene.colors, colors, count * sizeof(np_color_t));
+    scene.started_ms = to_ms_since_boot(get_absolute_time());
+    scene.dirty = true;
+    restore_interrupts(irq);
+    schedule_anim();
 }
 
-/**
- * Escreve a letra T na matriz de LEDs
- * @param color Cor RGB no formato [R, G, B] (opcional, branco por padrão)
- */
-void drawT(uint8_t color[3])
+static bool glyph_pixel(np_glyph_t glyph, uint x, uint y)
 {
-    int matriz[5][5][3] = {0};
-
-    // Padrão da letra T
-    for (int col = 0; col < 5; col++)
-    {
-        matriz[0][col][0] = color ? color[0] : 12; // R
-        matriz[0][col][1] = color ? color[1] : 12; // G
-        matriz[0][col][2] = color ? color[2] : 12; // B
-    }
-    for (int row = 1; row < 5; row++)
-    {
-        matriz[row][2][0] = color ? color[0] : 12; // R
-        matriz[row][2][1] = color ? color[1] : 12; // G
-        matriz[row][2][2] = color ? color[2] : 12; // B
-    }
+    return (glyph >> ((4 - y) * 5 + (4 - x))) & 1;
+}
 
-    updateMatrix(matriz);
+// Acende um LED com a cor da paleta escalada por level (0 a 255)
+static void set_pixel(uint x, uint y, np_color_t color, uint level)
+{
+    const npLED_t *c = &NP_PALETTE[color];
+    npLED_t *led = &leds[NP_INDEX[y][x]];
+    led->R = (uint8_t)(c->R * level / 255);
+    led->G = (uint8_t)(c->G * level / 255);
+    led->B = (uint8_t)(c->B * level / 255);
 }
 
-/**
- * Escreve a letra P na matriz de LEDs
- * @param color Cor RGB no formato [R, G, B] (opcional, branco por padrão)
- */
-void drawP(uint8_t color[3])
+static void render_glyph(np_glyph_t glyph, np_color_t color, uint level)
 {
-    int matriz[5][5][3] = {0};
+    for (uint y = 0; y < 5; y++)
+        for (uint x = 0; x < 5; x++)
+            set_pixel(x, y, glyph_pixel(glyph, x, y) ? color : NP_OFF, level);
+}
 
-    // Padrão da letra P
-    for (int row = 0; row < 5; row++)
-    {
-        matriz[row][0][0] = color ? color[0] : 12; // R
-        matriz[row][0][1] = color ? color[1] : 12; // G
-        matriz[row][0][2] = color ? color[2] : 12; // B
-    }
-    for (int col = 1; col < 4; col++)
+// Texto rolante: cada glifo ocupa 5 colunas mais uma de espaço, e a faixa volta ao início
+static void render_scroll(uint32_t step)
+{
+    uint width = scene.count * 6;
+    for (uint x = 0; x < 5; x++)
     {
-        matriz[0][col][0] = color ? color[0] : 12;
-        matriz[0][col][1] = color ? color[1] : 12;
-        matriz[0][col][2] = color ? color[2] : 12;
-        matriz[2][col][0] = color ? color[0] : 12;
-        matriz[2][col][1] = color ? color[1] : 12;
-        matriz[2][col][2] = color ? color[2] : 12;
+        uint col = (step + x) % width;
+        uint g = col / 6;
+        for (uint y = 0; y < 5; y++)
+        {
+            bool on = col % 6 < 5 && glyph_pixel(scene.glyphs[g], col % 6, y);
+            set_pixel(x, y, on ? scene.colors[g] : NP_OFF, 255);
+        }
     }
-    matriz[1][4][0] = color ? color[0] : 12;
-    matriz[1][4][1] = color ? color[1] : 12;
-    matriz[1][4][2] = color ? color[2] : 12;
-
-    updateMatrix(matriz);
 }
 
-/**
- * Escreve a letra A na matriz de LEDs
- * @param color Cor RGB no formato [R, G, B] (opcional, branco por padrão)
- */
-void drawA(uint8_t color[3])
+// Tick das animações, no contexto do alarme de hardware: só redesenha quando o quadro muda
+static bool anim_tick(repeating_timer_t *t)
 {
-    int matriz[5][5][3] = {0};
+    static uint32_t last_key = UINT32_MAX;
 
-    // Padrão da letra A
-    for (int row = 0; row < 5; row++)
+    uint32_t elapsed = to_ms_since_boot(get_absolute_time()) - scene.started_ms;
+    // Chave do quadro atual: passo da rolagem, fase do pisca ou nível do pulso
+    uint32_t key = 0;
+    uint level = 255;
+    if (scene.scrolling)
     {
-        matriz[row][0][0] = color ? color[0] : 12; // R
-        matriz[row][0][1] = color ? color[1] : 12; // G
-        matriz[row][0][2] = color ? color[2] : 12; // B
-        matriz[row][4][0] = color ? color[0] : 12;
-        matriz[row][4][1] = color ? color[1] : 12;
-        matriz[row][4][2] = color ? color[2] : 12;
+        key = elapsed / NP_SCROLL_STEP_MS;
     }
-    for (int col = 1; col < 4; col++)
+    else if (scene.anim == NP_ANIM_BLINK)
     {
-        matriz[0][col][0] = color ? color[0] : 12;
-        matriz[0][col][1] = color ? color[1] : 12;
-        matriz[0][col][2] = color ? color[2] : 12;
-        matriz[2][col][0] = color ? color[0] : 12;
-        matriz[2][col][1] = color ? color[1] : 12;
-        matriz[2][col][2] = color ? color[2] : 12;
+        key = (elapsed / NP_BLINK_MS) % 2;
+        level = key ? 0 : 255;
+    }
+    else if (scene.anim == NP_ANIM_PULSE)
+    {
+        // Rampa triangular entre 1/8 e o brilho cheio
+        uint32_t phase = elapsed % NP_PULSE_MS;
+        uint32_t half = NP_PULSE_MS / 2;
+        uint32_t ramp = phase < half ? phase : NP_PULSE_MS - phase;
+        level = 32 + ramp * (255 - 32) / half;
+        key = level;
     }
 
-    updateMatrix(matriz);
+    if (!scene.dirty && key == last_key)
+        return true;
+    scene.dirty = false;
+    last_key = key;
+
+    if (scene.scrolling)
+        render_scroll(key);
+    else if (scene.count > 0)
+        render_glyph(scene.glyphs[0], scene.colors[0], level);
+    else
+        npClear();
+    npWrite();
+    return true;
 }
 
-/**
- * Escreve a letra U na matriz de LEDs
- * @param color Cor RGB no formato [R, G, B] (opcional, branco por padrão)
- */
-void drawU(uint8_t color[3])
+// O tick só roda enquanto a cena anima, para não acordar o núcleo a cada
+// NP_ANIM_TICK_MS com a matriz parada; uma cena estática é desenhada uma vez
+static void schedule_anim(void)
 {
-    int matriz[5][5][3] = {0};
-
-    // Padrão da letra U
-    for (int row = 0; row < 4; row++)
+    bool animated = scene.scrolling || scene.anim != NP_ANIM_STATIC;
+    if (animated && !anim_running)
     {
-        matriz[row][0][0] = color ? color[0] : 12; // R
-        matriz[row][0][1] = color ? color[1] : 12; // G
-        matriz[row][0][2] = color ? color[2] : 12; // B
-        matriz[row][4][0] = color ? color[0] : 12;
-        matriz[row][4][1] = color ? color[1] : 12;
-        matriz[row][4][2] = color ? color[2] : 12;
+        // Intervalo negativo: o período conta do início de um tick ao do seguinte
+        anim_running = add_repeating_timer_ms(-NP_ANIM_TICK_MS, anim_tick, NULL, &anim_timer);
     }
-    for (int col = 1; col < 4; col++)
+    else if (!animated && anim_running)
     {
-        matriz[4][col][0] = color ? color[0] : 12;
-        matriz[4][col][1] = color ? color[1] : 12;
-        matriz[4][col][2] = color ? color[2] : 12;
+        cancel_repeating_timer(&anim_timer);
+        anim_running = false;
     }
-
-    updateMatrix(matriz);
+    if (!anim_running)
+        anim_tick(NULL);
 }
-
-/**
- * Desenha um sorriso normal na matriz de LEDs :)
- */
-void drawSorrisoNormal()
-{
-    updateMatrix(SORRISO_NORMAL);
-}
\ No newline at end of file
@@ -20,18 +20,73 @@ extern npLED_t leds[LED_COUNT];
 extern PIO np_pio;
 extern uint sm;
 
+// Tempo de um quadro no fio (24 bits a 800 kHz por LED) e pausa de reset/latch.
+// O WS2812B mais novo exige pelo menos 280 us de nível baixo.
+#define NP_FRAME_US (LED_COUNT * 30)
+#define NP_LATCH_US 300
+
+typedef struct
+{
+    uint32_t frames_sent;
+    uint32_t frames_coalesced; // Quadros substituídos por um mais novo antes do envio
+} np_stats_t;
+
+// Glifo 5x5 como máscara de 25 bits: cada argumento é uma linha, de cima para
+// baixo, com o bit 4 na coluna da esquerda (0b10001 acende as duas bordas)
+typedef uint32_t np_glyph_t;
+#define NP_GLYPH(l0, l1, l2, l3, l4) \
+    ((np_glyph_t)(l0) << 20 | (np_glyph_t)(l1) << 15 | (np_glyph_t)(l2) << 10 | (np_glyph_t)(l3) << 5 | (np_glyph_t)(l4))
+
+#define NP_GLYPH_T NP_GLYPH(0b11111, 0b00100, 0b00100, 0b00100, 0b00100)
+#define NP_GLYPH_P NP_GLYPH(0b11110, 0b10001, 0b11110, 0b10000, 0b10000)
+#define NP_GLYPH_A NP_GLYPH(0b11111, 0b10001, 0b11111, 0b10001, 0b10001)
+#define NP_GLYPH_U NP_GLYPH(0b10001, 0b10001, 0b10001, 0b10001, 0b01110)
+#define NP_GLYPH_SMILE NP_GLYPH(0b00000, 0b01010, 0b00000, 0b10001, 0b01110)
+
+// Cores em escala perceptiva; gama e brilho global são aplicados só na saída
+typedef enum
+{
+    NP_OFF,
+    NP_WHITE,
+    NP_GREEN,
+    NP_RED,
+    NP_ORANGE,
+    NP_PALETTE_SIZE
+} np_color_t;
+
+typedef enum
+{
+    NP_ANIM_STATIC,
+    NP_ANIM_BLINK, // Acende e apaga a cada NP_BLINK_MS
+    NP_ANIM_PULSE  // Brilho em rampa, período NP_PULSE_MS
+} np_anim_t;
+
+// As animações rodam em um timer repetitivo, fora do laço principal
+#define NP_ANIM_TICK_MS 20
+#define NP_BLINK_MS 500
+#define NP_PULSE_MS 2000
+#define NP_SCROLL_STEP_MS 150
+#define NP_SCROLL_MAX 16 // Glifos em um texto rolante
+
+#define NP_GAMMA 2.2f
+
 // Prototipação das funções
 void npInit(uint pin);
 void npSetLED(const uint index, const uint8_t r, const uint8_t g, const uint8_t b);
 void npClear();
+// Agenda o envio do buffer e retorna na hora: o quadro vai por DMA e o fim
+// do latch é marcado por um alarme. Chamadas mais rápidas que um quadro mais
+// latch são agrupadas e só o conteúdo mais recente é enviado.
 void npWrite();
-int getIndex(int x, int y);
-void updateMatrix(int matriz[5][5][3]);
-void applyBrightnessToMatrix(int matriz[5][5][3], float scale);
-void drawU(uint8_t color[3]);
-void drawA(uint8_t color[3]);
-void drawT(uint8_t color[3]);
-void drawP(uint8_t color[3]);
-void drawSorrisoNormal();
+void npGetStats(np_stats_t *stats);
+
+// Brilho global (0 a 255), aplicado junto com a correção de gama ao empacotar o quadro
+void npSetBrightness(uint8_t brightness);
+
+// Mostra um glifo, parado ou animado, a partir do próximo tick do timer
+void npShowGlyph(np_glyph_t glyph, np_color_t color, np_anim_t anim);
+
+// Rola os glifos da direita para a esquerda, em laço, cada um com a sua cor
+void npScroll(const np_glyph_t *glyphs, const np_color_t *colors, uint count);
 
 #endif // NP_LED_H
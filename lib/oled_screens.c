@@ -0,0 +1,251 @@
+#include <math.h>
+#include <stdio.h>
+
+#include "oled_screens.h"
+#include "sensors.h"
+
+#define PLOT_TOP (OLED_TREND_FIRST_PAGE * 8)
+#define PLOT_BOTTOM (HEIGHT - 1)
+
+// Anel de médias por coluna de um canal
+typedef struct
+{
+    float values[OLED_TREND_COLUMNS]; // NAN: intervalo sem amostras
+    uint16_t head;                    // Próxima posição de escrita
+    uint16_t len;
+    uint32_t total;                   // Colunas fechadas desde o boot
+    // Coluna em formação
+    uint32_t col_start;
+    float sum;
+    uint16_t count;
+} trend_t;
+
+static trend_t trends[OLED_TREND_CHANNELS];
+
+static ssd1306_t *oled;
+static int screen = 0; // 0: status; n > 0: tendência do canal n - 1
+static bool auto_cycle_started = false;
+static uint32_t next_cycle_ms;
+
+// O que está desenhado na área do gráfico
+static int drawn_screen = -1;
+static uint32_t drawn_total;
+static float scale_lo, scale_hi;
+static int last_y = -1;
+
+static void push_column(trend_t *t, float value)
+{
+    t->values[t->head] = value;
+    t->head = (t->head + 1) % OLED_TREND_COLUMNS;
+    if (t->len < OLED_TREND_COLUMNS)
+        t->len++;
+    t->total++;
+}
+
+void oled_screens_init(ssd1306_t *ssd)
+{
+    oled = ssd;
+    for (uint i = 0; i < OLED_TREND_CHANNELS; i++)
+        trends[i] = (trend_t){0};
+}
+
+void oled_screens_add_sample(uint8_t channel, uint32_t ts, float value)
+{
+    if (channel >= OLED_TREND_CHANNELS || isnan(value))
+        return;
+
+    trend_t *t = &trends[channel];
+    uint32_t start = ts - ts % OLED_TREND_COLUMN_MS;
+    if (t->count > 0 && start != t->col_start)
+    {
+        push_column(t, t->sum / t->count);
+        // Intervalos sem amostras viram colunas vazias, para o eixo de tempo continuar regular
+        uint32_t gaps = (start - t->col_start) / OLED_TREND_COLUMN_MS - 1;
+        for (uint32_t g = 0; g < gaps && g < OLED_TREND_COLUMNS; g++)
+            push_column(t, NAN);
+        t->count = 0;
+    }
+    if (t->count == 0)
+    {
+        t->col_start = start;
+        t->sum = 0.0f;
+    }
+    t->sum += value;
+    t->count++;
+}
+
+static uint screen_count(void)
+{
+    uint channels = sensors_channel_count();
+    return 1 + (channels < OLED_TREND_CHANNELS ? channels : OLED_TREND_CHANNELS);
+}
+
+void oled_screens_next(void)
+{
+    screen = (screen + 1) % (int)screen_count();
+    // Troca manual: a próxima troca automática conta a partir de agora
+    auto_cycle_started = false;
+}
+
+static float trend_value(const trend_t *t, uint i)
+{
+    return t->values[(t->head + OLED_TREND_COLUMNS - t->len + i) % OLED_TREND_COLUMNS];
+}
+
+// Escala vertical com 10% de margem e uma faixa mínima, para o ruído não ocupar a tela toda
+static bool compute_scale(const trend_t *t, float *lo, float *hi)
+{
+    bool any = false;
+    for (uint i = 0; i < t->len; i++)
+    {
+        float v = trend_value(t, i);
+        if (isnan(v))
+            continue;
+        if (!any || v < *lo)
+            *lo = v;
+        if (!any || v > *hi)
+            *hi = v;
+        any = true;
+    }
+    if (!any)
+        return false;
+
+    float span = *hi - *lo;
+    if (span < 0.2f)
+    {
+        float mid = (*hi + *lo) / 2;
+        *lo = mid - 0.1f;
+        *hi = mid + 0.1f;
+        span = 0.2f;
+    }
+    *lo -= span * 0.1f;
+    *hi += span * 0.1f;
+    return true;
+}
+
+static int value_to_y(float v)
+{
+    float frac = (v - scale_lo) / (scale_hi - scale_lo);
+    return PLOT_BOTTOM - (int)lroundf(frac * (PLOT_BOTTOM - PLOT_TOP));
+}
+
+// Desenha uma coluna do gráfico, ligada verticalmente à coluna anterior
+static void draw_column(uint8_t x, float v)
+{
+    ssd1306_vline(oled, x, PLOT_TOP, PLOT_BOTTOM, false);
+    if (isnan(v))
+    {
+        last_y = -1;
+        return;
+    }
+    int y = value_to_y(v);
+    int from = (last_y < 0) ? y : last_y;
+    ssd1306_vline(oled, x, MIN(y, from), MAX(y, from), true);
+    last_y = y;
+}
+
+static void redraw_plot(const trend_t *t)
+{
+    ssd1306_rect(oled, PLOT_TOP, 0, OLED_TREND_COLUMNS, PLOT_BOTTOM - PLOT_TOP + 1, false, true);
+    last_y = -1;
+    uint first_x = OLED_TREND_COLUMNS - t->len;
+    for (uint i = 0; i < t->len; i++)
+        draw_column(first_x + i, trend_value(t, i));
+}
+
+static void render_trend(uint8_t channel, bool entered)
+{
+    const trend_t *t = &trends[channel];
+    const sensor_channel_t *ch = sensors_channel(channel);
+
+    // Gráfico: colunas novas entram pela direita deslocando o resto; só é
+    // redesenhado inteiro ao entrar na tela ou quando um valor sai da escala
+    uint32_t fresh = t->total - drawn_total;
+    bool full = entered || fresh >= OLED_TREND_COLUMNS;
+    for (uint32_t i = 0; i < fresh && !full; i++)
+    {
+        float v = trend_value(t, t->len - fresh + i);
+        if (!isnan(v) && (v < scale_lo || v > scale_hi))
+            full = true;
+    }
+
+    if (full)
+    {
+        if (!compute_scale(t, &scale_lo, &scale_hi))
+        {
+            scale_lo = 0.0f;
+            scale_hi = 1.0f;
+        }
+        redraw_plot(t);
+    }
+    else
+    {
+        for (uint32_t i = 0; i < fresh; i++)
+        {
+            ssd1306_shift_left(oled, OLED_TREND_FIRST_PAGE, oled->pages - 1);
+            draw_column(OLED_TREND_COLUMNS - 1, trend_value(t, t->len - fresh + i));
+        }
+    }
+    drawn_total = t->total;
+
+    // Texto: grandeza, valor atual e escala do gráfico
+    char line[20];
+    ssd1306_rect(oled, 0, 0, oled->width, PLOT_TOP, false, true);
+    if (ch->valid)
+        snprintf(line, sizeof(line), "%s %.2f", sensors_kind_name(ch->kind), ch->value);
+    else
+        snprintf(line, sizeof(line), "%s --", sensors_kind_name(ch->kind));
+    ssd1306_draw_string(oled, line, 0, 0);
+    snprintf(line, sizeof(line), "%.1f-%.1f %um", scale_lo, scale_hi,
+             (unsigned)(OLED_TREND_COLUMNS * OLED_TREND_COLUMN_MS / 60000));
+    ssd1306_draw_string(oled, line, 0, 8);
+}
+
+// Valor do primeiro canal da grandeza
+static float primary_value(channel_kind_t kind)
+{
+    int index = sensors_find_channel(kind, 0);
+    return index >= 0 ? sensors_channel(index)->value : NAN;
+}
+
+static void render_status(const char *ip)
+{
+    char buffer[20];
+    ssd1306_fill(oled, false);
+    ssd1306_draw_string(oled, ip, 0, 5);
+    snprintf(buffer, sizeof(buffer), "T:%.1fC", primary_value(CHANNEL_TEMPERATURE));
+    ssd1306_draw_string(oled, buffer, 0, 15);
+    snprintf(buffer, sizeof(buffer), "P:%.1fkPa", primary_value(CHANNEL_PRESSURE));
+    ssd1306_draw_string(oled, buffer, 0, 25);
+    snprintf(buffer, sizeof(buffer), "U:%.1f%%", primary_value(CHANNEL_HUMIDITY));
+    ssd1306_draw_string(oled, buffer, 0, 35);
+    snprintf(buffer, sizeof(buffer), "Alt:%.0fm", primary_value(CHANNEL_ALTITUDE));
+    ssd1306_draw_string(oled, buffer, 0, 45);
+}
+
+void oled_screens_render(const char *ip, uint32_t now_ms)
+{
+    if (!auto_cycle_started)
+    {
+        auto_cycle_started = true;
+        next_cycle_ms = now_ms + OLED_SCREEN_CYCLE_MS;
+    }
+    else if ((int32_t)(now_ms - next_cycle_ms) >= 0)
+    {
+        oled_screens_next();
+        next_cycle_ms = now_ms + OLED_SCREEN_CYCLE_MS;
+    }
+    if (screen >= (int)screen_count())
+        screen = 0;
+
+    bool entered = screen != drawn_screen;
+    if (entered)
+        ssd1306_fill(oled, false);
+    if (screen == 0)
+        render_status(ip);
+    else
+        render_trend((uint8_t)(screen - 1), entered);
+    drawn_screen = screen;
+
+    ssd1306_send_data(oled);
+}
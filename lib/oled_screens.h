@@ -0,0 +1,32 @@
+#ifndef OLED_SCREENS_H
+#define OLED_SCREENS_H
+
+#include "pico/stdlib.h"
+#include "ssd1306.h"
+
+// Canais com tela de tendência (os primeiros registrados)
+#define OLED_TREND_CHANNELS 8
+
+// Cada coluna do gráfico é a média de um intervalo: 128 colunas ≈ 32 minutos
+#define OLED_TREND_COLUMN_MS 15000
+#define OLED_TREND_COLUMNS 128
+
+// Área do gráfico: páginas 2 a 7 (48 linhas); as páginas 0 e 1 ficam para o texto
+#define OLED_TREND_FIRST_PAGE 2
+
+// Troca automática de tela
+#define OLED_SCREEN_CYCLE_MS 5000
+
+void oled_screens_init(ssd1306_t *ssd);
+
+// Alimenta o anel de tendência de um canal (amostras em ordem de tempo)
+void oled_screens_add_sample(uint8_t channel, uint32_t ts, float value);
+
+// Avança para a próxima tela (status e uma tela por canal com dados)
+void oled_screens_next(void);
+
+// Desenha a tela atual e envia só as páginas alteradas. A troca automática
+// acontece aqui, a cada OLED_SCREEN_CYCLE_MS.
+void oled_screens_render(const char *ip, uint32_t now_ms);
+
+#endif // OLED_SCREENS_H
@@ -0,0 +1,208 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "hardware/sync.h"
+#include "perf.h"
+
+static const char *const NAMES[PERF_STAGE_COUNT] = {
+    [PERF_LOOP] = "loop",
+    [PERF_CYW43_POLL] = "cyw43_poll",
+    [PERF_WIFI] = "wifi",
+    [PERF_SENSORS] = "sensors",
+    [PERF_SENSOR_I2C] = "sensor_i2c",
+    [PERF_SENSOR_CONVERT] = "sensor_convert",
+    [PERF_HISTORY] = "history",
+    [PERF_ROLLUP] = "rollup",
+    [PERF_OLED] = "oled",
+    [PERF_SETTINGS] = "settings",
+    [PERF_ALARMS] = "alarms",
+    [PERF_NET] = "net",
+    [PERF_MATRIX] = "matrix",
+    [PERF_HTTP] = "http",
+    [PERF_HTTP_PAGE] = "http_page",
+    [PERF_HTTP_SENSORDATA] = "http_sensordata",
+    [PERF_HTTP_SETTINGS] = "http_settings",
+    [PERF_HTTP_HISTORY] = "http_history",
+    [PERF_HTTP_EXPORT] = "http_export",
+    [PERF_HTTP_EVENTS] = "http_events",
+    [PERF_HTTP_SCREEN] = "http_screen",
+    [PERF_HTTP_DEBUG] = "http_debug",
+};
+
+const char *perf_stage_name(perf_stage_t stage)
+{
+    return stage < PERF_STAGE_COUNT ? NAMES[stage] : "?";
+}
+
+// Marca de um traço válido; qualquer outro valor é o conteúdo aleatório da RAM no power-on
+#define TRACE_MAGIC 0x54524331u
+
+static perf_trace_t __uninitialized_ram(trace);
+
+void perf_trace_begin(perf_stage_t stage)
+{
+    uint32_t now = time_us_32();
+    uint32_t irq = save_and_disable_interrupts();
+    // A volta do laço só abre no nível de fora; o que ficou aberto é resto de um par quebrado
+    if (stage == PERF_LOOP || trace.depth > PERF_TRACE_DEPTH * 2)
+        trace.depth = 0;
+    if (trace.depth < PERF_TRACE_DEPTH)
+        trace.open[trace.depth] =
+            (perf_trace_entry_t){.stage = (uint8_t)stage, .depth = (uint8_t)trace.depth, .start_us = now};
+    trace.depth++;
+    restore_interrupts(irq);
+}
+
+uint32_t perf_trace_end(perf_stage_t stage)
+{
+    uint32_t now = time_us_32();
+    uint32_t us = 0;
+    uint32_t irq = save_and_disable_interrupts();
+    if (trace.depth > 0)
+    {
+        trace.depth--;
+        if (trace.depth < PERF_TRACE_DEPTH)
+        {
+            perf_trace_entry_t e = trace.open[trace.depth];
+            us = now - e.start_us;
+            e.stage = (uint8_t)stage;
+            e.dur_us = us;
+            trace.done[trace.closed % PERF_TRACE_LEN] = e;
+            trace.closed++;
+        }
+    }
+    restore_interrupts(irq);
+    return us;
+}
+
+void perf_trace_reset(void)
+{
+    uint32_t irq = save_and_disable_interrupts();
+    memset(&trace, 0, sizeof(trace));
+    trace.magic = TRACE_MAGIC;
+    restore_interrupts(irq);
+}
+
+bool perf_trace_get(perf_trace_t *out)
+{
+    uint32_t irq = save_and_disable_interrupts();
+    *out = trace;
+    restore_interrupts(irq);
+    return out->magic == TRACE_MAGIC;
+}
+
+#if PERF_ENABLED
+
+static perf_counter_t counters[PERF_STAGE_COUNT];
+static uint32_t reset_ms;
+
+static uint bucket_of(uint32_t us)
+{
+    uint b = us ? 32 - __builtin_clz(us) : 0;
+    return b < PERF_BUCKETS ? b : PERF_BUCKETS - 1;
+}
+
+void perf_record(perf_stage_t stage, uint32_t us)
+{
+    if (stage >= PERF_STAGE_COUNT)
+        return;
+    uint b = bucket_of(us);
+    // Poucas instruções: o handler do lwIP e o tick da matriz também registram
+    uint32_t irq = save_and_disable_interrupts();
+    perf_counter_t *c = &counters[stage];
+    c->count++;
+    c->total_us += us;
+    if (us > c->max_us)
+        c->max_us = us;
+    c->buckets[b]++;
+    restore_interrupts(irq);
+}
+
+void perf_reset(void)
+{
+    uint32_t irq = save_and_disable_interrupts();
+    memset(counters, 0, sizeof(counters));
+    restore_interrupts(irq);
+    reset_ms = to_ms_since_boot(get_absolute_time());
+}
+
+void perf_get(perf_stage_t stage, perf_counter_t *out)
+{
+    uint32_t irq = save_and_disable_interrupts();
+    *out = counters[stage];
+    restore_interrupts(irq);
+}
+
+// Quantil q (em milésimos) estimado no histograma: acha a faixa que contém a
+// amostra de ordem q e interpola linearmente dentro dela, supondo as amostras
+// da faixa espalhadas por igual entre os limites (o de cima cortado no máximo)
+static uint32_t quantile_us(const perf_counter_t *c, uint32_t q_per_mille)
+{
+    uint64_t target = ((uint64_t)c->count * q_per_mille + 999) / 1000;
+    uint64_t seen = 0;
+    for (uint b = 0; b < PERF_BUCKETS; b++)
+    {
+        if (seen + c->buckets[b] >= target && c->buckets[b])
+        {
+            uint64_t lo = b ? 1u << (b - 1) : 0;
+            uint64_t hi = b == PERF_BUCKETS - 1 ? (uint64_t)c->max_us + 1 : MIN(1u << b, (uint64_t)c->max_us + 1);
+            if (hi <= lo)
+                return c->max_us;
+            // Posição no meio da amostra de ordem target entre as da faixa
+            uint64_t rank2 = 2 * (target - seen) - 1;
+            return (uint32_t)(lo + (hi - lo) * rank2 / (2 * c->buckets[b]));
+        }
+        seen += c->buckets[b];
+    }
+    return c->max_us;
+}
+
+int perf_format_json(char *buf, size_t size)
+{
+    uint32_t now_ms = to_ms_since_boot(get_absolute_time());
+    int len = snprintf(buf, size, "{\"enabled\":true,\"window_ms\":%lu,\"stages\":{",
+                       (unsigned long)(now_ms - reset_ms));
+    uint emitted = 0;
+    for (uint i = 0; i < PERF_STAGE_COUNT && len >= 0 && (size_t)len < size; i++)
+    {
+        perf_counter_t c;
+        perf_get((perf_stage_t)i, &c);
+        if (c.count == 0)
+            continue;
+        len += snprintf(buf + len, size - len,
+                        "%s\"%s\":{\"count\":%lu,\"total_us\":%llu,\"mean_us\":%lu,\"p50_us\":%lu,"
+                        "\"p99_us\":%lu,\"max_us\":%lu,\"hist\":[",
+                        emitted++ ? "," : "", NAMES[i], (unsigned long)c.count, (unsigned long long)c.total_us,
+                        (unsigned long)(c.total_us / c.count), (unsigned long)quantile_us(&c, 500),
+                        (unsigned long)quantile_us(&c, 990), (unsigned long)c.max_us);
+        for (uint b = 0; b < PERF_BUCKETS && (size_t)len < size; b++)
+            len += snprintf(buf + len, size - len, "%s%lu", b ? "," : "", (unsigned long)c.buckets[b]);
+        if ((size_t)len < size)
+            len += snprintf(buf + len, size - len, "]}");
+    }
+    if (len >= 0 && (size_t)len < size)
+        len += snprintf(buf + len, size - len, "}}");
+    return len;
+}
+
+#else
+
+void perf_record(perf_stage_t stage, uint32_t us)
+{
+}
+
+void perf_reset(void)
+{
+}
+
+void perf_get(perf_stage_t stage, perf_counter_t *out)
+{
+    memset(out, 0, sizeof(*out));
+}
+
+int perf_format_json(char *buf, size_t size)
+{
+    return snprintf(buf, size, "{\"enabled\":false}");
+}
+
+#endif
@@ -0,0 +1,114 @@
+#ifndef PERF_H
+#define PERF_H
+
+#include <stddef.h>
+#include "pico/stdlib.h"
+
+// Contadores de tempo das etapas do laço e dos handlers HTTP: chamadas, tempo
+// total, máximo e histograma em faixas de potência de 2 (us). Ligados por
+// padrão (opção PERF_ENABLED no CMake); desligados, as macros só alimentam o
+// traço das últimas etapas, usado pelo watchdog do laço (loop_watchdog.h), e
+// não chamam perf_record.
+#ifndef PERF_ENABLED
+#define PERF_ENABLED 1
+#endif
+
+typedef enum
+{
+    PERF_LOOP,           // Volta inteira do laço, do despertar até dormir
+    PERF_CYW43_POLL,
+    PERF_WIFI,
+    PERF_SENSORS,        // sensors_poll inteiro
+    PERF_SENSOR_I2C,     // Leituras no barramento, com a espera feita no aht20_fetch_frame
+    PERF_SENSOR_CONVERT, // Compensação do BMP280, conversão do AHT20, altitude e offsets
+    PERF_HISTORY,
+    PERF_ROLLUP,
+    PERF_OLED,           // Desenho e envio das páginas alteradas
+    PERF_SETTINGS,
+    PERF_ALARMS,
+    PERF_NET,            // Eventos, telemetria e MQTT
+    PERF_MATRIX,         // npWrite
+    PERF_HTTP,           // Handler HTTP antes de a rota ser conhecida (só aparece no traço)
+    PERF_HTTP_PAGE,
+    PERF_HTTP_SENSORDATA,
+    PERF_HTTP_SETTINGS,
+    PERF_HTTP_HISTORY,
+    PERF_HTTP_EXPORT,
+    PERF_HTTP_EVENTS,
+    PERF_HTTP_SCREEN,
+    PERF_HTTP_DEBUG,
+    PERF_STAGE_COUNT
+} perf_stage_t;
+
+// Faixa i conta durações em [2^(i-1), 2^i) us; a faixa 0 é < 1 us e a última
+// acumula tudo a partir de 2^(PERF_BUCKETS-2) us (~1 s), acima das voltas
+// lentas do laço (80 a 100 ms com a conversão do AHT20)
+#define PERF_BUCKETS 22
+
+typedef struct
+{
+    uint32_t count;
+    uint64_t total_us;
+    uint32_t max_us;
+    uint32_t buckets[PERF_BUCKETS];
+} perf_counter_t;
+
+// PERF_BEGIN(SENSORS) ... PERF_END(SENSORS) mede o trecho na etapa PERF_SENSORS.
+// PERF_END_AS registra numa etapa escolhida em tempo de execução (rotas HTTP).
+// Os pares precisam se fechar na ordem inversa da abertura, sem return no meio.
+//
+// Com PERF_ENABLED=0 um par não some: ainda custa duas chamadas (perf_trace_begin
+// e perf_trace_end), cada uma com uma leitura do timer e algumas escritas no
+// traço com as interrupções desligadas. É o preço de saber onde o laço estava
+// preso depois de um reset pelo watchdog.
+#define PERF_BEGIN(name) perf_trace_begin(PERF_##name)
+#if PERF_ENABLED
+#define PERF_END(name) perf_record(PERF_##name, perf_trace_end(PERF_##name))
+#define PERF_END_AS(name, stage) perf_record((stage), perf_trace_end(stage))
+#else
+#define PERF_END(name) ((void)perf_trace_end(PERF_##name))
+#define PERF_END_AS(name, stage) ((void)perf_trace_end(stage))
+#endif
+
+// Registra uma duração; pode ser chamada de interrupções
+void perf_record(perf_stage_t stage, uint32_t us);
+
+// Traço das etapas: as abertas agora (o handler HTTP entra por cima do laço) e
+// as PERF_TRACE_LEN últimas encerradas. Fica em RAM que o boot não zera, para
+// que o que rodava antes de um reset pelo watchdog possa ser lido no boot seguinte.
+#define PERF_TRACE_DEPTH 6
+#define PERF_TRACE_LEN 24
+
+typedef struct
+{
+    uint8_t stage;
+    uint8_t depth;     // 0 = etapa de fora (o laço)
+    uint32_t start_us; // time_us_32 na abertura
+    uint32_t dur_us;   // Só nas encerradas
+} perf_trace_entry_t;
+
+typedef struct
+{
+    uint32_t magic;
+    uint32_t closed; // Etapas encerradas desde o reset do traço
+    uint32_t depth;  // Etapas abertas
+    perf_trace_entry_t open[PERF_TRACE_DEPTH];
+    perf_trace_entry_t done[PERF_TRACE_LEN]; // Circular: a próxima vai em closed % PERF_TRACE_LEN
+} perf_trace_t;
+
+// Abre uma etapa; PERF_LOOP recomeça a pilha de abertas
+void perf_trace_begin(perf_stage_t stage);
+// Fecha a etapa aberta mais recente com o nome final; retorna a duração em us
+uint32_t perf_trace_end(perf_stage_t stage);
+void perf_trace_reset(void);
+// Cópia do traço; false se a RAM não guarda um traço (power-on)
+bool perf_trace_get(perf_trace_t *out);
+
+void perf_reset(void);
+void perf_get(perf_stage_t stage, perf_counter_t *out);
+const char *perf_stage_name(perf_stage_t stage);
+
+// JSON com uma entrada por etapa que já foi chamada
+int perf_format_json(char *buf, size_t size);
+
+#endif // PERF_H
@@ -0,0 +1,78 @@
+#include "power.h"
+
+static const char *const NAMES[POWER_SUBSYSTEM_COUNT] = {
+    [POWER_CPU] = "cpu",
+    [POWER_RADIO] = "radio",
+    [POWER_OLED] = "oled",
+    [POWER_MATRIX] = "matrix",
+    [POWER_SENSORS] = "sensors",
+};
+
+// Corrente de repouso: acima dela o subsistema conta como ativo
+static const float IDLE_MA[POWER_SUBSYSTEM_COUNT] = {
+    [POWER_CPU] = POWER_MA_CPU_WFE,
+    [POWER_RADIO] = POWER_MA_RADIO_IDLE,
+    [POWER_OLED] = POWER_MA_OLED_OFF,
+    [POWER_MATRIX] = POWER_MA_MATRIX_DARK,
+    [POWER_SENSORS] = POWER_MA_SENSORS_IDLE,
+};
+
+typedef struct
+{
+    float ma;           // Corrente atual
+    uint64_t since_us;  // Início do intervalo atual
+    double charge;      // mA·us acumulados nos intervalos fechados
+    uint64_t active_us; // Tempo acumulado acima do repouso
+} subsystem_t;
+
+static subsystem_t subsystems[POWER_SUBSYSTEM_COUNT];
+static uint64_t start_us;
+
+void power_init(uint64_t now_us)
+{
+    start_us = now_us;
+    for (int i = 0; i < POWER_SUBSYSTEM_COUNT; i++)
+        subsystems[i] = (subsystem_t){.ma = IDLE_MA[i], .since_us = now_us};
+}
+
+// Fecha o intervalo em aberto até now_us
+static void close_interval(power_subsystem_t id, uint64_t now_us)
+{
+    subsystem_t *s = &subsystems[id];
+    uint64_t dt = now_us - s->since_us;
+    s->charge += (double)s->ma * dt;
+    if (s->ma > IDLE_MA[id])
+        s->active_us += dt;
+    s->since_us = now_us;
+}
+
+void power_set(power_subsystem_t subsystem, float ma, uint64_t now_us)
+{
+    if (subsystem >= POWER_SUBSYSTEM_COUNT)
+        return;
+    close_interval(subsystem, now_us);
+    subsystems[subsystem].ma = ma;
+}
+
+void power_get_report(uint64_t now_us, power_report_t *out)
+{
+    uint64_t elapsed = now_us - start_us;
+    out->elapsed_us = elapsed;
+    out->total_ma = 0.0f;
+    for (int i = 0; i < POWER_SUBSYSTEM_COUNT; i++)
+    {
+        close_interval((power_subsystem_t)i, now_us);
+        const subsystem_t *s = &subsystems[i];
+        power_usage_t *u = &out->subsystems[i];
+        u->avg_ma = elapsed ? (float)(s->charge / elapsed) : s->ma;
+        u->active_fraction = elapsed ? (float)((double)s->active_us / elapsed) : 0.0f;
+        u->mah_per_day = u->avg_ma * 24.0f;
+        out->total_ma += u->avg_ma;
+    }
+    out->total_mah_per_day = out->total_ma * 24.0f;
+}
+
+const char *power_subsystem_name(power_subsystem_t subsystem)
+{
+    return subsystem < POWER_SUBSYSTEM_COUNT ? NAMES[subsystem] : "?";
+}
@@ -0,0 +1,63 @@
+#ifndef POWER_H
+#define POWER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Contabilidade de energia por subsistema. Cada subsistema tem uma corrente
+// que muda ao longo do tempo (power_set) e o modelo integra a carga. Não usa
+// o SDK: quem chama passa o tempo, e o mesmo modelo roda no host com um
+// relógio virtual (tools/power_sim.c).
+
+// Correntes típicas em 3,3 V (mA), de datasheets e medições publicadas. Servem
+// para comparar configurações; não substituem um amperímetro na placa.
+#define POWER_MA_CPU_RUN 24.0f              // RP2040 a 125 MHz executando
+#define POWER_MA_CPU_WFE 8.0f               // Núcleo parado em WFE, clocks ligados
+#define POWER_MA_RADIO_IDLE 0.5f            // Fora de rede, esperando a próxima tentativa
+#define POWER_MA_RADIO_ACTIVE 45.0f         // Associação, DHCP ou tráfego contínuo
+#define POWER_MA_RADIO_PM_DEFAULT 10.0f     // Associado com CYW43_DEFAULT_PM
+#define POWER_MA_RADIO_PM_AGGRESSIVE 2.5f   // Associado com CYW43_AGGRESSIVE_PM
+#define POWER_MA_OLED_ON 12.0f              // Metade dos pixels acesos
+#define POWER_MA_OLED_OFF 0.01f             // Display desligado (0xAE)
+#define POWER_MA_MATRIX_DARK 17.0f          // 25 WS2812 apagados (~0,7 mA cada)
+#define POWER_MA_MATRIX_LIT 25.0f           // Um glifo aceso
+#define POWER_MA_SENSORS_MEASURING 1.7f     // BMP280 e AHT20 convertendo
+#define POWER_MA_SENSORS_IDLE 0.01f
+
+typedef enum
+{
+    POWER_CPU,
+    POWER_RADIO,
+    POWER_OLED,
+    POWER_MATRIX,
+    POWER_SENSORS,
+    POWER_SUBSYSTEM_COUNT
+} power_subsystem_t;
+
+typedef struct
+{
+    float avg_ma;          // Corrente média desde power_init
+    float active_fraction; // Fração do tempo acima da corrente de repouso do subsistema
+    float mah_per_day;
+} power_usage_t;
+
+typedef struct
+{
+    power_usage_t subsystems[POWER_SUBSYSTEM_COUNT];
+    float total_ma;
+    float total_mah_per_day;
+    uint64_t elapsed_us;
+} power_report_t;
+
+// Zera a contagem; todos os subsistemas começam na corrente de repouso
+void power_init(uint64_t now_us);
+
+// Fecha o intervalo do subsistema na corrente anterior e passa a contar com ma
+void power_set(power_subsystem_t subsystem, float ma, uint64_t now_us);
+
+// Médias desde power_init, extrapoladas para um dia
+void power_get_report(uint64_t now_us, power_report_t *out);
+
+const char *power_subsystem_name(power_subsystem_t subsystem);
+
+#endif // POWER_H
@@ -0,0 +1,302 @@
+#include <math.h>
+
+#include "rollup.h"
+#include "sample_log.h"
+
+typedef struct
+{
+    float min, max, mean;
+} rollup_bucket_t;
+
+// Intervalo em formação
+typedef struct
+{
+    uint32_t start;
+    uint32_t count;
+    float min, max, sum;
+} rollup_accum_t;
+
+// Anel de intervalos fechados; intervalos consecutivos, lacunas ficam com NAN
+typedef struct
+{
+    uint16_t head; // Próxima posição de escrita
+    uint16_t len;
+    uint32_t newest_start;
+} rollup_ring_t;
+
+typedef struct
+{
+    const char *name;
+    uint32_t period_ms;
+    uint16_t num_buckets;
+    rollup_bucket_t *storage;
+} rollup_tier_t;
+
+static rollup_bucket_t minute_storage[ROLLUP_MAX_CHANNELS * ROLLUP_MINUTE_BUCKETS];
+static rollup_bucket_t hour_storage[ROLLUP_MAX_CHANNELS * ROLLUP_HOUR_BUCKETS];
+
+static const rollup_tier_t TIERS[ROLLUP_NUM_TIERS] = {
+    {"1m", 60 * 1000, ROLLUP_MINUTE_BUCKETS, minute_storage},
+    {"1h", 60 * 60 * 1000, ROLLUP_HOUR_BUCKETS, hour_storage},
+};
+
+static rollup_accum_t accums[ROLLUP_NUM_TIERS][ROLLUP_MAX_CHANNELS];
+static rollup_ring_t rings[ROLLUP_NUM_TIERS][ROLLUP_MAX_CHANNELS];
+
+// Última amostra bruta incorporada por canal (evita contar duas vezes)
+static uint32_t fed_until[ROLLUP_MAX_CHANNELS];
+static bool fed_any[ROLLUP_MAX_CHANNELS];
+
+// Reconstrução a partir do log após o boot
+static bool rebuilding;
+static sample_log_cursor_t rebuild_cursor;
+
+static rollup_bucket_t *bucket_at(uint tier, uint channel, uint index)
+{
+    return &TIERS[tier].storage[channel * TIERS[tier].num_buckets + index];
+}
+
+static void push_bucket(uint tier, uint channel, uint32_t start, rollup_bucket_t bucket)
+{
+    const rollup_tier_t *t = &TIERS[tier];
+    rollup_ring_t *ring = &rings[tier][channel];
+
+    // Mantém o anel contíguo no tempo: intervalos sem amostras viram NAN
+    if (ring->len > 0 && start - ring->newest_start > t->period_ms)
+    {
+        uint32_t gaps = (start - ring->newest_start) / t->period_ms - 1;
+        if (gaps > t->num_buckets)
+            gaps = t->num_buckets;
+        for (uint32_t g = 0; g < gaps; g++)
+        {
+            *bucket_at(tier, channel, ring->head) = (rollup_bucket_t){NAN, NAN, NAN};
+            ring->head = (ring->head + 1) % t->num_buckets;
+            if (ring->len < t->num_buckets)
+                ring->len++;
+        }
+    }
+
+    *bucket_at(tier, channel, ring->head) = bucket;
+    ring->head = (ring->head + 1) % t->num_buckets;
+    if (ring->len < t->num_buckets)
+        ring->len++;
+    ring->newest_start = start;
+}
+
+static void accumulate(uint tier, uint channel, uint32_t ts, float min, float max, float sum, uint32_t count);
+
+static void close_bucket(uint tier, uint channel)
+{
+    rollup_accum_t *acc = &accums[tier][channel];
+    rollup_bucket_t bucket = {acc->min, acc->max, acc->sum / acc->count};
+    push_bucket(tier, channel, acc->start, bucket);
+
+    // O intervalo fechado alimenta o nível acima com peso igual ao número de amostras
+    if (tier + 1 < ROLLUP_NUM_TIERS)
+        accumulate(tier + 1, channel, acc->start, acc->min, acc->max, acc->sum, acc->count);
+    acc->count = 0;
+}
+
+static void accumulate(uint tier, uint channel, uint32_t ts, float min, float max, float sum, uint32_t count)
+{
+    rollup_accum_t *acc = &accums[tier][channel];
+    uint32_t start = ts - ts % TIERS[tier].period_ms;
+
+    if (acc->count > 0 && start != acc->start)
+        close_bucket(tier, channel);
+
+    if (acc->count == 0)
+    {
+        acc->start = start;
+        acc->min = min;
+        acc->max = max;
+        acc->sum = 0.0f;
+    }
+    if (min < acc->min)
+        acc->min = min;
+    if (max > acc->max)
+        acc->max = max;
+    acc->sum += sum;
+    acc->count += count;
+}
+
+static void feed(uint8_t channel, uint32_t ts, float value)
+{
+    if (channel >= ROLLUP_MAX_CHANNELS || isnan(value))
+        return;
+    if (fed_any[channel] && (int32_t)(ts - fed_until[channel]) <= 0)
+        return;
+
+    fed_until[channel] = ts;
+    fed_any[channel] = true;
+    accumulate(0, channel, ts, value, value, value, 1);
+}
+
+void rollup_init(void)
+{
+    for (uint tier = 0; tier < ROLLUP_NUM_TIERS; tier++)
+    {
+        for (uint c = 0; c < ROLLUP_MAX_CHANNELS; c++)
+        {
+            accums[tier][c].count = 0;
+            rings[tier][c] = (rollup_ring_t){0};
+        }
+    }
+    for (uint c = 0; c < ROLLUP_MAX_CHANNELS; c++)
+        fed_any[c] = false;
+
+    sample_log_cursor_init(&rebuild_cursor, -1);
+    rebuilding = true;
+}
+
+void rollup_add(uint8_t channel, uint32_t ts, float value)
+{
+    // Durante a reconstrução as amostras novas ficam no tsdb e são
+    // incorporadas em ordem quando ela termina
+    if (!rebuilding)
+        feed(channel, ts, value);
+}
+
+bool rollup_rebuild_step(uint budget)
+{
+    if (!rebuilding)
+        return true;
+
+    uint8_t channel;
+    uint32_t ts;
+    float value;
+    while (budget--)
+    {
+        if (!sample_log_cursor_next(&rebuild_cursor, &channel, &ts, &value))
+        {
+            // Amostras que chegaram a um canal depois que o cursor passou por ele
+            for (uint8_t c = 0; c < ROLLUP_MAX_CHANNELS; c++)
+            {
+                tsdb_iter_t it;
+                tsdb_iter_init(&it, c, fed_any[c] ? fed_until[c] + 1 : 0);
+                while (tsdb_iter_next(&it, &ts, &value))
+                    feed(c, ts, value);
+            }
+            rebuilding = false;
+            return true;
+        }
+        feed(channel, ts, value);
+    }
+    return false;
+}
+
+// Início do dado mais antigo que o nível ainda guarda do canal
+static bool tier_oldest(int tier, uint8_t channel, uint32_t *oldest)
+{
+    if (tier == ROLLUP_TIER_RAW)
+        return tsdb_oldest_ts(channel, oldest);
+    const rollup_ring_t *ring = &rings[tier][channel];
+    const rollup_accum_t *acc = &accums[tier][channel];
+    if (ring->len > 0)
+        *oldest = ring->newest_start - (uint32_t)(ring->len - 1) * TIERS[tier].period_ms;
+    else if (acc->count > 0)
+        *oldest = acc->start;
+    else
+        return false;
+    return true;
+}
+
+int rollup_select_tier(uint8_t channel, uint32_t step_ms, uint32_t since_ms)
+{
+    if (channel >= ROLLUP_MAX_CHANNELS)
+        return ROLLUP_TIER_RAW;
+    int best = ROLLUP_TIER_RAW;
+    for (int tier = ROLLUP_NUM_TIERS - 1; tier >= 0; tier--)
+    {
+        if (TIERS[tier].period_ms <= step_ms)
+        {
+            best = tier;
+            break;
+        }
+    }
+    if (since_ms == 0)
+        return best;
+
+    // Janela além do que o nível guarda: um nível mais grosso só entra se tiver
+    // um intervalo inteiro anterior ao dado mais antigo do escolhido (o primeiro
+    // intervalo de qualquer nível começa antes da primeira amostra)
+    uint32_t best_oldest = 0;
+    bool has = tier_oldest(best, channel, &best_oldest);
+    for (int tier = best + 1; tier < ROLLUP_NUM_TIERS && (!has || (int32_t)(best_oldest - since_ms) > 0); tier++)
+    {
+        uint32_t oldest;
+        if (tier_oldest(tier, channel, &oldest) &&
+            (!has || (int32_t)(oldest + TIERS[tier].period_ms - best_oldest) <= 0))
+        {
+            best = tier;
+            best_oldest = oldest;
+            has = true;
+        }
+    }
+    return best;
+}
+
+const char *rollup_tier_name(int tier)
+{
+    return (tier >= 0 && tier < ROLLUP_NUM_TIERS) ? TIERS[tier].name : "raw";
+}
+
+uint32_t rollup_tier_period(int tier)
+{
+    return (tier >= 0 && tier < ROLLUP_NUM_TIERS) ? TIERS[tier].period_ms : 0;
+}
+
+void rollup_iter_init(rollup_iter_t *it, int tier, uint8_t channel, uint32_t since_ms)
+{
+    *it = (rollup_iter_t){0};
+    if (tier < 0 || tier >= ROLLUP_NUM_TIERS || channel >= ROLLUP_MAX_CHANNELS)
+        return;
+
+    const rollup_tier_t *t = &TIERS[tier];
+    const rollup_ring_t *ring = &rings[tier][channel];
+    it->tier = (int8_t)tier;
+    it->channel = channel;
+    it->len = ring->len;
+    it->oldest_start = ring->newest_start - (uint32_t)(ring->len ? ring->len - 1 : 0) * t->period_ms;
+
+    // Pula direto para o primeiro intervalo que termina depois de since_ms
+    if (ring->len > 0 && (int32_t)(since_ms - it->oldest_start) > 0)
+    {
+        uint32_t skip = (since_ms - it->oldest_start) / t->period_ms;
+        it->index = (uint16_t)(skip < ring->len ? skip : ring->len);
+    }
+
+    const rollup_accum_t *acc = &accums[tier][channel];
+    it->open_pending = acc->count > 0 && (int32_t)(acc->start + t->period_ms - since_ms) > 0;
+}
+
+bool rollup_iter_next(rollup_iter_t *it, rollup_point_t *point)
+{
+    const rollup_tier_t *t = &TIERS[it->tier];
+
+    while (it->index < it->len)
+    {
+        const rollup_ring_t *ring = &rings[it->tier][it->channel];
+        uint16_t pos = (ring->head + t->num_buckets - it->len + it->index) % t->num_buckets;
+        const rollup_bucket_t *b = bucket_at(it->tier, it->channel, pos);
+        uint32_t start = it->oldest_start + it->index * t->period_ms;
+        it->index++;
+        if (isnan(b->mean))
+            continue;
+
+        *point = (rollup_point_t){start, b->min, b->max, b->mean, false};
+        return true;
+    }
+
+    if (it->open_pending)
+    {
+        const rollup_accum_t *acc = &accums[it->tier][it->channel];
+        it->open_pending = false;
+        if (acc->count > 0)
+        {
+            *point = (rollup_point_t){acc->start, acc->min, acc->max, acc->sum / acc->count, true};
+            return true;
+        }
+    }
+    return false;
+}
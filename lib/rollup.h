@@ -0,0 +1,56 @@
+#ifndef ROLLUP_H
+#define ROLLUP_H
+
+#include "pico/stdlib.h"
+
+// Agregados mantidos além das amostras brutas do tsdb:
+// 1 minuto por 3 horas e 1 hora por 7 dias
+#define ROLLUP_NUM_TIERS 2
+#define ROLLUP_MINUTE_BUCKETS 180
+#define ROLLUP_HOUR_BUCKETS 168
+
+// Somente os primeiros canais recebem agregados; os demais ficam só com o bruto
+#define ROLLUP_MAX_CHANNELS 8
+
+// Valor de tier que indica as amostras brutas do tsdb
+#define ROLLUP_TIER_RAW -1
+
+typedef struct
+{
+    uint32_t ts; // Início do intervalo
+    float min, max, mean;
+    bool partial; // Intervalo ainda aberto
+} rollup_point_t;
+
+typedef struct
+{
+    int8_t tier;
+    uint8_t channel;
+    uint16_t index;
+    uint16_t len;
+    uint32_t oldest_start;
+    bool open_pending; // Ainda falta entregar o intervalo aberto
+} rollup_iter_t;
+
+void rollup_init(void);
+
+// Acrescenta uma amostra bruta; os intervalos fechados sobem em cascata para os níveis acima
+void rollup_add(uint8_t channel, uint32_t ts, float value);
+
+// Reconstrói os agregados a partir do log da flash, processando no máximo
+// budget amostras por chamada. Retorna true quando terminou.
+bool rollup_rebuild_step(uint budget);
+
+// Nível mais grosso cuja resolução ainda atende ao passo pedido, ou
+// ROLLUP_TIER_RAW se nenhum atende. Se ele não guarda dados desde since_ms,
+// passa para o nível mais grosso que alcança mais para trás, mesmo com
+// resolução menor que a pedida; since_ms 0 dispensa a janela.
+int rollup_select_tier(uint8_t channel, uint32_t step_ms, uint32_t since_ms);
+
+const char *rollup_tier_name(int tier);
+uint32_t rollup_tier_period(int tier);
+
+void rollup_iter_init(rollup_iter_t *it, int tier, uint8_t channel, uint32_t since_ms);
+bool rollup_iter_next(rollup_iter_t *it, rollup_point_t *point);
+
+#endif // ROLLUP_H
@@ -0,0 +1,314 @@
+#include <string.h>
+
+#include "sample_log.h"
+#include "sensors.h"
+#include "flash_io.h"
+#include "crc32.h"
+
+#define SAMPLE_LOG_MAGIC 0x534C4F47u // "SLOG"
+
+#define PAGES_PER_SEGMENT (SAMPLE_LOG_SEGMENT_SIZE / FLASH_PAGE_SIZE)
+#define NUM_PAGES (FLASH_SAMPLE_LOG_SIZE / FLASH_PAGE_SIZE)
+#define NUM_SEGMENTS (FLASH_SAMPLE_LOG_SIZE / SAMPLE_LOG_SEGMENT_SIZE)
+
+_Static_assert(sizeof(sample_log_page_t) == FLASH_PAGE_SIZE, "página do log deve ocupar uma página de flash");
+
+static uint write_page = 0;
+static uint32_t next_seq = 1;
+static uint32_t logged_until[TSDB_MAX_CHANNELS];
+static uint8_t sensor_set[3];
+static sample_log_stats_t stats;
+
+static uint32_t page_offset(uint page)
+{
+    return FLASH_SAMPLE_LOG_OFFSET + page * FLASH_PAGE_SIZE;
+}
+
+static const sample_log_page_t *page_at(uint page)
+{
+    return (const sample_log_page_t *)flash_io_ptr(page_offset(page));
+}
+
+static bool page_valid(const sample_log_page_t *pg)
+{
+    return pg->magic == SAMPLE_LOG_MAGIC &&
+           pg->count > 0 && pg->bit_len <= TSDB_BLOCK_BYTES * 8 &&
+           pg->channel < TSDB_MAX_CHANNELS &&
+           pg->crc == crc32_update(0, pg, offsetof(sample_log_page_t, crc));
+}
+
+// Assinatura do conjunto de sensores: a grandeza e o chip (tipo e caminho no
+// barramento) de cada canal, na ordem dos índices
+static void compute_sensor_set(void)
+{
+    uint32_t crc = 0;
+    for (uint i = 0; i < sensors_channel_count(); i++)
+    {
+        const sensor_channel_t *ch = sensors_channel(i);
+        const sensor_instance_t *inst = sensors_instance(ch->instance);
+        const uint8_t desc[5] = {(uint8_t)ch->kind, (uint8_t)inst->type, inst->addr, inst->mux_addr,
+                                 inst->mux_channel};
+        crc = crc32_update(crc, desc, sizeof(desc));
+    }
+    sensor_set[0] = (uint8_t)crc;
+    sensor_set[1] = (uint8_t)(crc >> 8);
+    sensor_set[2] = (uint8_t)(crc >> 16);
+}
+
+static bool same_sensor_set(const sample_log_page_t *pg)
+{
+    return memcmp(pg->sensor_set, sensor_set, sizeof(sensor_set)) == 0;
+}
+
+// Sequência de um segmento: a da primeira página válida dele (normalmente a primeira)
+static bool segment_seq(uint segment, uint32_t *seq)
+{
+    for (uint i = 0; i < PAGES_PER_SEGMENT; i++)
+    {
+        uint page = segment * PAGES_PER_SEGMENT + i;
+        stats.scanned_pages++;
+        if (page_valid(page_at(page)))
+        {
+            *seq = page_at(page)->seq;
+            return true;
+        }
+        if (flash_io_is_blank(page_offset(page), FLASH_PAGE_SIZE))
+            return false;
+    }
+    return false;
+}
+
+// Recarrega no tsdb as páginas mais recentes, da mais antiga para a mais nova
+static void restore_recent(uint newest_page)
+{
+    uint32_t prev_seq = page_at(newest_page)->seq + 1;
+    uint first = newest_page;
+    uint found = 0;
+    uint page = newest_page;
+    for (uint steps = 0; steps < NUM_PAGES && found < SAMPLE_LOG_RESTORE_PAGES; steps++)
+    {
+        const sample_log_page_t *pg = page_at(page);
+        if (page_valid(pg) && pg->seq < prev_seq)
+        {
+            prev_seq = pg->seq;
+            first = page;
+            found++;
+        }
+        else if (flash_io_is_blank(page_offset(page), FLASH_PAGE_SIZE))
+        {
+            break; // Segmento apagado: não há dados mais antigos
+        }
+        page = (page + NUM_PAGES - 1) % NUM_PAGES;
+    }
+
+    uint32_t min_seq = prev_seq;
+    for (page = first;; page = (page + 1) % NUM_PAGES)
+    {
+        const sample_log_page_t *pg = page_at(page);
+        if (page_valid(pg) && pg->seq >= min_seq && !same_sensor_set(pg))
+        {
+            stats.foreign_pages++;
+        }
+        else if (page_valid(pg) && pg->seq >= min_seq)
+        {
+            tsdb_restore_block(pg->channel, pg->data, pg->count, pg->bit_len, pg->last_ts);
+            logged_until[pg->channel] = pg->last_ts;
+            stats.restored_pages++;
+        }
+        if (page == newest_page)
+            break;
+    }
+}
+
+static void on_block_sealed(const tsdb_block_t *b)
+{
+    static sample_log_page_t pg;
+    memset(&pg, 0xFF, sizeof(pg));
+    pg.magic = SAMPLE_LOG_MAGIC;
+    pg.seq = next_seq;
+    pg.last_ts = b->last_ts;
+    pg.count = b->count;
+    pg.bit_len = b->bit_len;
+    pg.channel = b->channel;
+    memcpy(pg.sensor_set, sensor_set, sizeof(sensor_set));
+    memcpy(pg.data, b->data, sizeof(pg.data));
+    pg.crc = crc32_update(0, &pg, offsetof(sample_log_page_t, crc));
+
+    // Cada bloco fechado ocupa exatamente uma página: a gravação já sai em lote
+    for (uint attempt = 0; attempt < 2 * PAGES_PER_SEGMENT; attempt++)
+    {
+        uint page = write_page;
+        write_page = (write_page + 1) % NUM_PAGES;
+
+        if (page % PAGES_PER_SEGMENT == 0)
+        {
+            // Entrando num segmento: ele guarda os dados mais antigos do log.
+            // Segmentos são usados em rodízio, o que distribui o desgaste.
+            if (!flash_io_is_blank(page_offset(page), SAMPLE_LOG_SEGMENT_SIZE))
+            {
+                if (!flash_io_erase(page_offset(page), SAMPLE_LOG_SEGMENT_SIZE))
+                    break;
+                stats.erases++;
+            }
+        }
+        else if (!flash_io_is_blank(page_offset(page), FLASH_PAGE_SIZE))
+        {
+            continue; // Restos de uma gravação interrompida
+        }
+
+        if (!flash_io_program(page_offset(page), (const uint8_t *)&pg, sizeof(pg)))
+            break;
+        if (!page_valid(page_at(page)) || page_at(page)->seq != pg.seq)
+            continue;
+
+        next_seq++;
+        logged_until[b->channel] = b->last_ts;
+        stats.pages_written++;
+        stats.samples_logged += b->count;
+        stats.payload_bytes += (b->bit_len + 7) / 8;
+        return;
+    }
+    stats.write_errors++;
+}
+
+bool sample_log_init(uint32_t *last_ts)
+{
+    compute_sensor_set();
+
+    // 1) Segmento mais novo: o de maior sequência na primeira página válida
+    int newest_segment = -1;
+    uint32_t newest_seq = 0;
+    for (uint seg = 0; seg < NUM_SEGMENTS; seg++)
+    {
+        uint32_t seq;
+        if (segment_seq(seg, &seq) && (newest_segment < 0 || seq > newest_seq))
+        {
+            newest_segment = (int)seg;
+            newest_seq = seq;
+        }
+    }
+
+    bool found = false;
+    if (newest_segment >= 0)
+    {
+        // 2) Dentro dele, a última página válida e o fim da área já escrita.
+        // Páginas escritas pela metade são ignoradas e contadas.
+        uint base = (uint)newest_segment * PAGES_PER_SEGMENT;
+        uint newest_page = base;
+        uint end = base;
+        for (uint i = 0; i < PAGES_PER_SEGMENT; i++)
+        {
+            uint page = base + i;
+            stats.scanned_pages++;
+            const sample_log_page_t *pg = page_at(page);
+            if (page_valid(pg))
+            {
+                if (pg->seq >= newest_seq)
+                {
+                    newest_seq = pg->seq;
+                    newest_page = page;
+                }
+                end = page + 1;
+            }
+            else if (!flash_io_is_blank(page_offset(page), FLASH_PAGE_SIZE))
+            {
+                stats.torn_pages++;
+                end = page + 1;
+            }
+        }
+
+        write_page = end % NUM_PAGES;
+        next_seq = newest_seq + 1;
+        *last_ts = page_at(newest_page)->last_ts;
+        restore_recent(newest_page);
+        found = true;
+    }
+
+    tsdb_set_seal_callback(on_block_sealed);
+    return found;
+}
+
+void sample_log_cursor_init(sample_log_cursor_t *cur, int channel)
+{
+    memset(cur, 0, sizeof(*cur));
+    cur->channel = channel;
+    // A página seguinte à de escrita é a mais antiga do anel
+    cur->page = write_page;
+    cur->pages_left = NUM_PAGES;
+    cur->end_seq = next_seq;
+    memcpy(cur->logged_until, logged_until, sizeof(logged_until));
+}
+
+static bool next_from_flash(sample_log_cursor_t *cur, uint8_t *channel, uint32_t *ts, float *value)
+{
+    while (true)
+    {
+        if (cur->in_page && tsdb_decoder_next(&cur->dec, ts, value))
+        {
+            *channel = cur->copy.channel;
+            return true;
+        }
+        cur->in_page = false;
+
+        if (cur->pages_left == 0)
+            return false;
+        uint page = cur->page;
+        cur->page = (cur->page + 1) % NUM_PAGES;
+        cur->pages_left--;
+
+        // Copia a página: o segmento pode ser reaproveitado durante a exportação
+        memcpy(&cur->copy, page_at(page), sizeof(cur->copy));
+        const sample_log_page_t *pg = &cur->copy;
+        if (!page_valid(pg) || pg->seq <= cur->last_seq || pg->seq >= cur->end_seq || !same_sensor_set(pg))
+            continue;
+        if (cur->channel >= 0 && pg->channel != cur->channel)
+            continue;
+
+        cur->last_seq = pg->seq;
+        tsdb_decoder_init(&cur->dec, pg->data, pg->count);
+        cur->in_page = true;
+    }
+}
+
+static bool next_from_ram(sample_log_cursor_t *cur, uint8_t *channel, uint32_t *ts, float *value)
+{
+    while (cur->ram_channel < TSDB_MAX_CHANNELS)
+    {
+        uint8_t ch = cur->ram_channel;
+        if (cur->channel >= 0 && ch != cur->channel)
+        {
+            cur->ram_channel++;
+            continue;
+        }
+        if (!cur->ram_active)
+        {
+            uint32_t since = cur->logged_until[ch] ? cur->logged_until[ch] + 1 : 0;
+            tsdb_iter_init(&cur->ram_it, ch, since);
+            cur->ram_active = true;
+        }
+        if (tsdb_iter_next(&cur->ram_it, ts, value))
+        {
+            *channel = ch;
+            return true;
+        }
+        cur->ram_active = false;
+        cur->ram_channel++;
+    }
+    return false;
+}
+
+bool sample_log_cursor_next(sample_log_cursor_t *cur, uint8_t *channel, uint32_t *ts, float *value)
+{
+    if (!cur->ram_phase)
+    {
+        if (next_from_flash(cur, channel, ts, value))
+            return true;
+        cur->ram_phase = true;
+    }
+    return next_from_ram(cur, channel, ts, value);
+}
+
+void sample_log_get_stats(sample_log_stats_t *out)
+{
+    *out = stats;
+}
@@ -0,0 +1,73 @@
+#ifndef SAMPLE_LOG_H
+#define SAMPLE_LOG_H
+
+#include "pico/stdlib.h"
+#include "hardware/flash.h"
+#include "tsdb.h"
+
+// Segmentos do log: unidade de apagamento e de rodízio
+#define SAMPLE_LOG_SEGMENT_SIZE FLASH_SECTOR_SIZE
+
+// Blocos recarregados para o histórico em RAM no boot
+#define SAMPLE_LOG_RESTORE_PAGES (TSDB_NUM_BLOCKS / 2)
+
+// Página do log: um bloco fechado do tsdb, com cabeçalho e CRC
+typedef struct
+{
+    uint32_t magic;
+    uint32_t seq;
+    uint32_t last_ts;
+    uint16_t count;
+    uint16_t bit_len;
+    uint8_t channel;
+    uint8_t sensor_set[3]; // Assinatura do conjunto de sensores que gerou a página
+    uint8_t data[TSDB_BLOCK_BYTES];
+    uint32_t crc; // Cobre todos os campos anteriores
+} sample_log_page_t;
+
+// Cursor de exportação: percorre o log da página mais antiga para a mais nova
+// e depois as amostras ainda não gravadas que estão na RAM
+typedef struct
+{
+    int channel;            // Canal exportado, ou -1 para todos
+    uint page;
+    uint pages_left;
+    uint32_t last_seq;
+    uint32_t end_seq;       // Páginas gravadas depois do início ficam para a fase da RAM
+    bool in_page;
+    bool ram_phase;
+    bool ram_active;
+    uint8_t ram_channel;
+    uint32_t logged_until[TSDB_MAX_CHANNELS];
+    sample_log_page_t copy;
+    tsdb_decoder_t dec;
+    tsdb_iter_t ram_it;
+} sample_log_cursor_t;
+
+typedef struct
+{
+    uint32_t pages_written;
+    uint32_t erases;
+    uint32_t samples_logged;
+    uint32_t payload_bytes;  // Bytes comprimidos efetivamente úteis
+    uint32_t write_errors;
+    uint32_t torn_pages;     // Páginas corrompidas encontradas no boot
+    uint32_t restored_pages;
+    uint32_t scanned_pages;  // Páginas lidas na recuperação do boot
+    uint32_t foreign_pages;  // Páginas de outro conjunto de sensores, não recarregadas
+} sample_log_stats_t;
+
+// Localiza o fim do log com uma varredura limitada (uma página por segmento
+// mais o segmento mais novo), recarrega os blocos recentes no tsdb e passa a
+// receber os blocos fechados. Retorna o timestamp da última amostra gravada.
+// Chamar depois de registrar os sensores: o índice de canal de uma página só
+// vale para o mesmo conjunto de sensores, e páginas de outro conjunto ficam
+// fora do histórico, dos agregados e da exportação.
+bool sample_log_init(uint32_t *last_ts);
+
+void sample_log_cursor_init(sample_log_cursor_t *cur, int channel);
+bool sample_log_cursor_next(sample_log_cursor_t *cur, uint8_t *channel, uint32_t *ts, float *value);
+
+void sample_log_get_stats(sample_log_stats_t *stats);
+
+#endif // SAMPLE_LOG_H
@@ -0,0 +1,33 @@
+#include <stddef.h>
+
+#include "sample_snapshot.h"
+#include "seqlock.h"
+
+static sample_snapshot_t published;
+static seqlock_t published_lock;
+
+void sample_snapshot_publish(uint32_t ts_ms)
+{
+    // Montada fora da seção crítica; só a cópia final desliga as interrupções
+    sample_snapshot_t s;
+    s.ts_ms = ts_ms;
+    s.alarms = alarms_active();
+    s.count = (uint8_t)sensors_channel_count();
+    for (uint i = 0; i < s.count; i++)
+    {
+        const sensor_channel_t *ch = sensors_channel(i);
+        s.channels[i] = (sample_snapshot_channel_t){ch->value, ch->valid, alarms_channel_active((uint8_t)i)};
+    }
+    size_t used = offsetof(sample_snapshot_t, channels) + s.count * sizeof(s.channels[0]);
+    seqlock_write(&published_lock, &published, &s, used);
+}
+
+uint32_t sample_snapshot_get(sample_snapshot_t *out)
+{
+    return seqlock_read(&published_lock, out, &published, sizeof(published));
+}
+
+uint32_t sample_snapshot_version(void)
+{
+    return seqlock_version(&published_lock);
+}
@@ -0,0 +1,35 @@
+#ifndef SAMPLE_SNAPSHOT_H
+#define SAMPLE_SNAPSHOT_H
+
+#include "pico/stdlib.h"
+#include "sensors.h"
+#include "alarms.h"
+
+// Última amostra completa, publicada pelo laço depois da avaliação dos alarmes
+// e lida pelas rotas HTTP (em interrupção) sem ver uma leitura pela metade:
+// valores, validade e alarmes de todos os canais são da mesma volta.
+
+typedef struct
+{
+    float value;
+    bool valid;
+    bool alarm; // Alguma regra do canal ativa
+} sample_snapshot_channel_t;
+
+typedef struct
+{
+    uint32_t ts_ms; // device_time_ms da avaliação
+    alarm_mask_t alarms;
+    uint8_t count;
+    sample_snapshot_channel_t channels[SENSORS_MAX_CHANNELS];
+} sample_snapshot_t;
+
+// Copia os canais e os alarmes atuais; chamar no laço, depois de alarms_evaluate
+void sample_snapshot_publish(uint32_t ts_ms);
+
+// Cópia da última publicação; retorna a versão (0 antes da primeira amostra),
+// que muda a cada publicação e serve de chave de cache
+uint32_t sample_snapshot_get(sample_snapshot_t *out);
+uint32_t sample_snapshot_version(void);
+
+#endif // SAMPLE_SNAPSHOT_H
@@ -0,0 +1,341 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "sensor_trace.h"
+#include "sensors.h"
+#include "flash_io.h"
+
+// Campos de settings_t que cabem em um registro TRACE_SETTINGS
+#define MAX_SETTINGS_FIELDS (SENSOR_TRACE_MAX_PAYLOAD / 4)
+
+static sensor_trace_mode_t mode = SENSOR_TRACE_OFF;
+static uint32_t time_base_ms = 0;
+static sensor_trace_stats_t stats;
+
+static float last_settings[MAX_SETTINGS_FIELDS];
+static bool settings_recorded = false;
+
+// Gravação na flash: página em montagem e posição (relativa à região) da próxima
+static uint8_t page[FLASH_PAGE_SIZE];
+static uint32_t page_fill = 0;
+static uint32_t flash_pos = 0;
+
+static const char *const MODE_NAMES[] = {"off", "usb", "flash"};
+
+void sensor_trace_init(uint32_t base_ms)
+{
+    time_base_ms = base_ms;
+}
+
+const char *sensor_trace_mode_name(sensor_trace_mode_t m)
+{
+    return MODE_NAMES[m];
+}
+
+static void put_u16(uint8_t *p, uint16_t v)
+{
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+}
+
+static void put_u32(uint8_t *p, uint32_t v)
+{
+    put_u16(p, (uint16_t)v);
+    put_u16(p + 2, (uint16_t)(v >> 16));
+}
+
+static uint16_t get_u16(const uint8_t *p)
+{
+    return (uint16_t)(p[0] | p[1] << 8);
+}
+
+static uint32_t get_u32(const uint8_t *p)
+{
+    return get_u16(p) | (uint32_t)get_u16(p + 2) << 16;
+}
+
+// Programa a página montada. A região é apagada um setor à frente, de modo
+// que depois do último registro sempre há flash apagada (o marcador de fim).
+static bool program_page(void)
+{
+    if (flash_pos % FLASH_SECTOR_SIZE == 0 && flash_pos + FLASH_SECTOR_SIZE < FLASH_TRACE_SIZE &&
+        !flash_io_erase(FLASH_TRACE_OFFSET + flash_pos + FLASH_SECTOR_SIZE, FLASH_SECTOR_SIZE))
+        return false;
+    if (!flash_io_program(FLASH_TRACE_OFFSET + flash_pos, page, FLASH_PAGE_SIZE))
+        return false;
+    flash_pos += FLASH_PAGE_SIZE;
+    page_fill = 0;
+    memset(page, 0xFF, sizeof(page));
+    return true;
+}
+
+static bool flash_append(const uint8_t *data, uint32_t len)
+{
+    // Um registro nunca fica cortado no fim da região: sem espaço, a gravação para
+    if (flash_pos + page_fill + len > FLASH_TRACE_SIZE)
+    {
+        stats.full = true;
+        sensor_trace_stop();
+        return false;
+    }
+    while (len > 0)
+    {
+        uint32_t n = MIN(len, FLASH_PAGE_SIZE - page_fill);
+        memcpy(page + page_fill, data, n);
+        page_fill += n;
+        data += n;
+        len -= n;
+        if (page_fill == FLASH_PAGE_SIZE && !program_page())
+        {
+            sensor_trace_stop();
+            return false;
+        }
+    }
+    return true;
+}
+
+static void usb_line(const uint8_t *data, uint32_t len)
+{
+    static const char HEX[] = "0123456789abcdef";
+    char line[8 + 2 * (SENSOR_TRACE_RECORD_HEADER + SENSOR_TRACE_MAX_PAYLOAD)];
+    memcpy(line, "@st ", 4);
+    uint32_t n = 4;
+    for (uint32_t i = 0; i < len; i++)
+    {
+        line[n++] = HEX[data[i] >> 4];
+        line[n++] = HEX[data[i] & 0x0F];
+    }
+    line[n++] = '\n';
+    line[n] = '\0';
+    fputs(line, stdout);
+}
+
+static bool write_bytes(const uint8_t *data, uint32_t len)
+{
+    if (mode == SENSOR_TRACE_USB)
+        usb_line(data, len);
+    else if (mode != SENSOR_TRACE_FLASH || !flash_append(data, len))
+        return false;
+    stats.bytes += len;
+    return true;
+}
+
+static void emit(sensor_trace_type_t type, uint32_t ts_ms, const uint8_t *payload, uint8_t len)
+{
+    if (mode == SENSOR_TRACE_OFF)
+        return;
+    uint8_t rec[SENSOR_TRACE_RECORD_HEADER + SENSOR_TRACE_MAX_PAYLOAD];
+    rec[0] = (uint8_t)type;
+    rec[1] = len;
+    put_u32(rec + 2, ts_ms);
+    memcpy(rec + SENSOR_TRACE_RECORD_HEADER, payload, len);
+    if (write_bytes(rec, SENSOR_TRACE_RECORD_HEADER + len))
+        stats.records++;
+}
+
+static uint32_t now_ms(void)
+{
+    return time_base_ms + to_ms_since_boot(get_absolute_time());
+}
+
+void sensor_trace_start(sensor_trace_mode_t new_mode, const settings_t *settings)
+{
+    sensor_trace_stop();
+    if (new_mode == SENSOR_TRACE_OFF)
+        return;
+
+    stats = (sensor_trace_stats_t){.mode = new_mode};
+    if (new_mode == SENSOR_TRACE_FLASH)
+    {
+        flash_pos = 0;
+        page_fill = 0;
+        memset(page, 0xFF, sizeof(page));
+        // O setor seguinte é apagado junto com a primeira página
+        if (!flash_io_erase(FLASH_TRACE_OFFSET, FLASH_SECTOR_SIZE))
+            return;
+    }
+    mode = new_mode;
+
+    const uint8_t header[SENSOR_TRACE_HEADER_SIZE] = {'S', 'T', SENSOR_TRACE_VERSION};
+    write_bytes(header, sizeof(header));
+
+    uint32_t ts = now_ms();
+    for (uint i = 0; i < sensors_instance_count(); i++)
+    {
+        const sensor_instance_t *inst = sensors_instance(i);
+        const uint8_t payload[5] = {(uint8_t)i, (uint8_t)inst->type, inst->addr, inst->mux_addr, inst->mux_channel};
+        emit(TRACE_INSTANCE, ts, payload, sizeof(payload));
+        if (inst->type == SENSOR_BMP280)
+            sensor_trace_calib((uint8_t)i, &inst->calib);
+    }
+    settings_recorded = false;
+    sensor_trace_settings(settings);
+
+    // O traço pode começar no meio da execução: valores atuais e estado das regras
+    for (uint i = 0; i < sensors_channel_count(); i++)
+    {
+        const sensor_channel_t *ch = sensors_channel(i);
+        uint8_t payload[6] = {(uint8_t)i, ch->valid};
+        memcpy(payload + 2, &ch->value, sizeof(float));
+        emit(TRACE_CHANNEL, ts, payload, sizeof(payload));
+    }
+    for (uint i = 0; i < alarms_rule_count(); i++)
+    {
+        const alarm_rule_t *r = alarms_rule(i);
+        uint8_t payload[15] = {(uint8_t)i, (uint8_t)(r->active | r->has_ref << 1), r->streak};
+        put_u32(payload + 3, r->ref_ts);
+        memcpy(payload + 7, &r->ref_value, sizeof(float));
+        memcpy(payload + 11, &r->rate, sizeof(float));
+        emit(TRACE_RULE, ts, payload, sizeof(payload));
+    }
+}
+
+void sensor_trace_stop(void)
+{
+    if (mode == SENSOR_TRACE_FLASH && page_fill > 0)
+        program_page();
+    if (mode == SENSOR_TRACE_USB)
+        fflush(stdout);
+    mode = SENSOR_TRACE_OFF;
+}
+
+void sensor_trace_get_stats(sensor_trace_stats_t *out)
+{
+    *out = stats;
+    out->mode = mode;
+}
+
+void sensor_trace_calib(uint8_t instance, const struct bmp280_calib_param *c)
+{
+    if (mode == SENSOR_TRACE_OFF)
+        return;
+    const uint16_t values[12] = {c->dig_t1, (uint16_t)c->dig_t2, (uint16_t)c->dig_t3,
+                                 c->dig_p1, (uint16_t)c->dig_p2, (uint16_t)c->dig_p3,
+                                 (uint16_t)c->dig_p4, (uint16_t)c->dig_p5, (uint16_t)c->dig_p6,
+                                 (uint16_t)c->dig_p7, (uint16_t)c->dig_p8, (uint16_t)c->dig_p9};
+    uint8_t payload[1 + SENSOR_TRACE_CALIB_SIZE];
+    payload[0] = instance;
+    for (uint i = 0; i < 12; i++)
+        put_u16(payload + 1 + 2 * i, values[i]);
+    emit(TRACE_CALIB, now_ms(), payload, sizeof(payload));
+}
+
+void sensor_trace_bmp280(uint8_t instance, int32_t raw_temp, int32_t raw_press)
+{
+    if (mode == SENSOR_TRACE_OFF)
+        return;
+    // Duas leituras de 20 bits em 40 bits: temperatura nos bits baixos
+    uint64_t packed = ((uint64_t)(raw_press & 0xFFFFF) << 20) | (uint64_t)(raw_temp & 0xFFFFF);
+    uint8_t payload[6] = {instance};
+    for (uint i = 0; i < 5; i++)
+        payload[1 + i] = (uint8_t)(packed >> (8 * i));
+    emit(TRACE_BMP280, now_ms(), payload, sizeof(payload));
+}
+
+void sensor_trace_aht20(uint8_t instance, const uint8_t frame[6])
+{
+    if (mode == SENSOR_TRACE_OFF)
+        return;
+    uint8_t payload[7] = {instance};
+    memcpy(payload + 1, frame, 6);
+    emit(TRACE_AHT20, now_ms(), payload, sizeof(payload));
+}
+
+void sensor_trace_fail(uint8_t instance)
+{
+    emit(TRACE_FAIL, now_ms(), &instance, 1);
+}
+
+void sensor_trace_settings(const settings_t *settings)
+{
+    if (mode == SENSOR_TRACE_OFF)
+        return;
+    uint count = MIN(settings_field_count(), MAX_SETTINGS_FIELDS);
+    bool changed = !settings_recorded;
+    for (uint i = 0; i < count; i++)
+    {
+        float v = settings_get(settings, i);
+        changed |= v != last_settings[i];
+        last_settings[i] = v;
+    }
+    if (!changed)
+        return;
+    settings_recorded = true;
+    // Floats IEEE 754 little-endian, como na memória do RP2040 e dos hosts x86/ARM
+    emit(TRACE_SETTINGS, now_ms(), (const uint8_t *)last_settings, (uint8_t)(count * sizeof(float)));
+}
+
+void sensor_trace_eval(uint32_t ts_ms, alarm_mask_t mask)
+{
+    if (mode == SENSOR_TRACE_OFF)
+        return;
+    uint8_t payload[8];
+    put_u32(payload, (uint32_t)mask);
+    put_u32(payload + 4, (uint32_t)(mask >> 32));
+    emit(TRACE_EVAL, ts_ms, payload, sizeof(payload));
+}
+
+const uint8_t *sensor_trace_flash_data(void)
+{
+    return flash_io_ptr(FLASH_TRACE_OFFSET);
+}
+
+uint32_t sensor_trace_flash_size(void)
+{
+    const uint8_t *data = sensor_trace_flash_data();
+    // Durante a gravação, só o que já foi programado (a página em montagem fica de fora)
+    uint32_t limit = mode == SENSOR_TRACE_FLASH ? flash_pos : FLASH_TRACE_SIZE;
+    if (limit < SENSOR_TRACE_HEADER_SIZE || !sensor_trace_check_header(data, limit))
+        return 0;
+    uint32_t pos = SENSOR_TRACE_HEADER_SIZE;
+    sensor_trace_record_t rec;
+    int n;
+    while ((n = sensor_trace_next(data + pos, limit - pos, &rec)) > 0)
+        pos += (uint32_t)n;
+    return pos;
+}
+
+bool sensor_trace_check_header(const uint8_t *buf, size_t len)
+{
+    return len >= SENSOR_TRACE_HEADER_SIZE && buf[0] == 'S' && buf[1] == 'T' && buf[2] == SENSOR_TRACE_VERSION;
+}
+
+int sensor_trace_next(const uint8_t *buf, size_t len, sensor_trace_record_t *rec)
+{
+    if (len == 0 || buf[0] == TRACE_END)
+        return 0;
+    if (len < SENSOR_TRACE_RECORD_HEADER || len < (size_t)SENSOR_TRACE_RECORD_HEADER + buf[1])
+        return -1;
+    rec->type = buf[0];
+    rec->len = buf[1];
+    rec->ts_ms = get_u32(buf + 2);
+    rec->payload = buf + SENSOR_TRACE_RECORD_HEADER;
+    return SENSOR_TRACE_RECORD_HEADER + rec->len;
+}
+
+// Os conteúdos começam pelo índice da instância; os valores vêm depois dele
+void sensor_trace_unpack_calib(const uint8_t *payload, struct bmp280_calib_param *c)
+{
+    const uint8_t *p = payload + 1;
+    c->dig_t1 = get_u16(p);
+    c->dig_t2 = (int16_t)get_u16(p + 2);
+    c->dig_t3 = (int16_t)get_u16(p + 4);
+    c->dig_p1 = get_u16(p + 6);
+    c->dig_p2 = (int16_t)get_u16(p + 8);
+    c->dig_p3 = (int16_t)get_u16(p + 10);
+    c->dig_p4 = (int16_t)get_u16(p + 12);
+    c->dig_p5 = (int16_t)get_u16(p + 14);
+    c->dig_p6 = (int16_t)get_u16(p + 16);
+    c->dig_p7 = (int16_t)get_u16(p + 18);
+    c->dig_p8 = (int16_t)get_u16(p + 20);
+    c->dig_p9 = (int16_t)get_u16(p + 22);
+}
+
+void sensor_trace_unpack_bmp280(const uint8_t *payload, int32_t *raw_temp, int32_t *raw_press)
+{
+    uint64_t packed = 0;
+    for (uint i = 0; i < 5; i++)
+        packed |= (uint64_t)payload[1 + i] << (8 * i);
+    *raw_temp = (int32_t)(packed & 0xFFFFF);
+    *raw_press = (int32_t)(packed >> 20);
+}
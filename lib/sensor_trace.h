@@ -0,0 +1,98 @@
+#ifndef SENSOR_TRACE_H
+#define SENSOR_TRACE_H
+
+#include "pico/stdlib.h"
+#include "bmp280.h"
+#include "alarms.h"
+#include "settings.h"
+
+// Traço das leituras brutas dos sensores: calibração do BMP280, leituras de
+// 20 bits e quadros do AHT20, com as configurações e as decisões de alarme.
+// sim/trace_replay.c passa o traço pela mesma conversão e pelas mesmas regras
+// no host e confere se as decisões saem idênticas.
+//
+// Formato (little-endian): cabeçalho "ST" + versão e, em seguida, registros
+//   tipo (1) | tamanho do conteúdo (1) | ts_ms (4, tempo do dispositivo) | conteúdo
+// O tipo 0xFF (flash apagada) encerra o traço; tipos desconhecidos são pulados pelo tamanho.
+// Pelo USB, cada registro sai como uma linha "@st <hex>".
+
+#define SENSOR_TRACE_VERSION 1
+#define SENSOR_TRACE_HEADER_SIZE 3
+#define SENSOR_TRACE_RECORD_HEADER 6
+#define SENSOR_TRACE_MAX_PAYLOAD 96
+
+// Tamanho da calibração do BMP280 no traço: 12 valores de 16 bits, na ordem dos registradores 0x88..0x9F
+#define SENSOR_TRACE_CALIB_SIZE 24
+
+typedef enum
+{
+    TRACE_INSTANCE = 1, // Índice, tipo, endereço, multiplexador, canal do multiplexador
+    TRACE_CALIB,        // Índice + calibração do BMP280
+    TRACE_BMP280,       // Índice + temperatura e pressão brutas (20 bits cada, em 5 bytes)
+    TRACE_AHT20,        // Índice + quadro de 6 bytes
+    TRACE_FAIL,         // Índice: leitura falhou
+    TRACE_SETTINGS,     // Campos de settings_t como float, na ordem de settings_field_name
+    TRACE_EVAL,         // Máscara de alarmes resultante da avaliação (8 bytes)
+    TRACE_CHANNEL,      // Índice, válido, valor (float): canais no início do traço
+    TRACE_RULE,         // Índice, ativo | tem referência << 1, contagem, ref_ts, ref_value, taxa: regras no início
+    TRACE_END = 0xFF
+} sensor_trace_type_t;
+
+typedef struct
+{
+    uint8_t type;
+    uint8_t len;
+    uint32_t ts_ms;
+    const uint8_t *payload;
+} sensor_trace_record_t;
+
+typedef enum
+{
+    SENSOR_TRACE_OFF,
+    SENSOR_TRACE_USB,
+    SENSOR_TRACE_FLASH
+} sensor_trace_mode_t;
+
+typedef struct
+{
+    sensor_trace_mode_t mode;
+    uint32_t records;
+    uint32_t bytes;
+    bool full; // Região da flash cheia: a gravação parou sozinha
+} sensor_trace_stats_t;
+
+// time_base_ms é a base do tempo do dispositivo; os registros levam base + ms desde o boot
+void sensor_trace_init(uint32_t time_base_ms);
+
+// Começa um traço novo com as instâncias registradas, as calibrações, as
+// configurações atuais e o estado dos canais e das regras de alarme, para que
+// a reprodução parta do mesmo ponto. Na flash, o traço anterior é apagado.
+void sensor_trace_start(sensor_trace_mode_t mode, const settings_t *settings);
+// Encerra o traço; na flash, grava a última página
+void sensor_trace_stop(void);
+void sensor_trace_get_stats(sensor_trace_stats_t *stats);
+const char *sensor_trace_mode_name(sensor_trace_mode_t mode);
+
+// Pontos de gravação; não fazem nada sem um traço em andamento
+void sensor_trace_calib(uint8_t instance, const struct bmp280_calib_param *calib);
+void sensor_trace_bmp280(uint8_t instance, int32_t raw_temp, int32_t raw_press);
+void sensor_trace_aht20(uint8_t instance, const uint8_t frame[6]);
+void sensor_trace_fail(uint8_t instance);
+// Grava as configurações só quando mudaram desde o último registro
+void sensor_trace_settings(const settings_t *settings);
+void sensor_trace_eval(uint32_t now_ms, alarm_mask_t mask);
+
+// Traço guardado na flash (o atual ou o da última gravação, mesmo depois de
+// um reboot): início para leitura direta e tamanho, 0 se não houver
+const uint8_t *sensor_trace_flash_data(void);
+uint32_t sensor_trace_flash_size(void);
+
+// Decodificação. sensor_trace_check_header confere o cabeçalho;
+// sensor_trace_next lê o registro em buf e retorna os bytes consumidos,
+// 0 no fim do traço ou -1 se ele estiver truncado.
+bool sensor_trace_check_header(const uint8_t *buf, size_t len);
+int sensor_trace_next(const uint8_t *buf, size_t len, sensor_trace_record_t *rec);
+void sensor_trace_unpack_calib(const uint8_t *payload, struct bmp280_calib_param *calib);
+void sensor_trace_unpack_bmp280(const uint8_t *payload, int32_t *raw_temp, int32_t *raw_press);
+
+#endif // SENSOR_TRACE_H
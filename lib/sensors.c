@@ -0,0 +1,492 @@
+#include <stdio.h>
+#include <math.h>
+
+#include "sensors.h"
+#include "aht20.h"
+#include "tca9548a.h"
+#include "perf.h"
+#include "sensor_trace.h"
+
+// Estado conhecido de cada multiplexador, para evitar reescrever o mesmo canal
+typedef struct
+{
+    i2c_inst_t *i2c;
+    uint8_t addr;
+    uint8_t mask; // Canais habilitados; MUX_MASK_UNKNOWN após falha de escrita
+} mux_state_t;
+
+#define MUX_MASK_UNKNOWN 0xFF
+
+static sensor_instance_t instances[SENSORS_MAX_INSTANCES];
+static uint num_instances = 0;
+
+static sensor_channel_t channels[SENSORS_MAX_CHANNELS];
+static uint num_channels = 0;
+
+static mux_state_t muxes[SENSORS_MAX_MUXES];
+static uint num_muxes = 0;
+static uint32_t mux_switches = 0;
+
+// Instâncias ordenadas por (barramento, multiplexador, canal) e posição da próxima leitura
+static uint8_t schedule[SENSORS_MAX_INSTANCES];
+static uint poll_cursor = 0;
+
+// Baixo consumo: BMP280 dormindo entre leituras, com uma conversão forçada por leitura
+static bool low_power = false;
+
+static const char *const KIND_NAMES[CHANNEL_KIND_COUNT] = {
+    "temp", "pressure", "altitude", "humidity"};
+
+float calculate_altitude_func(float pressure_pa)
+{
+    return 44330.0 * (1.0 - pow(pressure_pa / SEA_LEVEL_PRESSURE, 0.1903));
+}
+
+static mux_state_t *find_mux(i2c_inst_t *i2c, uint8_t addr)
+{
+    for (uint i = 0; i < num_muxes; i++)
+    {
+        if (muxes[i].i2c == i2c && muxes[i].addr == addr)
+            return &muxes[i];
+    }
+    return NULL;
+}
+
+static mux_state_t *add_mux(i2c_inst_t *i2c, uint8_t addr)
+{
+    mux_state_t *mux = find_mux(i2c, addr);
+    if (mux || num_muxes >= SENSORS_MAX_MUXES)
+        return mux;
+
+    mux = &muxes[num_muxes++];
+    mux->i2c = i2c;
+    mux->addr = addr;
+    mux->mask = MUX_MASK_UNKNOWN;
+    return mux;
+}
+
+// Deixa o barramento apontando para o segmento do sensor: o canal dele aberto
+// e todos os outros multiplexadores do mesmo barramento desconectados.
+// Só escreve nos multiplexadores cujo estado realmente muda.
+static void select_path(i2c_inst_t *i2c, uint8_t mux_addr, uint8_t mux_channel)
+{
+    for (uint i = 0; i < num_muxes; i++)
+    {
+        mux_state_t *mux = &muxes[i];
+        if (mux->i2c != i2c)
+            continue;
+
+        uint8_t wanted = (mux->addr == mux_addr) ? (uint8_t)(1u << mux_channel) : 0;
+        if (mux->mask == wanted)
+            continue;
+
+        mux->mask = tca9548a_set_mask(i2c, mux->addr, wanted) ? wanted : MUX_MASK_UNKNOWN;
+        mux_switches++;
+    }
+}
+
+static bool same_path(const sensor_instance_t *a, const sensor_instance_t *b)
+{
+    return a->i2c == b->i2c && a->mux_addr == b->mux_addr &&
+           (a->mux_addr == SENSOR_NO_MUX || a->mux_channel == b->mux_channel);
+}
+
+static bool path_before(const sensor_instance_t *a, const sensor_instance_t *b)
+{
+    if (a->i2c != b->i2c)
+        return (uintptr_t)a->i2c < (uintptr_t)b->i2c;
+    if (a->mux_addr != b->mux_addr)
+        return a->mux_addr < b->mux_addr;
+    return a->mux_channel < b->mux_channel;
+}
+
+// Configura o chip e carrega a calibração própria da instância. recover pede
+// o reset completo, usado quando o chip parou de responder.
+static bool init_instance(sensor_instance_t *inst, bool recover)
+{
+    select_path(inst->i2c, inst->mux_addr, inst->mux_channel);
+
+    switch (inst->type)
+    {
+    case SENSOR_BMP280:
+        bmp280_init(inst->i2c, inst->addr);
+        if (!bmp280_get_calib_params(inst->i2c, inst->addr, &inst->calib))
+            return false;
+        sensor_trace_calib((uint8_t)(inst - instances), &inst->calib);
+        return true;
+    case SENSOR_AHT20:
+        if (!recover)
+            return aht20_init(inst->i2c);
+        aht20_reset(inst->i2c);
+        return aht20_check(inst->i2c);
+    }
+    return false;
+}
+
+static bool probe(sensor_type_t type, i2c_inst_t *i2c, uint8_t addr)
+{
+    return type == SENSOR_BMP280 ? bmp280_check(i2c, addr) : aht20_check(i2c);
+}
+
+static void add_channel(sensor_instance_t *inst, channel_kind_t kind)
+{
+    sensor_channel_t *ch = &channels[num_channels++];
+    ch->kind = kind;
+    ch->instance = (uint8_t)(inst - instances);
+    ch->valid = false;
+    ch->value = 0.0f;
+    inst->num_channels++;
+}
+
+// Confere a capacidade e se o chip já está registrado e preenche a próxima
+// entrada da tabela, sem ainda contá-la
+static sensor_instance_t *new_instance(sensor_type_t type, i2c_inst_t *i2c, uint8_t addr, uint8_t mux_addr,
+                                       uint8_t mux_channel)
+{
+    uint needed = (type == SENSOR_BMP280) ? 3 : 2;
+    if (num_instances >= SENSORS_MAX_INSTANCES || num_channels + needed > SENSORS_MAX_CHANNELS)
+        return NULL;
+
+    // Rejeita o mesmo chip registrado duas vezes
+    for (uint i = 0; i < num_instances; i++)
+    {
+        const sensor_instance_t *other = &instances[i];
+        if (other->i2c == i2c && other->addr == addr && other->mux_addr == mux_addr &&
+            other->mux_channel == mux_channel)
+            return NULL;
+    }
+
+    sensor_instance_t *inst = &instances[num_instances];
+    *inst = (sensor_instance_t){0};
+    inst->type = type;
+    inst->i2c = i2c;
+    inst->addr = addr;
+    inst->mux_addr = mux_addr;
+    inst->mux_channel = mux_channel;
+    return inst;
+}
+
+// Cria os canais da instância e a põe na agenda
+static void commit_instance(sensor_instance_t *inst)
+{
+    const char *chip = (inst->type == SENSOR_BMP280) ? "BMP280" : "AHT20";
+    if (inst->mux_addr == SENSOR_NO_MUX)
+        snprintf(inst->label, sizeof(inst->label), "%s@%02X", chip, inst->addr);
+    else
+        snprintf(inst->label, sizeof(inst->label), "%s@%02X:%02X.%u", chip, inst->addr, inst->mux_addr,
+                 inst->mux_channel);
+
+    inst->first_channel = (uint8_t)num_channels;
+    add_channel(inst, CHANNEL_TEMPERATURE);
+    if (inst->type == SENSOR_BMP280)
+    {
+        add_channel(inst, CHANNEL_PRESSURE);
+        add_channel(inst, CHANNEL_ALTITUDE);
+    }
+    else
+    {
+        add_channel(inst, CHANNEL_HUMIDITY);
+    }
+
+    // Insere na agenda mantendo os sensores do mesmo segmento adjacentes
+    uint pos = num_instances;
+    while (pos > 0 && path_before(inst, &instances[schedule[pos - 1]]))
+    {
+        schedule[pos] = schedule[pos - 1];
+        pos--;
+    }
+    schedule[pos] = (uint8_t)num_instances;
+    num_instances++;
+    poll_cursor = 0;
+}
+
+bool sensors_add(sensor_type_t type, i2c_inst_t *i2c, uint8_t addr, uint8_t mux_addr, uint8_t mux_channel)
+{
+    if (type == SENSOR_AHT20)
+        addr = AHT20_I2C_ADDR;
+    if (mux_addr != SENSOR_NO_MUX && mux_channel >= TCA9548A_NUM_CHANNELS)
+        return false;
+    sensor_instance_t *inst = new_instance(type, i2c, addr, mux_addr, mux_channel);
+    if (!inst || (mux_addr != SENSOR_NO_MUX && !add_mux(i2c, mux_addr)))
+        return false;
+
+    select_path(i2c, mux_addr, mux_channel);
+    if (type == SENSOR_AHT20)
+        aht20_wait_power_on();
+    if (!probe(type, i2c, addr) || !init_instance(inst, false))
+        return false;
+
+    commit_instance(inst);
+    return true;
+}
+
+uint sensors_scan_mux(i2c_inst_t *i2c, uint8_t mux_addr)
+{
+    if (!tca9548a_check(i2c, mux_addr) || !add_mux(i2c, mux_addr))
+        return 0;
+
+    // Com todos os canais fechados, o que responder está ligado direto ao barramento
+    // e responderia também em qualquer canal; esses endereços não são sondados
+    select_path(i2c, SENSOR_NO_MUX, 0);
+    bool direct_bmp_primary = bmp280_check(i2c, BMP280_I2C_ADDR);
+    bool direct_bmp_alt = bmp280_check(i2c, BMP280_I2C_ADDR_ALT);
+    bool direct_aht = aht20_check(i2c);
+
+    uint found = 0;
+    for (uint8_t ch = 0; ch < TCA9548A_NUM_CHANNELS; ch++)
+    {
+        if (!direct_bmp_primary)
+            found += sensors_add(SENSOR_BMP280, i2c, BMP280_I2C_ADDR, mux_addr, ch);
+        if (!direct_bmp_alt)
+            found += sensors_add(SENSOR_BMP280, i2c, BMP280_I2C_ADDR_ALT, mux_addr, ch);
+        if (!direct_aht)
+            found += sensors_add(SENSOR_AHT20, i2c, AHT20_I2C_ADDR, mux_addr, ch);
+    }
+    return found;
+}
+
+static void store_bmp280(sensor_instance_t *inst, int32_t raw_temp, int32_t raw_press,
+                         const float offsets[CHANNEL_KIND_COUNT])
+{
+    int32_t temp_c = bmp280_convert_temp(raw_temp, &inst->calib);
+    int32_t press_pa = bmp280_convert_pressure(raw_press, raw_temp, &inst->calib);
+
+    sensor_channel_t *ch = &channels[inst->first_channel];
+    ch[0].value = (temp_c / 100.0f) + offsets[CHANNEL_TEMPERATURE];
+    ch[1].value = (press_pa / 1000.0f) + offsets[CHANNEL_PRESSURE];
+    ch[2].value = calculate_altitude_func(ch[1].value * 1000) + offsets[CHANNEL_ALTITUDE]; // A função espera Pa
+}
+
+static void store_aht20(sensor_instance_t *inst, const uint8_t frame[6],
+                        const float offsets[CHANNEL_KIND_COUNT])
+{
+    AHT20_Data data;
+    aht20_convert(frame, &data);
+    sensor_channel_t *ch = &channels[inst->first_channel];
+    ch[0].value = data.temperature + offsets[CHANNEL_TEMPERATURE];
+    ch[1].value = data.humidity + offsets[CHANNEL_HUMIDITY];
+}
+
+static void finish_read(sensor_instance_t *inst, bool ok)
+{
+    inst->read_count++;
+    if (!ok)
+        inst->error_count++;
+    inst->ok = ok;
+    for (uint c = 0; c < inst->num_channels; c++)
+        channels[inst->first_channel + c].valid = ok;
+}
+
+// Lê um segmento do barramento: dispara os AHT20, lê os BMP280 enquanto
+// eles convertem e só então busca o resultado dos AHT20
+static void poll_group(const uint8_t *group, uint len, const float offsets[CHANNEL_KIND_COUNT])
+{
+    const sensor_instance_t *first = &instances[group[0]];
+    select_path(first->i2c, first->mux_addr, first->mux_channel);
+
+    bool triggered[SENSORS_MAX_INSTANCES];
+    for (uint i = 0; i < len; i++)
+    {
+        sensor_instance_t *inst = &instances[group[i]];
+        // Um chip que falhou pode ter reiniciado e perdido a configuração
+        if (!inst->ok && inst->read_count > 0)
+            init_instance(inst, true);
+        if (inst->type == SENSOR_AHT20)
+        {
+            // A medição disparada por sensors_prime já está (ou quase) pronta
+            triggered[i] = inst->primed || aht20_trigger(inst->i2c);
+            inst->primed = false;
+        }
+        else if (low_power)
+        {
+            // Converte junto com os AHT20 do lote
+            triggered[i] = bmp280_set_mode(inst->i2c, inst->addr, BMP280_MODE_FORCED);
+        }
+    }
+
+    for (uint i = 0; i < len; i++)
+    {
+        sensor_instance_t *inst = &instances[group[i]];
+        if (inst->type != SENSOR_BMP280)
+            continue;
+        int32_t raw_temp, raw_press;
+        PERF_BEGIN(SENSOR_I2C);
+        bool ok = (!low_power || (triggered[i] && bmp280_wait_ready(inst->i2c, inst->addr))) &&
+                  bmp280_read_raw(inst->i2c, inst->addr, &raw_temp, &raw_press);
+        PERF_END(SENSOR_I2C);
+        if (ok)
+        {
+            sensor_trace_bmp280(group[i], raw_temp, raw_press);
+            PERF_BEGIN(SENSOR_CONVERT);
+            store_bmp280(inst, raw_temp, raw_press, offsets);
+            PERF_END(SENSOR_CONVERT);
+        }
+        else
+        {
+            sensor_trace_fail(group[i]);
+        }
+        finish_read(inst, ok);
+    }
+
+    for (uint i = 0; i < len; i++)
+    {
+        sensor_instance_t *inst = &instances[group[i]];
+        if (inst->type != SENSOR_AHT20)
+            continue;
+        uint8_t frame[6];
+        PERF_BEGIN(SENSOR_I2C);
+        bool ok = triggered[i] && aht20_fetch_frame(inst->i2c, frame);
+        PERF_END(SENSOR_I2C);
+        if (ok)
+        {
+            sensor_trace_aht20(group[i], frame);
+            PERF_BEGIN(SENSOR_CONVERT);
+            store_aht20(inst, frame, offsets);
+            PERF_END(SENSOR_CONVERT);
+        }
+        else
+        {
+            sensor_trace_fail(group[i]);
+        }
+        finish_read(inst, ok);
+    }
+}
+
+void sensors_prime(void)
+{
+    for (uint i = 0; i < num_instances; i++)
+    {
+        sensor_instance_t *inst = &instances[schedule[i]];
+        if (inst->type != SENSOR_AHT20)
+            continue;
+        select_path(inst->i2c, inst->mux_addr, inst->mux_channel);
+        inst->primed = aht20_trigger(inst->i2c);
+    }
+}
+
+void sensors_set_low_power(bool enabled)
+{
+    low_power = enabled;
+    for (uint i = 0; i < num_instances; i++)
+    {
+        sensor_instance_t *inst = &instances[schedule[i]];
+        if (inst->type != SENSOR_BMP280)
+            continue;
+        select_path(inst->i2c, inst->mux_addr, inst->mux_channel);
+        bmp280_set_mode(inst->i2c, inst->addr, enabled ? BMP280_MODE_SLEEP : BMP280_MODE_NORMAL);
+    }
+}
+
+void sensors_poll(const float offsets[CHANNEL_KIND_COUNT])
+{
+    if (num_instances == 0)
+        return;
+
+    // Percorre a agenda em rodízio começando pelo segmento que já está
+    // selecionado, de modo que cada passada custe uma troca a menos
+    uint8_t group[SENSORS_MAX_INSTANCES];
+    uint done = 0;
+    uint last_start = poll_cursor;
+    while (done < num_instances)
+    {
+        uint start = (poll_cursor + done) % num_instances;
+        uint len = 0;
+        do
+        {
+            group[len] = schedule[(start + len) % num_instances];
+            len++;
+        } while (done + len < num_instances &&
+                 same_path(&instances[group[0]], &instances[schedule[(start + len) % num_instances]]));
+
+        poll_group(group, len, offsets);
+        last_start = start;
+        done += len;
+    }
+    poll_cursor = last_start;
+}
+
+bool sensors_replay_add(sensor_type_t type, uint8_t addr, uint8_t mux_addr, uint8_t mux_channel)
+{
+    sensor_instance_t *inst = new_instance(type, NULL, addr, mux_addr, mux_channel);
+    if (!inst)
+        return false;
+    commit_instance(inst);
+    return true;
+}
+
+void sensors_replay_calib(uint index, const struct bmp280_calib_param *calib)
+{
+    if (index < num_instances)
+        instances[index].calib = *calib;
+}
+
+void sensors_replay_bmp280(uint index, int32_t raw_temp, int32_t raw_press, const float offsets[CHANNEL_KIND_COUNT])
+{
+    if (index >= num_instances || instances[index].type != SENSOR_BMP280)
+        return;
+    store_bmp280(&instances[index], raw_temp, raw_press, offsets);
+    finish_read(&instances[index], true);
+}
+
+void sensors_replay_aht20(uint index, const uint8_t frame[6], const float offsets[CHANNEL_KIND_COUNT])
+{
+    if (index >= num_instances || instances[index].type != SENSOR_AHT20)
+        return;
+    store_aht20(&instances[index], frame, offsets);
+    finish_read(&instances[index], true);
+}
+
+void sensors_replay_fail(uint index)
+{
+    if (index < num_instances)
+        finish_read(&instances[index], false);
+}
+
+void sensors_replay_channel(uint index, bool valid, float value)
+{
+    if (index < num_channels)
+    {
+        channels[index].valid = valid;
+        channels[index].value = value;
+    }
+}
+
+uint sensors_instance_count(void)
+{
+    return num_instances;
+}
+
+const sensor_instance_t *sensors_instance(uint index)
+{
+    return index < num_instances ? &instances[index] : NULL;
+}
+
+uint sensors_channel_count(void)
+{
+    return num_channels;
+}
+
+const sensor_channel_t *sensors_channel(uint index)
+{
+    return index < num_channels ? &channels[index] : NULL;
+}
+
+int sensors_find_channel(channel_kind_t kind, uint nth)
+{
+    for (uint i = 0; i < num_channels; i++)
+    {
+        if (channels[i].kind == kind && nth-- == 0)
+            return (int)i;
+    }
+    return -1;
+}
+
+const char *sensors_kind_name(channel_kind_t kind)
+{
+    return kind < CHANNEL_KIND_COUNT ? KIND_NAMES[kind] : "?";
+}
+
+uint32_t sensors_mux_switches(void)
+{
+    return mux_switches;
+}
@@ -0,0 +1,107 @@
+#ifndef SENSORS_H
+#define SENSORS_H
+
+#include "pico/stdlib.h"
+#include "hardware/i2c.h"
+#include "bmp280.h"
+
+// Capacidade do registro (definida em tempo de compilação)
+#define SENSORS_MAX_INSTANCES 16
+#define SENSORS_MAX_CHANNELS 40
+#define SENSORS_MAX_MUXES 4
+
+// Valor de mux_addr para sensores ligados diretamente ao barramento
+#define SENSOR_NO_MUX 0x00
+
+#define SEA_LEVEL_PRESSURE 101325.0
+
+typedef enum
+{
+    SENSOR_BMP280,
+    SENSOR_AHT20
+} sensor_type_t;
+
+// Grandeza medida por um canal. A ordem também é a prioridade dos alarmes.
+typedef enum
+{
+    CHANNEL_TEMPERATURE,
+    CHANNEL_PRESSURE,
+    CHANNEL_ALTITUDE,
+    CHANNEL_HUMIDITY,
+    CHANNEL_KIND_COUNT
+} channel_kind_t;
+
+// Uma instância de driver: um chip físico, com seu caminho no barramento,
+// sua calibração e seu estado de leitura
+typedef struct
+{
+    sensor_type_t type;
+    i2c_inst_t *i2c;
+    uint8_t addr;
+    uint8_t mux_addr;    // SENSOR_NO_MUX quando não há multiplexador
+    uint8_t mux_channel;
+    uint8_t first_channel;
+    uint8_t num_channels;
+    bool ok;             // Resultado da última leitura
+    bool primed;         // AHT20 com medição já disparada por sensors_prime
+    uint32_t read_count;
+    uint32_t error_count;
+    char label[20];      // "BMP280@76:70.7"; cabe o pior caso de cada campo
+    struct bmp280_calib_param calib; // Usado somente pelo BMP280
+} sensor_instance_t;
+
+// Um canal de dados produzido por uma instância
+typedef struct
+{
+    channel_kind_t kind;
+    uint8_t instance;
+    bool valid;
+    float value; // Já com offset de calibração
+} sensor_channel_t;
+
+// Registra um sensor. Retorna false se ele não responder ou se o registro estiver cheio.
+bool sensors_add(sensor_type_t type, i2c_inst_t *i2c, uint8_t addr, uint8_t mux_addr, uint8_t mux_channel);
+
+// Procura BMP280 (0x76/0x77) e AHT20 em todos os canais de um TCA9548A.
+// Retorna o número de sensores registrados.
+uint sensors_scan_mux(i2c_inst_t *i2c, uint8_t mux_addr);
+
+// Dispara a conversão dos AHT20 (~80 ms) logo após o registro, para que ela
+// corra durante o resto da inicialização e a primeira leitura não espere
+void sensors_prime(void);
+
+// Baixo consumo: o BMP280 dorme entre leituras e cada sensors_poll faz uma
+// conversão forçada; fora dele, o BMP280 volta ao modo contínuo
+void sensors_set_low_power(bool enabled);
+
+// Lê todos os sensores em lotes agrupados por canal do multiplexador.
+// offsets[kind] é somado ao valor físico de cada canal daquela grandeza.
+void sensors_poll(const float offsets[CHANNEL_KIND_COUNT]);
+
+// Reprodução de traços (sensor_trace.h): registra instâncias sem barramento,
+// na ordem do traço, e as alimenta com as leituras brutas gravadas, que passam
+// pela mesma compensação e pelos mesmos offsets de sensors_poll
+bool sensors_replay_add(sensor_type_t type, uint8_t addr, uint8_t mux_addr, uint8_t mux_channel);
+void sensors_replay_calib(uint index, const struct bmp280_calib_param *calib);
+void sensors_replay_bmp280(uint index, int32_t raw_temp, int32_t raw_press, const float offsets[CHANNEL_KIND_COUNT]);
+void sensors_replay_aht20(uint index, const uint8_t frame[6], const float offsets[CHANNEL_KIND_COUNT]);
+void sensors_replay_fail(uint index);
+void sensors_replay_channel(uint index, bool valid, float value);
+
+uint sensors_instance_count(void);
+const sensor_instance_t *sensors_instance(uint index);
+uint sensors_channel_count(void);
+const sensor_channel_t *sensors_channel(uint index);
+
+// Índice do n-ésimo canal da grandeza informada, ou -1 se não existir
+int sensors_find_channel(channel_kind_t kind, uint nth);
+
+// Nome curto da grandeza, usado no JSON
+const char *sensors_kind_name(channel_kind_t kind);
+
+// Número de trocas de canal feitas nos multiplexadores desde o boot
+uint32_t sensors_mux_switches(void);
+
+float calculate_altitude_func(float pressure_pa);
+
+#endif // SENSORS_H
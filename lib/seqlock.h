@@ -0,0 +1,72 @@
+#ifndef SEQLOCK_H
+#define SEQLOCK_H
+
+#include <string.h>
+#include "hardware/sync.h"
+
+// Publicação de um valor maior que uma palavra entre as interrupções (botões,
+// lwIP) e o laço. O escritor copia com as interrupções desligadas só durante o
+// memcpy; o leitor não as desliga: copia e repete se a sequência mudou no meio.
+// A sequência fica ímpar durante a escrita, o que também protege um leitor no
+// outro núcleo; escritores nos dois núcleos precisariam de um spinlock.
+typedef struct
+{
+    volatile uint32_t seq;
+} seqlock_t;
+
+// Número da versão publicada (metade da sequência); muda a cada escrita
+static inline uint32_t seqlock_version(const seqlock_t *lock)
+{
+    return lock->seq >> 1;
+}
+
+// Copia src para dst e retorna a versão da cópia
+static inline uint32_t seqlock_read(const seqlock_t *lock, void *dst, const void *src, size_t size)
+{
+    uint32_t seq;
+    do
+    {
+        seq = lock->seq;
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        memcpy(dst, src, size);
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    } while ((seq & 1) || seq != lock->seq);
+    return seq >> 1;
+}
+
+// Publica src em dst se a versão ainda for expected (leitura, alteração e
+// escrita sem perder uma escrita que entrou no meio). Retorna a versão nova, ou
+// 0 se outra escrita chegou antes.
+static inline uint32_t seqlock_write_if(seqlock_t *lock, uint32_t expected, void *dst, const void *src, size_t size)
+{
+    uint32_t irq = save_and_disable_interrupts();
+    if ((lock->seq >> 1) != expected)
+    {
+        restore_interrupts(irq);
+        return 0;
+    }
+    lock->seq++;
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    memcpy(dst, src, size);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    lock->seq++;
+    uint32_t version = lock->seq >> 1;
+    restore_interrupts(irq);
+    return version;
+}
+
+// Publica incondicionalmente; retorna a versão nova
+static inline uint32_t seqlock_write(seqlock_t *lock, void *dst, const void *src, size_t size)
+{
+    uint32_t irq = save_and_disable_interrupts();
+    lock->seq++;
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    memcpy(dst, src, size);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    lock->seq++;
+    uint32_t version = lock->seq >> 1;
+    restore_interrupts(irq);
+    return version;
+}
+
+#endif // SEQLOCK_H
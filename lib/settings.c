@@ -0,0 +1,207 @@
+#include <stddef.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <strings.h>
+
+#include "seqlock.h"
+#include "settings.h"
+
+typedef struct
+{
+    const char *name;
+    size_t offset;
+    float default_value;
+} settings_field_t;
+
+#define FIELD(name, default_value) {#name, offsetof(settings_t, name), default_value}
+
+static const settings_field_t FIELDS[] = {
+    FIELD(temp_offset, 0.0f),
+    FIELD(pressure_offset_kpa, 0.0f),
+    FIELD(temp_min, 0.0f),
+    FIELD(temp_max, 40.0f),
+    FIELD(pressure_min, 80.0f),
+    FIELD(pressure_max, 105.0f),
+    FIELD(altitude_min, -100.0f),
+    FIELD(altitude_max, 1000.0f),
+    FIELD(humidity_min, 20.0f),
+    FIELD(humidity_max, 90.0f),
+    FIELD(low_power, 0.0f),
+    FIELD(sample_interval_s, 30.0f),
+    FIELD(loop_slo_ms, 200.0f),
+};
+
+#define NUM_FIELDS (sizeof(FIELDS) / sizeof(FIELDS[0]))
+
+static settings_t published;
+static seqlock_t published_lock;
+
+void settings_reset(settings_t *s)
+{
+    for (uint i = 0; i < NUM_FIELDS; i++)
+        settings_set(s, i, FIELDS[i].default_value);
+    s->collector_ip = 0;
+    s->collector_port = 0;
+    s->telemetry_ip = 0;
+    s->telemetry_port = 0;
+    s->mqtt_ip = 0;
+    s->mqtt_port = 0;
+}
+
+uint settings_field_count(void)
+{
+    return NUM_FIELDS;
+}
+
+const char *settings_field_name(uint index)
+{
+    return index < NUM_FIELDS ? FIELDS[index].name : NULL;
+}
+
+float settings_get(const settings_t *s, uint index)
+{
+    return *(const float *)((const uint8_t *)s + FIELDS[index].offset);
+}
+
+void settings_set(settings_t *s, uint index, float value)
+{
+    *(float *)((uint8_t *)s + FIELDS[index].offset) = value;
+}
+
+uint32_t settings_load(settings_t *out)
+{
+    return seqlock_read(&published_lock, out, &published, sizeof(published));
+}
+
+uint32_t settings_version(void)
+{
+    return seqlock_version(&published_lock);
+}
+
+uint32_t settings_publish(const settings_t *s)
+{
+    return seqlock_write(&published_lock, &published, s, sizeof(published));
+}
+
+uint settings_publish_query(const char *query)
+{
+    settings_t s;
+    uint changed;
+    uint32_t version;
+    do
+    {
+        version = settings_load(&s);
+        changed = settings_parse_query(&s, query);
+    } while (changed > 0 && !seqlock_write_if(&published_lock, version, &published, &s, sizeof(published)));
+    return changed;
+}
+
+void settings_publish_defaults(void)
+{
+    settings_t s;
+    settings_reset(&s);
+    settings_publish(&s);
+}
+
+// Procura "nome=" no início de um parâmetro (após '?' ou '&'),
+// para que um nome não case com o final de outro
+static const char *find_param(const char *query, const char *name)
+{
+    size_t len = strlen(name);
+    for (const char *p = strstr(query, name); p; p = strstr(p + 1, name))
+    {
+        if (p > query && (p[-1] == '?' || p[-1] == '&') && p[len] == '=')
+            return p + len + 1;
+    }
+    return NULL;
+}
+
+// Endereço "a.b.c.d:porta"; valor vazio (ou inválido) desativa. Retorna 1 se o parâmetro estava presente.
+static uint parse_endpoint(const char *query, const char *name, uint32_t *ip_out, uint32_t *port_out)
+{
+    const char *value = find_param(query, name);
+    if (!value)
+        return 0;
+
+    uint32_t ip = 0, port = 0;
+    const char *p = value;
+    bool ok = true;
+    for (uint octet = 0; octet < 4 && ok; octet++)
+    {
+        char *end;
+        unsigned long n = strtoul(p, &end, 10);
+        ok = end != p && n <= 255;
+        ip = (ip << 8) | (uint32_t)n;
+        p = end + 1;
+        if (octet < 3)
+            ok = ok && *end == '.';
+        else if (strncasecmp(end, "%3A", 3) == 0) // ':' codificado pelo formulário
+            p = end + 3;
+        else
+            ok = ok && *end == ':';
+    }
+    if (ok)
+    {
+        char *end;
+        port = strtoul(p, &end, 10);
+        ok = end != p && port > 0 && port <= 65535;
+    }
+    if (!ok)
+        ip = port = 0;
+    *ip_out = ip;
+    *port_out = port;
+    return 1;
+}
+
+uint settings_parse_query(settings_t *s, const char *query)
+{
+    uint changed = 0;
+    for (uint i = 0; i < NUM_FIELDS; i++)
+    {
+        const char *value = find_param(query, FIELDS[i].name);
+        if (!value)
+            continue;
+
+        char *end;
+        float parsed = strtof(value, &end);
+        if (end == value)
+            continue;
+        settings_set(s, i, parsed);
+        changed++;
+    }
+
+    changed += parse_endpoint(query, "collector", &s->collector_ip, &s->collector_port);
+    changed += parse_endpoint(query, "telemetry", &s->telemetry_ip, &s->telemetry_port);
+    changed += parse_endpoint(query, "mqtt", &s->mqtt_ip, &s->mqtt_port);
+    return changed;
+}
+
+static void format_endpoint(uint32_t ip, uint32_t port, char *buf, size_t size)
+{
+    if (port == 0)
+    {
+        if (size > 0)
+            buf[0] = '\0';
+        return;
+    }
+    snprintf(buf, size, "%lu.%lu.%lu.%lu:%lu",
+             (unsigned long)(ip >> 24), (unsigned long)((ip >> 16) & 0xFF),
+             (unsigned long)((ip >> 8) & 0xFF), (unsigned long)(ip & 0xFF),
+             (unsigned long)port);
+}
+
+void settings_format_collector(const settings_t *s, char *buf, size_t size)
+{
+    format_endpoint(s->collector_ip, s->collector_port, buf, size);
+}
+
+void settings_format_telemetry(const settings_t *s, char *buf, size_t size)
+{
+    format_endpoint(s->telemetry_ip, s->telemetry_port, buf, size);
+}
+
+void settings_format_mqtt(const settings_t *s, char *buf, size_t size)
+{
+    format_endpoint(s->mqtt_ip, s->mqtt_port, buf, size);
+}
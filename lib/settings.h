@@ -0,0 +1,66 @@
+#ifndef SETTINGS_H
+#define SETTINGS_H
+
+#include "pico/stdlib.h"
+
+// Versão do layout de settings_t gravado na flash. Campos novos devem ser
+// acrescentados no fim da estrutura; registros antigos são completados com os padrões.
+#define SETTINGS_VERSION 6
+
+// Configurações ajustáveis pela interface web (limites e offsets)
+typedef struct
+{
+    float temp_offset, pressure_offset_kpa;
+    float temp_min, temp_max;
+    float pressure_min, pressure_max;
+    float altitude_min, altitude_max;
+    float humidity_min, humidity_max;
+    // Coletor que recebe os eventos de alarme (versão 2). IP em ordem de
+    // host (a.b.c.d = a << 24 | ...); porta 0 desativa o envio.
+    uint32_t collector_ip;
+    uint32_t collector_port;
+    // Destino da telemetria binária (versão 3): grupo multicast, broadcast
+    // ou unicast, no mesmo formato; porta 0 desativa.
+    uint32_t telemetry_ip;
+    uint32_t telemetry_port;
+    // Broker MQTT (versão 4); porta 0 desativa
+    uint32_t mqtt_ip;
+    uint32_t mqtt_port;
+    // Modo de baixo consumo (versão 5): 0 desliga, 1 liga; leituras a cada sample_interval_s
+    float low_power;
+    float sample_interval_s;
+    // SLO de uma volta do laço principal (versão 6); 0 desliga a contagem
+    float loop_slo_ms;
+} settings_t;
+
+// Restaura os valores padrão
+void settings_reset(settings_t *s);
+
+// Acesso genérico aos campos, na ordem da estrutura
+uint settings_field_count(void);
+const char *settings_field_name(uint index);
+float settings_get(const settings_t *s, uint index);
+void settings_set(settings_t *s, uint index, float value);
+
+// Aplica os parâmetros "nome=valor" de uma query string, incluindo
+// "collector=", "telemetry=" e "mqtt=a.b.c.d:porta". Retorna o número de campos alterados.
+uint settings_parse_query(settings_t *s, const char *query);
+
+// Configurações publicadas: escritas pelo botão de reset, pelo HTTP e pelo
+// MQTT (em interrupção) e lidas pelo laço e pelas rotas, sempre inteiras.
+// O número da versão muda a cada publicação e serve de chave de cache.
+uint32_t settings_load(settings_t *out);
+uint32_t settings_version(void);
+uint32_t settings_publish(const settings_t *s);
+// Aplica a query (ou os padrões) sobre a versão publicada e publica o
+// resultado, refazendo se outra escrita entrou no meio. Retorna o número de
+// campos alterados; sem alteração, nada é publicado.
+uint settings_publish_query(const char *query);
+void settings_publish_defaults(void);
+
+// Escreve o coletor como "a.b.c.d:porta" (vazio se desativado)
+void settings_format_collector(const settings_t *s, char *buf, size_t size);
+void settings_format_telemetry(const settings_t *s, char *buf, size_t size);
+void settings_format_mqtt(const settings_t *s, char *buf, size_t size);
+
+#endif // SETTINGS_H
@@ -0,0 +1,176 @@
+#include <string.h>
+
+#include "settings_store.h"
+#include "flash_io.h"
+#include "crc32.h"
+
+// Registro de log: uma página de flash por versão das configurações.
+// Registros nunca são reescritos; o mais novo é o de maior sequência com CRC válido.
+#define SETTINGS_RECORD_MAGIC 0x53455431u // "SET1"
+#define SETTINGS_PAYLOAD_MAX (FLASH_PAGE_SIZE - 16)
+
+typedef struct
+{
+    uint32_t magic;
+    uint32_t seq;
+    uint16_t version;
+    uint16_t length;
+    uint8_t payload[SETTINGS_PAYLOAD_MAX];
+    uint32_t crc; // Cobre todos os campos anteriores
+} settings_record_t;
+
+_Static_assert(sizeof(settings_record_t) == FLASH_PAGE_SIZE, "registro deve ocupar uma página");
+_Static_assert(sizeof(settings_t) <= SETTINGS_PAYLOAD_MAX, "settings_t não cabe no registro");
+
+#define NUM_PAGES (FLASH_SETTINGS_SIZE / FLASH_PAGE_SIZE)
+#define PAGES_PER_SECTOR (FLASH_SECTOR_SIZE / FLASH_PAGE_SIZE)
+
+static uint32_t next_seq = 1;
+static uint write_page = 0;
+static volatile bool dirty = false;
+static volatile uint32_t dirty_since_ms = 0;
+static uint32_t last_write_ms = 0;
+static bool written_once = false;
+static settings_t persisted;
+static settings_store_stats_t stats;
+
+static uint32_t page_offset(uint page)
+{
+    return FLASH_SETTINGS_OFFSET + page * FLASH_PAGE_SIZE;
+}
+
+static const settings_record_t *record_at(uint page)
+{
+    return (const settings_record_t *)flash_io_ptr(page_offset(page));
+}
+
+static bool record_valid(const settings_record_t *rec)
+{
+    return rec->magic == SETTINGS_RECORD_MAGIC &&
+           rec->length <= SETTINGS_PAYLOAD_MAX &&
+           rec->crc == crc32_update(0, rec, offsetof(settings_record_t, crc));
+}
+
+bool settings_store_init(settings_t *s)
+{
+    settings_reset(s);
+    next_seq = 1;
+    write_page = 0;
+    dirty = false;
+    written_once = false;
+    stats = (settings_store_stats_t){0};
+
+    // Varredura única: fica com o registro válido de maior sequência.
+    // Gravações interrompidas falham no CRC e são ignoradas.
+    const settings_record_t *newest = NULL;
+    uint newest_page = 0;
+    for (uint page = 0; page < NUM_PAGES; page++)
+    {
+        const settings_record_t *rec = record_at(page);
+        if (record_valid(rec) && (!newest || rec->seq > newest->seq))
+        {
+            newest = rec;
+            newest_page = page;
+        }
+    }
+
+    if (newest)
+    {
+        // Registros de versões anteriores podem ser menores: o restante fica com o padrão
+        memcpy(s, newest->payload, MIN(newest->length, sizeof(settings_t)));
+        next_seq = newest->seq + 1;
+        write_page = (newest_page + 1) % NUM_PAGES;
+        stats.seq = newest->seq;
+    }
+    persisted = *s;
+    return newest != NULL;
+}
+
+void settings_store_request_save(void)
+{
+    dirty_since_ms = to_ms_since_boot(get_absolute_time());
+    dirty = true;
+}
+
+// Grava um registro na próxima página livre do log circular. Ao entrar num
+// setor, ele é apagado antes: contém apenas registros mais antigos que o atual,
+// que sempre está no setor anterior. Isso compacta a região e distribui o
+// desgaste igualmente entre todos os setores.
+static bool write_record(const settings_t *s)
+{
+    static settings_record_t rec;
+    memset(&rec, 0xFF, sizeof(rec));
+    rec.magic = SETTINGS_RECORD_MAGIC;
+    rec.seq = next_seq;
+    rec.version = SETTINGS_VERSION;
+    rec.length = sizeof(settings_t);
+    memcpy(rec.payload, s, sizeof(settings_t));
+    rec.crc = crc32_update(0, &rec, offsetof(settings_record_t, crc));
+
+    for (uint attempt = 0; attempt < NUM_PAGES; attempt++)
+    {
+        uint page = write_page;
+        write_page = (write_page + 1) % NUM_PAGES;
+
+        if (page % PAGES_PER_SECTOR == 0)
+        {
+            if (!flash_io_is_blank(page_offset(page), FLASH_SECTOR_SIZE))
+            {
+                if (!flash_io_erase(page_offset(page), FLASH_SECTOR_SIZE))
+                    return false;
+                stats.erases++;
+            }
+        }
+        else if (!flash_io_is_blank(page_offset(page), FLASH_PAGE_SIZE))
+        {
+            // Restos de uma gravação interrompida: pula a página
+            continue;
+        }
+
+        if (!flash_io_program(page_offset(page), (const uint8_t *)&rec, sizeof(rec)))
+            return false;
+        if (!record_valid(record_at(page)) || record_at(page)->seq != rec.seq)
+            continue;
+
+        stats.seq = next_seq++;
+        stats.writes++;
+        return true;
+    }
+    return false;
+}
+
+void settings_store_task(void)
+{
+    if (!dirty)
+        return;
+
+    uint32_t now = to_ms_since_boot(get_absolute_time());
+    if (now - dirty_since_ms < SETTINGS_SAVE_DELAY_MS)
+        return;
+    if (written_once && now - last_write_ms < SETTINGS_MIN_WRITE_INTERVAL_MS)
+        return;
+
+    // Limpa antes de ler: uma escrita que chegar depois marca de novo
+    dirty = false;
+    settings_t snapshot;
+    settings_load(&snapshot);
+    if (memcmp(&snapshot, &persisted, sizeof(snapshot)) == 0)
+        return;
+
+    last_write_ms = now;
+    written_once = true;
+    if (write_record(&snapshot))
+    {
+        persisted = snapshot;
+    }
+    else
+    {
+        stats.write_errors++;
+        dirty = true; // Tenta de novo no próximo intervalo
+    }
+}
+
+void settings_store_get_stats(settings_store_stats_t *out)
+{
+    *out = stats;
+}
@@ -0,0 +1,33 @@
+#ifndef SETTINGS_STORE_H
+#define SETTINGS_STORE_H
+
+#include "pico/stdlib.h"
+#include "settings.h"
+
+// Tempo que as configurações precisam ficar estáveis antes de irem para a flash
+#define SETTINGS_SAVE_DELAY_MS 3000
+// Intervalo mínimo entre duas gravações, para limitar o desgaste
+#define SETTINGS_MIN_WRITE_INTERVAL_MS 30000
+
+typedef struct
+{
+    uint32_t writes;       // Registros gravados desde o boot
+    uint32_t erases;       // Setores apagados desde o boot
+    uint32_t seq;          // Sequência do registro mais recente
+    uint32_t write_errors;
+} settings_store_stats_t;
+
+// Varre a região uma única vez e carrega o registro válido mais recente.
+// Sem registro válido, s recebe os valores padrão e a função retorna false.
+bool settings_store_init(settings_t *s);
+
+// Marca as configurações como alteradas; pode ser chamada de interrupções
+void settings_store_request_save(void);
+
+// Chamada no laço principal: grava a versão publicada (settings_load) quando a
+// alteração assentou e o limite de taxa permite
+void settings_store_task(void);
+
+void settings_store_get_stats(settings_store_stats_t *stats);
+
+#endif // SETTINGS_STORE_H
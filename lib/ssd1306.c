@@ -1,3 +1,6 @@
+#include <stdio.h>
+#include <string.h>
+
 #include "ssd1306.h"
 #include "font.h"
 
@@ -11,6 +14,26 @@ void ssd1306_init(ssd1306_t *ssd, uint8_t width, uint8_t height, bool external_v
   ssd->ram_buffer = calloc(ssd->bufsize, sizeof(uint8_t));
   ssd->ram_buffer[0] = 0x40;
   ssd->port_buffer[0] = 0x80;
+  ssd->shadow = calloc(ssd->bufsize - 1, sizeof(uint8_t));
+  ssd->tx_buffer = calloc(SSD1306_WINDOW_HEADER + ssd->bufsize - 1, sizeof(uint8_t));
+  ssd->frames_sent = ssd->frames_skipped = 0;
+  ssd->last_frame_bytes = ssd->total_bytes = 0;
+  ssd1306_invalidate(ssd);
+}
+
+void ssd1306_invalidate(ssd1306_t *ssd) {
+  ssd->shadow_valid = false;
+  for (uint8_t p = 0; p < ssd->pages; ++p) {
+    ssd->dirty_lo[p] = 0;
+    ssd->dirty_hi[p] = ssd->width - 1;
+  }
+}
+
+static inline void mark_dirty(ssd1306_t *ssd, uint8_t x, uint8_t page) {
+  if (x < ssd->dirty_lo[page])
+    ssd->dirty_lo[page] = x;
+  if (x > ssd->dirty_hi[page])
+    ssd->dirty_hi[page] = x;
 }
 
 void ssd1306_config(ssd1306_t *ssd) {
@@ -41,6 +64,19 @@ void ssd1306_config(ssd1306_t *ssd) {
   ssd1306_command(ssd, SET_DISP | 0x01);
 }
 
+void ssd1306_set_power(ssd1306_t *ssd, bool on) {
+  // Desligado, sem a bomba de carga, o controlador fica em alguns uA e guarda a RAM
+  if (on) {
+    ssd1306_command(ssd, SET_CHARGE_PUMP);
+    ssd1306_command(ssd, 0x14);
+    ssd1306_command(ssd, SET_DISP | 0x01);
+  } else {
+    ssd1306_command(ssd, SET_DISP | 0x00);
+    ssd1306_command(ssd, SET_CHARGE_PUMP);
+    ssd1306_command(ssd, 0x10);
+  }
+}
+
 void ssd1306_command(ssd1306_t *ssd, uint8_t command) {
   ssd->port_buffer[1] = command;
   i2c_write_blocking(
@@ -52,69 +88,163 @@ void ssd1306_command(ssd1306_t *ssd, uint8_t command) {
   );
 }
 
+// Reduz a faixa suja de cada página às colunas que diferem do que já está na tela
+static void trim_dirty(ssd1306_t *ssd, uint8_t page) {
+  const uint8_t *buf = ssd->ram_buffer + 1;
+  uint8_t lo = ssd->dirty_lo[page], hi = ssd->dirty_hi[page];
+  while (lo <= hi && buf[lo * ssd->pages + page] == ssd->shadow[lo * ssd->pages + page])
+    ++lo;
+  while (hi > lo && buf[hi * ssd->pages + page] == ssd->shadow[hi * ssd->pages + page])
+    --hi;
+  ssd->dirty_lo[page] = lo;
+  ssd->dirty_hi[page] = hi;
+}
+
+// Envia uma janela em uma única transação: comandos com Co=1 seguidos do fluxo de dados.
+// No modo de endereçamento vertical os bytes vão coluna a coluna, página a página.
+static uint32_t send_window(ssd1306_t *ssd, uint8_t c0, uint8_t c1, uint8_t p0, uint8_t p1) {
+  uint8_t *tx = ssd->tx_buffer;
+  const uint8_t header[SSD1306_WINDOW_HEADER] = {
+    0x80, SET_COL_ADDR, 0x80, c0, 0x80, c1,
+    0x80, SET_PAGE_ADDR, 0x80, p0, 0x80, p1,
+    0x40
+  };
+  size_t len = SSD1306_WINDOW_HEADER;
+  for (uint8_t i = 0; i < SSD1306_WINDOW_HEADER; ++i)
+    tx[i] = header[i];
+
+  uint8_t rows = p1 - p0 + 1;
+  for (uint16_t x = c0; x <= c1; ++x) {
+    uint16_t base = x * ssd->pages + p0;
+    for (uint8_t r = 0; r < rows; ++r) {
+      tx[len++] = ssd->ram_buffer[base + r + 1];
+      ssd->shadow[base + r] = ssd->ram_buffer[base + r + 1];
+    }
+  }
+  i2c_write_blocking(ssd->i2c_port, ssd->address, tx, len, false);
+  return len;
+}
+
 void ssd1306_send_data(ssd1306_t *ssd) {
-  ssd1306_command(ssd, SET_COL_ADDR);
-  ssd1306_command(ssd, 0);
-  ssd1306_command(ssd, ssd->width - 1);
-  ssd1306_command(ssd, SET_PAGE_ADDR);
-  ssd1306_command(ssd, 0);
-  ssd1306_command(ssd, ssd->pages - 1);
-  i2c_write_blocking(
-    ssd->i2c_port,
-    ssd->address,
-    ssd->ram_buffer,
-    ssd->bufsize,
-    false
-  );
+  if (ssd->shadow_valid) {
+    for (uint8_t p = 0; p < ssd->pages; ++p) {
+      if (ssd->dirty_lo[p] <= ssd->dirty_hi[p])
+        trim_dirty(ssd, p);
+    }
+  }
+
+  // Agrupa páginas sujas consecutivas numa janela enquanto isso custa menos
+  // bytes do que abrir uma janela nova para cada uma
+  uint32_t bytes = 0;
+  uint8_t p = 0;
+  while (p < ssd->pages) {
+    if (ssd->dirty_lo[p] > ssd->dirty_hi[p]) {
+      ++p;
+      continue;
+    }
+    uint8_t p0 = p, p1 = p;
+    uint8_t lo = ssd->dirty_lo[p], hi = ssd->dirty_hi[p];
+    uint32_t separate = hi - lo + 1;
+    while (p1 + 1 < ssd->pages && ssd->dirty_lo[p1 + 1] <= ssd->dirty_hi[p1 + 1]) {
+      uint8_t nlo = MIN(lo, ssd->dirty_lo[p1 + 1]);
+      uint8_t nhi = MAX(hi, ssd->dirty_hi[p1 + 1]);
+      uint32_t next = ssd->dirty_hi[p1 + 1] - ssd->dirty_lo[p1 + 1] + 1;
+      uint32_t merged = (uint32_t)(nhi - nlo + 1) * (p1 + 2 - p0);
+      if (merged > separate + next + SSD1306_WINDOW_HEADER + 1)
+        break;
+      lo = nlo;
+      hi = nhi;
+      separate = merged;
+      ++p1;
+    }
+    bytes += send_window(ssd, lo, hi, p0, p1) + 1; // + byte de endereço
+    p = p1 + 1;
+  }
+
+  for (p = 0; p < ssd->pages; ++p) {
+    ssd->dirty_lo[p] = SSD1306_CLEAN;
+    ssd->dirty_hi[p] = 0;
+  }
+  ssd->shadow_valid = true;
+
+  ssd->last_frame_bytes = bytes;
+  ssd->total_bytes += bytes;
+  if (bytes)
+    ssd->frames_sent++;
+  else
+    ssd->frames_skipped++;
 }
 
 void ssd1306_pixel(ssd1306_t *ssd, uint8_t x, uint8_t y, bool value) {
+  if (x >= ssd->width || y >= ssd->height)
+    return;
   uint16_t index = (y >> 3) + (x << 3) + 1;
   uint8_t pixel = (y & 0b111);
+  mark_dirty(ssd, x, y >> 3);
   if (value)
     ssd->ram_buffer[index] |= (1 << pixel);
   else
     ssd->ram_buffer[index] &= ~(1 << pixel);
 }
 
-/*
-void ssd1306_fill(ssd1306_t *ssd, bool value) {
-  uint8_t byte = value ? 0xFF : 0x00;
-  for (uint8_t i = 1; i < ssd->bufsize; ++i)
-    ssd->ram_buffer[i] = byte;
-}*/
+static inline void mark_dirty_range(ssd1306_t *ssd, uint8_t x0, uint8_t x1, uint8_t page) {
+  if (x0 < ssd->dirty_lo[page])
+    ssd->dirty_lo[page] = x0;
+  if (x1 > ssd->dirty_hi[page])
+    ssd->dirty_hi[page] = x1;
+}
 
-void ssd1306_fill(ssd1306_t *ssd, bool value) {
-    // Itera por todas as posições do display
-    for (uint8_t y = 0; y < ssd->height; ++y) {
-        for (uint8_t x = 0; x < ssd->width; ++x) {
-            ssd1306_pixel(ssd, x, y, value);
-        }
-    }
+// Byte da coluna x na página page (o buffer é organizado coluna a coluna)
+static inline uint8_t *column_byte(ssd1306_t *ssd, uint8_t x, uint8_t page) {
+  return &ssd->ram_buffer[x * ssd->pages + page + 1];
 }
 
+// Aplica mask a um byte: liga ou desliga os bits selecionados
+static inline void apply_mask(uint8_t *byte, uint8_t mask, bool value) {
+  if (value)
+    *byte |= mask;
+  else
+    *byte &= ~mask;
+}
 
+void ssd1306_fill(ssd1306_t *ssd, bool value) {
+  memset(ssd->ram_buffer + 1, value ? 0xFF : 0x00, ssd->bufsize - 1);
+  for (uint8_t p = 0; p < ssd->pages; ++p)
+    mark_dirty_range(ssd, 0, ssd->width - 1, p);
+}
 
 void ssd1306_rect(ssd1306_t *ssd, uint8_t top, uint8_t left, uint8_t width, uint8_t height, bool value, bool fill) {
-  for (uint8_t x = left; x < left + width; ++x) {
-    ssd1306_pixel(ssd, x, top, value);
-    ssd1306_pixel(ssd, x, top + height - 1, value);
-  }
-  for (uint8_t y = top; y < top + height; ++y) {
-    ssd1306_pixel(ssd, left, y, value);
-    ssd1306_pixel(ssd, left + width - 1, y, value);
-  }
+  if (width == 0 || height == 0)
+    return;
+  uint16_t right = left + width - 1, bottom = top + height - 1;
+  uint8_t x1 = right < ssd->width ? right : ssd->width - 1;
+  uint8_t y1 = bottom < ssd->height ? bottom : ssd->height - 1;
 
   if (fill) {
-    for (uint8_t x = left + 1; x < left + width - 1; ++x) {
-      for (uint8_t y = top + 1; y < top + height - 1; ++y) {
-        ssd1306_pixel(ssd, x, y, value);
-      }
-    }
+    // Contorno e interior têm o mesmo valor: um span vertical por coluna
+    for (uint16_t x = left; x <= x1; ++x)
+      ssd1306_vline(ssd, x, top, y1, value);
+    return;
   }
+  ssd1306_hline(ssd, left, x1, top, value);
+  if (bottom < ssd->height)
+    ssd1306_hline(ssd, left, x1, bottom, value);
+  ssd1306_vline(ssd, left, top, y1, value);
+  if (right < ssd->width)
+    ssd1306_vline(ssd, right, top, y1, value);
 }
 
 void ssd1306_line(ssd1306_t *ssd, uint8_t x0, uint8_t y0, uint8_t x1, uint8_t y1, bool value) {
+    // Linhas retas usam os spans de byte
+    if (y0 == y1) {
+        ssd1306_hline(ssd, MIN(x0, x1), MAX(x0, x1), y0, value);
+        return;
+    }
+    if (x0 == x1) {
+        ssd1306_vline(ssd, x0, MIN(y0, y1), MAX(y0, y1), value);
+        return;
+    }
+
     int dx = abs(x1 - x0);
     int dy = abs(y1 - y0);
 
@@ -142,15 +272,103 @@ void ssd1306_line(ssd1306_t *ssd, uint8_t x0, uint8_t y0, uint8_t x1, uint8_t y1
     }
 }
 
-
 void ssd1306_hline(ssd1306_t *ssd, uint8_t x0, uint8_t x1, uint8_t y, bool value) {
-  for (uint8_t x = x0; x <= x1; ++x)
-    ssd1306_pixel(ssd, x, y, value);
+  if (y >= ssd->height || x0 >= ssd->width || x0 > x1)
+    return;
+  if (x1 >= ssd->width)
+    x1 = ssd->width - 1;
+
+  // Mesmo bit em bytes consecutivos de colunas: passo de ssd->pages no buffer
+  uint8_t page = y >> 3, mask = 1 << (y & 7);
+  uint8_t *byte = column_byte(ssd, x0, page);
+  for (uint16_t x = x0; x <= x1; ++x, byte += ssd->pages)
+    apply_mask(byte, mask, value);
+  mark_dirty_range(ssd, x0, x1, page);
 }
 
 void ssd1306_vline(ssd1306_t *ssd, uint8_t x, uint8_t y0, uint8_t y1, bool value) {
-  for (uint8_t y = y0; y <= y1; ++y)
-    ssd1306_pixel(ssd, x, y, value);
+  if (x >= ssd->width || y0 >= ssd->height || y0 > y1)
+    return;
+  if (y1 >= ssd->height)
+    y1 = ssd->height - 1;
+
+  // Bytes da coluna são contíguos: máscara parcial nas pontas, bytes inteiros no meio
+  uint8_t p0 = y0 >> 3, p1 = y1 >> 3;
+  uint8_t first = 0xFF << (y0 & 7), last = 0xFF >> (7 - (y1 & 7));
+  uint8_t *byte = column_byte(ssd, x, 0);
+  if (p0 == p1) {
+    apply_mask(&byte[p0], first & last, value);
+  } else {
+    apply_mask(&byte[p0], first, value);
+    for (uint8_t p = p0 + 1; p < p1; ++p)
+      byte[p] = value ? 0xFF : 0x00;
+    apply_mask(&byte[p1], last, value);
+  }
+  for (uint8_t p = p0; p <= p1; ++p)
+    mark_dirty_range(ssd, x, x, p);
+}
+
+void ssd1306_shift_left(ssd1306_t *ssd, uint8_t first_page, uint8_t last_page) {
+  if (first_page > last_page || last_page >= ssd->pages)
+    return;
+  uint8_t rows = last_page - first_page + 1;
+  uint8_t *dst = column_byte(ssd, 0, first_page);
+  for (uint8_t x = 0; x + 1 < ssd->width; ++x, dst += ssd->pages)
+    memcpy(dst, dst + ssd->pages, rows);
+  memset(dst, 0, rows);
+  for (uint8_t p = first_page; p <= last_page; ++p)
+    mark_dirty_range(ssd, 0, ssd->width - 1, p);
+}
+
+size_t ssd1306_export_pbm(const ssd1306_t *ssd, uint8_t *out, size_t size) {
+  int header = snprintf((char *)out, size, "P4\n%u %u\n", ssd->width, ssd->height);
+  size_t row_bytes = (ssd->width + 7) / 8;
+  size_t len = header + row_bytes * ssd->height;
+  if (header < 0 || len > size)
+    return 0;
+
+  // PBM binário: uma linha por vez, pixel mais à esquerda no bit mais alto, 1 = preto.
+  // O pixel aceso vira preto, como num "print" da tela.
+  uint8_t *row = out + header;
+  for (uint8_t y = 0; y < ssd->height; ++y, row += row_bytes) {
+    memset(row, 0, row_bytes);
+    for (uint8_t x = 0; x < ssd->width; ++x) {
+      if (ssd->ram_buffer[x * ssd->pages + (y >> 3) + 1] & (1 << (y & 7)))
+        row[x >> 3] |= 0x80 >> (x & 7);
+    }
+  }
+  return len;
+}
+
+// Desenha colunas de 8 pixels (bit 0 em cima), o mesmo formato das páginas do
+// controlador. Com y alinhado a 8 cada coluna é um byte; senão ela se divide
+// entre duas páginas. transparent só liga pixels; caso contrário copia a coluna.
+void ssd1306_draw_bitmap(ssd1306_t *ssd, const uint8_t *columns, uint8_t width, uint8_t x, uint8_t y, bool transparent) {
+  if (x >= ssd->width || y >= ssd->height)
+    return;
+  uint8_t w = (x + width > ssd->width) ? ssd->width - x : width;
+  uint8_t page = y >> 3, shift = y & 7;
+  bool second = shift && page + 1 < ssd->pages;
+  uint8_t keep_low = (1 << shift) - 1; // Bits da primeira página acima do bitmap
+
+  uint8_t *byte = column_byte(ssd, x, page);
+  for (uint8_t i = 0; i < w; ++i, byte += ssd->pages) {
+    uint8_t col = columns[i];
+    if (transparent) {
+      byte[0] |= col << shift;
+      if (second)
+        byte[1] |= col >> (8 - shift);
+    } else if (!shift) {
+      byte[0] = col;
+    } else {
+      byte[0] = (byte[0] & keep_low) | (uint8_t)(col << shift);
+      if (second)
+        byte[1] = (byte[1] & ~keep_low) | (col >> (8 - shift));
+    }
+  }
+  mark_dirty_range(ssd, x, x + w - 1, page);
+  if (second)
+    mark_dirty_range(ssd, x, x + w - 1, page + 1);
 }
 
 // Função para desenhar um caractere
@@ -169,15 +387,8 @@ void ssd1306_draw_char(ssd1306_t *ssd, char c, uint8_t x, uint8_t y)
     index = 0; // Índice 0 corresponde ao caractere "nada" (espaço)
   }
 
-  // Desenha o caractere na tela
-  for (uint8_t i = 0; i < 8; ++i)
-  {
-    uint8_t line = font[index + i]; // Acessa a linha correspondente do caractere na fonte
-    for (uint8_t j = 0; j < 8; ++j)
-    {
-      ssd1306_pixel(ssd, x + i, y + j, line & (1 << j)); // Desenha cada pixel do caractere
-    }
-  }
+  // As colunas da fonte já estão no formato das páginas: copia byte a byte
+  ssd1306_draw_bitmap(ssd, &font[index], 8, x, y, false);
 }
 
 // Função para desenhar uma string
@@ -1,3 +1,6 @@
+#ifndef SSD1306_H
+#define SSD1306_H
+
 #include <stdlib.h>
 #include "pico/stdlib.h"
 #include "hardware/i2c.h"
@@ -25,6 +28,13 @@ typedef enum {
   SET_CHARGE_PUMP = 0x8D
 } ssd1306_command_t;
 
+#define SSD1306_MAX_PAGES 8
+// Valor de dirty_lo de uma página sem alterações
+#define SSD1306_CLEAN 0xFF
+
+// Bytes de comando antes dos dados em cada janela: seis pares (0x80, comando) e o 0x40
+#define SSD1306_WINDOW_HEADER 13
+
 typedef struct {
   uint8_t width, height, pages, address;
   i2c_inst_t *i2c_port;
@@ -32,12 +42,26 @@ typedef struct {
   uint8_t *ram_buffer;
   size_t bufsize;
   uint8_t port_buffer[2];
+  // Conteúdo já enviado ao controlador e faixa de colunas alteradas por página
+  // desde o último envio (dirty_lo > dirty_hi: página limpa)
+  uint8_t *shadow;
+  uint8_t *tx_buffer;
+  bool shadow_valid;
+  uint8_t dirty_lo[SSD1306_MAX_PAGES], dirty_hi[SSD1306_MAX_PAGES];
+  // Estatísticas de envio
+  uint32_t frames_sent, frames_skipped;
+  uint32_t last_frame_bytes, total_bytes;
 } ssd1306_t;
 
 void ssd1306_init(ssd1306_t *ssd, uint8_t width, uint8_t height, bool external_vcc, uint8_t address, i2c_inst_t *i2c);
 void ssd1306_config(ssd1306_t *ssd);
 void ssd1306_command(ssd1306_t *ssd, uint8_t command);
+// Liga ou apaga o painel; o conteúdo da RAM do controlador é mantido
+void ssd1306_set_power(ssd1306_t *ssd, bool on);
+// Envia só as janelas alteradas desde o último envio; não faz nada se nada mudou
 void ssd1306_send_data(ssd1306_t *ssd);
+// Força o reenvio do quadro inteiro no próximo ssd1306_send_data
+void ssd1306_invalidate(ssd1306_t *ssd);
 
 void ssd1306_pixel(ssd1306_t *ssd, uint8_t x, uint8_t y, bool value);
 void ssd1306_fill(ssd1306_t *ssd, bool value);
@@ -45,5 +69,13 @@ void ssd1306_rect(ssd1306_t *ssd, uint8_t top, uint8_t left, uint8_t width, uint
 void ssd1306_line(ssd1306_t *ssd, uint8_t x0, uint8_t y0, uint8_t x1, uint8_t y1, bool value);
 void ssd1306_hline(ssd1306_t *ssd, uint8_t x0, uint8_t x1, uint8_t y, bool value);
 void ssd1306_vline(ssd1306_t *ssd, uint8_t x, uint8_t y0, uint8_t y1, bool value);
+// Desloca as páginas [first_page, last_page] uma coluna para a esquerda; a última coluna fica apagada
+void ssd1306_shift_left(ssd1306_t *ssd, uint8_t first_page, uint8_t last_page);
+// Copia o quadro atual como imagem PBM binária (P4). Retorna o tamanho, ou 0 se não couber.
+size_t ssd1306_export_pbm(const ssd1306_t *ssd, uint8_t *out, size_t size);
+// Bitmap de colunas de 8 pixels (bit 0 em cima), recortado nas bordas da tela
+void ssd1306_draw_bitmap(ssd1306_t *ssd, const uint8_t *columns, uint8_t width, uint8_t x, uint8_t y, bool transparent);
 void ssd1306_draw_char(ssd1306_t *ssd, char c, uint8_t x, uint8_t y);
-void ssd1306_draw_string(ssd1306_t *ssd, const char *str, uint8_t x, uint8_t y);
\ No newline at end of file
+void ssd1306_draw_string(ssd1306_t *ssd, const char *str, uint8_t x, uint8_t y);
+
+#endif // SSD1306_H
@@ -0,0 +1,17 @@
+#include "tca9548a.h"
+
+bool tca9548a_check(i2c_inst_t *i2c, uint8_t addr) {
+    uint8_t mask;
+    return i2c_read_blocking(i2c, addr, &mask, 1, false) == 1;
+}
+
+bool tca9548a_set_mask(i2c_inst_t *i2c, uint8_t addr, uint8_t mask) {
+    // O TCA9548A tem um único registrador de controle, escrito sem endereço de registrador
+    return i2c_write_blocking(i2c, addr, &mask, 1, false) == 1;
+}
+
+bool tca9548a_select(i2c_inst_t *i2c, uint8_t addr, uint8_t channel) {
+    if (channel >= TCA9548A_NUM_CHANNELS)
+        return false;
+    return tca9548a_set_mask(i2c, addr, (uint8_t)(1u << channel));
+}
@@ -0,0 +1,23 @@
+#ifndef TCA9548A_H
+#define TCA9548A_H
+
+#include "pico/stdlib.h"
+#include "hardware/i2c.h"
+
+// Faixa de endereços do multiplexador (pinos A0..A2)
+#define TCA9548A_I2C_ADDR_MIN 0x70
+#define TCA9548A_I2C_ADDR_MAX 0x77
+
+// Número de canais de saída
+#define TCA9548A_NUM_CHANNELS 8
+
+// Verifica se há um multiplexador respondendo no endereço informado
+bool tca9548a_check(i2c_inst_t *i2c, uint8_t addr);
+
+// Habilita os canais indicados pela máscara (bit n = canal n). Máscara 0 desconecta todos.
+bool tca9548a_set_mask(i2c_inst_t *i2c, uint8_t addr, uint8_t mask);
+
+// Habilita somente o canal informado
+bool tca9548a_select(i2c_inst_t *i2c, uint8_t addr, uint8_t channel);
+
+#endif // TCA9548A_H
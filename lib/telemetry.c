@@ -0,0 +1,134 @@
+#include <string.h>
+
+#include "pico/cyw43_arch.h"
+#include "lwip/udp.h"
+
+#include "telemetry.h"
+#include "sensors.h"
+
+#define DATAGRAM_SIZE (TELEMETRY_HEADER_SIZE + TELEMETRY_MAX_RECORDS * TELEMETRY_RECORD_SIZE)
+
+static struct udp_pcb *pcb = NULL;
+static ip_addr_t dest_addr;
+static uint16_t dest_port = 0;
+static uint32_t dest_ip = 0;
+
+static uint32_t device = 0;
+static uint32_t seq = 0;
+
+// Lote em formação, já no formato do fio
+static uint8_t datagram[DATAGRAM_SIZE];
+static uint8_t count = 0;
+static uint32_t base_ts;
+
+static telemetry_stats_t stats;
+
+static void put_le16(uint8_t *p, uint16_t v)
+{
+    p[0] = v & 0xFF;
+    p[1] = v >> 8;
+}
+
+static void put_le32(uint8_t *p, uint32_t v)
+{
+    put_le16(p, v & 0xFFFF);
+    put_le16(p + 2, v >> 16);
+}
+
+bool telemetry_init(uint32_t device_id)
+{
+    device = device_id;
+
+    cyw43_arch_lwip_begin();
+    pcb = udp_new();
+    if (pcb)
+    {
+        ip_set_option(pcb, SOF_BROADCAST);
+#if LWIP_MULTICAST_TX_OPTIONS
+        udp_set_multicast_ttl(pcb, TELEMETRY_MULTICAST_TTL);
+#endif
+    }
+    cyw43_arch_lwip_end();
+    return pcb != NULL;
+}
+
+void telemetry_set_destination(uint32_t ip, uint16_t port)
+{
+    if (ip == dest_ip && port == dest_port)
+        return;
+    IP_ADDR4(&dest_addr, (ip >> 24) & 0xFF, (ip >> 16) & 0xFF, (ip >> 8) & 0xFF, ip & 0xFF);
+    dest_ip = ip;
+    dest_port = port;
+    count = 0;
+}
+
+static void flush(void)
+{
+    if (count == 0)
+        return;
+
+    datagram[0] = 'M';
+    datagram[1] = 'A';
+    datagram[2] = TELEMETRY_VERSION;
+    datagram[3] = count;
+    put_le32(datagram + 4, device);
+    put_le32(datagram + 8, seq);
+    put_le32(datagram + 12, base_ts);
+    u16_t len = TELEMETRY_HEADER_SIZE + count * TELEMETRY_RECORD_SIZE;
+
+    err_t err = ERR_MEM;
+    cyw43_arch_lwip_begin();
+    struct pbuf *p = pbuf_alloc(PBUF_TRANSPORT, len, PBUF_RAM);
+    if (p)
+    {
+        memcpy(p->payload, datagram, len);
+        err = udp_sendto(pcb, p, &dest_addr, dest_port);
+        pbuf_free(p);
+    }
+    cyw43_arch_lwip_end();
+
+    // O seq avança mesmo em falha, para o receptor enxergar a perda
+    seq++;
+    if (err == ERR_OK)
+    {
+        stats.datagrams++;
+        stats.samples += count;
+    }
+    else
+    {
+        stats.send_errors++;
+    }
+    count = 0;
+}
+
+void telemetry_add_sample(uint8_t channel, uint32_t ts, float value)
+{
+    if (!pcb || !dest_port)
+        return;
+
+    // Lote cheio ou amostra fora do alcance do dt de 16 bits
+    if (count == TELEMETRY_MAX_RECORDS || (count > 0 && ts - base_ts > UINT16_MAX))
+        flush();
+    if (count == 0)
+        base_ts = ts;
+
+    uint8_t *r = datagram + TELEMETRY_HEADER_SIZE + count * TELEMETRY_RECORD_SIZE;
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    r[0] = channel;
+    r[1] = (uint8_t)sensors_channel(channel)->kind;
+    put_le16(r + 2, (uint16_t)(ts - base_ts));
+    put_le32(r + 4, bits);
+    count++;
+}
+
+void telemetry_task(uint32_t now_ms)
+{
+    if (count > 0 && (int32_t)(now_ms - base_ts) >= TELEMETRY_BATCH_MS)
+        flush();
+}
+
+void telemetry_get_stats(telemetry_stats_t *out)
+{
+    *out = stats;
+}
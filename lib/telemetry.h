@@ -0,0 +1,45 @@
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include "pico/stdlib.h"
+
+// Datagrama binário, little-endian, versão TELEMETRY_VERSION:
+//   cabeçalho (16 bytes): 'M' 'A' | versão u8 | n u8 | device_id u32 | seq u32 | base_ts u32
+//   n registros (8 bytes): canal u8 | grandeza u8 | dt u16 (ms desde base_ts) | valor float32
+// seq cresce 1 por datagrama a partir de 0 a cada boot: um salto indica perda
+// e uma volta a 0 indica reinício do dispositivo.
+#define TELEMETRY_VERSION 1
+#define TELEMETRY_HEADER_SIZE 16
+#define TELEMETRY_RECORD_SIZE 8
+#define TELEMETRY_MAX_RECORDS 58 // 480 bytes de dados, bem abaixo do MTU
+
+// Tempo máximo que uma amostra espera por companhia antes do envio. Com uma
+// leitura por segundo, cada datagrama leva todos os canais de uma leitura;
+// com taxas maiores, várias leituras seguem juntas.
+#define TELEMETRY_BATCH_MS 500
+
+// Saltos permitidos para os datagramas multicast (se o lwIP tiver a opção)
+#define TELEMETRY_MULTICAST_TTL 4
+
+typedef struct
+{
+    uint32_t datagrams;
+    uint32_t samples;
+    uint32_t send_errors;
+} telemetry_stats_t;
+
+// Abre o socket de envio. device_id identifica o nó para os receptores.
+bool telemetry_init(uint32_t device_id);
+
+// Grupo multicast, broadcast ou unicast; porta 0 desativa e descarta o lote pendente
+void telemetry_set_destination(uint32_t ip, uint16_t port);
+
+// Acrescenta uma amostra ao lote; envia antes se o lote estiver cheio
+void telemetry_add_sample(uint8_t channel, uint32_t ts, float value);
+
+// Envia o lote quando a amostra mais antiga completou TELEMETRY_BATCH_MS
+void telemetry_task(uint32_t now_ms);
+
+void telemetry_get_stats(telemetry_stats_t *stats);
+
+#endif // TELEMETRY_H
@@ -0,0 +1,412 @@
+#include <string.h>
+#include <math.h>
+
+#include "tsdb.h"
+
+// Larguras dos campos para cada prefixo: '10', '110', '1110' e '1111'.
+// O valor zero é codificado com um único bit '0'.
+static const uint8_t DOD_WIDTHS[4] = {7, 9, 12, 32};
+static const uint8_t DELTA_WIDTHS[4] = {3, 7, 12, 32};
+
+#define TSDB_BLOCK_BITS (TSDB_BLOCK_BYTES * 8)
+#define TSDB_VALUE_LIMIT 1.0e9f
+
+static tsdb_block_t blocks[TSDB_NUM_BLOCKS];
+static uint16_t heads[TSDB_MAX_CHANNELS];
+static uint16_t tails[TSDB_MAX_CHANNELS];
+static uint32_t channel_samples[TSDB_MAX_CHANNELS];
+static uint16_t free_head;
+static uint32_t next_seq;
+static uint32_t evictions;
+static tsdb_seal_callback_t seal_callback;
+
+static inline uint32_t zigzag(int32_t n)
+{
+    return ((uint32_t)n << 1) ^ (uint32_t)(n >> 31);
+}
+
+static inline int32_t unzigzag(uint32_t z)
+{
+    return (int32_t)(z >> 1) ^ -(int32_t)(z & 1);
+}
+
+static void put_bits(tsdb_block_t *b, uint32_t value, uint8_t nbits)
+{
+    while (nbits--)
+    {
+        if ((value >> nbits) & 1)
+            b->data[b->bit_len >> 3] |= (uint8_t)(0x80 >> (b->bit_len & 7));
+        b->bit_len++;
+    }
+}
+
+static uint32_t get_bits(const uint8_t *data, uint16_t *pos, uint8_t nbits)
+{
+    uint32_t value = 0;
+    while (nbits--)
+    {
+        value = (value << 1) | ((data[*pos >> 3] >> (7 - (*pos & 7))) & 1);
+        (*pos)++;
+    }
+    return value;
+}
+
+static uint bucket_of(uint32_t z, const uint8_t *widths)
+{
+    for (uint i = 0; i < 3; i++)
+    {
+        if (z < (1u << widths[i]))
+            return i;
+    }
+    return 3;
+}
+
+static uint bucket_bits(uint32_t z, const uint8_t *widths)
+{
+    if (z == 0)
+        return 1;
+    uint i = bucket_of(z, widths);
+    return (i < 3 ? i + 2 : 4) + widths[i];
+}
+
+static void put_bucketed(tsdb_block_t *b, uint32_t z, const uint8_t *widths)
+{
+    if (z == 0)
+    {
+        put_bits(b, 0, 1);
+        return;
+    }
+    uint i = bucket_of(z, widths);
+    if (i < 3)
+        put_bits(b, ((1u << (i + 1)) - 1) << 1, i + 2);
+    else
+        put_bits(b, 0xF, 4);
+    put_bits(b, z, widths[i]);
+}
+
+static uint32_t get_bucketed(const uint8_t *data, uint16_t *pos, const uint8_t *widths)
+{
+    if (!get_bits(data, pos, 1))
+        return 0;
+    uint i = 0;
+    while (i < 3 && get_bits(data, pos, 1))
+        i++;
+    return get_bits(data, pos, widths[i]);
+}
+
+void tsdb_init(void)
+{
+    for (uint i = 0; i < TSDB_NUM_BLOCKS; i++)
+    {
+        blocks[i].seq = 0;
+        blocks[i].next = (i + 1 < TSDB_NUM_BLOCKS) ? (uint16_t)(i + 1) : TSDB_NO_BLOCK;
+    }
+    for (uint c = 0; c < TSDB_MAX_CHANNELS; c++)
+    {
+        heads[c] = tails[c] = TSDB_NO_BLOCK;
+        channel_samples[c] = 0;
+    }
+    free_head = 0;
+    next_seq = 1;
+    evictions = 0;
+}
+
+void tsdb_set_seal_callback(tsdb_seal_callback_t callback)
+{
+    seal_callback = callback;
+}
+
+static void seal_block(tsdb_block_t *b)
+{
+    if (b->sealed)
+        return;
+    b->sealed = true;
+    if (seal_callback && b->count > 0)
+        seal_callback(b);
+}
+
+// Descarta o bloco fechado mais antigo de todos. Como cada canal mantém seus
+// blocos em ordem de alocação, ele é sempre a cabeça de alguma lista. Uma
+// cabeça ainda aberta (o único bloco de um canal lento) fica: os dados dela
+// ainda não passaram pelo callback e se perderiam antes de chegar à flash.
+static uint16_t evict_oldest(void)
+{
+    int victim_channel = -1;
+    uint32_t oldest_seq = UINT32_MAX;
+    for (uint c = 0; c < TSDB_MAX_CHANNELS; c++)
+    {
+        if (heads[c] != TSDB_NO_BLOCK && blocks[heads[c]].sealed && blocks[heads[c]].seq < oldest_seq)
+        {
+            oldest_seq = blocks[heads[c]].seq;
+            victim_channel = (int)c;
+        }
+    }
+    if (victim_channel < 0)
+        return TSDB_NO_BLOCK;
+
+    uint16_t victim = heads[victim_channel];
+    heads[victim_channel] = blocks[victim].next;
+    if (heads[victim_channel] == TSDB_NO_BLOCK)
+        tails[victim_channel] = TSDB_NO_BLOCK;
+    channel_samples[victim_channel] -= blocks[victim].count;
+    evictions++;
+    return victim;
+}
+
+static tsdb_block_t *open_block(uint8_t channel)
+{
+    uint16_t index = free_head;
+    if (index != TSDB_NO_BLOCK)
+        free_head = blocks[index].next;
+    else
+        index = evict_oldest();
+    if (index == TSDB_NO_BLOCK)
+        return NULL;
+
+    // O bloco é preparado por completo antes de ficar visível para os leitores
+    tsdb_block_t *b = &blocks[index];
+    b->seq = next_seq++;
+    b->next = TSDB_NO_BLOCK;
+    b->count = 0;
+    b->bit_len = 0;
+    b->channel = channel;
+    b->sealed = false;
+    memset(b->data, 0, sizeof(b->data));
+
+    if (tails[channel] == TSDB_NO_BLOCK)
+        heads[channel] = index;
+    else
+        blocks[tails[channel]].next = index;
+    tails[channel] = index;
+    return b;
+}
+
+bool tsdb_append(uint8_t channel, uint32_t timestamp_ms, float value)
+{
+    if (channel >= TSDB_MAX_CHANNELS || isnan(value))
+        return false;
+
+    float scaled = value * TSDB_VALUE_SCALE;
+    if (scaled > TSDB_VALUE_LIMIT)
+        scaled = TSDB_VALUE_LIMIT;
+    else if (scaled < -TSDB_VALUE_LIMIT)
+        scaled = -TSDB_VALUE_LIMIT;
+    int32_t q = (int32_t)lroundf(scaled);
+
+    tsdb_block_t *b = (tails[channel] != TSDB_NO_BLOCK) ? &blocks[tails[channel]] : NULL;
+    if (b && b->count > 0 && !b->sealed)
+    {
+        int32_t delta = (int32_t)(timestamp_ms - b->last_ts);
+        if (delta < 0)
+            return false;
+
+        uint32_t dod = zigzag(delta - b->last_delta);
+        uint32_t dv = zigzag(q - b->last_value);
+        if (b->bit_len + bucket_bits(dod, DOD_WIDTHS) + bucket_bits(dv, DELTA_WIDTHS) <= TSDB_BLOCK_BITS)
+        {
+            put_bucketed(b, dod, DOD_WIDTHS);
+            put_bucketed(b, dv, DELTA_WIDTHS);
+            b->last_ts = timestamp_ms;
+            b->last_delta = delta;
+            b->last_value = q;
+            b->count++;
+            channel_samples[channel]++;
+            return true;
+        }
+    }
+
+    // Bloco cheio (ou inexistente): a primeira amostra de cada bloco vai sem compressão
+    if (b)
+        seal_block(b);
+    b = open_block(channel);
+    if (!b)
+        return false;
+    put_bits(b, timestamp_ms, 32);
+    put_bits(b, (uint32_t)q, 32);
+    b->first_ts = timestamp_ms;
+    b->last_ts = timestamp_ms;
+    b->last_delta = 0;
+    b->last_value = q;
+    b->count = 1;
+    channel_samples[channel]++;
+    return true;
+}
+
+void tsdb_seal_older_than(uint32_t ts)
+{
+    for (uint c = 0; c < TSDB_MAX_CHANNELS; c++)
+    {
+        if (tails[c] == TSDB_NO_BLOCK)
+            continue;
+        tsdb_block_t *b = &blocks[tails[c]];
+        if (b->count > 0 && (int32_t)(ts - b->first_ts) > 0)
+            seal_block(b);
+    }
+}
+
+bool tsdb_restore_block(uint8_t channel, const uint8_t *data, uint16_t count, uint16_t bit_len, uint32_t last_ts)
+{
+    if (channel >= TSDB_MAX_CHANNELS || count == 0 || bit_len > TSDB_BLOCK_BITS)
+        return false;
+
+    if (tails[channel] != TSDB_NO_BLOCK)
+        seal_block(&blocks[tails[channel]]);
+    tsdb_block_t *b = open_block(channel);
+    if (!b)
+        return false;
+
+    memcpy(b->data, data, (bit_len + 7) / 8);
+    b->bit_len = bit_len;
+    b->first_ts = ((uint32_t)data[0] << 24) | ((uint32_t)data[1] << 16) | ((uint32_t)data[2] << 8) | data[3];
+    b->last_ts = last_ts;
+    // Já está na flash: fecha sem passar pelo callback
+    b->sealed = true;
+    b->count = count;
+    channel_samples[channel] += count;
+    return true;
+}
+
+void tsdb_decoder_init(tsdb_decoder_t *dec, const uint8_t *data, uint16_t count)
+{
+    dec->data = data;
+    dec->count = count;
+    dec->index = 0;
+    dec->bit_pos = 0;
+}
+
+bool tsdb_decoder_next(tsdb_decoder_t *dec, uint32_t *timestamp_ms, float *value)
+{
+    if (dec->index >= dec->count)
+        return false;
+
+    if (dec->index == 0)
+    {
+        dec->ts = get_bits(dec->data, &dec->bit_pos, 32);
+        dec->value = (int32_t)get_bits(dec->data, &dec->bit_pos, 32);
+        dec->delta = 0;
+    }
+    else
+    {
+        dec->delta += unzigzag(get_bucketed(dec->data, &dec->bit_pos, DOD_WIDTHS));
+        dec->ts += (uint32_t)dec->delta;
+        dec->value += unzigzag(get_bucketed(dec->data, &dec->bit_pos, DELTA_WIDTHS));
+    }
+    dec->index++;
+
+    *timestamp_ms = dec->ts;
+    *value = dec->value / TSDB_VALUE_SCALE;
+    return true;
+}
+
+// Avança até o próximo bloco que contenha amostras a partir de since_ms
+static void enter_block(tsdb_iter_t *it)
+{
+    while (it->block != TSDB_NO_BLOCK)
+    {
+        const tsdb_block_t *b = &blocks[it->block];
+        if (b->count > 0 && b->last_ts >= it->since_ms)
+            break;
+        it->block = b->next;
+    }
+    if (it->block == TSDB_NO_BLOCK)
+        return;
+
+    it->block_seq = blocks[it->block].seq;
+    tsdb_decoder_init(&it->dec, blocks[it->block].data, blocks[it->block].count);
+}
+
+void tsdb_iter_init(tsdb_iter_t *it, uint8_t channel, uint32_t since_ms)
+{
+    it->channel = channel;
+    it->since_ms = since_ms;
+    it->block = (channel < TSDB_MAX_CHANNELS) ? heads[channel] : TSDB_NO_BLOCK;
+    enter_block(it);
+}
+
+bool tsdb_iter_next(tsdb_iter_t *it, uint32_t *timestamp_ms, float *value)
+{
+    while (it->block != TSDB_NO_BLOCK)
+    {
+        const tsdb_block_t *b = &blocks[it->block];
+
+        // Bloco reaproveitado durante a leitura: os dados antigos não existem mais
+        if (b->seq != it->block_seq)
+        {
+            it->block = TSDB_NO_BLOCK;
+            return false;
+        }
+
+        // O bloco aberto pode ter recebido amostras desde a última passagem
+        it->dec.count = b->count;
+        if (!tsdb_decoder_next(&it->dec, timestamp_ms, value))
+        {
+            it->block = b->next;
+            enter_block(it);
+            continue;
+        }
+
+        if (*timestamp_ms >= it->since_ms)
+            return true;
+    }
+    return false;
+}
+
+bool tsdb_oldest_ts(uint8_t channel, uint32_t *ts)
+{
+    if (channel >= TSDB_MAX_CHANNELS)
+        return false;
+    for (uint16_t i = heads[channel]; i != TSDB_NO_BLOCK; i = blocks[i].next)
+    {
+        if (blocks[i].count > 0)
+        {
+            *ts = blocks[i].first_ts;
+            return true;
+        }
+    }
+    return false;
+}
+
+uint32_t tsdb_sample_count(uint8_t channel, uint32_t since_ms)
+{
+    if (channel >= TSDB_MAX_CHANNELS)
+        return 0;
+    if (since_ms == 0)
+        return channel_samples[channel];
+
+    // Blocos inteiros dentro da janela contam pelo cabeçalho; só o que a
+    // atravessa precisa ser decodificado
+    uint32_t n = 0;
+    for (uint16_t i = heads[channel]; i != TSDB_NO_BLOCK; i = blocks[i].next)
+    {
+        const tsdb_block_t *b = &blocks[i];
+        if (b->count == 0 || b->last_ts < since_ms)
+            continue;
+        if (b->first_ts >= since_ms)
+        {
+            n += b->count;
+            continue;
+        }
+        tsdb_decoder_t dec;
+        uint32_t ts;
+        float value;
+        tsdb_decoder_init(&dec, b->data, b->count);
+        while (tsdb_decoder_next(&dec, &ts, &value))
+            n += ts >= since_ms;
+    }
+    return n;
+}
+
+void tsdb_get_stats(tsdb_stats_t *stats)
+{
+    *stats = (tsdb_stats_t){0};
+    stats->evictions = evictions;
+    for (uint c = 0; c < TSDB_MAX_CHANNELS; c++)
+    {
+        stats->samples += channel_samples[c];
+        for (uint16_t i = heads[c]; i != TSDB_NO_BLOCK; i = blocks[i].next)
+        {
+            stats->blocks_used++;
+            stats->bytes_used += (blocks[i].bit_len + 7) / 8;
+        }
+    }
+}
@@ -0,0 +1,97 @@
+#ifndef TSDB_H
+#define TSDB_H
+
+#include "pico/stdlib.h"
+#include "sensors.h"
+
+// Memória do histórico, fixada em tempo de compilação:
+// TSDB_NUM_BLOCKS blocos de TSDB_BLOCK_BYTES bytes, compartilhados por todos os canais.
+// O tamanho do bloco permite gravar um bloco fechado em uma página de flash.
+#define TSDB_NUM_BLOCKS 256
+#define TSDB_BLOCK_BYTES 232
+#define TSDB_MAX_CHANNELS SENSORS_MAX_CHANNELS
+
+// Resolução dos valores armazenados (1/100 da unidade do canal)
+#define TSDB_VALUE_SCALE 100.0f
+
+#define TSDB_NO_BLOCK 0xFFFF
+
+// Bloco comprimido: timestamps em delta-of-delta e valores em delta zigzag,
+// ambos com prefixos de tamanho variável, no estilo do Gorilla
+typedef struct
+{
+    uint32_t seq;        // Ordem de alocação; muda quando o bloco é reaproveitado
+    uint16_t next;       // Próximo bloco do mesmo canal
+    uint16_t count;      // Amostras gravadas (atualizado por último em cada append)
+    uint16_t bit_len;
+    uint8_t channel;
+    bool sealed;         // Fechado: não recebe mais amostras
+    uint32_t first_ts;
+    // Estado do codificador, usado apenas para anexar ao bloco aberto
+    uint32_t last_ts;
+    int32_t last_delta;
+    int32_t last_value;
+    uint8_t data[TSDB_BLOCK_BYTES];
+} tsdb_block_t;
+
+// Decodificador de um único bloco, também usado em cópias vindas da flash
+typedef struct
+{
+    const uint8_t *data;
+    uint16_t count;
+    uint16_t index;
+    uint16_t bit_pos;
+    uint32_t ts;
+    int32_t delta;
+    int32_t value;
+} tsdb_decoder_t;
+
+// Iterador de leitura em streaming, da amostra mais antiga para a mais nova
+typedef struct
+{
+    uint8_t channel;
+    uint32_t since_ms;
+    uint16_t block;
+    uint32_t block_seq;
+    tsdb_decoder_t dec;
+} tsdb_iter_t;
+
+// Chamada quando um bloco é fechado, com os dados já definitivos
+typedef void (*tsdb_seal_callback_t)(const tsdb_block_t *block);
+
+typedef struct
+{
+    uint32_t samples;     // Amostras atualmente armazenadas
+    uint32_t bytes_used;  // Bytes de dados efetivamente ocupados
+    uint32_t blocks_used;
+    uint32_t evictions;   // Blocos descartados para abrir espaço
+} tsdb_stats_t;
+
+void tsdb_init(void);
+void tsdb_set_seal_callback(tsdb_seal_callback_t callback);
+
+// Anexa uma amostra. Timestamps de um canal devem ser não decrescentes.
+bool tsdb_append(uint8_t channel, uint32_t timestamp_ms, float value);
+
+// Prepara a leitura das amostras de um canal com timestamp >= since_ms
+void tsdb_iter_init(tsdb_iter_t *it, uint8_t channel, uint32_t since_ms);
+bool tsdb_iter_next(tsdb_iter_t *it, uint32_t *timestamp_ms, float *value);
+
+// Fecha os blocos abertos cuja primeira amostra é anterior a ts, para que
+// canais lentos também sejam entregues ao callback em tempo limitado
+void tsdb_seal_older_than(uint32_t ts);
+
+// Reinsere um bloco fechado (por exemplo, lido da flash) no fim do histórico do canal
+bool tsdb_restore_block(uint8_t channel, const uint8_t *data, uint16_t count, uint16_t bit_len, uint32_t last_ts);
+
+void tsdb_decoder_init(tsdb_decoder_t *dec, const uint8_t *data, uint16_t count);
+bool tsdb_decoder_next(tsdb_decoder_t *dec, uint32_t *timestamp_ms, float *value);
+
+// Timestamp da amostra mais antiga ainda guardada do canal; false se não há nenhuma
+bool tsdb_oldest_ts(uint8_t channel, uint32_t *ts);
+
+// Amostras do canal com timestamp >= since_ms (0: todas)
+uint32_t tsdb_sample_count(uint8_t channel, uint32_t since_ms);
+void tsdb_get_stats(tsdb_stats_t *stats);
+
+#endif // TSDB_H
@@ -0,0 +1,149 @@
+#include "pico/cyw43_arch.h"
+#include "lwip/netif.h"
+
+#include "wifi_manager.h"
+
+static const char *ssid;
+static const char *password;
+
+static wifi_state_t state = WIFI_DOWN;
+static uint32_t next_try_ms;
+static uint32_t attempt_started_ms;
+static uint32_t up_since_ms;
+static uint32_t retry_delay_ms = WIFI_RETRY_MIN_MS;
+static uint32_t last_poll_ms;
+static uint32_t last_now_ms;
+static bool ever_connected = false;
+static bool power_save = false;
+static wifi_stats_t stats;
+
+// Com o enlace ativo, o estado é consultado a cada WIFI_POLL_MS; os callbacks
+// do netif só antecipam a consulta. A decisão é sempre de cyw43_tcpip_link_status.
+static volatile bool netif_changed = false;
+
+#if LWIP_NETIF_STATUS_CALLBACK || LWIP_NETIF_LINK_CALLBACK
+static void on_netif_change(struct netif *netif)
+{
+    netif_changed = true;
+}
+#endif
+
+void wifi_manager_init(const char *wifi_ssid, const char *wifi_password)
+{
+    ssid = wifi_ssid;
+    password = wifi_password;
+    cyw43_arch_enable_sta_mode();
+
+    cyw43_arch_lwip_begin();
+    struct netif *netif = &cyw43_state.netif[CYW43_ITF_STA];
+#if LWIP_NETIF_STATUS_CALLBACK
+    netif_set_status_callback(netif, on_netif_change);
+#endif
+#if LWIP_NETIF_LINK_CALLBACK
+    netif_set_link_callback(netif, on_netif_change);
+#endif
+    (void)netif;
+    cyw43_arch_lwip_end();
+
+    state = WIFI_DOWN;
+    next_try_ms = 0;
+}
+
+// O modo de economia vale por associação: é reaplicado a cada conexão
+static void apply_power_mode(void)
+{
+    cyw43_arch_lwip_begin();
+    cyw43_wifi_pm(&cyw43_state, power_save ? CYW43_AGGRESSIVE_PM : CYW43_DEFAULT_PM);
+    cyw43_arch_lwip_end();
+}
+
+void wifi_manager_set_power_save(bool enabled)
+{
+    if (enabled == power_save)
+        return;
+    power_save = enabled;
+    if (state == WIFI_UP)
+        apply_power_mode();
+}
+
+static void schedule_retry(uint32_t now_ms)
+{
+    state = WIFI_DOWN;
+    next_try_ms = now_ms + retry_delay_ms;
+    retry_delay_ms = MIN(retry_delay_ms * 2, WIFI_RETRY_MAX_MS);
+}
+
+wifi_event_t wifi_manager_task(uint32_t now_ms)
+{
+    last_now_ms = now_ms;
+    if (state == WIFI_UP && !netif_changed && now_ms - last_poll_ms < WIFI_POLL_MS)
+        return WIFI_EVENT_NONE;
+    netif_changed = false;
+    last_poll_ms = now_ms;
+    int link = cyw43_tcpip_link_status(&cyw43_state, CYW43_ITF_STA);
+
+    switch (state)
+    {
+    case WIFI_DOWN:
+        if (stats.attempts > 0 && (int32_t)(now_ms - next_try_ms) < 0)
+            break;
+        stats.attempts++;
+        attempt_started_ms = now_ms;
+        if (cyw43_arch_wifi_connect_async(ssid, password, CYW43_AUTH_WPA2_AES_PSK) == 0)
+            state = WIFI_CONNECTING;
+        else
+            schedule_retry(now_ms);
+        break;
+
+    case WIFI_CONNECTING:
+        if (link == CYW43_LINK_UP)
+        {
+            state = WIFI_UP;
+            up_since_ms = now_ms;
+            retry_delay_ms = WIFI_RETRY_MIN_MS;
+            if (ever_connected)
+                stats.reconnects++;
+            ever_connected = true;
+            apply_power_mode();
+            return WIFI_EVENT_UP;
+        }
+        // Falhas definitivas da tentativa (senha, rede ausente) ou tempo esgotado
+        if (link == CYW43_LINK_FAIL || link == CYW43_LINK_NONET || link == CYW43_LINK_BADAUTH ||
+            now_ms - attempt_started_ms >= WIFI_CONNECT_TIMEOUT_MS)
+        {
+            stats.failures++;
+            cyw43_wifi_leave(&cyw43_state, CYW43_ITF_STA);
+            schedule_retry(now_ms);
+        }
+        break;
+
+    case WIFI_UP:
+        if (link != CYW43_LINK_UP)
+        {
+            stats.link_losses++;
+            stats.total_up_ms += now_ms - up_since_ms;
+            cyw43_wifi_leave(&cyw43_state, CYW43_ITF_STA);
+            // Primeira tentativa depois de uma queda sai na hora
+            retry_delay_ms = WIFI_RETRY_MIN_MS;
+            state = WIFI_DOWN;
+            next_try_ms = now_ms;
+            return WIFI_EVENT_DOWN;
+        }
+        break;
+    }
+    return WIFI_EVENT_NONE;
+}
+
+wifi_state_t wifi_manager_state(void)
+{
+    return state;
+}
+
+void wifi_manager_get_stats(wifi_stats_t *out)
+{
+    *out = stats;
+    out->state = state;
+    out->uptime_ms = state == WIFI_UP ? last_now_ms - up_since_ms : 0;
+    if (state == WIFI_UP)
+        out->total_up_ms += out->uptime_ms;
+}
@@ -0,0 +1,56 @@
+#ifndef WIFI_MANAGER_H
+#define WIFI_MANAGER_H
+
+#include "pico/stdlib.h"
+
+// Tempo máximo de uma tentativa (associação + DHCP)
+#define WIFI_CONNECT_TIMEOUT_MS 20000
+
+// Consulta periódica do enlace quando ativo (os callbacks do netif antecipam)
+#define WIFI_POLL_MS 1000
+
+// Espera entre tentativas: dobra a cada falha, até o máximo
+#define WIFI_RETRY_MIN_MS 2000
+#define WIFI_RETRY_MAX_MS 60000
+
+typedef enum
+{
+    WIFI_DOWN,       // Aguardando a próxima tentativa
+    WIFI_CONNECTING, // Associação ou DHCP em andamento
+    WIFI_UP          // Enlace ativo e com IP
+} wifi_state_t;
+
+// Mudanças de estado relevantes para quem usa a rede, devolvidas por wifi_manager_task
+typedef enum
+{
+    WIFI_EVENT_NONE,
+    WIFI_EVENT_UP,  // Enlace ativo com IP (primeira conexão ou retorno)
+    WIFI_EVENT_DOWN // Enlace perdido
+} wifi_event_t;
+
+typedef struct
+{
+    wifi_state_t state;
+    uint32_t attempts;    // Tentativas de conexão iniciadas
+    uint32_t failures;    // Tentativas que terminaram sem IP
+    uint32_t reconnects;  // Conexões bem-sucedidas depois da primeira
+    uint32_t link_losses; // Quedas com o enlace ativo
+    uint32_t uptime_ms;   // Tempo da conexão atual (0 se fora)
+    uint32_t total_up_ms; // Tempo total com enlace desde o boot
+} wifi_stats_t;
+
+// Liga o modo estação e registra os callbacks do netif; a primeira tentativa
+// sai na primeira chamada de wifi_manager_task. Não bloqueia.
+void wifi_manager_init(const char *ssid, const char *password);
+
+// Chamada no laço principal: consulta o estado do enlace e conduz as tentativas
+wifi_event_t wifi_manager_task(uint32_t now_ms);
+
+// Economia agressiva do rádio (CYW43_AGGRESSIVE_PM): o chip dorme entre
+// beacons, à custa de latência maior nas respostas. Desligada, usa CYW43_DEFAULT_PM.
+void wifi_manager_set_power_save(bool enabled);
+
+wifi_state_t wifi_manager_state(void);
+void wifi_manager_get_stats(wifi_stats_t *stats);
+
+#endif // WIFI_MANAGER_H
@@ -6,6 +6,9 @@
 #include "pico/stdlib.h"
 #include "pico/cyw43_arch.h"
 #include "pico/bootrom.h"
+#include "pico/unique_id.h"
+#include "pico/rand.h"
+#include "pico/stdio_usb.h"
 
 #include "lwip/tcp.h"
 #include "hardware/i2c.h"
@@ -14,8 +17,31 @@
 
 #include "aht20.h"
 #include "bmp280.h"
+#include "sensors.h"
+#include "alarms.h"
+#include "alarm_events.h"
+#include "alarm_rules.h"
+#include "telemetry.h"
+#include "mqtt.h"
+#include "wifi_manager.h"
+#include "tsdb.h"
+#include "sample_log.h"
+#include "rollup.h"
+#include "settings.h"
+#include "settings_store.h"
 #include "ssd1306.h"
+#include "oled_screens.h"
 #include "np_led.h"
+#include "buzzer.h"
+#include "boot_profile.h"
+#include "duty_cycle.h"
+#include "power.h"
+#include "perf.h"
+#include "appendf.h"
+#include "mem_report.h"
+#include "sample_snapshot.h"
+#include "loop_watchdog.h"
+#include "sensor_trace.h"
 #include "font.h"
 
 // --- CONFIGURAÇÕES DE REDE E HARDWARE ---
@@ -24,6 +50,7 @@
 
 #define RESET_CONFIG_BUTTON 5
 #define BOOTSEL_BUTTON 6
+#define SCREEN_BUTTON 22 // Botão do joystick: troca a tela do OLED
 #define LED_GREEN_PIN 11
 #define LED_RED_PIN 13
 #define BUZZER_A 21
@@ -38,45 +65,57 @@
 #define I2C_SCL_DISP 15
 #define DISP_ADDR 0x3C
 
-#define SEA_LEVEL_PRESSURE 101325.0
+// Endereço do TCA9548A no barramento dos sensores (SENSOR_NO_MUX desativa a busca)
+#define SENSORS_MUX_ADDR 0x70
 
-typedef enum
-{
-    ERROR_NONE,
-    ERROR_TEMPERATURE,
-    ERROR_PRESSURE,
-    ERROR_ALTITUDE,
-    ERROR_HUMIDITY
-} ErrorType;
+// Intervalo entre amostras gravadas no histórico
+#define HISTORY_INTERVAL_MS 1000
+// Máximo de pontos devolvidos por /history
+#define HISTORY_MAX_POINTS 300
+// Idade máxima de um bloco aberto antes de ser fechado e gravado na flash
+#define SAMPLE_LOG_MAX_BLOCK_AGE_MS (5 * 60 * 1000)
+// Amostras do log processadas por volta do laço na reconstrução dos agregados
+#define ROLLUP_REBUILD_BUDGET 2000
 
 // --- VARIÁVEIS GLOBAIS ---
 
-static ErrorType last_error_displayed = ERROR_NONE;
+// Cópia do laço das configurações publicadas (lib/settings.h), renovada no
+// início de cada volta; as regras de alarme apontam para os limites dela
+settings_t settings;
+static uint32_t settings_loaded; // Versão publicada que está na cópia
+
+static volatile uint32_t current_time; // Tempo atual (usado para debounce)
+static volatile uint32_t last_time_button = 0;
 
-// Variáveis para armazenar os dados dos sensores (já com offset)
-float temperature_bmp = 0.0f, pressure_kpa = 0.0f, altitude_m = 0.0f;
-float temperature_aht = 0.0f, humidity_rh = 0.0f;
+// Alarmes ativos na última atualização das saídas
+static alarm_mask_t last_alarms = 0;
 
-// Variáveis para as configurações (limites e offsets)
-float temp_offset = 0.0f, pressure_offset_kpa = 0.0f;
-float temp_min = 0.0f, temp_max = 40.0f;
-float pressure_min = 80.0f, pressure_max = 105.0f;
-float altitude_min = -100.0f, altitude_max = 1000.0f;
-float humidity_min = 20.0f, humidity_max = 90.0f;
+// Alarmes silenciados pelo botão; um alarme novo volta a tocar
+static alarm_mask_t acked_alarms = 0;
+static volatile bool ack_requested = false;
+static buzzer_pattern_id_t buzzer_pattern = BUZZER_SILENT;
 
-// Configurações do buzzer
-bool buzzer_state = false;      // Estado atual do buzzer (ligado/desligado)
-uint32_t last_buzzer_time = 0;  // Último momento que o buzzer foi acionado
-const float DIVIDER_PWM = 16.0; // Divisor de clock para PWM do buzzer
-const uint16_t PERIOD = 4096;   // Período do PWM para o buzzer
-uint slice_buzzer;              // Slice PWM associado ao buzzer
+// Display OLED; também lido por /screen.pbm
+static ssd1306_t ssd;
+// Pedido de troca de tela feito pelo botão do joystick
+static volatile bool screen_advance_requested = false;
 
-static volatile uint32_t current_time; // Tempo atual (usado para debounce)
-static volatile uint32_t last_time_button = 0;
+// Modo do traço de sensores pedido em /trace; o laço principal começa ou
+// encerra o traço entre duas voltas, fora das leituras e da avaliação de alarmes
+static volatile bool trace_requested = false;
+static volatile sensor_trace_mode_t trace_requested_mode;
 
-// Variáveis para indicar se tudo está OK
-static bool last_ok_state = false;
-static uint64_t last_update_time = 0;
+// Instante agendado da próxima amostra do histórico e o espaçamento atual
+// (no baixo consumo, o intervalo de leitura configurado)
+static uint32_t next_history_ms = 0;
+static uint32_t history_interval_ms = HISTORY_INTERVAL_MS;
+
+// Modo de baixo consumo em vigor (aplicado a partir das configurações no laço)
+static bool low_power_mode = false;
+
+// Base do tempo do dispositivo: continua a linha do tempo do log gravado na
+// flash, de modo que os timestamps nunca voltam atrás após um reboot
+static uint32_t device_time_base_ms = 0;
 
 // --- CONTEÚDO DA PÁGINA WEB ---
 
@@ -85,8 +124,17 @@ struct http_state
     char response[8192];
     size_t len;
     size_t sent;
+    sample_log_cursor_t *export_cursor; // Resposta em partes de /export
+    const uint8_t *raw;                 // Resposta binária copiada da flash em partes (/trace.bin)
+    uint32_t raw_left;
 };
 
+// Tamanho de cada parte de uma resposta gerada em partes
+#define HTTP_CHUNK_SIZE 4096
+
+// Espaço reservado no início da resposta quando o corpo é gerado direto no buffer
+#define HTTP_HEADER_RESERVE 128
+
 const char HTML_BODY[] =
     "<!DOCTYPE html>"
     "<html lang='pt-BR'>"
@@ -117,7 +165,7 @@ const char HTML_BODY[] =
     "<h2>📊 Gráfico de Monitoramento</h2>"
     "<label for='chart-select'>Selecione o Gráfico:</label>"
     "<select id='chart-select'>"
-    "<option value='temperatures' selected>Temperaturas (°C)</option>"
+    "<option value='temp' selected>Temperaturas (°C)</option>"
     "<option value='pressure'>Pressão (kPa)</option>"
     "<option value='altitude'>Altitude (m)</option>"
     "<option value='humidity'>Umidade (%)</option>"
@@ -147,9 +195,23 @@ const char HTML_BODY[] =
     "<div><label for='humidity_max'>Umidade Max</label><input type='number' step='1' id='humidity_max' name='humidity_max'></div>"
     "</div>"
     "</fieldset>"
-    "<button type='submit' style='margin-top: 1rem;'>Salvar Configurações</button>"
+    "<fieldset>"
+    "<legend>Notificações</legend>"
+    "<div><label for='collector'>Coletor UDP (ip:porta)</label><input type='text' id='collector' name='collector' placeholder='192.168.0.10:9000'></div>"
+    "<div><label for='telemetry'>Telemetria UDP (multicast ip:porta)</label><input type='text' id='telemetry' name='telemetry' placeholder='239.255.42.1:5005'></div>"
+    "<div><label for='mqtt'>Broker MQTT (ip:porta)</label><input type='text' id='mqtt' name='mqtt' placeholder='192.168.0.10:1883'></div>"
+    "</fieldset>"
+    "<fieldset>"
+    "<legend>Energia</legend>"
+    "<div class='form-grid'>"
+    "<div><label for='low_power'>Baixo consumo (0/1)</label><input type='number' min='0' max='1' step='1' id='low_power' name='low_power'></div>"
+    "<div><label for='sample_interval_s'>Intervalo de leitura (s)</label><input type='number' min='1' step='1' id='sample_interval_s' name='sample_interval_s'></div>"
+    "</div>"
+    "</fieldset>"
+        "<button type='submit' style='margin-top: 1rem;'>Salvar Configurações</button>"
     "</form>"
     "<div id='live-values' style='margin-top: 1rem; text-align: center;'></div>"
+    "<div id='events' style='margin-top: 1rem;'></div>"
     "</div>"
     "</div>"
     "<script>"
@@ -158,43 +220,42 @@ const char HTML_BODY[] =
     "const form = document.getElementById('settings-form');"
     "const chartSelect = document.getElementById('chart-select');"
 
-    "const chartConfigs = {"
-    "'temperatures': { type: 'line', data: { labels: [], datasets: [{ label: 'Temp (BMP280)', data: [], borderColor: '#ff6384' }, { label: 'Temp (AHT20)', data: [], borderColor: '#36a2eb' }] } },"
-    "'pressure': { type: 'line', data: { labels: [], datasets: [{ label: 'Pressão (kPa)', data: [], borderColor: '#4bc0c0' }] } },"
-    "'altitude': { type: 'line', data: { labels: [], datasets: [{ label: 'Altitude (m)', data: [], borderColor: '#9966ff' }] } },"
-    "'humidity': { type: 'line', data: { labels: [], datasets: [{ label: 'Umidade (%)', data: [], borderColor: '#ffcd56' }] } }"
+    "const KIND_INFO = {"
+    "'temp': { label: 'Temp', unit: '°C', digits: 2 },"
+    "'pressure': { label: 'Pressão', unit: 'kPa', digits: 2 },"
+    "'altitude': { label: 'Altitude', unit: 'm', digits: 1 },"
+    "'humidity': { label: 'Umidade', unit: '%', digits: 1 }"
     "};"
+    "const COLORS = ['#ff6384', '#36a2eb', '#4bc0c0', '#9966ff', '#ffcd56', '#ff9f40'];"
+    "let channels = [];"
 
     "function createOrUpdateChart() {"
     "if (chartInstance) chartInstance.destroy();"
-    "const selected = chartSelect.value;"
-    "const config = chartConfigs[selected];"
+    "const selected = channels.filter(c => c.kind === chartSelect.value);"
+    "const config = { type: 'line', data: { labels: [], datasets: selected.map((c, i) => ({ label: `${KIND_INFO[c.kind].label} (${c.sensor})`, data: [], borderColor: COLORS[i % COLORS.length], channel: c.id })) } };"
     "config.options = { responsive: true, animation: { duration: 400 }, scales: { y: { beginAtZero: false } } };"
     "chartInstance = new Chart(document.getElementById('mainChart').getContext('2d'), config);"
     "}"
 
     "function updateDisplayValues(data) {"
-    "const s = data.sensors;"
-    "const set = data.settings;"
-    "document.getElementById('live-values').innerHTML = "
-    "`<h2>Valores Atuais</h2>` + "
-    "`<p>Temp BMP280: <span class='value-display' id='v_temp_bmp'>${s.temp_bmp.toFixed(2)} °C</span></p>` + "
-    "`<p>Temp AHT20: <span class='value-display'>${s.temp_aht.toFixed(2)} °C</span></p>` + "
-    "`<p>Pressão: <span class='value-display' id='v_pressure'>${s.pressure.toFixed(2)} kPa</span></p>` + "
-    "`<p>Altitude: <span class='value-display' id='v_altitude'>${s.altitude.toFixed(1)} m</span></p>` + "
-    "`<p>Umidade: <span class='value-display' id='v_humidity'>${s.humidity.toFixed(1)} %</span></p>`;"
-
-    "document.getElementById('v_temp_bmp').classList.toggle('out-of-range', s.temp_bmp < set.temp_min || s.temp_bmp > set.temp_max);"
-    "document.getElementById('v_pressure').classList.toggle('out-of-range', s.pressure < set.pressure_min || s.pressure > set.pressure_max);"
-    "document.getElementById('v_altitude').classList.toggle('out-of-range', s.altitude < set.altitude_min || s.altitude > set.altitude_max);"
-    "document.getElementById('v_humidity').classList.toggle('out-of-range', s.humidity < set.humidity_min || s.humidity > set.humidity_max);"
+    "let html = `<h2>Valores Atuais</h2>`;"
+    "for (const c of data.channels) {"
+    "const k = KIND_INFO[c.kind];"
+    "const text = c.valid ? `${c.value.toFixed(k.digits)} ${k.unit}` : '--';"
+    "html += `<p>${k.label} ${c.sensor}: <span class='value-display${c.alarm ? ' out-of-range' : ''}'>${text}</span></p>`;"
+    "}"
+    "document.getElementById('live-values').innerHTML = html;"
     "}"
 
     "async function updateData() {"
     "try {"
     "const response = await fetch('/sensordata');"
     "const data = await response.json();"
+    "const wanted = data.channels.filter(c => c.kind === chartSelect.value).length;"
+    "channels = data.channels;"
+    "if (chartInstance.data.datasets.length !== wanted) createOrUpdateChart();"
     "updateDisplayValues(data);"
+    "updateEvents();"
     "const time = new Date().toLocaleTimeString();"
 
     "if (chartInstance.data.labels.length >= MAX_DATA_POINTS) {"
@@ -202,16 +263,23 @@ const char HTML_BODY[] =
     "chartInstance.data.datasets.forEach(d => d.data.shift());"
     "}"
     "chartInstance.data.labels.push(time);"
-    "const s = data.sensors;"
-    "const selectedChart = chartSelect.value;"
-    "if(selectedChart === 'temperatures') { chartInstance.data.datasets[0].data.push(s.temp_bmp); chartInstance.data.datasets[1].data.push(s.temp_aht); }"
-    "if(selectedChart === 'pressure') { chartInstance.data.datasets[0].data.push(s.pressure); }"
-    "if(selectedChart === 'altitude') { chartInstance.data.datasets[0].data.push(s.altitude); }"
-    "if(selectedChart === 'humidity') { chartInstance.data.datasets[0].data.push(s.humidity); }"
+    "chartInstance.data.datasets.forEach(d => { const c = channels[d.channel]; d.data.push(c && c.valid ? c.value : null); });"
     "chartInstance.update('none');"
     "} catch (e) { console.error('Falha ao buscar dados:', e); }"
     "}"
 
+    "let lastEventSeq = 0;"
+    "const recentEvents = [];"
+    "async function updateEvents() {"
+    "const data = await (await fetch(`/events?since=${lastEventSeq}`)).json();"
+    "for (const e of data.events) recentEvents.unshift(e);"
+    "recentEvents.splice(10);"
+    "lastEventSeq = data.last_seq;"
+    "let html = '<h2>Eventos de Alarme</h2>';"
+    "for (const e of recentEvents) html += `<p>#${e.seq} ${e.event === 'raise' ? '🔴' : '🟢'} ${KIND_INFO[e.kind].label} ${e.sensor} (${e.type}): ${e.value.toFixed(2)} / ${e.threshold.toFixed(2)}</p>`;"
+    "document.getElementById('events').innerHTML = html;"
+    "}"
+
     "async function loadInitialSettings() {"
     "const response = await fetch('/sensordata');"
     "const data = await response.json();"
@@ -237,28 +305,6 @@ const char HTML_BODY[] =
 
 // --- FUNÇÕES DE REDE E LÓGICA ---
 
-ErrorType get_current_error()
-{
-    if (temperature_bmp < temp_min || temperature_bmp > temp_max ||
-        temperature_aht < temp_min || temperature_aht > temp_max)
-    {
-        return ERROR_TEMPERATURE;
-    }
-    else if (pressure_kpa < pressure_min || pressure_kpa > pressure_max)
-    {
-        return ERROR_PRESSURE;
-    }
-    else if (altitude_m < altitude_min || altitude_m > altitude_max)
-    {
-        return ERROR_ALTITUDE;
-    }
-    else if (humidity_rh < humidity_min || humidity_rh > humidity_max)
-    {
-        return ERROR_HUMIDITY;
-    }
-    return ERROR_NONE;
-}
-
 void ligar_led_verde()
 {
     gpio_put(LED_GREEN_PIN, 1);
@@ -271,17 +317,73 @@ void ligar_led_vermelho()
     gpio_put(LED_RED_PIN, 1);
 }
 
-// Funções para controle do buzzer
-void buzzer_on()
+static np_glyph_t glyph_of_kind(channel_kind_t kind)
+{
+    switch (kind)
+    {
+    case CHANNEL_TEMPERATURE:
+        return NP_GLYPH_T;
+    case CHANNEL_PRESSURE:
+        return NP_GLYPH_P;
+    case CHANNEL_ALTITUDE:
+        return NP_GLYPH_A;
+    default:
+        return NP_GLYPH_U;
+    }
+}
+
+// Mostra na matriz a letra da grandeza de cada alarme ativo: vermelho piscando
+// para faixa, laranja pulsando para taxa; com vários, as letras rolam em laço,
+// em ordem de prioridade. As animações seguem no timer da matriz.
+static void show_alarms(alarm_mask_t active)
 {
-    pwm_set_gpio_level(BUZZER_A, 300); // Define nível PWM para ligar o buzzer
-    buzzer_state = true;
+    if (active == 0)
+    {
+        // No baixo consumo a matriz fica apagada enquanto está tudo bem
+        npShowGlyph(NP_GLYPH_SMILE, low_power_mode ? NP_OFF : NP_GREEN, NP_ANIM_STATIC);
+        return;
+    }
+
+    np_glyph_t glyphs[NP_SCROLL_MAX];
+    np_color_t colors[NP_SCROLL_MAX];
+    np_anim_t anim = NP_ANIM_BLINK;
+    uint count = 0;
+    for (uint i = 0; i < alarms_rule_count() && count < NP_SCROLL_MAX; i++)
+    {
+        if (!((active >> i) & 1))
+            continue;
+        const alarm_rule_t *rule = alarms_rule(i);
+        bool rate = rule->type == ALARM_RULE_RATE;
+        glyphs[count] = glyph_of_kind(sensors_channel(rule->channel)->kind);
+        colors[count] = rate ? NP_ORANGE : NP_RED;
+        anim = rate ? NP_ANIM_PULSE : NP_ANIM_BLINK;
+        count++;
+    }
+
+    if (count == 1)
+        npShowGlyph(glyphs[0], colors[0], anim);
+    else
+        npScroll(glyphs, colors, count);
 }
 
-void buzzer_off()
+// Padrão do buzzer pela gravidade dos alarmes ainda não silenciados
+static buzzer_pattern_id_t pattern_for_alarms(alarm_mask_t mask)
 {
-    pwm_set_gpio_level(BUZZER_A, 0); // Desliga o buzzer
-    buzzer_state = false;
+    uint range = 0, rate = 0;
+    for (uint i = 0; mask; i++, mask >>= 1)
+    {
+        if (!(mask & 1))
+            continue;
+        if (alarms_rule(i)->type == ALARM_RULE_RANGE)
+            range++;
+        else
+            rate++;
+    }
+    if (range > 1)
+        return BUZZER_CRITICAL;
+    if (range)
+        return BUZZER_RANGE;
+    return rate ? BUZZER_RATE : BUZZER_SILENT;
 }
 
 void gpio_irq_handler(uint gpio, uint32_t events)
@@ -298,23 +400,65 @@ void gpio_irq_handler(uint gpio, uint32_t events)
         if (gpio == RESET_CONFIG_BUTTON)
         {
             // Reseta as configurações para os valores padrão
-            temp_offset = 0.0f;
-            pressure_offset_kpa = 0.0f;
-            temp_min = 0.0f;
-            temp_max = 40.0f;
-            pressure_min = 80.0f;
-            pressure_max = 105.0f;
-            altitude_min = -100.0f;
-            altitude_max = 1000.0f;
-            humidity_min = 20.0f;
-            humidity_max = 90.0f;
+            settings_publish_defaults();
+            settings_store_request_save();
         }
+        else if (gpio == SCREEN_BUTTON)
+        {
+            // Com o buzzer tocando, o botão silencia os alarmes atuais; senão troca a tela
+            if (buzzer_playing())
+            {
+                buzzer_stop();
+                ack_requested = true;
+            }
+            else
+            {
+                screen_advance_requested = true;
+            }
+        }
+    }
+}
+
+// Configurações recebidas no tópico MQTT settings/set (contexto do lwIP, como o servidor HTTP)
+static void apply_remote_settings(const char *query)
+{
+    if (settings_publish_query(query) > 0)
+        settings_store_request_save();
+}
+
+// Tempo do dispositivo em ms, contínuo entre reinicializações
+static uint32_t device_time_ms(void)
+{
+    return device_time_base_ms + to_ms_since_boot(get_absolute_time());
+}
+
+// Gera a próxima parte do CSV de /export. Retorna false quando não há mais dados.
+static bool fill_export(struct http_state *hs)
+{
+    int len = 0;
+    uint8_t channel;
+    uint32_t ts;
+    float value;
+    while (len < HTTP_CHUNK_SIZE - 32 &&
+           sample_log_cursor_next(hs->export_cursor, &channel, &ts, &value))
+    {
+        len = appendf(hs->response, HTTP_CHUNK_SIZE, len, "%u,%lu,%.2f\n", channel, (unsigned long)ts, value);
     }
+    hs->len = len;
+    hs->sent = 0;
+    return len > 0;
 }
 
-float calculate_altitude_func(float pressure_pa)
+// Copia a próxima parte de uma resposta binária. Retorna false quando acabou.
+static bool fill_raw(struct http_state *hs)
 {
-    return 44330.0 * (1.0 - pow(pressure_pa / SEA_LEVEL_PRESSURE, 0.1903));
+    uint32_t n = MIN(hs->raw_left, HTTP_CHUNK_SIZE);
+    memcpy(hs->response, hs->raw, n);
+    hs->raw += n;
+    hs->raw_left -= n;
+    hs->len = n;
+    hs->sent = 0;
+    return n > 0;
 }
 
 static err_t http_sent(void *arg, struct tcp_pcb *tpcb, u16_t len)
@@ -323,7 +467,15 @@ static err_t http_sent(void *arg, struct tcp_pcb *tpcb, u16_t len)
     hs->sent += len;
     if (hs->sent >= hs->len)
     {
+        // Respostas em partes: a próxima só é gerada depois que a anterior foi confirmada
+        if ((hs->export_cursor && fill_export(hs)) || (hs->raw_left && fill_raw(hs)))
+        {
+            tcp_write(tpcb, hs->response, hs->len, TCP_WRITE_FLAG_COPY);
+            tcp_output(tpcb);
+            return ERR_OK;
+        }
         tcp_close(tpcb);
+        free(hs->export_cursor);
         free(hs);
     }
     return ERR_OK;
@@ -339,6 +491,114 @@ void parse_float_param(const char *req, const char *param, float *value)
     }
 }
 
+// Canais e configurações de /sensordata: só mudam com uma amostra nova ou uma
+// escrita nas configurações, então o trecho fica renderizado com o par de
+// versões como chave. Só o handler HTTP usa o cache (um contexto só).
+static int render_sensordata_state(const char **out)
+{
+    static char cache[1792];
+    static int cache_len = -1;
+    static uint32_t cache_sample, cache_settings;
+    *out = cache;
+    if (cache_len >= 0 && cache_sample == sample_snapshot_version() && cache_settings == settings_version())
+        return cache_len;
+
+    static sample_snapshot_t sample; // Fora da pilha do handler
+    settings_t current;
+    cache_sample = sample_snapshot_get(&sample);
+    cache_settings = settings_load(&current);
+
+    int len = appendf(cache, sizeof(cache), 0, "{\"channels\":[");
+    for (uint i = 0; i < sample.count; i++)
+    {
+        const sensor_channel_t *ch = sensors_channel(i);
+        const sample_snapshot_channel_t *v = &sample.channels[i];
+        len = appendf(cache, sizeof(cache), len,
+                      "%s{\"id\":%u,\"kind\":\"%s\",\"sensor\":\"%s\",\"value\":%.2f,\"valid\":%s,\"alarm\":%s}",
+                      i ? "," : "", i, sensors_kind_name(ch->kind), sensors_instance(ch->instance)->label, v->value,
+                      v->valid ? "true" : "false", v->alarm ? "true" : "false");
+    }
+    len = appendf(cache, sizeof(cache), len, "],\"settings\":{");
+    for (uint i = 0; i < settings_field_count(); i++)
+        len = appendf(cache, sizeof(cache), len, "%s\"%s\":%.2f", i ? "," : "", settings_field_name(i),
+                      settings_get(&current, i));
+    char collector[24];
+    settings_format_collector(&current, collector, sizeof(collector));
+    char telemetry[24];
+    settings_format_telemetry(&current, telemetry, sizeof(telemetry));
+    char mqtt[24];
+    settings_format_mqtt(&current, mqtt, sizeof(mqtt));
+    len = appendf(cache, sizeof(cache), len, ",\"collector\":\"%s\",\"telemetry\":\"%s\",\"mqtt\":\"%s\"}",
+                  collector, telemetry, mqtt);
+    cache_len = MIN(len, (int)sizeof(cache) - 1);
+    return cache_len;
+}
+
+// Completa uma resposta cujo corpo foi escrito em hs->response + HTTP_HEADER_RESERVE
+static void http_finish_in_place(struct http_state *hs, const char *content_type, int body_len)
+{
+    char header[HTTP_HEADER_RESERVE];
+    int header_len = snprintf(header, sizeof(header),
+                              "HTTP/1.1 200 OK\r\nContent-Type: %s\r\nContent-Length: %d\r\nConnection: close\r\n\r\n",
+                              content_type, body_len);
+    memmove(hs->response + header_len, hs->response + HTTP_HEADER_RESERVE, body_len);
+    memcpy(hs->response, header, header_len);
+    hs->len = header_len + body_len;
+}
+
+// Gera o histórico de um canal como pares [timestamp_ms, valor], reduzindo
+// a amostragem das amostras da janela para caber em max_points
+static int render_history(char *buf, size_t size, uint8_t channel, uint32_t since_ms, uint max_points)
+{
+    uint stride = (tsdb_sample_count(channel, since_ms) + max_points - 1) / max_points;
+    if (stride == 0)
+        stride = 1;
+
+    int len = appendf(buf, size, 0, "{\"ch\":%u,\"now\":%lu,\"interval_ms\":%u,\"points\":[",
+                      channel, (unsigned long)device_time_ms(), (unsigned)(history_interval_ms * stride));
+
+    tsdb_iter_t it;
+    tsdb_iter_init(&it, channel, since_ms);
+    uint32_t ts;
+    float value;
+    uint n = 0, emitted = 0;
+    while (tsdb_iter_next(&it, &ts, &value))
+    {
+        if (n++ % stride != 0)
+            continue;
+        len = appendf(buf, size, len, "%s[%lu,%.2f]", emitted++ ? "," : "", (unsigned long)ts, value);
+    }
+    return appendf(buf, size, len, "]}");
+}
+
+// Histórico agregado: pontos [início, média, mínimo, máximo] de um nível de rollup
+static int render_rollup(char *buf, size_t size, int tier, uint8_t channel, uint32_t since_ms, uint max_points)
+{
+    // Com mais intervalos que pontos, entrega só os mais recentes
+    rollup_iter_t it;
+    rollup_point_t pt;
+    uint total = 0;
+    rollup_iter_init(&it, tier, channel, since_ms);
+    while (rollup_iter_next(&it, &pt))
+        total++;
+    uint skip = total > max_points ? total - max_points : 0;
+
+    int len = appendf(buf, size, 0, "{\"ch\":%u,\"now\":%lu,\"tier\":\"%s\",\"interval_ms\":%lu,\"points\":[",
+                      channel, (unsigned long)device_time_ms(), rollup_tier_name(tier),
+                      (unsigned long)rollup_tier_period(tier));
+
+    uint n = 0, emitted = 0;
+    rollup_iter_init(&it, tier, channel, since_ms);
+    while (rollup_iter_next(&it, &pt))
+    {
+        if (n++ < skip)
+            continue;
+        len = appendf(buf, size, len, "%s[%lu,%.2f,%.2f,%.2f]", emitted++ ? "," : "",
+                      (unsigned long)pt.ts, pt.mean, pt.min, pt.max);
+    }
+    return appendf(buf, size, len, "]}");
+}
+
 static err_t http_recv(void *arg, struct tcp_pcb *tpcb, struct pbuf *p, err_t err)
 {
     if (!p)
@@ -350,45 +610,37 @@ static err_t http_recv(void *arg, struct tcp_pcb *tpcb, struct pbuf *p, err_t er
     char *req = (char *)p->payload;
     struct http_state *hs = malloc(sizeof(struct http_state));
     hs->sent = 0;
+    hs->export_cursor = NULL;
+    hs->raw_left = 0;
 
+    // Tempo de montagem da resposta, por rota
+    PERF_BEGIN(HTTP);
+    perf_stage_t route = PERF_HTTP_PAGE;
     if (strstr(req, "GET /set_settings?"))
     {
-        parse_float_param(req, "temp_offset=", &temp_offset);
-        parse_float_param(req, "pressure_offset_kpa=", &pressure_offset_kpa);
-        parse_float_param(req, "temp_min=", &temp_min);
-        parse_float_param(req, "temp_max=", &temp_max);
-        parse_float_param(req, "pressure_min=", &pressure_min);
-        parse_float_param(req, "pressure_max=", &pressure_max);
-        parse_float_param(req, "altitude_min=", &altitude_min);
-        parse_float_param(req, "altitude_max=", &altitude_max);
-        parse_float_param(req, "humidity_min=", &humidity_min);
-        parse_float_param(req, "humidity_max=", &humidity_max);
+        route = PERF_HTTP_SETTINGS;
+        settings_publish_query(req);
+        settings_store_request_save();
+        settings_t current;
+        settings_load(&current);
 
         char response_body[1500];
-        snprintf(response_body, sizeof(response_body),
-                 "Request: %s\n"
-                 "Configuracoes atualizadas:\n"
-                 "temp_offset=%.2f\n"
-                 "pressure_offset_kpa=%.2f\n"
-                 "temp_min=%.2f\n"
-                 "temp_max=%.2f\n"
-                 "pressure_min=%.2f\n"
-                 "pressure_max=%.2f\n"
-                 "altitude_min=%.2f\n"
-                 "altitude_max=%.2f\n"
-                 "humidity_min=%.2f\n"
-                 "humidity_max=%.2f\n",
-                 req,
-                 temp_offset,
-                 pressure_offset_kpa,
-                 temp_min,
-                 temp_max,
-                 pressure_min,
-                 pressure_max,
-                 altitude_min,
-                 altitude_max,
-                 humidity_min,
-                 humidity_max);
+        int body_len = appendf(response_body, sizeof(response_body), 0,
+                               "Request: %s\n"
+                               "Configuracoes atualizadas:\n",
+                               req);
+        for (uint i = 0; i < settings_field_count(); i++)
+            body_len = appendf(response_body, sizeof(response_body), body_len, "%s=%.2f\n",
+                               settings_field_name(i), settings_get(&current, i));
+        char collector[24];
+        settings_format_collector(&current, collector, sizeof(collector));
+        body_len = appendf(response_body, sizeof(response_body), body_len, "collector=%s\n", collector);
+        char telemetry[24];
+        settings_format_telemetry(&current, telemetry, sizeof(telemetry));
+        body_len = appendf(response_body, sizeof(response_body), body_len, "telemetry=%s\n", telemetry);
+        char mqtt[24];
+        settings_format_mqtt(&current, mqtt, sizeof(mqtt));
+        body_len = appendf(response_body, sizeof(response_body), body_len, "mqtt=%s\n", mqtt);
 
         hs->len = snprintf(hs->response, sizeof(hs->response),
                            "HTTP/1.1 200 OK\r\n"
@@ -396,20 +648,213 @@ static err_t http_recv(void *arg, struct tcp_pcb *tpcb, struct pbuf *p, err_t er
                            "Content-Length: %d\r\n"
                            "Connection: close\r\n\r\n"
                            "%s",
-                           (int)strlen(response_body), response_body);
+                           body_len, response_body);
+    }
+    else if (strstr(req, "GET /export"))
+    {
+        route = PERF_HTTP_EXPORT;
+        // CSV de todo o log da flash mais as amostras ainda na RAM, enviado em partes
+        float channel = -1.0f;
+        parse_float_param(req, "ch=", &channel);
+        hs->export_cursor = malloc(sizeof(sample_log_cursor_t));
+        sample_log_cursor_init(hs->export_cursor, (int)channel);
+        hs->len = snprintf(hs->response, sizeof(hs->response),
+                           "HTTP/1.1 200 OK\r\nContent-Type: text/csv\r\nConnection: close\r\n\r\n"
+                           "channel,timestamp_ms,value\n");
+    }
+    else if (strstr(req, "GET /history"))
+    {
+        route = PERF_HTTP_HISTORY;
+        float channel = 0.0f, since = 0.0f, points = HISTORY_MAX_POINTS, step = 0.0f;
+        parse_float_param(req, "ch=", &channel);
+        parse_float_param(req, "since=", &since);
+        parse_float_param(req, "n=", &points);
+        parse_float_param(req, "step=", &step);
+        if (points < 1 || points > HISTORY_MAX_POINTS)
+            points = HISTORY_MAX_POINTS;
+
+        // Sem passo explícito, deriva da janela pedida; janelas longas saem dos
+        // agregados em vez de decodificar e descartar amostras brutas. Só com
+        // o passo, a janela é a dos pontos pedidos.
+        uint32_t now = device_time_ms();
+        if (step <= 0 && since > 0 && (uint32_t)since < now)
+            step = (float)(now - (uint32_t)since) / points;
+        uint32_t window_since = (uint32_t)since;
+        if (since <= 0 && step > 0)
+            window_since = (float)now > step * points ? now - (uint32_t)(step * points) : 0;
+        int tier = rollup_select_tier((uint8_t)channel, (uint32_t)step, window_since);
+
+        char *body = hs->response + HTTP_HEADER_RESERVE;
+        size_t body_size = sizeof(hs->response) - HTTP_HEADER_RESERVE;
+        int body_len = (tier == ROLLUP_TIER_RAW)
+                           ? render_history(body, body_size, (uint8_t)channel, (uint32_t)since, (uint)points)
+                           : render_rollup(body, body_size, tier, (uint8_t)channel, (uint32_t)since, (uint)points);
+        http_finish_in_place(hs, "application/json", body_len);
+    }
+    else if (strstr(req, "GET /debug/perf"))
+    {
+        // Contadores de tempo do laço e do HTTP; reset=1 zera depois de responder
+        route = PERF_HTTP_DEBUG;
+        float reset = 0.0f;
+        parse_float_param(req, "reset=", &reset);
+        char *body = hs->response + HTTP_HEADER_RESERVE;
+        size_t body_size = sizeof(hs->response) - HTTP_HEADER_RESERVE;
+        int body_len = perf_format_json(body, body_size);
+        if (body_len >= (int)body_size)
+            body_len = (int)body_size - 1;
+        http_finish_in_place(hs, "application/json", body_len);
+        if (reset > 0)
+            perf_reset();
+    }
+    else if (strstr(req, "GET /debug/mem"))
+    {
+        // Seções estáticas, heap, marca d'água das pilhas e heap e pools do lwIP
+        route = PERF_HTTP_DEBUG;
+        char *body = hs->response + HTTP_HEADER_RESERVE;
+        size_t body_size = sizeof(hs->response) - HTTP_HEADER_RESERVE;
+        int body_len = mem_report_format_json(body, body_size);
+        if (body_len >= (int)body_size)
+            body_len = (int)body_size - 1;
+        http_finish_in_place(hs, "application/json", body_len);
+    }
+    else if (strstr(req, "GET /debug/loop"))
+    {
+        // SLO da volta do laço, pior volta acima dele e o travamento antes do último reset
+        route = PERF_HTTP_DEBUG;
+        char *body = hs->response + HTTP_HEADER_RESERVE;
+        size_t body_size = sizeof(hs->response) - HTTP_HEADER_RESERVE;
+        int body_len = loop_watchdog_format_json(body, body_size);
+        if (body_len >= (int)body_size)
+            body_len = (int)body_size - 1;
+        http_finish_in_place(hs, "application/json", body_len);
+    }
+    else if (strstr(req, "GET /debug/power"))
+    {
+        route = PERF_HTTP_DEBUG;
+        // Estimativa de consumo pelo tempo de cada subsistema em cada estado desde o boot
+        power_report_t report;
+        power_get_report(time_us_64(), &report);
+
+        char *body = hs->response + HTTP_HEADER_RESERVE;
+        size_t body_size = sizeof(hs->response) - HTTP_HEADER_RESERVE;
+        int body_len = appendf(body, body_size, 0,
+                               "{\"low_power\":%s,\"sample_interval_ms\":%lu,\"elapsed_s\":%.1f,"
+                               "\"avg_ma\":%.2f,\"mah_per_day\":%.1f,\"subsystems\":{",
+                               low_power_mode ? "true" : "false", (unsigned long)duty_sample_interval_ms(),
+                               report.elapsed_us / 1e6, report.total_ma, report.total_mah_per_day);
+        for (int i = 0; i < POWER_SUBSYSTEM_COUNT; i++)
+        {
+            const power_usage_t *u = &report.subsystems[i];
+            body_len = appendf(body, body_size, body_len, "%s\"%s\":{\"avg_ma\":%.3f,\"active\":%.4f,\"mah_per_day\":%.2f}",
+                               i ? "," : "", power_subsystem_name((power_subsystem_t)i), u->avg_ma,
+                               u->active_fraction, u->mah_per_day);
+        }
+        body_len = appendf(body, body_size, body_len, "}}");
+        http_finish_in_place(hs, "application/json", body_len);
+    }
+    else if (strstr(req, "GET /debug/boot"))
+    {
+        route = PERF_HTTP_DEBUG;
+        // Linha do tempo do boot: fim e duração de cada fase desde o reset
+        char *body = hs->response + HTTP_HEADER_RESERVE;
+        size_t body_size = sizeof(hs->response) - HTTP_HEADER_RESERVE;
+        int body_len = boot_format_report(body, body_size);
+        if (body_len >= (int)body_size)
+            body_len = (int)body_size - 1;
+        http_finish_in_place(hs, "text/plain", body_len);
+    }
+    else if (strstr(req, "GET /events"))
+    {
+        route = PERF_HTTP_EVENTS;
+        // Registro de transições de alarme com seq maior que since
+        float since = 0.0f;
+        parse_float_param(req, "since=", &since);
+
+        char *body = hs->response + HTTP_HEADER_RESERVE;
+        size_t body_size = sizeof(hs->response) - HTTP_HEADER_RESERVE;
+        int body_len = appendf(body, body_size, 0, "{\"last_seq\":%lu,\"events\":[",
+                               (unsigned long)alarm_events_last_seq());
+        uint emitted = 0;
+        for (uint i = 0; i < alarm_events_count(); i++)
+        {
+            const alarm_event_t *e = alarm_events_get(i);
+            if (e->seq <= (uint32_t)since)
+                continue;
+            const sensor_channel_t *ch = sensors_channel(e->channel);
+            body_len = appendf(body, body_size, body_len,
+                               "%s{\"seq\":%lu,\"ts\":%lu,\"event\":\"%s\",\"type\":\"%s\",\"ch\":%u,"
+                               "\"kind\":\"%s\",\"sensor\":\"%s\",\"value\":%.2f,\"threshold\":%.2f,\"acked\":%s}",
+                               emitted++ ? "," : "", (unsigned long)e->seq, (unsigned long)e->ts,
+                               e->raised ? "raise" : "clear",
+                               alarms_rule(e->rule)->type == ALARM_RULE_RATE ? "rate" : "range", e->channel,
+                               sensors_kind_name(ch->kind), sensors_instance(ch->instance)->label,
+                               e->value, e->threshold, e->acked ? "true" : "false");
+        }
+        body_len = appendf(body, body_size, body_len, "]}");
+        http_finish_in_place(hs, "application/json", body_len);
+    }
+    else if (strstr(req, "GET /trace.bin"))
+    {
+        route = PERF_HTTP_DEBUG;
+        // Traço de sensores gravado na flash, enviado em partes
+        hs->raw = sensor_trace_flash_data();
+        hs->raw_left = sensor_trace_flash_size();
+        hs->len = snprintf(hs->response, sizeof(hs->response),
+                           "HTTP/1.1 200 OK\r\nContent-Type: application/octet-stream\r\nContent-Length: %lu\r\n"
+                           "Connection: close\r\n\r\n",
+                           (unsigned long)hs->raw_left);
+    }
+    else if (strstr(req, "GET /trace"))
+    {
+        route = PERF_HTTP_DEBUG;
+        // Gravação do traço de sensores: mode=usb, mode=flash ou mode=off. O
+        // pedido vale a partir da próxima volta do laço; mode traz o modo atual
+        // e requested o pedido ainda não aplicado
+        if (strstr(req, "mode=usb") || strstr(req, "mode=flash") || strstr(req, "mode=off"))
+        {
+            trace_requested_mode = strstr(req, "mode=usb")     ? SENSOR_TRACE_USB
+                                   : strstr(req, "mode=flash") ? SENSOR_TRACE_FLASH
+                                                               : SENSOR_TRACE_OFF;
+            trace_requested = true;
+        }
+        sensor_trace_stats_t trace;
+        sensor_trace_get_stats(&trace);
+        char *body = hs->response + HTTP_HEADER_RESERVE;
+        size_t body_size = sizeof(hs->response) - HTTP_HEADER_RESERVE;
+        int body_len = appendf(body, body_size, 0,
+                               "{\"mode\":\"%s\",\"requested\":\"%s\",\"records\":%lu,\"bytes\":%lu,\"full\":%s,"
+                               "\"flash_bytes\":%lu}",
+                               sensor_trace_mode_name(trace.mode),
+                               sensor_trace_mode_name(trace_requested ? trace_requested_mode : trace.mode),
+                               (unsigned long)trace.records, (unsigned long)trace.bytes, trace.full ? "true" : "false",
+                               (unsigned long)sensor_trace_flash_size());
+        http_finish_in_place(hs, "application/json", body_len);
+    }
+    else if (strstr(req, "GET /screen.pbm"))
+    {
+        route = PERF_HTTP_SCREEN;
+        // Cópia do quadro atual do OLED como imagem PBM
+        size_t body_len = ssd1306_export_pbm(&ssd, (uint8_t *)hs->response + HTTP_HEADER_RESERVE,
+                                             sizeof(hs->response) - HTTP_HEADER_RESERVE);
+        http_finish_in_place(hs, "image/x-portable-bitmap", (int)body_len);
     }
     else if (strstr(req, "GET /sensordata"))
     {
-        char json_payload[1024];
-        int json_len = snprintf(json_payload, sizeof(json_payload),
-                                "{\"sensors\":{\"temp_bmp\":%.2f,\"pressure\":%.2f,\"altitude\":%.1f,\"temp_aht\":%.2f,\"humidity\":%.1f},"
-                                "\"settings\":{\"temp_offset\":%.2f,\"pressure_offset_kpa\":%.2f,"
-                                "\"temp_min\":%.1f,\"temp_max\":%.1f,\"pressure_min\":%.2f,\"pressure_max\":%.2f,"
-                                "\"altitude_min\":%.1f,\"altitude_max\":%.1f,\"humidity_min\":%.1f,\"humidity_max\":%.1f}}",
-                                temperature_bmp, pressure_kpa, altitude_m, temperature_aht, humidity_rh,
-                                temp_offset, pressure_offset_kpa,
-                                temp_min, temp_max, pressure_min, pressure_max,
-                                altitude_min, altitude_max, humidity_min, humidity_max);
+        route = PERF_HTTP_SENSORDATA;
+        char json_payload[2048];
+        const char *state;
+        int json_len = render_sensordata_state(&state);
+        json_len = MIN(json_len, (int)sizeof(json_payload) - 1);
+        memcpy(json_payload, state, json_len);
+        json_payload[json_len] = '\0';
+        wifi_stats_t wifi;
+        wifi_manager_get_stats(&wifi);
+        json_len = appendf(json_payload, sizeof(json_payload), json_len,
+                           ",\"wifi\":{\"uptime_s\":%lu,\"total_up_s\":%lu,\"attempts\":%lu,\"failures\":%lu,"
+                           "\"reconnects\":%lu,\"link_losses\":%lu}}",
+                           (unsigned long)(wifi.uptime_ms / 1000), (unsigned long)(wifi.total_up_ms / 1000),
+                           (unsigned long)wifi.attempts, (unsigned long)wifi.failures,
+                           (unsigned long)wifi.reconnects, (unsigned long)wifi.link_losses);
 
         hs->len = snprintf(hs->response, sizeof(hs->response),
                            "HTTP/1.1 200 OK\r\nContent-Type: application/json\r\nContent-Length: %d\r\nConnection: close\r\n\r\n%s",
@@ -421,6 +866,7 @@ static err_t http_recv(void *arg, struct tcp_pcb *tpcb, struct pbuf *p, err_t er
                            "HTTP/1.1 200 OK\r\nContent-Type: text/html\r\nContent-Length: %d\r\nConnection: close\r\n\r\n%s",
                            (int)strlen(HTML_BODY), HTML_BODY);
     }
+    PERF_END_AS(HTTP, route);
 
     tcp_arg(tpcb, hs);
     tcp_sent(tpcb, http_sent);
@@ -436,18 +882,96 @@ static err_t connection_callback(void *arg, struct tcp_pcb *newpcb, err_t err)
     return ERR_OK;
 }
 
+static struct tcp_pcb *http_listener = NULL;
+
+// Abre o servidor quando o enlace sobe e o fecha na queda, para voltar a escutar
+// limpo a cada reconexão
 static void start_http_server(void)
 {
+    if (http_listener)
+        return;
+    cyw43_arch_lwip_begin();
     struct tcp_pcb *pcb = tcp_new();
-    tcp_bind(pcb, IP_ADDR_ANY, 80);
-    pcb = tcp_listen(pcb);
-    tcp_accept(pcb, connection_callback);
+    if (pcb && tcp_bind(pcb, IP_ADDR_ANY, 80) == ERR_OK)
+    {
+        http_listener = tcp_listen(pcb);
+        if (http_listener)
+            tcp_accept(http_listener, connection_callback);
+    }
+    else if (pcb)
+    {
+        tcp_close(pcb);
+    }
+    cyw43_arch_lwip_end();
+}
+
+static void stop_http_server(void)
+{
+    if (!http_listener)
+        return;
+    cyw43_arch_lwip_begin();
+    tcp_close(http_listener);
+    http_listener = NULL;
+    cyw43_arch_lwip_end();
+}
+
+// Modo de operação pedido nas configurações (a web e o MQTT podem mudá-lo a qualquer momento)
+static duty_config_t duty_config_from_settings(void)
+{
+    return (duty_config_t){
+        .low_power = settings.low_power >= 0.5f,
+        .sample_interval_ms = settings.sample_interval_s > 0 ? (uint32_t)(settings.sample_interval_s * 1000.0f) : 0,
+    };
+}
+
+// Leva o modo aos sensores, ao rádio, à matriz e ao espaçamento do histórico
+static void apply_power_mode(bool low_power)
+{
+    low_power_mode = low_power;
+    sensors_set_low_power(low_power);
+    wifi_manager_set_power_save(low_power);
+    show_alarms(last_alarms);
+    history_interval_ms = low_power ? duty_sample_interval_ms() : HISTORY_INTERVAL_MS;
+}
+
+// Corrente de cada subsistema no estado atual, para a contabilidade de energia.
+// CPU e sensores são contados onde ligam e desligam, no próprio laço.
+static void account_power(bool display_on, uint64_t now_us)
+{
+    float radio_ma = POWER_MA_RADIO_IDLE;
+    if (wifi_manager_state() == WIFI_UP)
+        radio_ma = low_power_mode ? POWER_MA_RADIO_PM_AGGRESSIVE : POWER_MA_RADIO_PM_DEFAULT;
+    else if (wifi_manager_state() == WIFI_CONNECTING)
+        radio_ma = POWER_MA_RADIO_ACTIVE;
+    power_set(POWER_RADIO, radio_ma, now_us);
+    power_set(POWER_OLED, display_on ? POWER_MA_OLED_ON : POWER_MA_OLED_OFF, now_us);
+    bool matrix_dark = low_power_mode && last_alarms == 0;
+    power_set(POWER_MATRIX, matrix_dark ? POWER_MA_MATRIX_DARK : POWER_MA_MATRIX_LIT, now_us);
+}
+
+// Dorme até o instante pedido; um botão (ou qualquer interrupção que deixe
+// pedido para o laço) acorda antes
+static void sleep_until_wake(absolute_time_t until)
+{
+    while (!screen_advance_requested && !ack_requested && !trace_requested && !best_effort_wfe_or_timeout(until))
+        ;
 }
 
 int main()
 {
+    // Pinta as pilhas antes de qualquer trabalho, para medir a maior profundidade
+    mem_report_init();
+    // O traço das etapas de antes de um reset pelo watchdog, antes que o boot o sobrescreva
+    loop_watchdog_init();
+
+    // Sem espera pela USB: o relatório do boot sai quando o host abrir a porta
     stdio_init_all();
-    sleep_ms(1000);
+    boot_mark("stdio");
+
+    // Restaura as configurações salvas antes de qualquer avaliação de alarme
+    settings_store_init(&settings);
+    settings_loaded = settings_publish(&settings);
+    boot_mark("settings");
 
     // Inicialização do Hardware e Wi-Fi
     gpio_init(BOOTSEL_BUTTON);
@@ -460,6 +984,11 @@ int main()
     gpio_pull_up(RESET_CONFIG_BUTTON);
     gpio_set_irq_enabled(RESET_CONFIG_BUTTON, GPIO_IRQ_EDGE_FALL, true);
 
+    gpio_init(SCREEN_BUTTON);
+    gpio_set_dir(SCREEN_BUTTON, GPIO_IN);
+    gpio_pull_up(SCREEN_BUTTON);
+    gpio_set_irq_enabled(SCREEN_BUTTON, GPIO_IRQ_EDGE_FALL, true);
+
     i2c_init(I2C_PORT_SENSORS, 400 * 1000);
     gpio_set_function(I2C_SDA_SENSORS, GPIO_FUNC_I2C);
     gpio_set_function(I2C_SCL_SENSORS, GPIO_FUNC_I2C);
@@ -478,164 +1007,307 @@ int main()
     gpio_init(LED_RED_PIN);
     gpio_set_dir(LED_RED_PIN, GPIO_OUT);
     ligar_led_verde();
+    boot_mark("gpio");
 
-    // Configura a matriz de LEDs Neopixel
-    npInit(MATRIX_LED_PIN);
-    drawSorrisoNormal(); // Desenha sorriso normal
-
-    // Configura PWM para o buzzer
-    gpio_set_function(BUZZER_A, GPIO_FUNC_PWM);
-    slice_buzzer = pwm_gpio_to_slice_num(BUZZER_A);
-    pwm_set_clkdiv(slice_buzzer, DIVIDER_PWM);
-    pwm_set_wrap(slice_buzzer, PERIOD);
-    pwm_set_gpio_level(BUZZER_A, 0);
-    pwm_set_enabled(slice_buzzer, true);
-
-    ssd1306_t ssd;
+    // Saídas primeiro: o tempo de energização do AHT20 corre enquanto isso
     ssd1306_init(&ssd, WIDTH, HEIGHT, false, DISP_ADDR, I2C_PORT_DISP);
     ssd1306_config(&ssd);
+    oled_screens_init(&ssd);
+    boot_mark("display");
 
-    bmp280_init(I2C_PORT_SENSORS);
-    struct bmp280_calib_param params;
-    bmp280_get_calib_params(I2C_PORT_SENSORS, &params);
-
-    aht20_reset(I2C_PORT_SENSORS);
-    aht20_init(I2C_PORT_SENSORS);
+    // Configura a matriz de LEDs Neopixel
+    npInit(MATRIX_LED_PIN);
+    npShowGlyph(NP_GLYPH_SMILE, NP_GREEN, NP_ANIM_STATIC); // Desenha sorriso normal
 
+    // Configura PWM para o buzzer
+    buzzer_init(BUZZER_A);
+    boot_mark("outputs");
+
+    // Registro dos sensores: os dois endereços do BMP280, o AHT20 e o que houver
+    // atrás do multiplexador. Chips ausentes são simplesmente ignorados.
+    sensors_add(SENSOR_BMP280, I2C_PORT_SENSORS, BMP280_I2C_ADDR, SENSOR_NO_MUX, 0);
+    sensors_add(SENSOR_BMP280, I2C_PORT_SENSORS, BMP280_I2C_ADDR_ALT, SENSOR_NO_MUX, 0);
+    sensors_add(SENSOR_AHT20, I2C_PORT_SENSORS, AHT20_I2C_ADDR, SENSOR_NO_MUX, 0);
+    if (SENSORS_MUX_ADDR != SENSOR_NO_MUX)
+        sensors_scan_mux(I2C_PORT_SENSORS, SENSORS_MUX_ADDR);
+    // A conversão do AHT20 corre durante o histórico e a subida do rádio
+    sensors_prime();
+    alarm_rules_register(&settings);
+    boot_mark("sensors");
+
+    // Histórico: recupera o log da flash e continua a linha do tempo dele
+    tsdb_init();
+    uint32_t last_logged_ms;
+    if (sample_log_init(&last_logged_ms))
+        device_time_base_ms = last_logged_ms + HISTORY_INTERVAL_MS;
+    next_history_ms = device_time_ms();
+    sensor_trace_init(device_time_base_ms);
+    // Os agregados são refeitos a partir do log aos poucos, dentro do laço principal
+    rollup_init();
+    boot_mark("history");
+
+    // Wi-Fi em segundo plano: sensores, alarmes e display funcionam desde já,
+    // com ou sem rede; o servidor HTTP sobe junto com o enlace
     cyw43_arch_init();
-    cyw43_arch_enable_sta_mode();
-    ssd1306_fill(&ssd, false);
-    ssd1306_draw_string(&ssd, "Conectando WiFi...", 0, 0);
-    ssd1306_send_data(&ssd);
-
-    if (cyw43_arch_wifi_connect_timeout_ms(WIFI_SSID, WIFI_PASS, CYW43_AUTH_WPA2_AES_PSK, 15000))
+    wifi_manager_init(WIFI_SSID, WIFI_PASS);
+    char ip_str[24] = "WiFi: conectando";
+    boot_mark("radio");
+
+    // Eventos de alarme: um número aleatório identifica a sequência deste boot para o coletor
+    alarm_events_init(get_rand_32());
+
+    // Telemetria e MQTT identificados pelos 4 últimos bytes do ID único da flash
+    pico_unique_board_id_t board_id;
+    pico_get_unique_board_id(&board_id);
+    uint32_t device_id = (uint32_t)board_id.id[4] << 24 | (uint32_t)board_id.id[5] << 16 |
+                         (uint32_t)board_id.id[6] << 8 | board_id.id[7];
+    telemetry_init(device_id);
+    mqtt_init(device_id, apply_remote_settings);
+    boot_mark("net clients");
+
+    // Modo de operação e contabilidade de energia a partir daqui
+    duty_config_t duty = duty_config_from_settings();
+    duty_init(&duty, to_ms_since_boot(get_absolute_time()));
+    apply_power_mode(duty.low_power);
+    power_init(time_us_64());
+    bool display_on = true;
+
+    bool boot_reported = false;
+    // Daqui em diante, cada volta do laço precisa terminar dentro de LOOP_WATCHDOG_TIMEOUT_MS
+    loop_watchdog_start();
+    while (true)
     {
-        ssd1306_fill(&ssd, false);
-        ssd1306_draw_string(&ssd, "WiFi: ERRO", 0, 0);
-        ssd1306_send_data(&ssd);
-        return 1;
-    }
+        power_set(POWER_CPU, POWER_MA_CPU_RUN, time_us_64());
+        PERF_BEGIN(LOOP);
+        loop_watchdog_begin();
+        PERF_BEGIN(CYW43_POLL);
+        cyw43_arch_poll();
+        PERF_END(CYW43_POLL);
+        uint32_t boot_ms = to_ms_since_boot(get_absolute_time());
 
-    char ip_str[24];
-    snprintf(ip_str, sizeof(ip_str), "%s", ip4addr_ntoa(netif_ip4_addr(netif_default)));
-    ssd1306_fill(&ssd, false);
-    ssd1306_draw_string(&ssd, "WiFi Conectado!", 0, 0);
-    ssd1306_draw_string(&ssd, ip_str, 0, 10);
-    ssd1306_send_data(&ssd);
+        // Escritas do botão, da web e do MQTT valem a partir desta volta, inteiras
+        if (settings_version() != settings_loaded)
+            settings_loaded = settings_load(&settings);
 
-    start_http_server();
+        // Traço pedido pela web: o estado dos canais e das regras gravado no
+        // início é o de uma volta completa, como a reprodução espera
+        if (trace_requested)
+        {
+            trace_requested = false;
+            if (trace_requested_mode == SENSOR_TRACE_OFF)
+                sensor_trace_stop();
+            else
+                sensor_trace_start(trace_requested_mode, &settings);
+        }
 
-    char buffer[20];
-    while (true)
-    {
-        cyw43_arch_poll();
+        // Mudança de modo feita pela web ou pelo MQTT vale a partir desta volta
+        duty_config_t wanted = duty_config_from_settings();
+        if (wanted.low_power != duty.low_power || wanted.sample_interval_ms != duty.sample_interval_ms)
+        {
+            duty = wanted;
+            duty_configure(&duty, boot_ms);
+            apply_power_mode(duty.low_power);
+        }
+        uint32_t due = duty_due(boot_ms);
+
+        // Botão do joystick: com o OLED apagado só reacende; senão troca a tela
+        if (screen_advance_requested)
+        {
+            screen_advance_requested = false;
+            if (duty_display_on(boot_ms))
+                oled_screens_next();
+            duty_user_activity(boot_ms);
+            due |= DUTY_SERVICE;
+        }
 
-        // Leitura RAW dos sensores
-        int32_t raw_temp_bmp, raw_press;
-        bmp280_read_raw(I2C_PORT_SENSORS, &raw_temp_bmp, &raw_press);
-        int32_t temp_c = bmp280_convert_temp(raw_temp_bmp, &params);
-        int32_t press_pa_raw = bmp280_convert_pressure(raw_press, raw_temp_bmp, &params);
-
-        AHT20_Data aht_data;
-        aht20_read(I2C_PORT_SENSORS, &aht_data);
-
-        // *** APLICAÇÃO DOS OFFSETS DE CALIBRAÇÃO ***
-        temperature_bmp = (temp_c / 100.0f) + temp_offset;
-        pressure_kpa = (press_pa_raw / 1000.0f) + pressure_offset_kpa;
-        altitude_m = calculate_altitude_func(pressure_kpa * 1000); // A função espera Pa
-
-        // Dados do AHT20
-        temperature_aht = aht_data.temperature + temp_offset;
-        humidity_rh = aht_data.humidity;
-
-        // Atualiza display OLED
-        ssd1306_fill(&ssd, false);
-        ssd1306_draw_string(&ssd, ip_str, 0, 5);
-        snprintf(buffer, sizeof(buffer), "T:%.1fC", temperature_bmp);
-        ssd1306_draw_string(&ssd, buffer, 0, 15);
-        snprintf(buffer, sizeof(buffer), "P:%.1fkPa", pressure_kpa);
-        ssd1306_draw_string(&ssd, buffer, 0, 25);
-        snprintf(buffer, sizeof(buffer), "U:%.1f%%", humidity_rh);
-        ssd1306_draw_string(&ssd, buffer, 0, 35);
-        snprintf(buffer, sizeof(buffer), "Alt:%.0fm", altitude_m);
-        ssd1306_draw_string(&ssd, buffer, 0, 45);
-        ssd1306_send_data(&ssd);
-
-        bool current_ok = !(temperature_bmp < temp_min || temperature_bmp > temp_max ||
-                            temperature_aht < temp_min || temperature_aht > temp_max ||
-                            pressure_kpa < pressure_min || pressure_kpa > pressure_max ||
-                            altitude_m < altitude_min || altitude_m > altitude_max ||
-                            humidity_rh < humidity_min || humidity_rh > humidity_max);
-
-        // Verifica se o estado mudou, se é hora de atualizar OU se o erro específico mudou
-        if (current_ok != last_ok_state ||
-            (current_ok && (time_us_64() - last_update_time) >= 250000) ||
-            (!current_ok && (get_current_error() != last_error_displayed))) // Erro diferente do último exibido
+        if (due & DUTY_SERVICE)
         {
-            if (current_ok)
+            PERF_BEGIN(WIFI);
+            wifi_event_t wifi_event = wifi_manager_task(boot_ms);
+            PERF_END(WIFI);
+            switch (wifi_event)
             {
-                ligar_led_verde();
-                buzzer_off();
-                drawSorrisoNormal();
-                last_error_displayed = ERROR_NONE; // Reseta o último erro exibido
-                last_update_time = time_us_64();
+            case WIFI_EVENT_UP:
+                snprintf(ip_str, sizeof(ip_str), "%s", ip4addr_ntoa(netif_ip4_addr(netif_default)));
+                start_http_server();
+                break;
+            case WIFI_EVENT_DOWN:
+                stop_http_server();
+                snprintf(ip_str, sizeof(ip_str), "WiFi: sem rede");
+                break;
+            default:
+                break;
             }
-            else
-            {
-                ligar_led_vermelho();
-                ErrorType current_error = get_current_error(); // Função que identifica o erro prioritário
+        }
 
-                // Só redesenha se o erro atual for diferente do último
-                if (current_error != last_error_displayed)
+        if (due & DUTY_SAMPLE)
+        {
+            // Leitura de todos os sensores registrados, já com os offsets de calibração
+            const float offsets[CHANNEL_KIND_COUNT] = {
+                [CHANNEL_TEMPERATURE] = settings.temp_offset,
+                [CHANNEL_PRESSURE] = settings.pressure_offset_kpa,
+            };
+            power_set(POWER_SENSORS, POWER_MA_SENSORS_MEASURING, time_us_64());
+            PERF_BEGIN(SENSORS);
+            sensor_trace_settings(&settings);
+            sensors_poll(offsets);
+            PERF_END(SENSORS);
+            power_set(POWER_SENSORS, POWER_MA_SENSORS_IDLE, time_us_64());
+            if (!boot_mark_us("first sample") && sensors_channel_count() > 0 && sensors_channel(0)->valid)
+                boot_mark("first sample");
+
+            // Grava no histórico no instante agendado (e não no instante real da
+            // leitura), o que mantém o delta-of-delta dos timestamps em zero
+            uint32_t now_ms = device_time_ms();
+            if ((int32_t)(now_ms - next_history_ms) >= 0)
+            {
+                PERF_BEGIN(HISTORY);
+                for (uint i = 0; i < sensors_channel_count(); i++)
                 {
-                    switch (current_error)
+                    const sensor_channel_t *ch = sensors_channel(i);
+                    if (ch->valid)
                     {
-                    case ERROR_TEMPERATURE:
-                        drawT((uint8_t[]){255, 0, 0});
-                        break;
-                    case ERROR_PRESSURE:
-                        drawP((uint8_t[]){255, 0, 0});
-                        break;
-                    case ERROR_ALTITUDE:
-                        drawA((uint8_t[]){255, 0, 0});
-                        break;
-                    case ERROR_HUMIDITY:
-                        drawU((uint8_t[]){255, 0, 0});
-                        break;
+                        tsdb_append((uint8_t)i, next_history_ms, ch->value);
+                        rollup_add((uint8_t)i, next_history_ms, ch->value);
+                        oled_screens_add_sample((uint8_t)i, next_history_ms, ch->value);
+                        telemetry_add_sample((uint8_t)i, next_history_ms, ch->value);
+                        mqtt_add_sample((uint8_t)i, next_history_ms, ch->value);
                     }
-
-                    last_error_displayed = current_error; // Atualiza o último erro exibido
                 }
+                next_history_ms += history_interval_ms;
+                // Se o laço atrasou mais de um intervalo, recomeça a agenda a partir de agora
+                if ((int32_t)(now_ms - next_history_ms) >= 0)
+                    next_history_ms = now_ms + history_interval_ms;
+
+                // Canais lentos também chegam à flash em tempo limitado
+                tsdb_seal_older_than(now_ms - SAMPLE_LOG_MAX_BLOCK_AGE_MS);
+                PERF_END(HISTORY);
             }
-
-            last_ok_state = current_ok;
         }
 
-        if (!current_ok) // Se está em estado de erro
+        if (due & DUTY_SERVICE)
         {
-            uint64_t current_time = time_us_64();
-            uint64_t elapsed = current_time - last_buzzer_time;
-
-            // Ciclo de 500ms (250ms ligado, 250ms desligado)
-            if (buzzer_state && elapsed >= 250000) // Já está ligado há 250ms? Desliga.
+            PERF_BEGIN(ROLLUP);
+            rollup_rebuild_step(ROLLUP_REBUILD_BUDGET);
+            PERF_END(ROLLUP);
+
+            // Atualiza display OLED (status ou tendência de um canal); no baixo
+            // consumo ele apaga depois de um tempo sem uso dos botões
+            bool wanted_on = duty_display_on(boot_ms);
+            if (wanted_on != display_on)
             {
-                buzzer_off();
-                last_buzzer_time = current_time;
+                ssd1306_set_power(&ssd, wanted_on);
+                display_on = wanted_on;
             }
-            else if (!buzzer_state && elapsed >= 250000) // Já está desligado há 250ms? Liga.
+            if (display_on)
             {
-                buzzer_on();
-                last_buzzer_time = current_time;
+                PERF_BEGIN(OLED);
+                oled_screens_render(ip_str, device_time_ms());
+                PERF_END(OLED);
             }
+
+            // Persiste as configurações alteradas, respeitando o limite de gravações
+            PERF_BEGIN(SETTINGS);
+            settings_store_task();
+            PERF_END(SETTINGS);
         }
-        else // Se voltou ao normal, DESLIGA o buzzer
+
+        if (due & DUTY_SAMPLE)
         {
-            if (buzzer_state) // Se estava ligado, desliga
+            // Todas as regras em uma passada; as saídas só mudam quando a máscara muda
+            PERF_BEGIN(ALARMS);
+            uint32_t eval_ms = device_time_ms();
+            sensor_trace_settings(&settings);
+            alarm_mask_t active = alarms_evaluate(eval_ms);
+            sensor_trace_eval(eval_ms, active);
+            // Valores e alarmes desta volta, juntos, para as rotas HTTP
+            sample_snapshot_publish(eval_ms);
+            bool current_ok = active == 0;
+            if (!boot_mark_us("first alarm eval") && boot_mark_us("first sample"))
+                boot_mark("first alarm eval");
+            if (active != last_alarms)
             {
-                buzzer_off();
+                // Cada transição vai para o registro e é enviada ao coletor na mesma volta
+                alarm_events_record(device_time_ms(), last_alarms, active);
+
+                if (current_ok)
+                {
+                    ligar_led_verde();
+                }
+                else
+                {
+                    ligar_led_vermelho();
+                }
+                last_alarms = active;
+                show_alarms(active);
             }
+            PERF_END(ALARMS);
+        }
+
+        if (due & DUTY_SERVICE)
+        {
+            // Reenvio, com backoff, dos eventos que o coletor ainda não confirmou
+            PERF_BEGIN(NET);
+            alarm_events_set_collector(settings.collector_ip, (uint16_t)settings.collector_port);
+            alarm_events_task(device_time_ms());
+
+            // Lote de telemetria multicast; sai assim que completa o tempo de espera
+            telemetry_set_destination(settings.telemetry_ip, (uint16_t)settings.telemetry_port);
+            telemetry_task(device_time_ms());
+
+            // Lotes MQTT; sem broker, as amostras esperam na fila e escoam na reconexão
+            mqtt_set_broker(settings.mqtt_ip, (uint16_t)settings.mqtt_port);
+            mqtt_task(device_time_ms());
+            PERF_END(NET);
         }
 
-        sleep_ms(250);
+        // O buzzer toca sozinho no alarme de hardware; aqui só muda o padrão
+        if (ack_requested)
+        {
+            ack_requested = false;
+            acked_alarms = last_alarms;
+        }
+        acked_alarms &= last_alarms; // Alarme que limpou e voltou conta como novo
+        buzzer_pattern_id_t pattern = pattern_for_alarms(last_alarms & ~acked_alarms);
+        if (pattern != buzzer_pattern)
+        {
+            buzzer_play(pattern);
+            buzzer_pattern = pattern;
+        }
+
+        // Linha do tempo do boot no console, uma vez, quando o host abrir a porta USB
+        bool boot_done = boot_mark_us("first alarm eval") || sensors_channel_count() == 0;
+        if (!boot_reported && boot_done && stdio_usb_connected())
+        {
+            static char report[2048];
+            boot_format_report(report, sizeof(report));
+            printf("%s", report);
+            mem_report_sample(); // Os picos de agora já saem no relatório
+            mem_report_format_text(report, sizeof(report));
+            printf("%s", report);
+            // Se o boot veio de um travamento, onde o laço estava preso
+            loop_watchdog_format_text(report, sizeof(report));
+            printf("%s", report);
+            boot_reported = true;
+        }
+        // Depois, uma linha a cada pico novo de heap ou de pilha
+        if ((due & DUTY_SERVICE) && mem_report_sample() && boot_reported && stdio_usb_connected())
+        {
+            mem_report_t mem;
+            mem_report_get(&mem);
+            printf("memoria: heap pico %lu (arena %lu), pilhas %lu/%lu e %lu/%lu\n", (unsigned long)mem.heap_used_peak,
+                   (unsigned long)mem.heap_arena, (unsigned long)mem.stacks[0].used,
+                   (unsigned long)mem.stacks[0].reserved, (unsigned long)mem.stacks[1].used,
+                   (unsigned long)mem.stacks[1].reserved);
+        }
+
+        // Núcleo dormindo até o próximo vencimento da agenda
+        PERF_END(LOOP);
+        loop_watchdog_end(settings.loop_slo_ms > 0 ? (uint32_t)settings.loop_slo_ms : 0);
+        account_power(display_on, time_us_64());
+        power_set(POWER_CPU, POWER_MA_CPU_WFE, time_us_64());
+        int32_t wait_ms = (int32_t)(duty_next_wake_ms() - to_ms_since_boot(get_absolute_time()));
+        if (wait_ms > 0)
+            sleep_until_wake(make_timeout_time_ms(wait_ms));
     }
-}
\ No newline at end of file
+}
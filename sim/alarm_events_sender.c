@@ -0,0 +1,112 @@
+#include <stdlib.h>
+
+#include "sim.h"
+#include "pico/cyw43_arch.h"
+#include "hardware/i2c.h"
+#include "sensors.h"
+#include "bmp280.h"
+#include "alarms.h"
+#include "alarm_events.h"
+
+// Emissor dos eventos de alarme (lib/alarm_events.c) para o teste com o
+// coletor em tools/alarm_events_collector_test.py: o BMP280 da placa
+// simulada, uma regra de faixa na temperatura e uma de taxa na pressão, e um
+// evento a cada intervalo_ms virtuais, alternando as regras e disparando e
+// limpando cada uma. O alarm_events_task roda a cada volta do laço, como no
+// main.c. Depois dos eventos, continua até cada um ser confirmado ou
+// abandonado.
+//
+//   alarm_events_sender porta [eventos] [intervalo_ms] [velocidade]
+//
+// Ao sair, imprime uma linha JSON com as regras e as estatísticas do registro.
+
+#define BOOT_ID 0xB0070001
+#define LOOP_MS 250 // Volta do laço principal do firmware
+#define DRAIN_MAX_MS 300000
+
+// Eventos ainda sem confirmação e sem desistência
+static uint pending_events(void)
+{
+    uint pending = 0;
+    for (uint i = 0; i < alarm_events_count(); i++)
+    {
+        const alarm_event_t *e = alarm_events_get(i);
+        pending += !e->acked && !e->given_up;
+    }
+    return pending;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 2)
+    {
+        fprintf(stderr, "uso: %s porta [eventos] [intervalo_ms] [velocidade]\n", argv[0]);
+        return 2;
+    }
+    uint16_t port = (uint16_t)atoi(argv[1]);
+    uint events = argc > 2 ? (uint)atoi(argv[2]) : 10;
+    uint32_t interval_ms = argc > 3 ? (uint32_t)atoi(argv[3]) : 1000;
+    sim_opts.speed = argc > 4 ? atof(argv[4]) : 1.0;
+    sim_time_init();
+
+    sim_i2c_init();
+    i2c_init(i2c0, 400 * 1000);
+    sensors_add(SENSOR_BMP280, i2c0, BMP280_I2C_ADDR, SENSOR_NO_MUX, 0);
+    alarms_init();
+    float temp_max = 40.0f;
+    alarms_add_range(0, NULL, &temp_max, 1.0f, 1);
+    alarms_add_rate(1, 0.5f, 0.1f, 1);
+    uint rules = alarms_rule_count();
+
+    cyw43_arch_enable_sta_mode();
+    cyw43_arch_wifi_connect_async("sim", "sim", CYW43_AUTH_WPA2_AES_PSK);
+    while (cyw43_tcpip_link_status(&cyw43_state, CYW43_ITF_STA) != CYW43_LINK_UP)
+        sleep_ms(10);
+    if (!alarm_events_init(BOOT_ID))
+        return 2;
+    alarm_events_set_collector(0x7F000001, port);
+
+    // Eventos na agenda do relógio virtual, a partir de ts 0, entre as voltas do laço
+    uint64_t start_us = sim_now_us(), next_tick_us = start_us;
+    alarm_mask_t mask = 0;
+    for (uint k = 0; k < events; k++)
+    {
+        uint64_t at_us = start_us + (uint64_t)k * interval_ms * 1000;
+        for (; next_tick_us < at_us; next_tick_us += LOOP_MS * 1000)
+        {
+            sleep_until(next_tick_us);
+            alarm_events_task((uint32_t)((next_tick_us - start_us) / 1000));
+        }
+        sleep_until(at_us);
+        alarm_mask_t after = mask ^ (1u << (k % rules));
+        alarm_events_record(k * interval_ms, mask, after);
+        mask = after;
+    }
+
+    // Reenvios até a confirmação ou a desistência de cada evento
+    uint64_t drain_end_us = sim_now_us() + (uint64_t)DRAIN_MAX_MS * 1000;
+    while (pending_events() && next_tick_us < drain_end_us)
+    {
+        sleep_until(next_tick_us);
+        alarm_events_task((uint32_t)((next_tick_us - start_us) / 1000));
+        next_tick_us += LOOP_MS * 1000;
+    }
+
+    printf("{\"boot\":%lu,\"interval_ms\":%lu,\"rules\":[", (unsigned long)BOOT_ID, (unsigned long)interval_ms);
+    for (uint i = 0; i < rules; i++)
+    {
+        const alarm_rule_t *rule = alarms_rule(i);
+        const sensor_channel_t *ch = sensors_channel(rule->channel);
+        printf("%s{\"type\":\"%s\",\"ch\":%u,\"kind\":\"%s\",\"sensor\":\"%s\"}", i ? "," : "",
+               rule->type == ALARM_RULE_RATE ? "rate" : "range", rule->channel, sensors_kind_name(ch->kind),
+               sensors_instance(ch->instance)->label);
+    }
+    alarm_events_stats_t st;
+    alarm_events_get_stats(&st);
+    uint pending = pending_events();
+    printf("],\"recorded\":%lu,\"sent\":%lu,\"retries\":%lu,\"acked\":%lu,\"dropped\":%lu,\"send_errors\":%lu,"
+           "\"pending\":%u}\n",
+           (unsigned long)st.recorded, (unsigned long)st.sent, (unsigned long)st.retries, (unsigned long)st.acked,
+           (unsigned long)st.dropped, (unsigned long)st.send_errors, pending);
+    return pending ? 1 : 0;
+}
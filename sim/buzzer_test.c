@@ -0,0 +1,226 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "sim.h"
+#include "buzzer.h"
+
+// Ritmo dos padrões do buzzer (lib/buzzer.c) no relógio virtual: cada mudança
+// de som no PWM simulado tem de cair no instante da tabela do padrão, com a
+// frequência certa, enquanto um laço principal de duração irregular roda ao
+// lado. Também confere o fim das repetições, o buzzer_stop no meio de um tom,
+// a troca de padrão sem sobras do anterior e a volta ao ritmo depois de um
+// trecho com as interrupções atrasadas.
+//
+//   buzzer_test    (status 1 se alguma mudança sair do ritmo)
+
+#define BUZZER_PIN 21
+#define TOLERANCE_US 1000
+#define MAX_EDGES 256
+
+typedef struct
+{
+    uint16_t freq_hz;
+    uint16_t ms;
+} step_t;
+
+// As tabelas esperadas de cada padrão (as mesmas descritas em buzzer.h)
+static const step_t RATE[] = {{1500, 150}, {0, 150}, {1500, 150}, {0, 1550}};
+static const step_t RANGE[] = {{1900, 250}, {0, 250}};
+static const step_t CRITICAL[] = {{2500, 100}, {0, 100}, {2500, 100}, {0, 100}, {2500, 100}, {0, 400}};
+
+static const struct
+{
+    const step_t *steps;
+    uint count;
+    uint repeat; // 0: até buzzer_stop
+} EXPECTED[BUZZER_PATTERN_COUNT] = {
+    [BUZZER_RATE] = {RATE, count_of(RATE), 3},
+    [BUZZER_RANGE] = {RANGE, count_of(RANGE), 0},
+    [BUZZER_CRITICAL] = {CRITICAL, count_of(CRITICAL), 0},
+};
+
+typedef struct
+{
+    uint64_t t_us; // Desde o buzzer_play
+    uint32_t freq_hz;
+} edge_t;
+
+static struct
+{
+    edge_t edges[MAX_EDGES];
+    uint count;
+    uint64_t t0;
+} heard;
+
+// Mudanças no mesmo instante (o buzzer_play para o padrão anterior antes de
+// começar) não chegam a soar: fica só a última
+static void on_buzzer(uint32_t freq_hz)
+{
+    uint64_t t = sim_now_us() - heard.t0;
+    if (heard.count && heard.edges[heard.count - 1].t_us == t)
+        heard.count--;
+    uint32_t before = heard.count ? heard.edges[heard.count - 1].freq_hz : 0;
+    if (heard.count && before == freq_hz)
+        return;
+    if (heard.count < MAX_EDGES)
+        heard.edges[heard.count++] = (edge_t){t, freq_hz};
+}
+
+typedef struct
+{
+    const char *name;
+    buzzer_pattern_id_t pattern;
+    uint32_t run_ms;
+    uint32_t stop_ms;               // buzzer_stop neste instante (0: não para)
+    buzzer_pattern_id_t before;     // Padrão tocando antes, trocado no início
+    uint32_t stall_at_ms, stall_ms; // Interrupções atrasadas neste trecho
+} scenario_t;
+
+static const scenario_t SCENARIOS[] = {
+    {"taxa, três vezes", BUZZER_RATE, 8000, 0, BUZZER_SILENT, 0, 0},
+    {"faixa, parado no meio do tom", BUZZER_RANGE, 12000, 10100, BUZZER_SILENT, 0, 0},
+    {"crítico", BUZZER_CRITICAL, 9000, 0, BUZZER_SILENT, 0, 0},
+    {"faixa trocado por crítico", BUZZER_CRITICAL, 5000, 0, BUZZER_RANGE, 0, 0},
+    {"faixa com 1,3 s sem interrupções", BUZZER_RANGE, 6000, 0, BUZZER_SILENT, 1000, 1300},
+};
+
+// Mudanças de som esperadas até o fim do cenário, inclusive (os alarmes do
+// próprio instante final disparam), ou até o buzzer_stop, pela tabela do padrão
+static uint expected_edges(const scenario_t *sc, edge_t *out)
+{
+    const step_t *steps = EXPECTED[sc->pattern].steps;
+    uint count = EXPECTED[sc->pattern].count, repeat = EXPECTED[sc->pattern].repeat;
+    uint64_t t = 0, end = (uint64_t)(sc->stop_ms ? sc->stop_ms : sc->run_ms) * 1000;
+    uint32_t freq = 0;
+    uint n = 0, i = 0, loops = 0;
+    while ((sc->stop_ms ? t < end : t <= end) && n < MAX_EDGES - 1)
+    {
+        if (steps[i].freq_hz != freq)
+            out[n++] = (edge_t){t, steps[i].freq_hz};
+        freq = steps[i].freq_hz;
+        t += (uint64_t)steps[i].ms * 1000;
+        if (++i == count)
+        {
+            i = 0;
+            if (repeat && ++loops >= repeat)
+                break;
+        }
+    }
+    // Mudo no buzzer_stop no meio de um tom ou no fim das repetições
+    if (freq && (sc->stop_ms || t < end))
+        out[n++] = (edge_t){MIN(t, end), 0};
+    return n;
+}
+
+// Tira as mudanças entre from e to (inclusive)
+static uint drop_between(edge_t *edges, uint n, uint64_t from, uint64_t to)
+{
+    uint kept = 0;
+    for (uint i = 0; i < n; i++)
+    {
+        if (edges[i].t_us < from || edges[i].t_us > to)
+            edges[kept++] = edges[i];
+    }
+    return kept;
+}
+
+// Laço principal com voltas de 1 a 400 ms, como o do firmware com leituras
+// lentas e redesenhos, até o instante until_ms do cenário
+static void run_loop_until(uint32_t until_ms, uint32_t *rng)
+{
+    while (sim_now_us() - heard.t0 < (uint64_t)until_ms * 1000)
+    {
+        *rng = *rng * 1664525u + 1013904223u;
+        uint64_t left = (uint64_t)until_ms * 1000 - (sim_now_us() - heard.t0);
+        sleep_us(MIN(left, 1000 + (*rng >> 8) % 400000));
+    }
+}
+
+static bool run(const scenario_t *sc)
+{
+    uint32_t rng = 12345;
+    if (sc->before != BUZZER_SILENT)
+    {
+        buzzer_play(sc->before);
+        sleep_ms(600); // No meio de um tom do padrão anterior
+    }
+    heard.count = 0;
+    heard.t0 = sim_now_us();
+    buzzer_play(sc->pattern);
+
+    if (sc->stall_ms)
+    {
+        run_loop_until(sc->stall_at_ms, &rng);
+        sim_spend_us((uint64_t)sc->stall_ms * 1000);
+    }
+    if (sc->stop_ms)
+    {
+        run_loop_until(sc->stop_ms, &rng);
+        buzzer_stop();
+    }
+    run_loop_until(sc->run_ms, &rng);
+
+    edge_t want[MAX_EDGES];
+    uint n = expected_edges(sc, want);
+    if (sc->stall_ms)
+    {
+        // As mudanças presas no trecho sem interrupções saem juntas no fim dele;
+        // depois disso o padrão tem de estar de volta ao ritmo original
+        uint64_t from = (uint64_t)sc->stall_at_ms * 1000, to = from + (uint64_t)sc->stall_ms * 1000;
+        n = drop_between(want, n, from, to);
+        heard.count = drop_between(heard.edges, heard.count, from, to + TOLERANCE_US);
+    }
+
+    bool ok = true;
+    int64_t worst = 0;
+    uint h = 0;
+    for (uint i = 0; i < n; i++, h++)
+    {
+        if (h >= heard.count)
+        {
+            fprintf(stderr, "%s: faltou a mudança para %u Hz em %.1f ms\n", sc->name, want[i].freq_hz,
+                    want[i].t_us / 1e3);
+            return false;
+        }
+        const edge_t *e = &heard.edges[h];
+        int64_t dt = (int64_t)e->t_us - (int64_t)want[i].t_us;
+        worst = MAX(worst, llabs(dt));
+        bool freq_ok = want[i].freq_hz ? abs((int)e->freq_hz - (int)want[i].freq_hz) * 100 <= (int)want[i].freq_hz
+                                       : e->freq_hz == 0;
+        if (llabs(dt) > TOLERANCE_US || !freq_ok)
+        {
+            fprintf(stderr, "%s: esperava %u Hz em %.1f ms, veio %lu Hz em %.1f ms\n", sc->name, want[i].freq_hz,
+                    want[i].t_us / 1e3, (unsigned long)e->freq_hz, e->t_us / 1e3);
+            ok = false;
+        }
+    }
+    if (h < heard.count)
+    {
+        fprintf(stderr, "%s: %u mudanças a mais, a primeira para %lu Hz em %.1f ms\n", sc->name, heard.count - h,
+                (unsigned long)heard.edges[h].freq_hz, heard.edges[h].t_us / 1e3);
+        ok = false;
+    }
+    bool endless = !EXPECTED[sc->pattern].repeat && !sc->stop_ms;
+    if (buzzer_playing() != endless)
+    {
+        fprintf(stderr, "%s: buzzer_playing() = %d no fim\n", sc->name, buzzer_playing());
+        ok = false;
+    }
+    buzzer_stop();
+    printf("%s: %u mudanças, maior desvio %.3f ms\n", sc->name, n, worst / 1e3);
+    return ok;
+}
+
+int main(void)
+{
+    sim_time_init();
+    sim_opts.speed = 0;
+    buzzer_init(BUZZER_PIN);
+    sim_buzzer_watch(on_buzzer);
+
+    uint failures = 0;
+    for (uint i = 0; i < count_of(SCENARIOS); i++)
+        failures += !run(&SCENARIOS[i]);
+    printf("%s\n", failures ? "FALHAS" : "todos os padrões no ritmo da tabela");
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,16 @@
+#ifndef SIM_HARDWARE_FLASH_H
+#define SIM_HARDWARE_FLASH_H
+
+#include "pico/stdlib.h"
+
+// Flash de 2 MB em memória (ou num arquivo, com --flash), com a semântica de
+// NOR: apagar deixa 0xFF e programar só baixa bits
+#define FLASH_PAGE_SIZE (1u << 8)
+#define FLASH_SECTOR_SIZE (1u << 12)
+#define FLASH_BLOCK_SIZE (1u << 16)
+#define PICO_FLASH_SIZE_BYTES (2u * 1024 * 1024)
+
+void flash_range_erase(uint32_t flash_offs, size_t count);
+void flash_range_program(uint32_t flash_offs, const uint8_t *data, size_t count);
+
+#endif // SIM_HARDWARE_FLASH_H
@@ -0,0 +1,22 @@
+#ifndef SIM_HARDWARE_I2C_H
+#define SIM_HARDWARE_I2C_H
+
+#include "pico/stdlib.h"
+
+// Os dois barramentos levam aos modelos de dispositivo de sim/sim_i2c.c.
+// Como no SDK, um endereço sem dispositivo devolve PICO_ERROR_GENERIC.
+typedef struct i2c_inst
+{
+    uint index;
+    uint baudrate; // Define o tempo gasto em cada transação
+} i2c_inst_t;
+
+extern i2c_inst_t sim_i2c_inst[2];
+#define i2c0 (&sim_i2c_inst[0])
+#define i2c1 (&sim_i2c_inst[1])
+
+uint i2c_init(i2c_inst_t *i2c, uint baudrate);
+int i2c_write_blocking(i2c_inst_t *i2c, uint8_t addr, const uint8_t *src, size_t len, bool nostop);
+int i2c_read_blocking(i2c_inst_t *i2c, uint8_t addr, uint8_t *dst, size_t len, bool nostop);
+
+#endif // SIM_HARDWARE_I2C_H
@@ -0,0 +1,29 @@
+#ifndef SIM_HARDWARE_PIO_H
+#define SIM_HARDWARE_PIO_H
+
+#include "pico/stdlib.h"
+
+// Só o FIFO de transmissão existe: o DMA escreve nele e o simulador decodifica
+// as palavras como os bits GRB da matriz WS2812
+typedef struct
+{
+    volatile uint32_t txf[4];
+} pio_hw_t;
+typedef pio_hw_t *PIO;
+
+typedef struct pio_program
+{
+    const uint16_t *instructions;
+    uint8_t length;
+    int8_t origin;
+} pio_program_t;
+
+extern pio_hw_t sim_pio_hw[2];
+#define pio0 (&sim_pio_hw[0])
+#define pio1 (&sim_pio_hw[1])
+
+uint pio_add_program(PIO pio, const pio_program_t *program);
+int pio_claim_unused_sm(PIO pio, bool required);
+uint pio_get_dreq(PIO pio, uint sm, bool is_tx);
+
+#endif // SIM_HARDWARE_PIO_H
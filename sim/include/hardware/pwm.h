@@ -0,0 +1,13 @@
+#ifndef SIM_HARDWARE_PWM_H
+#define SIM_HARDWARE_PWM_H
+
+#include "pico/stdlib.h"
+
+// O simulador só registra o estado do buzzer (frequência e se está soando)
+uint pwm_gpio_to_slice_num(uint gpio);
+void pwm_set_clkdiv_int_frac(uint slice_num, uint8_t integer, uint8_t fract);
+void pwm_set_wrap(uint slice_num, uint16_t wrap);
+void pwm_set_gpio_level(uint gpio, uint16_t level);
+void pwm_set_enabled(uint slice_num, bool enabled);
+
+#endif // SIM_HARDWARE_PWM_H
@@ -0,0 +1,10 @@
+#ifndef SIM_HARDWARE_REGS_ADDRESSMAP_H
+#define SIM_HARDWARE_REGS_ADDRESSMAP_H
+
+#include <stdint.h>
+
+// Leituras diretas da flash (XIP_BASE + deslocamento) caem na cópia em memória
+extern uint8_t *sim_flash;
+#define XIP_BASE ((uintptr_t)sim_flash)
+
+#endif // SIM_HARDWARE_REGS_ADDRESSMAP_H
@@ -0,0 +1,14 @@
+#ifndef SIM_HARDWARE_WATCHDOG_H
+#define SIM_HARDWARE_WATCHDOG_H
+
+#include "pico/stdlib.h"
+
+// Watchdog sobre o relógio virtual: sem watchdog_update até o prazo, a placa
+// reinicia (sim_reboot, em sim_board.c), com a RAM de __uninitialized_ram
+// preservada como na placa
+void watchdog_enable(uint32_t delay_ms, bool pause_on_debug);
+void watchdog_update(void);
+bool watchdog_caused_reboot(void);
+bool watchdog_enable_caused_reboot(void);
+
+#endif // SIM_HARDWARE_WATCHDOG_H
@@ -0,0 +1,30 @@
+#ifndef SIM_LWIP_IP_ADDR_H
+#define SIM_LWIP_IP_ADDR_H
+
+#include <arpa/inet.h>
+
+#include "lwip/err.h"
+
+// Endereços IPv4 em ordem de rede, como no lwIP
+typedef struct ip4_addr
+{
+    u32_t addr;
+} ip4_addr_t;
+typedef ip4_addr_t ip_addr_t;
+
+#define IP4_ADDR(ipaddr, a, b, c, d)                                                                       \
+    ((ipaddr)->addr = htonl(((u32_t)((a) & 0xff) << 24) | ((u32_t)((b) & 0xff) << 16) |                     \
+                            ((u32_t)((c) & 0xff) << 8) | (u32_t)((d) & 0xff)))
+#define IP_ADDR4(ipaddr, a, b, c, d) IP4_ADDR(ipaddr, a, b, c, d)
+#define ip4_addr_isany_val(ipaddr) ((ipaddr).addr == 0)
+
+extern const ip_addr_t ip_addr_any;
+#define IP_ADDR_ANY (&ip_addr_any)
+#define IP4_ADDR_ANY (&ip_addr_any)
+
+char *ip4addr_ntoa(const ip4_addr_t *addr);
+#define ipaddr_ntoa(addr) ip4addr_ntoa(addr)
+int ip4addr_aton(const char *cp, ip4_addr_t *addr);
+#define ipaddr_aton(cp, addr) ip4addr_aton(cp, addr)
+
+#endif // SIM_LWIP_IP_ADDR_H
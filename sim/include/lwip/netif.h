@@ -0,0 +1,31 @@
+#ifndef SIM_LWIP_NETIF_H
+#define SIM_LWIP_NETIF_H
+
+#include "lwip/ip_addr.h"
+
+struct netif;
+typedef void (*netif_status_callback_fn)(struct netif *netif);
+
+struct netif
+{
+    ip4_addr_t ip_addr;
+    ip4_addr_t netmask;
+    ip4_addr_t gw;
+    u8_t flags;
+    netif_status_callback_fn status_callback;
+    netif_status_callback_fn link_callback;
+};
+
+#define NETIF_FLAG_UP 0x01U
+#define NETIF_FLAG_LINK_UP 0x04U
+
+extern struct netif *netif_default;
+
+#define netif_ip4_addr(netif) ((const ip4_addr_t *)&((netif)->ip_addr))
+#define netif_is_up(netif) (((netif)->flags & NETIF_FLAG_UP) != 0)
+#define netif_is_link_up(netif) (((netif)->flags & NETIF_FLAG_LINK_UP) != 0)
+
+void netif_set_status_callback(struct netif *netif, netif_status_callback_fn status_callback);
+void netif_set_link_callback(struct netif *netif, netif_status_callback_fn link_callback);
+
+#endif // SIM_LWIP_NETIF_H
@@ -0,0 +1,38 @@
+#ifndef SIM_LWIP_PBUF_H
+#define SIM_LWIP_PBUF_H
+
+#include "lwip/err.h"
+
+// Sempre um segmento só, com um '\0' depois do fim (não faz parte de len)
+struct pbuf
+{
+    struct pbuf *next;
+    void *payload;
+    u16_t tot_len;
+    u16_t len;
+    u8_t type_internal; // pbuf_type, para devolver ao heap ou ao pool do lwIP
+    u16_t alloc_len;    // Tamanho pedido em pbuf_alloc
+};
+
+typedef enum
+{
+    PBUF_TRANSPORT,
+    PBUF_IP,
+    PBUF_LINK,
+    PBUF_RAW,
+} pbuf_layer;
+
+typedef enum
+{
+    PBUF_RAM,
+    PBUF_ROM,
+    PBUF_REF,
+    PBUF_POOL,
+} pbuf_type;
+
+struct pbuf *pbuf_alloc(pbuf_layer layer, u16_t length, pbuf_type type);
+u8_t pbuf_free(struct pbuf *p);
+err_t pbuf_take(struct pbuf *buf, const void *dataptr, u16_t len);
+u16_t pbuf_copy_partial(const struct pbuf *p, void *dataptr, u16_t len, u16_t offset);
+
+#endif // SIM_LWIP_PBUF_H
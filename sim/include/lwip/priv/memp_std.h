@@ -0,0 +1,9 @@
+// Pools do lwIP que o simulador modela (a placa tem outros, de segmentos,
+// ARP, DNS e timers), no formato X-macro do lwip/priv/memp_std.h original:
+// quem inclui define LWIP_MEMPOOL(name, num, size, desc).
+LWIP_MEMPOOL(UDP_PCB, MEMP_NUM_UDP_PCB, 0, "UDP_PCB")
+LWIP_MEMPOOL(TCP_PCB, MEMP_NUM_TCP_PCB, 0, "TCP_PCB")
+LWIP_MEMPOOL(TCP_PCB_LISTEN, MEMP_NUM_TCP_PCB_LISTEN, 0, "TCP_PCB_LISTEN")
+LWIP_MEMPOOL(PBUF_POOL, PBUF_POOL_SIZE, 0, "PBUF_POOL")
+
+#undef LWIP_MEMPOOL
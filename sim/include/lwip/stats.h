@@ -0,0 +1,43 @@
+#ifndef SIM_LWIP_STATS_H
+#define SIM_LWIP_STATS_H
+
+#include "lwip/err.h"
+
+// Contadores do heap e dos pools do lwIP, mantidos por sim/sim_net.c com os
+// limites da placa: as alocações além deles falham e contam em err, como no lwIP
+#define LWIP_STATS 1
+#define MEM_STATS 1
+#define MEMP_STATS 1
+
+// Do lwipopts.h do firmware e, os que ele não define, dos padrões do lwip/opt.h
+#define MEM_SIZE 16000
+#define PBUF_POOL_SIZE 32
+#define MEMP_NUM_UDP_PCB 4
+#define MEMP_NUM_TCP_PCB 5
+#define MEMP_NUM_TCP_PCB_LISTEN 8
+
+typedef enum
+{
+#define LWIP_MEMPOOL(name, num, size, desc) MEMP_##name,
+#include "lwip/priv/memp_std.h"
+    MEMP_MAX
+} memp_t;
+
+struct stats_mem
+{
+    u16_t err;
+    u16_t avail;
+    u16_t used;
+    u16_t max;
+    u16_t illegal;
+};
+
+struct stats_
+{
+    struct stats_mem mem;
+    struct stats_mem *memp[MEMP_MAX];
+};
+
+extern struct stats_ lwip_stats;
+
+#endif // SIM_LWIP_STATS_H
@@ -0,0 +1,24 @@
+#ifndef SIM_LWIP_UDP_H
+#define SIM_LWIP_UDP_H
+
+#include "lwip/ip_addr.h"
+#include "lwip/pbuf.h"
+
+struct udp_pcb;
+
+typedef void (*udp_recv_fn)(void *arg, struct udp_pcb *pcb, struct pbuf *p, const ip_addr_t *addr, u16_t port);
+
+#define SOF_BROADCAST 0x20U
+
+struct udp_pcb *udp_new(void);
+void udp_remove(struct udp_pcb *pcb);
+err_t udp_bind(struct udp_pcb *pcb, const ip_addr_t *ipaddr, u16_t port);
+void udp_recv(struct udp_pcb *pcb, udp_recv_fn recv, void *recv_arg);
+err_t udp_sendto(struct udp_pcb *pcb, struct pbuf *p, const ip_addr_t *dst_ip, u16_t dst_port);
+void udp_set_multicast_ttl(struct udp_pcb *pcb, u8_t ttl);
+
+// ip_set_option recebe o pcb de qualquer protocolo no lwIP; aqui só há o UDP
+void sim_udp_set_option(struct udp_pcb *pcb, u8_t opt);
+#define ip_set_option(pcb, opt) sim_udp_set_option(pcb, opt)
+
+#endif // SIM_LWIP_UDP_H
@@ -0,0 +1,10 @@
+#ifndef SIM_MALLOC_H
+#define SIM_MALLOC_H
+
+#include_next <malloc.h>
+
+// A newlib da placa só tem mallinfo; na glibc ela está obsoleta e trunca em
+// int, então o firmware usa mallinfo2 sem saber (inclusive o nome da struct)
+#define mallinfo mallinfo2
+
+#endif // SIM_MALLOC_H
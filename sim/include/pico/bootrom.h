@@ -0,0 +1,9 @@
+#ifndef SIM_PICO_BOOTROM_H
+#define SIM_PICO_BOOTROM_H
+
+#include "pico/stdlib.h"
+
+// No simulador, entrar no modo BOOTSEL encerra o processo
+void reset_usb_boot(uint32_t gpio_activity_pin_mask, uint32_t disable_interface_mask);
+
+#endif // SIM_PICO_BOOTROM_H
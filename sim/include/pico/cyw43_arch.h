@@ -0,0 +1,48 @@
+#ifndef SIM_PICO_CYW43_ARCH_H
+#define SIM_PICO_CYW43_ARCH_H
+
+#include "pico/stdlib.h"
+#include "lwip/netif.h"
+
+// Rádio simulado: a associação termina depois de um atraso fixo e o endereço é
+// o de loopback. Quedas e voltas do enlace vêm do roteiro de ambiente.
+#define CYW43_ITF_STA 0
+#define CYW43_ITF_AP 1
+
+#define CYW43_LINK_DOWN 0
+#define CYW43_LINK_JOIN 1
+#define CYW43_LINK_NOIP 2
+#define CYW43_LINK_UP 3
+#define CYW43_LINK_FAIL -1
+#define CYW43_LINK_NONET -2
+#define CYW43_LINK_BADAUTH -3
+
+#define CYW43_AUTH_OPEN 0
+#define CYW43_AUTH_WPA2_AES_PSK 0x00400004
+
+#define CYW43_DEFAULT_PM 0xa11142
+#define CYW43_AGGRESSIVE_PM 0xa11c82
+#define CYW43_PERFORMANCE_PM 0x111022
+#define CYW43_NO_POWERSAVE_MODE 0xa11140
+
+typedef struct
+{
+    struct netif netif[2];
+} cyw43_t;
+
+extern cyw43_t cyw43_state;
+
+int cyw43_arch_init(void);
+void cyw43_arch_deinit(void);
+void cyw43_arch_enable_sta_mode(void);
+int cyw43_arch_wifi_connect_async(const char *ssid, const char *pw, uint32_t auth);
+void cyw43_arch_poll(void);
+// Sem preempção, as seções críticas do lwIP não precisam travar nada
+static inline void cyw43_arch_lwip_begin(void) {}
+static inline void cyw43_arch_lwip_end(void) {}
+
+int cyw43_tcpip_link_status(cyw43_t *self, int itf);
+int cyw43_wifi_pm(cyw43_t *self, uint32_t pm);
+int cyw43_wifi_leave(cyw43_t *self, int itf);
+
+#endif // SIM_PICO_CYW43_ARCH_H
@@ -0,0 +1,14 @@
+#ifndef SIM_PICO_FLASH_H
+#define SIM_PICO_FLASH_H
+
+#include "pico/stdlib.h"
+
+// Sem o outro núcleo nem XIP de verdade, a função roda direto
+static inline int flash_safe_execute(void (*func)(void *), void *param, uint32_t enter_exit_timeout_ms)
+{
+    (void)enter_exit_timeout_ms;
+    func(param);
+    return PICO_OK;
+}
+
+#endif // SIM_PICO_FLASH_H
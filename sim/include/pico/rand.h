@@ -0,0 +1,8 @@
+#ifndef SIM_PICO_RAND_H
+#define SIM_PICO_RAND_H
+
+#include "pico/stdlib.h"
+
+uint32_t get_rand_32(void);
+
+#endif // SIM_PICO_RAND_H
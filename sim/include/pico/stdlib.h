@@ -0,0 +1,117 @@
+#ifndef SIM_PICO_STDLIB_H
+#define SIM_PICO_STDLIB_H
+
+// Subconjunto do Pico SDK usado pelo firmware, implementado sobre o relógio
+// virtual do simulador (sim/sim_time.c). Alarmes, timers e callbacks de
+// GPIO e de rede rodam na mesma thread, nos pontos em que o firmware dorme
+// ou chama cyw43_arch_poll, como interrupções que chegam nesses instantes.
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+typedef unsigned int uint;
+typedef uint64_t absolute_time_t;
+
+#define _u(x) x##u
+#define count_of(a) (sizeof(a) / sizeof((a)[0]))
+#ifndef MIN
+#define MIN(a, b) ((a) < (b) ? (a) : (b))
+#endif
+#ifndef MAX
+#define MAX(a, b) ((a) > (b) ? (a) : (b))
+#endif
+
+#define PICO_OK 0
+#define PICO_ERROR_GENERIC -1
+#define PICO_ERROR_TIMEOUT -2
+
+#define __not_in_flash_func(f) f
+#define __no_inline_not_in_flash_func(f) f
+// RAM que o reset não zera: a seção vai para o processo novo no reboot pelo watchdog
+#define __uninitialized_ram(group) __attribute__((section("sim_noinit"))) group
+
+// Tempo
+uint64_t time_us_64(void);
+uint32_t time_us_32(void);
+static inline absolute_time_t get_absolute_time(void) { return time_us_64(); }
+static inline uint64_t to_us_since_boot(absolute_time_t t) { return t; }
+static inline uint32_t to_ms_since_boot(absolute_time_t t) { return (uint32_t)(t / 1000); }
+static inline absolute_time_t from_us_since_boot(uint64_t us) { return us; }
+static inline absolute_time_t make_timeout_time_us(uint64_t us) { return time_us_64() + us; }
+static inline absolute_time_t make_timeout_time_ms(uint32_t ms) { return time_us_64() + (uint64_t)ms * 1000; }
+static inline absolute_time_t delayed_by_us(absolute_time_t t, uint64_t us) { return t + us; }
+static inline absolute_time_t delayed_by_ms(absolute_time_t t, uint32_t ms) { return t + (uint64_t)ms * 1000; }
+static inline int64_t absolute_time_diff_us(absolute_time_t from, absolute_time_t to) { return (int64_t)(to - from); }
+
+void sleep_until(absolute_time_t t);
+void sleep_us(uint64_t us);
+void sleep_ms(uint32_t ms);
+// Volta no instante pedido (true) ou antes, quando algum callback rodou (false)
+bool best_effort_wfe_or_timeout(absolute_time_t t);
+static inline void tight_loop_contents(void) {}
+
+// Alarmes e timers repetitivos
+typedef int32_t alarm_id_t;
+typedef int64_t (*alarm_callback_t)(alarm_id_t id, void *user_data);
+alarm_id_t add_alarm_at(absolute_time_t t, alarm_callback_t callback, void *user_data, bool fire_if_past);
+alarm_id_t add_alarm_in_us(uint64_t us, alarm_callback_t callback, void *user_data, bool fire_if_past);
+alarm_id_t add_alarm_in_ms(uint32_t ms, alarm_callback_t callback, void *user_data, bool fire_if_past);
+bool cancel_alarm(alarm_id_t id);
+
+typedef struct repeating_timer repeating_timer_t;
+typedef bool (*repeating_timer_callback_t)(repeating_timer_t *rt);
+struct repeating_timer
+{
+    int64_t delay_us;
+    alarm_id_t alarm_id;
+    repeating_timer_callback_t callback;
+    void *user_data;
+};
+bool add_repeating_timer_us(int64_t delay_us, repeating_timer_callback_t callback, void *user_data, repeating_timer_t *out);
+static inline bool add_repeating_timer_ms(int32_t delay_ms, repeating_timer_callback_t callback, void *user_data,
+                                          repeating_timer_t *out)
+{
+    return add_repeating_timer_us((int64_t)delay_ms * 1000, callback, user_data, out);
+}
+bool cancel_repeating_timer(repeating_timer_t *timer);
+
+// Interrupções: só contam o aninhamento (não há preempção no simulador)
+uint32_t save_and_disable_interrupts(void);
+void restore_interrupts(uint32_t status);
+
+// GPIO
+#define GPIO_IN false
+#define GPIO_OUT true
+enum gpio_function
+{
+    GPIO_FUNC_SPI = 1,
+    GPIO_FUNC_UART = 2,
+    GPIO_FUNC_I2C = 3,
+    GPIO_FUNC_PWM = 4,
+    GPIO_FUNC_SIO = 5,
+    GPIO_FUNC_PIO0 = 6,
+    GPIO_FUNC_PIO1 = 7,
+};
+enum gpio_irq_level
+{
+    GPIO_IRQ_LEVEL_LOW = 1,
+    GPIO_IRQ_LEVEL_HIGH = 2,
+    GPIO_IRQ_EDGE_FALL = 4,
+    GPIO_IRQ_EDGE_RISE = 8,
+};
+typedef void (*gpio_irq_callback_t)(uint gpio, uint32_t event_mask);
+void gpio_init(uint gpio);
+void gpio_set_dir(uint gpio, bool out);
+void gpio_put(uint gpio, bool value);
+bool gpio_get(uint gpio);
+void gpio_pull_up(uint gpio);
+void gpio_set_function(uint gpio, enum gpio_function fn);
+void gpio_set_irq_enabled(uint gpio, uint32_t events, bool enabled);
+void gpio_set_irq_enabled_with_callback(uint gpio, uint32_t events, bool enabled, gpio_irq_callback_t callback);
+
+// stdio: a saída padrão do processo; a "USB" está sempre conectada
+bool stdio_init_all(void);
+
+#endif // SIM_PICO_STDLIB_H
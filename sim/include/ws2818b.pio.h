@@ -0,0 +1,19 @@
+#ifndef SIM_WS2818B_PIO_H
+#define SIM_WS2818B_PIO_H
+
+// Substitui o cabeçalho gerado pelo pioasm a partir de ws2818b.pio
+
+#include "hardware/pio.h"
+
+static const pio_program_t ws2818b_program = {
+    .instructions = NULL,
+    .length = 4,
+    .origin = -1,
+};
+
+static inline void ws2818b_program_init(PIO pio, uint sm, uint offset, uint pin, float freq)
+{
+    (void)pio, (void)sm, (void)offset, (void)pin, (void)freq;
+}
+
+#endif // SIM_WS2818B_PIO_H
@@ -0,0 +1,98 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "sim.h"
+#include "pico/cyw43_arch.h"
+#include "mqtt.h"
+
+// Cliente MQTT do firmware (lib/mqtt.c) para o teste com broker em
+// tools/mqtt_broker_test.py, ou para um mosquitto local: leituras de cinco
+// canais a rate_hz por duração segundos virtuais, com valores que o broker
+// recalcula a partir do canal e do ts, e o mqtt_task a cada volta do laço,
+// como no main.c. Depois das leituras, continua até a fila esvaziar.
+//
+//   mqtt_sender porta [rate_hz] [segundos] [velocidade]
+//
+// Ao sair, imprime uma linha JSON com as estatísticas do cliente.
+
+#define DEVICE_ID 0x4D4F4E31
+#define CHANNELS 5
+#define LOOP_MS 250     // Volta do laço principal do firmware
+#define DRAIN_MAX_MS 60000
+
+static char last_settings[64];
+
+static void on_settings(const char *query)
+{
+    strncpy(last_settings, query, sizeof(last_settings) - 1);
+}
+
+// O mesmo cálculo está no broker do teste
+static float sample_value(uint channel, uint32_t ts)
+{
+    return (float)(channel * 100) + (float)(ts % 100000) / 1000.0f;
+}
+
+static uint32_t now_ms(uint64_t start_us)
+{
+    return (uint32_t)((sim_now_us() - start_us) / 1000);
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 2)
+    {
+        fprintf(stderr, "uso: %s porta [rate_hz] [segundos] [velocidade]\n", argv[0]);
+        return 2;
+    }
+    uint16_t port = (uint16_t)atoi(argv[1]);
+    double rate_hz = argc > 2 ? atof(argv[2]) : 1.0;
+    double seconds = argc > 3 ? atof(argv[3]) : 10.0;
+    sim_opts.speed = argc > 4 ? atof(argv[4]) : 1.0;
+    sim_time_init();
+
+    cyw43_arch_enable_sta_mode();
+    cyw43_arch_wifi_connect_async("sim", "sim", CYW43_AUTH_WPA2_AES_PSK);
+    while (cyw43_tcpip_link_status(&cyw43_state, CYW43_ITF_STA) != CYW43_LINK_UP)
+        sleep_ms(10);
+    mqtt_init(DEVICE_ID, on_settings);
+    mqtt_set_broker(0x7F000001, port);
+
+    // Leituras na agenda do relógio virtual, a partir de ts 0
+    uint64_t interval_us = (uint64_t)(1e6 / rate_hz);
+    uint64_t start_us = sim_now_us(), next_tick_us = start_us;
+    uint64_t readings = (uint64_t)(seconds * rate_hz);
+    for (uint64_t r = 0; r < readings; r++)
+    {
+        uint64_t at_us = start_us + r * interval_us;
+        for (; next_tick_us <= at_us; next_tick_us += LOOP_MS * 1000)
+        {
+            sleep_until(next_tick_us);
+            mqtt_task(now_ms(start_us));
+        }
+        sleep_until(at_us);
+        uint32_t ts = (uint32_t)(r * interval_us / 1000);
+        for (uint c = 0; c < CHANNELS; c++)
+            mqtt_add_sample((uint8_t)c, ts, sample_value(c, ts));
+    }
+
+    // Esvazia a fila, com o lote incompleto saindo pelo tempo
+    mqtt_stats_t st;
+    uint64_t drain_end_us = sim_now_us() + (uint64_t)DRAIN_MAX_MS * 1000;
+    do
+    {
+        sleep_until(next_tick_us);
+        next_tick_us += LOOP_MS * 1000;
+        mqtt_task(now_ms(start_us));
+        mqtt_get_stats(&st);
+    } while (st.queued && sim_now_us() < drain_end_us);
+
+    printf("{\"device\":%lu,\"channels\":%u,\"readings\":%llu,\"elapsed_ms\":%lu,\"connects\":%lu,\"disconnects\":%lu,"
+           "\"publishes\":%lu,\"samples_acked\":%lu,\"samples_dropped\":%lu,\"queued\":%lu,\"last_connect_ms\":%lu,"
+           "\"settings_applied\":%lu,\"settings\":\"%s\"}\n",
+           (unsigned long)DEVICE_ID, CHANNELS, (unsigned long long)readings, (unsigned long)now_ms(start_us),
+           (unsigned long)st.connects, (unsigned long)st.disconnects, (unsigned long)st.publishes,
+           (unsigned long)st.samples_acked, (unsigned long)st.samples_dropped, (unsigned long)st.queued,
+           (unsigned long)st.last_connect_ms, (unsigned long)st.settings_applied, last_settings);
+    return st.queued ? 1 : 0;
+}
@@ -0,0 +1,169 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "sim.h"
+#include "ssd1306.h"
+
+// Driver do SSD1306 (lib/ssd1306.c) contra o modelo do controlador
+// (sim_ssd1306.c): depois de cada envio, a RAM de vídeo que o modelo montou a
+// partir do fluxo I2C tem de ser igual, byte a byte, ao quadro do driver. As
+// cenas imitam o uso do firmware (números mudando na tela de status, gráfico
+// de tendência rolando, quadros sem mudança, desligar e religar o painel) e
+// desenhos aleatórios em qualquer posição. Para cada cena, imprime os bytes
+// por quadro no barramento contra o quadro inteiro.
+//
+//   oled_test    (status 1 se algum quadro divergir)
+
+#define FRAMES 400
+
+static ssd1306_t ssd;
+static uint32_t rng = 12345;
+static uint mismatches;
+
+static uint32_t next_rand(void)
+{
+    rng = rng * 1664525u + 1013904223u;
+    return rng >> 8;
+}
+
+// Envia o quadro e compara com a RAM do controlador
+static void send_and_check(const char *scene, uint frame)
+{
+    ssd1306_send_data(&ssd);
+    for (uint x = 0; x < ssd.width; x++)
+    {
+        for (uint p = 0; p < ssd.pages; p++)
+        {
+            uint8_t expected = ssd.ram_buffer[x * ssd.pages + p + 1];
+            if (sim_ssd1306_ram(p, x) == expected)
+                continue;
+            if (mismatches++ < 5)
+                fprintf(stderr, "%s, quadro %u: coluna %u, página %u: tela 0x%02X, driver 0x%02X\n", scene, frame, x,
+                        p, sim_ssd1306_ram(p, x), expected);
+        }
+    }
+}
+
+// Tela de status: quatro linhas de texto com as leituras mudando aos poucos
+static void draw_status(uint frame)
+{
+    static float temp = 24.0f, hum = 55.0f;
+    char line[24];
+    if (next_rand() % 4 == 0)
+        temp += (float)((int)(next_rand() % 5) - 2) * 0.01f;
+    if (next_rand() % 8 == 0)
+        hum += (float)((int)(next_rand() % 3) - 1) * 0.1f;
+    ssd1306_fill(&ssd, false);
+    ssd1306_rect(&ssd, 0, 0, 128, 64, true, false);
+    ssd1306_draw_string(&ssd, "192.168.0.42", 4, 4);
+    snprintf(line, sizeof(line), "T %.2f C", temp);
+    ssd1306_draw_string(&ssd, line, 4, 20);
+    snprintf(line, sizeof(line), "U %.1f %%", hum);
+    ssd1306_draw_string(&ssd, line, 4, 36);
+    ssd1306_draw_string(&ssd, (frame / 20) % 2 ? "ALARME" : "OK    ", 4, 52);
+}
+
+// Tela de tendência: o gráfico das páginas 2 a 7 rola uma coluna por quadro
+static void draw_trend(uint frame)
+{
+    static uint level = 40;
+    char line[24];
+    snprintf(line, sizeof(line), "T %u", 20 + level / 4);
+    ssd1306_draw_string(&ssd, line, 0, 0);
+    ssd1306_shift_left(&ssd, 2, 7);
+    level = (level + next_rand() % 3 + 47) % 48;
+    ssd1306_vline(&ssd, 127, (uint8_t)(63 - level), 63, true);
+}
+
+// Primitivas em posições e tamanhos quaisquer, inclusive cortadas nas bordas
+static void draw_random(uint frame)
+{
+    uint n = next_rand() % 4;
+    for (uint i = 0; i < n; i++)
+    {
+        uint8_t x = next_rand() % 140, y = next_rand() % 72;
+        bool on = next_rand() % 3 != 0;
+        switch (next_rand() % 6)
+        {
+        case 0:
+            ssd1306_pixel(&ssd, x, y, on);
+            break;
+        case 1:
+            ssd1306_rect(&ssd, y, x, next_rand() % 40 + 1, next_rand() % 30 + 1, on, next_rand() % 2);
+            break;
+        case 2:
+            ssd1306_line(&ssd, x, y, next_rand() % 128, next_rand() % 64, on);
+            break;
+        case 3:
+            ssd1306_draw_char(&ssd, (char)(' ' + next_rand() % 95), x, y);
+            break;
+        case 4:
+            ssd1306_hline(&ssd, x, (uint8_t)(x + next_rand() % 60), y, on);
+            break;
+        default:
+            ssd1306_vline(&ssd, x, y, (uint8_t)(y + next_rand() % 30), on);
+            break;
+        }
+    }
+}
+
+// Painel desligado e religado no meio: a RAM do controlador se mantém e o
+// driver não reenvia nada
+static void draw_power(uint frame)
+{
+    if (frame % 50 == 10)
+        ssd1306_set_power(&ssd, false);
+    else if (frame % 50 == 30)
+        ssd1306_set_power(&ssd, true);
+    if (frame % 50 == 40)
+        ssd1306_invalidate(&ssd);
+    draw_status(frame);
+}
+
+static const struct
+{
+    const char *name;
+    void (*draw)(uint frame);
+} SCENES[] = {
+    {"status", draw_status},
+    {"tendência", draw_trend},
+    {"aleatória", draw_random},
+    {"energia", draw_power},
+};
+
+int main(void)
+{
+    sim_time_init();
+    sim_opts.speed = 0;
+    sim_i2c_init();
+    i2c_init(i2c1, 400 * 1000);
+    ssd1306_init(&ssd, WIDTH, HEIGHT, false, 0x3C, i2c1);
+    ssd1306_config(&ssd);
+
+    // Quadro inteiro: a referência do envio sem janelas
+    ssd1306_fill(&ssd, false);
+    send_and_check("inicial", 0);
+    uint32_t full_bytes = ssd.last_frame_bytes;
+
+    for (uint s = 0; s < count_of(SCENES); s++)
+    {
+        uint32_t bytes_before = ssd.total_bytes, sent_before = ssd.frames_sent;
+        uint32_t skipped_before = ssd.frames_skipped;
+        uint64_t bus_before = sim_now_us();
+        for (uint f = 0; f < FRAMES; f++)
+        {
+            SCENES[s].draw(f);
+            send_and_check(SCENES[s].name, f);
+        }
+        uint32_t bytes = ssd.total_bytes - bytes_before;
+        printf("%s: %u quadros, %lu enviados, %lu sem mudança: %.1f bytes/quadro (%.1f%% do quadro inteiro de %lu), "
+               "%.2f ms de barramento/quadro\n",
+               SCENES[s].name, FRAMES, (unsigned long)(ssd.frames_sent - sent_before),
+               (unsigned long)(ssd.frames_skipped - skipped_before), (double)bytes / FRAMES,
+               100.0 * bytes / FRAMES / full_bytes, (unsigned long)full_bytes,
+               (sim_now_us() - bus_before) / 1e3 / FRAMES);
+    }
+
+    printf("%s\n", mismatches ? "FALHAS: a tela divergiu do driver" : "tela idêntica ao driver em todos os quadros");
+    return mismatches ? 1 : 0;
+}
@@ -0,0 +1,136 @@
+#include <setjmp.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "sim.h"
+#include "flash_io.h"
+#include "settings.h"
+#include "settings_store.h"
+
+// Queda de energia em cada passo de uma gravação das configurações
+// (lib/settings_store.c) sobre a flash simulada: a gravação para depois de k
+// operações completas, com a seguinte interrompida em vários pontos (antes de
+// começar, no cabeçalho, no meio dos dados, antes do CRC), e o boot seguinte tem de carregar a versão antiga ou a nova, nunca
+// outra coisa, e voltar a gravar normalmente. Os cenários começam com o log em
+// pontos diferentes: vazio, no meio de um setor, na virada de setor (com e sem
+// apagamento) e depois de dar a volta na região.
+//
+//   settings_store_test    (status 1 se algum corte falhar)
+
+static const uint PRIOR_RECORDS[] = {0, 1, 15, 16, 17, 63, 64, 65, 80};
+static const double TORN[] = {0.0, 0.02, 0.1, 0.25, 0.5, 0.98};
+
+static jmp_buf power_lost;
+
+static void cut(void)
+{
+    longjmp(power_lost, 1);
+}
+
+static void make_settings(settings_t *s, uint n)
+{
+    settings_reset(s);
+    s->temp_max = 30.0f + n;
+    s->collector_port = 9000 + n;
+}
+
+// Um /set_settings seguido do tempo que o laço espera antes de gravar
+static void save(const settings_t *s)
+{
+    settings_publish(s);
+    settings_store_request_save();
+    sim_spend_us((uint64_t)(SETTINGS_SAVE_DELAY_MS + SETTINGS_MIN_WRITE_INTERVAL_MS) * 1000u);
+    settings_store_task();
+}
+
+static bool boot(settings_t *out)
+{
+    bool found = settings_store_init(out);
+    settings_publish(out);
+    return found;
+}
+
+// Gravação com a energia acabando depois de ops operações da flash. Retorna
+// true se ela terminou antes disso.
+static bool save_until_cut(const settings_t *s, uint32_t ops, double torn)
+{
+    if (setjmp(power_lost) != 0)
+        return false;
+    sim_flash_power_cut(ops, torn, cut);
+    save(s);
+    sim_flash_power_cut(0, 0, NULL);
+    return true;
+}
+
+static bool same(const settings_t *a, const settings_t *b)
+{
+    return memcmp(a, b, sizeof(settings_t)) == 0;
+}
+
+int main(void)
+{
+    sim_time_init();
+    sim_opts.speed = 0;
+    if (!sim_flash_init(NULL))
+        return 2;
+    uint8_t *region = (uint8_t *)flash_io_ptr(FLASH_SETTINGS_OFFSET);
+    static uint8_t before[FLASH_SETTINGS_SIZE];
+
+    uint cuts = 0, failures = 0;
+    for (uint sc = 0; sc < count_of(PRIOR_RECORDS); sc++)
+    {
+        // Estado antes da gravação interrompida
+        memset(region, 0xFF, FLASH_SETTINGS_SIZE);
+        settings_t old, next, third, loaded;
+        boot(&loaded);
+        for (uint i = 1; i <= PRIOR_RECORDS[sc]; i++)
+        {
+            make_settings(&old, i);
+            save(&old);
+        }
+        if (PRIOR_RECORDS[sc] == 0)
+            settings_reset(&old);
+        memcpy(before, region, FLASH_SETTINGS_SIZE);
+        make_settings(&next, 1000);
+        make_settings(&third, 2000);
+
+        for (uint t = 0; t < count_of(TORN); t++)
+        {
+            for (uint32_t k = 0;; k++)
+            {
+                memcpy(region, before, FLASH_SETTINGS_SIZE);
+                boot(&loaded);
+                bool completed = save_until_cut(&next, k, TORN[t]);
+
+                // Boot depois da queda (ou da gravação completa)
+                boot(&loaded);
+                const char *error = NULL;
+                if (completed && !same(&loaded, &next))
+                    error = "gravação completa não carregou a versão nova";
+                else if (!same(&loaded, &old) && !same(&loaded, &next))
+                    error = "carregou uma versão que não é a antiga nem a nova";
+                else
+                {
+                    // A próxima gravação depois da recuperação também tem de valer
+                    save(&third);
+                    boot(&loaded);
+                    if (!same(&loaded, &third))
+                        error = "gravação depois da recuperação se perdeu";
+                }
+                if (error)
+                {
+                    fprintf(stderr, "%u registros antes, corte após %lu operações (%.0f%% da seguinte): %s\n",
+                            PRIOR_RECORDS[sc], (unsigned long)k, TORN[t] * 100, error);
+                    failures++;
+                }
+                if (completed)
+                    break;
+                cuts++;
+            }
+        }
+    }
+
+    printf("%u cortes em %u cenários: %s\n", cuts, (uint)count_of(PRIOR_RECORDS),
+           failures ? "FALHAS" : "todos voltaram à versão antiga ou à nova");
+    return failures ? 1 : 0;
+}
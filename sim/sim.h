@@ -0,0 +1,141 @@
+#ifndef SIM_H
+#define SIM_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "pico/stdlib.h"
+
+// Interface interna do simulador no host: relógio virtual, modelos de
+// dispositivo, rede e roteiro de ambiente. O firmware só enxerga os
+// cabeçalhos de sim/include, que imitam o Pico SDK e o lwIP.
+
+// --- Opções da linha de comando ---
+typedef struct
+{
+    double speed;        // 1 = tempo real, 0 = o mais rápido possível
+    double duration_s;   // 0 = sem fim
+    const char *script;  // Roteiro de ambiente
+    const char *flash;   // Arquivo que guarda a flash entre execuções
+    const char *screen;  // PBM gravado na saída
+    uint16_t http_port;  // Porta do host no lugar da 80
+    bool show_matrix;    // Imprime a matriz a cada quadro novo
+    bool trace;          // Registra eventos de hardware em stderr
+    char **argv;         // Para reiniciar o processo no reboot pelo watchdog
+} sim_options_t;
+
+extern sim_options_t sim_opts;
+
+// Mensagens do simulador (stderr), com o instante virtual
+void sim_log(const char *fmt, ...) __attribute__((format(printf, 1, 2)));
+#define SIM_TRACE(...)                                                                                               \
+    do                                                                                                               \
+    {                                                                                                                \
+        if (sim_opts.trace)                                                                                          \
+            sim_log(__VA_ARGS__);                                                                                    \
+    } while (0)
+
+// Instala os sinais e marca o início no relógio do host (sim_board.c)
+void sim_board_start(void);
+// Encerra com o resumo (fim da duração, Ctrl+C ou BOOTSEL)
+void sim_exit(int status) __attribute__((noreturn));
+// Atende Ctrl+C e SIGUSR1 (imprime a tela e a matriz); chamada nas esperas
+void sim_check_signals(void);
+// Reboot pelo watchdog: o processo recomeça com os mesmos argumentos, levando
+// a RAM de __uninitialized_ram, a flash e o instante do ambiente
+void sim_reboot(void) __attribute__((noreturn));
+// No processo novo, antes de carregar o roteiro: restaura o que sim_reboot levou
+void sim_reboot_restore(void);
+// Relógio do ambiente (roteiro, duração, mensagens): o da placa somado ao
+// tempo que passou antes dos reboots
+uint64_t sim_world_us(void);
+
+// --- Relógio virtual (sim_time.c) ---
+void sim_time_init(void);
+uint64_t sim_now_us(void);
+// Tempo gasto pela CPU ou por um periférico bloqueante: avança o relógio sem
+// atender interrupções
+void sim_spend_us(uint64_t us);
+// Evento interno do simulador em t (mudanças do ambiente, botões, Wi-Fi)
+typedef void (*sim_event_fn)(void *arg);
+void sim_schedule(uint64_t t_us, sim_event_fn fn, void *arg);
+// Um callback do firmware rodou: acorda quem está em best_effort_wfe_or_timeout
+void sim_note_irq(void);
+bool sim_irqs_enabled(void);
+// Botão ligado ao GPIO pressionado (borda de descida)
+void sim_gpio_press(unsigned gpio);
+
+// --- Barramentos I2C e modelos (sim_i2c.c, sim_ssd1306.c) ---
+typedef struct sim_i2c_dev sim_i2c_dev_t;
+struct sim_i2c_dev
+{
+    const char *name;
+    int bus;
+    uint8_t addr;
+    int8_t mux_channel; // -1: ligado direto ao barramento
+    uint64_t fail_until_us;
+    uint64_t hang_until_us;
+    int (*write)(sim_i2c_dev_t *dev, const uint8_t *src, size_t len);
+    int (*read)(sim_i2c_dev_t *dev, uint8_t *dst, size_t len);
+    void *state;
+    uint32_t transactions;
+    uint32_t naks;
+};
+
+// Adiciona um sensor a partir de "bmp280@0x76", "aht20@0x38/2" (canal do TCA9548A)
+bool sim_i2c_add_sensor(const char *spec);
+void sim_i2c_init(void);
+// Sensores no endereço addr do barramento dos sensores deixam de responder
+void sim_i2c_fail(uint8_t addr, uint64_t duration_us);
+// Sensores no endereço addr seguram o barramento: a transação seguinte só termina no fim do prazo
+void sim_i2c_hang(uint8_t addr, uint64_t duration_us);
+void sim_i2c_report(FILE *out);
+
+// Liga o modelo do SSD1306 ao dispositivo
+void sim_ssd1306_attach(sim_i2c_dev_t *dev);
+void sim_ssd1306_dump_ascii(FILE *out);
+bool sim_ssd1306_write_pbm(const char *path);
+// Byte da RAM de vídeo do controlador (bit 0 em cima), como o modelo a recebeu
+uint8_t sim_ssd1306_ram(uint page, uint col);
+void sim_ssd1306_report(FILE *out);
+
+// --- Ambiente (sim_env.c) ---
+typedef struct
+{
+    double temp_c;
+    double pressure_pa;
+    double humidity_pct;
+} sim_env_t;
+
+bool sim_env_load(const char *path);
+void sim_env_at(uint64_t t_us, sim_env_t *out);
+
+// --- Periféricos restantes (sim_hw.c) ---
+bool sim_flash_init(const char *path);
+void sim_flash_close(void);
+// Grava a flash para o processo seguinte no reboot (a em memória vai num arquivo temporário)
+void sim_flash_handoff(void);
+// Queda de energia durante a gravação: depois de ops operações completas
+// (setores apagados ou páginas programadas), a seguinte chega à flash só na
+// fração torn e cut é chamada; ela não deve retornar (longjmp). cut NULL desarma.
+void sim_flash_power_cut(uint32_t ops, double torn, void (*cut)(void));
+typedef struct
+{
+    uint32_t erases; // Setores apagados
+    uint32_t pages;  // Páginas programadas
+} sim_flash_stats_t;
+void sim_flash_get_stats(sim_flash_stats_t *out);
+// Cada mudança do som do buzzer (frequência em Hz, 0 = mudo) chama fn; NULL desliga
+void sim_buzzer_watch(void (*fn)(uint32_t freq_hz));
+void sim_matrix_print(FILE *out);
+void sim_hw_report(FILE *out);
+
+// --- Rádio e rede (sim_net.c) ---
+// Atende os sockets; espera até timeout_ms por atividade. Retorna true se
+// algum callback do firmware rodou.
+bool sim_net_pump(int timeout_ms);
+void sim_wifi_set_available(bool available);
+void sim_net_report(FILE *out);
+
+#endif // SIM_H
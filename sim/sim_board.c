@@ -0,0 +1,150 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <signal.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "hardware/watchdog.h"
+
+#include "sim.h"
+
+// Estado da execução compartilhado pelos modelos: opções, sinais do host e o
+// encerramento com o resumo. Fica fora de sim_main.c para que outros
+// programas (o benchmark no host) usem a placa simulada com o próprio main().
+
+sim_options_t sim_opts = {.speed = 1.0, .http_port = 8080};
+
+// Variáveis __uninitialized_ram do firmware (sim/include/pico/stdlib.h); fracos
+// para os programas sem nenhuma
+extern char __start_sim_noinit[] __attribute__((weak));
+extern char __stop_sim_noinit[] __attribute__((weak));
+
+#define REBOOT_ENV "SIM_REBOOT"
+
+static volatile sig_atomic_t interrupted;
+static volatile sig_atomic_t dump_requested;
+static struct timespec host_start;
+static uint64_t world_offset_us;
+static bool rebooted_by_watchdog;
+
+static void on_signal(int sig)
+{
+    if (sig == SIGUSR1)
+        dump_requested = 1;
+    else
+        interrupted = 1;
+}
+
+void sim_board_start(void)
+{
+    clock_gettime(CLOCK_MONOTONIC, &host_start);
+    struct sigaction sa = {.sa_handler = on_signal};
+    sigemptyset(&sa.sa_mask);
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+    sigaction(SIGUSR1, &sa, NULL);
+    signal(SIGPIPE, SIG_IGN);
+}
+
+static void dump_outputs(FILE *out)
+{
+    sim_ssd1306_dump_ascii(out);
+    sim_matrix_print(out);
+}
+
+void sim_check_signals(void)
+{
+    if (dump_requested)
+    {
+        dump_requested = 0;
+        dump_outputs(stderr);
+    }
+    if (interrupted)
+        sim_exit(0);
+}
+
+uint64_t sim_world_us(void)
+{
+    return world_offset_us + sim_now_us();
+}
+
+void sim_reboot(void)
+{
+    sim_log("watchdog sem alimentação: reiniciando a placa");
+    if (!sim_opts.argv)
+        sim_exit(3);
+
+    // "<instante do ambiente em us> <RAM não inicializada em hex>"
+    size_t noinit = (size_t)(__stop_sim_noinit - __start_sim_noinit);
+    char *env = malloc(32 + 2 * noinit);
+    int len = sprintf(env, "%llu ", (unsigned long long)sim_world_us());
+    for (size_t i = 0; i < noinit; i++)
+        len += sprintf(env + len, "%02x", (uint8_t)__start_sim_noinit[i]);
+    setenv(REBOOT_ENV, env, 1);
+    free(env);
+
+    sim_flash_handoff();
+    fflush(stdout);
+    fflush(stderr);
+    // Os sockets do servidor HTTP e do rádio não passam para o processo novo
+    for (int fd = 3; fd < 1024; fd++)
+        close(fd);
+    execv("/proc/self/exe", sim_opts.argv);
+    perror("execv");
+    exit(3);
+}
+
+void sim_reboot_restore(void)
+{
+    const char *env = getenv(REBOOT_ENV);
+    if (!env)
+        return;
+    char *p;
+    world_offset_us = strtoull(env, &p, 10);
+    size_t noinit = (size_t)(__stop_sim_noinit - __start_sim_noinit);
+    if (*p == ' ' && strlen(p + 1) == 2 * noinit)
+    {
+        for (size_t i = 0; i < noinit; i++)
+        {
+            unsigned byte;
+            sscanf(p + 1 + 2 * i, "%2x", &byte);
+            __start_sim_noinit[i] = (char)byte;
+        }
+    }
+    unsetenv(REBOOT_ENV);
+    rebooted_by_watchdog = true;
+    sim_log("boot depois do reset pelo watchdog");
+}
+
+bool watchdog_caused_reboot(void)
+{
+    return rebooted_by_watchdog;
+}
+
+bool watchdog_enable_caused_reboot(void)
+{
+    return rebooted_by_watchdog;
+}
+
+void sim_exit(int status)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    double host_s = (now.tv_sec - host_start.tv_sec) + (now.tv_nsec - host_start.tv_nsec) / 1e9;
+    double sim_s = sim_world_us() / 1e6;
+
+    fflush(stdout);
+    fprintf(stderr, "\n--- simulação encerrada: %.3f s simulados em %.3f s (%.0fx) ---\n", sim_s, host_s,
+            host_s > 0 ? sim_s / host_s : 0.0);
+    sim_i2c_report(stderr);
+    sim_ssd1306_report(stderr);
+    sim_hw_report(stderr);
+    sim_net_report(stderr);
+    dump_outputs(stderr);
+    if (sim_opts.screen && !sim_ssd1306_write_pbm(sim_opts.screen))
+        fprintf(stderr, "não foi possível gravar %s\n", sim_opts.screen);
+    sim_flash_close();
+    exit(status);
+}
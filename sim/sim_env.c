@@ -0,0 +1,149 @@
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "sim.h"
+
+// Ambiente simulado. Sem roteiro, um ciclo diário em torno de 25 °C, 101,3 kPa
+// e 60 %. O roteiro é um arquivo de texto, uma linha por entrada:
+//
+//   # t_s  temp_c  pressão_kpa  umidade_pct    (pontos, interpolados em linha reta)
+//   0      24.0    101.3        55
+//   600    31.5    101.1        40
+//   wifi 120 down                               (queda do enlace; "up" volta)
+//   fail 300 0x76 20                            (sensor no endereço sem responder por 20 s)
+//   press 45 22                                 (botão no GPIO pressionado)
+//   hang 400 0x38 12                            (sensor segurando o barramento por 12 s)
+//
+// Antes do primeiro ponto e depois do último, valem os extremos. Os instantes
+// são do ambiente: depois de um reboot pelo watchdog o roteiro continua de
+// onde estava, e os eventos anteriores ao reboot não se repetem.
+
+#define MAX_POINTS 4096
+
+typedef struct
+{
+    double t_s;
+    sim_env_t env;
+} point_t;
+
+static point_t points[MAX_POINTS];
+static uint point_count;
+
+typedef struct
+{
+    uint8_t addr;
+    double duration_s;
+} fail_t;
+
+static void on_wifi(void *arg)
+{
+    sim_wifi_set_available(arg != NULL);
+}
+
+static void on_fail(void *arg)
+{
+    fail_t *f = arg;
+    SIM_TRACE("sensor 0x%02X sem responder por %.1f s", f->addr, f->duration_s);
+    sim_i2c_fail(f->addr, (uint64_t)(f->duration_s * 1e6));
+}
+
+static void on_hang(void *arg)
+{
+    fail_t *f = arg;
+    SIM_TRACE("sensor 0x%02X segurando o barramento por %.1f s", f->addr, f->duration_s);
+    sim_i2c_hang(f->addr, (uint64_t)(f->duration_s * 1e6));
+}
+
+static void on_press(void *arg)
+{
+    sim_gpio_press((unsigned)(uintptr_t)arg);
+}
+
+static uint64_t to_us(double t_s)
+{
+    return t_s > 0 ? (uint64_t)(t_s * 1e6) : 0;
+}
+
+// Evento no instante t_s do ambiente, no relógio da placa atual
+static void schedule_at(double t_s, sim_event_fn fn, void *arg)
+{
+    uint64_t t = to_us(t_s), offset = sim_world_us() - sim_now_us();
+    if (t >= offset)
+        sim_schedule(t - offset, fn, arg);
+}
+
+bool sim_env_load(const char *path)
+{
+    FILE *f = fopen(path, "r");
+    if (!f)
+        return false;
+    char line[256];
+    uint lineno = 0;
+    bool ok = true;
+    while (ok && fgets(line, sizeof(line), f))
+    {
+        lineno++;
+        char *hash = strchr(line, '#');
+        if (hash)
+            *hash = '\0';
+        char word[16], arg[16];
+        double t, a, b, c;
+        unsigned addr, gpio;
+        if (sscanf(line, " %15s", word) != 1)
+            continue;
+        if (strcmp(word, "wifi") == 0 && sscanf(line, " wifi %lf %15s", &t, arg) == 2)
+            schedule_at(t, on_wifi, strcmp(arg, "up") == 0 ? (void *)1 : NULL);
+        else if (strcmp(word, "fail") == 0 && sscanf(line, " fail %lf %x %lf", &t, &addr, &a) == 3)
+        {
+            fail_t *fail = malloc(sizeof(*fail));
+            *fail = (fail_t){(uint8_t)addr, a};
+            schedule_at(t, on_fail, fail);
+        }
+        else if (strcmp(word, "hang") == 0 && sscanf(line, " hang %lf %x %lf", &t, &addr, &a) == 3)
+        {
+            fail_t *hang = malloc(sizeof(*hang));
+            *hang = (fail_t){(uint8_t)addr, a};
+            schedule_at(t, on_hang, hang);
+        }
+        else if (strcmp(word, "press") == 0 && sscanf(line, " press %lf %u", &t, &gpio) == 2)
+            schedule_at(t, on_press, (void *)(uintptr_t)gpio);
+        else if (sscanf(line, " %lf %lf %lf %lf", &t, &a, &b, &c) == 4 && point_count < MAX_POINTS &&
+                 (point_count == 0 || t >= points[point_count - 1].t_s))
+            points[point_count++] = (point_t){t, {a, b * 1000.0, c}};
+        else
+            ok = false;
+    }
+    fclose(f);
+    if (!ok)
+        fprintf(stderr, "%s:%u: linha inválida\n", path, lineno);
+    return ok;
+}
+
+void sim_env_at(uint64_t t_us, sim_env_t *out)
+{
+    double t = t_us / 1e6;
+    if (point_count == 0)
+    {
+        double phase = sin(2 * M_PI * t / 86400.0);
+        *out = (sim_env_t){25.0 + 4.0 * phase, 101300.0 - 150.0 * phase, 60.0 - 15.0 * phase};
+        return;
+    }
+    if (t <= points[0].t_s)
+    {
+        *out = points[0].env;
+        return;
+    }
+    for (uint i = 1; i < point_count; i++)
+    {
+        const point_t *p0 = &points[i - 1], *p1 = &points[i];
+        if (t > p1->t_s)
+            continue;
+        double k = p1->t_s > p0->t_s ? (t - p0->t_s) / (p1->t_s - p0->t_s) : 1.0;
+        out->temp_c = p0->env.temp_c + k * (p1->env.temp_c - p0->env.temp_c);
+        out->pressure_pa = p0->env.pressure_pa + k * (p1->env.pressure_pa - p0->env.pressure_pa);
+        out->humidity_pct = p0->env.humidity_pct + k * (p1->env.humidity_pct - p0->env.humidity_pct);
+        return;
+    }
+    *out = points[point_count - 1].env;
+}
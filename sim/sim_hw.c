@@ -0,0 +1,439 @@
+#define _DEFAULT_SOURCE
+
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "hardware/clocks.h"
+#include "hardware/dma.h"
+#include "hardware/flash.h"
+#include "hardware/pio.h"
+#include "hardware/pwm.h"
+#include "hardware/regs/addressmap.h"
+#include "pico/bootrom.h"
+#include "pico/rand.h"
+#include "pico/unique_id.h"
+#include "sim.h"
+
+// Periféricos restantes: PWM do buzzer, PIO e DMA da matriz WS2812 (as
+// palavras que chegam ao FIFO viram a grade 5x5), flash, relógio do sistema,
+// identificador da placa, o gerador aleatório e o reboot para o BOOTSEL.
+
+#define SYS_CLOCK_HZ 125000000u
+
+// Custos típicos da flash da placa (W25Q16): apagar um setor e programar uma página
+#define FLASH_ERASE_SECTOR_US 45000
+#define FLASH_PROGRAM_PAGE_US 700
+
+// --- Bancos de scratch ---
+
+// SCRATCH_X e SCRATCH_Y da placa, com as pilhas dos núcleos no topo de cada um;
+// os símbolos do linker lidos por lib/mem_report.c são definidos sobre eles em
+// sim/CMakeLists.txt. No host o firmware roda na pilha da thread, então as
+// pilhas aparecem sem uso.
+uint32_t sim_scratch_x[1024], sim_scratch_y[1024];
+
+// --- Relógio e identificação ---
+
+uint32_t clock_get_hz(enum clock_index clk_index)
+{
+    return SYS_CLOCK_HZ;
+}
+
+void pico_get_unique_board_id(pico_unique_board_id_t *id_out)
+{
+    static const uint8_t ID[PICO_UNIQUE_BOARD_ID_SIZE_BYTES] = {0xE6, 0x61, 0x41, 0x04, 0x03, 0x51, 0x5D, 0x2A};
+    memcpy(id_out->id, ID, sizeof(ID));
+}
+
+// Cada execução do simulador é um boot diferente, como na placa
+uint32_t get_rand_32(void)
+{
+    uint32_t r;
+    int fd = open("/dev/urandom", O_RDONLY);
+    if (fd < 0 || read(fd, &r, sizeof(r)) != sizeof(r))
+        r = (uint32_t)time(NULL) ^ ((uint32_t)getpid() << 16);
+    if (fd >= 0)
+        close(fd);
+    return r;
+}
+
+void reset_usb_boot(uint32_t gpio_activity_pin_mask, uint32_t disable_interface_mask)
+{
+    sim_log("reboot para o BOOTSEL pedido pelo firmware");
+    sim_exit(0);
+}
+
+// --- Buzzer ---
+
+static struct
+{
+    uint8_t div;
+    uint16_t wrap;
+    uint16_t level;
+    bool enabled;
+    uint32_t tones;
+    uint32_t freq_hz; // Som atual, 0 = mudo
+    void (*watch)(uint32_t freq_hz);
+} buzzer;
+
+void sim_buzzer_watch(void (*fn)(uint32_t freq_hz))
+{
+    buzzer.watch = fn;
+}
+
+uint pwm_gpio_to_slice_num(uint gpio)
+{
+    return (gpio >> 1) & 7;
+}
+
+void pwm_set_clkdiv_int_frac(uint slice_num, uint8_t integer, uint8_t fract)
+{
+    buzzer.div = integer;
+}
+
+void pwm_set_wrap(uint slice_num, uint16_t wrap)
+{
+    buzzer.wrap = wrap;
+}
+
+void pwm_set_gpio_level(uint gpio, uint16_t level)
+{
+    if ((level != 0) != (buzzer.level != 0))
+    {
+        if (level)
+            buzzer.tones++;
+        SIM_TRACE("buzzer %s", level ? "soando" : "mudo");
+        if (level && sim_opts.trace && buzzer.div)
+            SIM_TRACE("  %lu Hz", (unsigned long)(SYS_CLOCK_HZ / buzzer.div / (buzzer.wrap + 1u)));
+    }
+    buzzer.level = level;
+    uint32_t freq = level && buzzer.div ? SYS_CLOCK_HZ / buzzer.div / (buzzer.wrap + 1u) : 0;
+    if (freq != buzzer.freq_hz)
+    {
+        buzzer.freq_hz = freq;
+        if (buzzer.watch)
+            buzzer.watch(freq);
+    }
+}
+
+void pwm_set_enabled(uint slice_num, bool enabled)
+{
+    buzzer.enabled = enabled;
+}
+
+// --- PIO, DMA e a matriz ---
+
+pio_hw_t sim_pio_hw[2];
+static uint pio_sm_used[2];
+
+#define LED_COUNT 25
+// Mesma fiação da placa: a fita corre em zigue-zague a partir do canto inferior direito
+#define NP_INDEX_OF(x, y) ((y) % 2 == 0 ? 24 - ((y) * 5 + (x)) : 24 - ((y) * 5 + (4 - (x))))
+
+static uint32_t matrix[LED_COUNT];
+static uint32_t matrix_frames;
+
+uint pio_add_program(PIO pio, const pio_program_t *program)
+{
+    return 0;
+}
+
+int pio_claim_unused_sm(PIO pio, bool required)
+{
+    uint *used = &pio_sm_used[pio == pio1];
+    for (uint sm = 0; sm < 4; sm++)
+    {
+        if (!(*used & (1u << sm)))
+        {
+            *used |= 1u << sm;
+            return (int)sm;
+        }
+    }
+    return -1;
+}
+
+uint pio_get_dreq(PIO pio, uint sm, bool is_tx)
+{
+    return (pio == pio1 ? 8 : 0) + (is_tx ? 0 : 4) + sm;
+}
+
+#define DMA_CHANNELS 12
+
+static struct
+{
+    bool claimed;
+    dma_channel_config config;
+    volatile void *write_addr;
+    const volatile void *read_addr;
+    uint count;
+} dma[DMA_CHANNELS];
+
+int dma_claim_unused_channel(bool required)
+{
+    for (uint ch = 0; ch < DMA_CHANNELS; ch++)
+    {
+        if (!dma[ch].claimed)
+        {
+            dma[ch].claimed = true;
+            return (int)ch;
+        }
+    }
+    return -1;
+}
+
+dma_channel_config dma_channel_get_default_config(uint channel)
+{
+    return (dma_channel_config){.size = DMA_SIZE_32, .read_increment = true, .write_increment = false, .dreq = 0x3F};
+}
+
+void channel_config_set_transfer_data_size(dma_channel_config *c, enum dma_channel_transfer_size size)
+{
+    c->size = (uint8_t)size;
+}
+
+void channel_config_set_read_increment(dma_channel_config *c, bool incr)
+{
+    c->read_increment = incr;
+}
+
+void channel_config_set_write_increment(dma_channel_config *c, bool incr)
+{
+    c->write_increment = incr;
+}
+
+void channel_config_set_dreq(dma_channel_config *c, uint dreq)
+{
+    c->dreq = dreq;
+}
+
+static bool is_pio_fifo(volatile void *addr)
+{
+    uintptr_t a = (uintptr_t)addr, base = (uintptr_t)sim_pio_hw;
+    return a >= base && a < base + sizeof(sim_pio_hw);
+}
+
+// As palavras do quadro são GRB deslocados 8 bits, como o PIO os envia
+static void matrix_frame(const volatile uint32_t *words, uint count)
+{
+    bool changed = false;
+    for (uint i = 0; i < count && i < LED_COUNT; i++)
+    {
+        changed |= matrix[i] != words[i];
+        matrix[i] = words[i];
+    }
+    matrix_frames++;
+    if (changed && sim_opts.show_matrix)
+        sim_matrix_print(stderr);
+}
+
+static void dma_run(uint channel)
+{
+    if (is_pio_fifo(dma[channel].write_addr) && dma[channel].config.size == DMA_SIZE_32 &&
+        dma[channel].config.read_increment)
+        matrix_frame((const volatile uint32_t *)dma[channel].read_addr, dma[channel].count);
+}
+
+void dma_channel_configure(uint channel, const dma_channel_config *config, volatile void *write_addr,
+                           const volatile void *read_addr, uint transfer_count, bool trigger)
+{
+    dma[channel].config = *config;
+    dma[channel].write_addr = write_addr;
+    dma[channel].read_addr = read_addr;
+    dma[channel].count = transfer_count;
+    if (trigger)
+        dma_run(channel);
+}
+
+void dma_channel_transfer_from_buffer_now(uint channel, const volatile void *read_addr, uint32_t transfer_count)
+{
+    dma[channel].read_addr = read_addr;
+    dma[channel].count = transfer_count;
+    dma_run(channel);
+}
+
+bool dma_channel_is_busy(uint channel)
+{
+    return false;
+}
+
+void sim_matrix_print(FILE *out)
+{
+    fprintf(out, "matriz (quadro %lu):\n", (unsigned long)matrix_frames);
+    for (uint y = 0; y < 5; y++)
+    {
+        fprintf(out, " ");
+        for (uint x = 0; x < 5; x++)
+        {
+            uint32_t w = matrix[NP_INDEX_OF(x, y)];
+            fprintf(out, " %02X%02X%02X", (w >> 16) & 0xFF, w >> 24, (w >> 8) & 0xFF);
+        }
+        fprintf(out, "\n");
+    }
+}
+
+// --- Flash ---
+
+uint8_t *sim_flash;
+static int flash_fd = -1;
+static uint32_t flash_erases, flash_pages;
+
+// Queda de energia programada (sim_flash_power_cut)
+static bool cut_armed;
+static uint32_t cut_ops_left;
+static double cut_torn;
+static void (*cut_fn)(void);
+
+// Flash em memória que atravessa um reboot pelo watchdog (sim_flash_handoff)
+#define FLASH_HANDOFF_ENV "SIM_REBOOT_FLASH"
+
+bool sim_flash_init(const char *path)
+{
+    if (!path)
+    {
+        sim_flash = malloc(PICO_FLASH_SIZE_BYTES);
+        if (!sim_flash)
+            return false;
+        memset(sim_flash, 0xFF, PICO_FLASH_SIZE_BYTES);
+        const char *handoff = getenv(FLASH_HANDOFF_ENV);
+        if (handoff)
+        {
+            FILE *f = fopen(handoff, "rb");
+            if (f)
+            {
+                if (fread(sim_flash, 1, PICO_FLASH_SIZE_BYTES, f) != PICO_FLASH_SIZE_BYTES)
+                    sim_log("flash do reboot incompleta");
+                fclose(f);
+            }
+            unlink(handoff);
+            unsetenv(FLASH_HANDOFF_ENV);
+        }
+        return true;
+    }
+    flash_fd = open(path, O_RDWR | O_CREAT, 0644);
+    if (flash_fd < 0)
+        return false;
+    struct stat st;
+    bool fresh = fstat(flash_fd, &st) == 0 && st.st_size == 0;
+    if (ftruncate(flash_fd, PICO_FLASH_SIZE_BYTES) != 0)
+        return false;
+    sim_flash = mmap(NULL, PICO_FLASH_SIZE_BYTES, PROT_READ | PROT_WRITE, MAP_SHARED, flash_fd, 0);
+    if (sim_flash == MAP_FAILED)
+        return false;
+    // Flash nova sai apagada
+    if (fresh)
+        memset(sim_flash, 0xFF, PICO_FLASH_SIZE_BYTES);
+    return true;
+}
+
+void sim_flash_close(void)
+{
+    if (flash_fd >= 0)
+    {
+        msync(sim_flash, PICO_FLASH_SIZE_BYTES, MS_SYNC);
+        munmap(sim_flash, PICO_FLASH_SIZE_BYTES);
+        close(flash_fd);
+        flash_fd = -1;
+    }
+}
+
+void sim_flash_handoff(void)
+{
+    if (flash_fd >= 0)
+    {
+        sim_flash_close();
+        return;
+    }
+    char path[] = "/tmp/monitor_sim_flash_XXXXXX";
+    int fd = mkstemp(path);
+    if (fd < 0)
+        return;
+    bool ok = write(fd, sim_flash, PICO_FLASH_SIZE_BYTES) == PICO_FLASH_SIZE_BYTES;
+    close(fd);
+    if (ok)
+        setenv(FLASH_HANDOFF_ENV, path, 1);
+    else
+        unlink(path);
+}
+
+void sim_flash_power_cut(uint32_t ops, double torn, void (*cut)(void))
+{
+    cut_armed = cut != NULL;
+    cut_ops_left = ops;
+    cut_torn = torn;
+    cut_fn = cut;
+}
+
+void sim_flash_get_stats(sim_flash_stats_t *out)
+{
+    out->erases = flash_erases;
+    out->pages = flash_pages;
+}
+
+// Conta uma operação (um setor apagado ou uma página programada) contra a
+// queda programada. Na operação em que a energia acaba, só o início dela chega
+// à flash (data NULL: apagamento) e o simulador não volta daqui.
+static void power_check(uint8_t *dst, const uint8_t *data, size_t len)
+{
+    if (!cut_armed)
+        return;
+    if (cut_ops_left > 0)
+    {
+        cut_ops_left--;
+        return;
+    }
+    size_t done = (size_t)(len * cut_torn);
+    for (size_t i = 0; i < done; i++)
+        dst[i] = data ? dst[i] & data[i] : 0xFF;
+    cut_armed = false;
+    cut_fn();
+    sim_log("sim_flash_power_cut: o callback da queda retornou");
+    sim_exit(1);
+}
+
+void flash_range_erase(uint32_t flash_offs, size_t count)
+{
+    if (flash_offs % FLASH_SECTOR_SIZE || count % FLASH_SECTOR_SIZE || flash_offs + count > PICO_FLASH_SIZE_BYTES)
+    {
+        sim_log("flash_range_erase desalinhado: 0x%lx +%zu", (unsigned long)flash_offs, count);
+        sim_exit(1);
+    }
+    for (size_t off = 0; off < count; off += FLASH_SECTOR_SIZE)
+    {
+        power_check(sim_flash + flash_offs + off, NULL, FLASH_SECTOR_SIZE);
+        memset(sim_flash + flash_offs + off, 0xFF, FLASH_SECTOR_SIZE);
+        flash_erases++;
+    }
+    sim_spend_us((uint64_t)FLASH_ERASE_SECTOR_US * (count / FLASH_SECTOR_SIZE));
+}
+
+// NOR: programar só leva bits de 1 para 0
+void flash_range_program(uint32_t flash_offs, const uint8_t *data, size_t count)
+{
+    if (flash_offs % FLASH_PAGE_SIZE || count % FLASH_PAGE_SIZE || flash_offs + count > PICO_FLASH_SIZE_BYTES)
+    {
+        sim_log("flash_range_program desalinhado: 0x%lx +%zu", (unsigned long)flash_offs, count);
+        sim_exit(1);
+    }
+    for (size_t off = 0; off < count; off += FLASH_PAGE_SIZE)
+    {
+        uint8_t *page = sim_flash + flash_offs + off;
+        power_check(page, data + off, FLASH_PAGE_SIZE);
+        for (size_t i = 0; i < FLASH_PAGE_SIZE; i++)
+            page[i] &= data[off + i];
+        flash_pages++;
+    }
+    sim_spend_us((uint64_t)FLASH_PROGRAM_PAGE_US * (count / FLASH_PAGE_SIZE));
+}
+
+void sim_hw_report(FILE *out)
+{
+    fprintf(out, "  flash: %lu setores apagados, %lu páginas programadas\n", (unsigned long)flash_erases,
+            (unsigned long)flash_pages);
+    fprintf(out, "  matriz: %lu quadros; buzzer: %lu toques\n", (unsigned long)matrix_frames,
+            (unsigned long)buzzer.tones);
+}
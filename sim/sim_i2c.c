@@ -0,0 +1,425 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "hardware/i2c.h"
+#include "sim.h"
+
+// Barramentos I2C e os modelos dos sensores: BMP280 em nível de registrador
+// (com a calibração do exemplo do datasheet), AHT20 pelos comandos e o
+// TCA9548A. Cada transação gasta o tempo de barramento na taxa configurada.
+
+#define MAX_DEVICES 32
+#define SENSORS_BUS 0
+#define MUX_ADDR 0x70
+
+i2c_inst_t sim_i2c_inst[2] = {{.index = 0, .baudrate = 100000}, {.index = 1, .baudrate = 100000}};
+
+static sim_i2c_dev_t devices[MAX_DEVICES];
+static uint device_count;
+static sim_i2c_dev_t *mux;
+static uint8_t mux_mask;
+
+static sim_i2c_dev_t *add_device(const char *name, int bus, uint8_t addr, int8_t mux_channel)
+{
+    if (device_count == MAX_DEVICES)
+        return NULL;
+    sim_i2c_dev_t *dev = &devices[device_count++];
+    *dev = (sim_i2c_dev_t){.name = name, .bus = bus, .addr = addr, .mux_channel = mux_channel};
+    return dev;
+}
+
+// --- TCA9548A: um único registrador com a máscara de canais ---
+
+static int mux_write(sim_i2c_dev_t *dev, const uint8_t *src, size_t len)
+{
+    if (len)
+        mux_mask = src[len - 1];
+    return (int)len;
+}
+
+static int mux_read(sim_i2c_dev_t *dev, uint8_t *dst, size_t len)
+{
+    memset(dst, mux_mask, len);
+    return (int)len;
+}
+
+// --- BMP280 ---
+
+typedef struct
+{
+    uint8_t regs[256];
+    uint8_t pointer;
+    uint64_t measuring_until_us;
+} bmp280_state_t;
+
+// Calibração do exemplo do datasheet (seção 3.12)
+static const uint16_t DIG_T1 = 27504;
+static const int16_t DIG_T2 = 26435, DIG_T3 = -1000;
+static const uint16_t DIG_P1 = 36477;
+static const int16_t DIG_P2 = -10685, DIG_P3 = 3024, DIG_P4 = 2855, DIG_P5 = 140, DIG_P6 = -7, DIG_P7 = 15500,
+                     DIG_P8 = -14600, DIG_P9 = 6000;
+
+// Compensação em ponto flutuante do datasheet (seção 8.1), independente da
+// versão inteira do firmware
+static double bmp280_t_fine(int32_t adc_t)
+{
+    double var1 = (adc_t / 16384.0 - DIG_T1 / 1024.0) * DIG_T2;
+    double d = adc_t / 131072.0 - DIG_T1 / 8192.0;
+    return var1 + d * d * DIG_T3;
+}
+
+static double bmp280_pressure(int32_t adc_p, double t_fine)
+{
+    double var1 = t_fine / 2.0 - 64000.0;
+    double var2 = var1 * var1 * DIG_P6 / 32768.0;
+    var2 = var2 + var1 * DIG_P5 * 2.0;
+    var2 = var2 / 4.0 + DIG_P4 * 65536.0;
+    var1 = (DIG_P3 * var1 * var1 / 524288.0 + DIG_P2 * var1) / 524288.0;
+    var1 = (1.0 + var1 / 32768.0) * DIG_P1;
+    if (var1 == 0)
+        return 0;
+    double p = 1048576.0 - adc_p;
+    p = (p - var2 / 4096.0) * 6250.0 / var1;
+    var1 = DIG_P9 * p * p / 2147483648.0;
+    var2 = p * DIG_P8 / 32768.0;
+    return p + (var1 + var2 + DIG_P7) / 16.0;
+}
+
+// Leituras brutas de 20 bits que a compensação leva aos valores do ambiente:
+// a temperatura cresce e a pressão cai com o valor bruto
+static void bmp280_raw_for(const sim_env_t *env, int32_t *adc_t, int32_t *adc_p)
+{
+    int32_t lo = 0, hi = 0xFFFFF;
+    while (lo < hi)
+    {
+        int32_t mid = (lo + hi) / 2;
+        if (bmp280_t_fine(mid) / 5120.0 < env->temp_c)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    *adc_t = lo;
+    double t_fine = bmp280_t_fine(lo);
+    lo = 0, hi = 0xFFFFF;
+    while (lo < hi)
+    {
+        int32_t mid = (lo + hi) / 2;
+        if (bmp280_pressure(mid, t_fine) > env->pressure_pa)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    *adc_p = lo;
+}
+
+static void put20(uint8_t *p, int32_t raw)
+{
+    p[0] = (uint8_t)(raw >> 12);
+    p[1] = (uint8_t)(raw >> 4);
+    p[2] = (uint8_t)((raw & 0x0F) << 4);
+}
+
+static void bmp280_measure(bmp280_state_t *s)
+{
+    sim_env_t env;
+    int32_t adc_t, adc_p;
+    sim_env_at(sim_world_us(), &env);
+    bmp280_raw_for(&env, &adc_t, &adc_p);
+    put20(&s->regs[0xF7], adc_p);
+    put20(&s->regs[0xFA], adc_t);
+}
+
+// Tempo máximo de conversão do datasheet para a sobreamostragem de ctrl_meas
+static uint64_t bmp280_measure_us(uint8_t ctrl_meas)
+{
+    static const uint8_t FACTOR[8] = {0, 1, 2, 4, 8, 16, 16, 16};
+    return 1250 + 2300u * FACTOR[ctrl_meas >> 5] + 2300u * FACTOR[(ctrl_meas >> 2) & 7] + 575;
+}
+
+static void bmp280_power_on(bmp280_state_t *s)
+{
+    memset(s->regs, 0, sizeof(s->regs));
+    const uint16_t calib[12] = {DIG_T1, (uint16_t)DIG_T2, (uint16_t)DIG_T3, DIG_P1, (uint16_t)DIG_P2,
+                                (uint16_t)DIG_P3, (uint16_t)DIG_P4, (uint16_t)DIG_P5, (uint16_t)DIG_P6,
+                                (uint16_t)DIG_P7, (uint16_t)DIG_P8, (uint16_t)DIG_P9};
+    for (uint i = 0; i < 12; i++)
+    {
+        s->regs[0x88 + 2 * i] = (uint8_t)calib[i];
+        s->regs[0x89 + 2 * i] = (uint8_t)(calib[i] >> 8);
+    }
+    s->regs[0xD0] = 0x58;
+    // Valores de reset dos registradores de dados
+    put20(&s->regs[0xF7], 0x80000);
+    put20(&s->regs[0xFA], 0x80000);
+    s->measuring_until_us = 0;
+}
+
+// Escrita: endereço do registrador e pares (registrador, valor); só o
+// endereço posiciona o ponteiro para a leitura seguinte
+static int bmp280_write(sim_i2c_dev_t *dev, const uint8_t *src, size_t len)
+{
+    bmp280_state_t *s = dev->state;
+    if (len)
+        s->pointer = src[0];
+    for (size_t i = 0; i + 1 < len; i += 2)
+    {
+        uint8_t reg = src[i], value = src[i + 1];
+        if (reg == 0xE0 && value == 0xB6)
+        {
+            bmp280_power_on(s);
+            continue;
+        }
+        if (reg != 0xF4 && reg != 0xF5)
+            continue;
+        s->regs[reg] = value;
+        // Modo forçado: uma conversão, depois volta a dormir
+        if (reg == 0xF4 && (value & 3) && (value & 3) != 3)
+        {
+            s->measuring_until_us = sim_now_us() + bmp280_measure_us(value);
+            bmp280_measure(s);
+            s->regs[0xF4] &= ~3;
+        }
+    }
+    return (int)len;
+}
+
+static int bmp280_read(sim_i2c_dev_t *dev, uint8_t *dst, size_t len)
+{
+    bmp280_state_t *s = dev->state;
+    uint64_t now = sim_now_us();
+    if ((s->regs[0xF4] & 3) == 3)
+        bmp280_measure(s);
+    s->regs[0xF3] = now < s->measuring_until_us ? 0x08 : 0x00;
+    for (size_t i = 0; i < len; i++)
+        dst[i] = s->regs[(uint8_t)(s->pointer + i)];
+    return (int)len;
+}
+
+// --- AHT20 ---
+
+#define AHT20_BUSY 0x80
+#define AHT20_CALIBRATED 0x08
+#define AHT20_MEASURE_US 80000
+// Antes disso, depois da energização, o sensor não responde
+#define AHT20_STARTUP_US 20000
+
+typedef struct
+{
+    bool calibrated;
+    uint64_t busy_until_us;
+    uint8_t data[6];
+} aht20_state_t;
+
+static uint8_t crc8(const uint8_t *data, size_t len)
+{
+    uint8_t crc = 0xFF;
+    for (size_t i = 0; i < len; i++)
+    {
+        crc ^= data[i];
+        for (int b = 0; b < 8; b++)
+            crc = (crc & 0x80) ? (uint8_t)((crc << 1) ^ 0x31) : (uint8_t)(crc << 1);
+    }
+    return crc;
+}
+
+static int aht20_write(sim_i2c_dev_t *dev, const uint8_t *src, size_t len)
+{
+    aht20_state_t *s = dev->state;
+    if (sim_now_us() < AHT20_STARTUP_US)
+        return PICO_ERROR_GENERIC;
+    if (len >= 1 && src[0] == 0xBE)
+        s->calibrated = true;
+    else if (len >= 1 && src[0] == 0xBA)
+        s->busy_until_us = sim_now_us() + 20000;
+    else if (len >= 3 && src[0] == 0xAC && src[1] == 0x33)
+    {
+        // Valores do início da conversão, entregues quando ela termina
+        sim_env_t env;
+        sim_env_at(sim_world_us(), &env);
+        double h = env.humidity_pct < 0 ? 0 : env.humidity_pct > 100 ? 100 : env.humidity_pct;
+        uint32_t raw_h = (uint32_t)(h / 100.0 * 1048575.0 + 0.5);
+        uint32_t raw_t = (uint32_t)((env.temp_c + 50.0) / 200.0 * 1048576.0 + 0.5) & 0xFFFFF;
+        s->data[1] = (uint8_t)(raw_h >> 12);
+        s->data[2] = (uint8_t)(raw_h >> 4);
+        s->data[3] = (uint8_t)(((raw_h & 0x0F) << 4) | (raw_t >> 16));
+        s->data[4] = (uint8_t)(raw_t >> 8);
+        s->data[5] = (uint8_t)raw_t;
+        s->busy_until_us = sim_now_us() + AHT20_MEASURE_US;
+    }
+    return (int)len;
+}
+
+static int aht20_read(sim_i2c_dev_t *dev, uint8_t *dst, size_t len)
+{
+    aht20_state_t *s = dev->state;
+    if (sim_now_us() < AHT20_STARTUP_US)
+        return PICO_ERROR_GENERIC;
+    uint8_t frame[7];
+    memcpy(frame, s->data, 6);
+    frame[0] = (s->calibrated ? AHT20_CALIBRATED : 0) | (sim_now_us() < s->busy_until_us ? AHT20_BUSY : 0);
+    frame[6] = crc8(frame, 6);
+    for (size_t i = 0; i < len; i++)
+        dst[i] = i < sizeof(frame) ? frame[i] : 0xFF;
+    return (int)len;
+}
+
+bool sim_i2c_add_sensor(const char *spec)
+{
+    char type[16];
+    unsigned addr = 0;
+    int channel = -1;
+    int n = sscanf(spec, "%15[^@]@%x/%d", type, &addr, &channel);
+    if (n < 2 || addr > 0x7F || channel > 7)
+        return false;
+
+    sim_i2c_dev_t *dev;
+    if (strcmp(type, "bmp280") == 0)
+    {
+        dev = add_device("bmp280", SENSORS_BUS, (uint8_t)addr, (int8_t)channel);
+        if (!dev)
+            return false;
+        bmp280_state_t *s = calloc(1, sizeof(*s));
+        bmp280_power_on(s);
+        dev->state = s;
+        dev->write = bmp280_write;
+        dev->read = bmp280_read;
+    }
+    else if (strcmp(type, "aht20") == 0)
+    {
+        dev = add_device("aht20", SENSORS_BUS, (uint8_t)addr, (int8_t)channel);
+        if (!dev)
+            return false;
+        aht20_state_t *s = calloc(1, sizeof(*s));
+        s->calibrated = true; // Sai de fábrica calibrado
+        dev->state = s;
+        dev->write = aht20_write;
+        dev->read = aht20_read;
+    }
+    else
+    {
+        return false;
+    }
+
+    if (channel >= 0 && !mux)
+    {
+        mux = add_device("tca9548a", SENSORS_BUS, MUX_ADDR, -1);
+        if (!mux)
+            return false;
+        mux->write = mux_write;
+        mux->read = mux_read;
+    }
+    return true;
+}
+
+// Sem --sensor: um BMP280 e um AHT20 ligados direto, como na placa
+void sim_i2c_init(void)
+{
+    bool have_sensors = false;
+    for (uint i = 0; i < device_count; i++)
+        have_sensors |= devices[i].bus == SENSORS_BUS;
+    if (!have_sensors)
+    {
+        sim_i2c_add_sensor("bmp280@0x76");
+        sim_i2c_add_sensor("aht20@0x38");
+    }
+    sim_i2c_dev_t *oled = add_device("ssd1306", 1, 0x3C, -1);
+    if (oled)
+        sim_ssd1306_attach(oled);
+}
+
+void sim_i2c_fail(uint8_t addr, uint64_t duration_us)
+{
+    for (uint i = 0; i < device_count; i++)
+    {
+        if (devices[i].bus == SENSORS_BUS && devices[i].addr == addr)
+            devices[i].fail_until_us = sim_now_us() + duration_us;
+    }
+}
+
+void sim_i2c_hang(uint8_t addr, uint64_t duration_us)
+{
+    for (uint i = 0; i < device_count; i++)
+    {
+        if (devices[i].bus == SENSORS_BUS && devices[i].addr == addr)
+            devices[i].hang_until_us = sim_now_us() + duration_us;
+    }
+}
+
+static sim_i2c_dev_t *find(i2c_inst_t *i2c, uint8_t addr)
+{
+    for (uint i = 0; i < device_count; i++)
+    {
+        sim_i2c_dev_t *dev = &devices[i];
+        if (dev->bus != (int)i2c->index || dev->addr != addr)
+            continue;
+        if (dev->mux_channel >= 0 && !(mux_mask & (1u << dev->mux_channel)))
+            continue;
+        return dev;
+    }
+    return NULL;
+}
+
+// Endereço mais os dados, 9 bits por byte
+static void bus_time(i2c_inst_t *i2c, size_t len)
+{
+    sim_spend_us((uint64_t)(len + 1) * 9 * 1000000u / i2c->baudrate);
+}
+
+static sim_i2c_dev_t *start(i2c_inst_t *i2c, uint8_t addr, size_t len)
+{
+    sim_i2c_dev_t *dev = find(i2c, addr);
+    // Escravo segurando SCL: as funções _blocking do SDK esperam sem prazo
+    if (dev && sim_now_us() < dev->hang_until_us)
+        sim_spend_us(dev->hang_until_us - sim_now_us());
+    if (!dev || sim_now_us() < dev->fail_until_us)
+    {
+        bus_time(i2c, 0);
+        if (dev)
+            dev->naks++;
+        return NULL;
+    }
+    bus_time(i2c, len);
+    dev->transactions++;
+    return dev;
+}
+
+uint i2c_init(i2c_inst_t *i2c, uint baudrate)
+{
+    i2c->baudrate = baudrate;
+    return baudrate;
+}
+
+int i2c_write_blocking(i2c_inst_t *i2c, uint8_t addr, const uint8_t *src, size_t len, bool nostop)
+{
+    sim_i2c_dev_t *dev = start(i2c, addr, len);
+    if (!dev)
+        return PICO_ERROR_GENERIC;
+    int ret = dev->write(dev, src, len);
+    if (ret < 0)
+        dev->naks++;
+    return ret;
+}
+
+int i2c_read_blocking(i2c_inst_t *i2c, uint8_t addr, uint8_t *dst, size_t len, bool nostop)
+{
+    sim_i2c_dev_t *dev = start(i2c, addr, len);
+    if (!dev || !dev->read)
+        return PICO_ERROR_GENERIC;
+    int ret = dev->read(dev, dst, len);
+    if (ret < 0)
+        dev->naks++;
+    return ret;
+}
+
+void sim_i2c_report(FILE *out)
+{
+    for (uint i = 0; i < device_count; i++)
+    {
+        const sim_i2c_dev_t *dev = &devices[i];
+        char where[16] = "";
+        if (dev->mux_channel >= 0)
+            snprintf(where, sizeof(where), " canal %d", dev->mux_channel);
+        fprintf(out, "  i2c%d 0x%02X %-8s%-9s %8lu transações, %lu NAK\n", dev->bus, dev->addr, dev->name, where,
+                (unsigned long)dev->transactions, (unsigned long)dev->naks);
+    }
+}
@@ -0,0 +1,109 @@
+#include <getopt.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "sim.h"
+
+// Ponto de entrada do simulador: lê as opções, monta a placa simulada e chama
+// o main() do firmware, compilado como firmware_main.
+
+int firmware_main(void);
+
+static void usage(const char *argv0)
+{
+    fprintf(stderr,
+            "uso: %s [opções]\n"
+            "  --speed X         velocidade em relação ao tempo real (0 = o mais rápido possível; padrão 1)\n"
+            "  --duration S      encerra depois de S segundos simulados\n"
+            "  --script ARQ      roteiro de ambiente (pontos de temperatura, pressão e umidade; eventos)\n"
+            "  --flash ARQ       guarda a flash no arquivo, entre execuções\n"
+            "  --http-port N     porta do host para o servidor HTTP (padrão 8080)\n"
+            "  --sensor ESPEC    sensor no barramento, ex.: bmp280@0x76, aht20@0x38/2 (canal do TCA9548A)\n"
+            "  --screen ARQ      grava a tela do OLED em PBM ao sair\n"
+            "  --show-matrix     imprime a matriz de LEDs a cada quadro diferente\n"
+            "  --trace           registra eventos de hardware em stderr\n"
+            "SIGUSR1 imprime a tela e a matriz; Ctrl+C encerra com o resumo.\n",
+            argv0);
+}
+
+int main(int argc, char **argv)
+{
+    static const struct option OPTIONS[] = {
+        {"speed", required_argument, NULL, 's'},
+        {"duration", required_argument, NULL, 'd'},
+        {"script", required_argument, NULL, 'e'},
+        {"flash", required_argument, NULL, 'f'},
+        {"http-port", required_argument, NULL, 'p'},
+        {"sensor", required_argument, NULL, 'S'},
+        {"screen", required_argument, NULL, 'o'},
+        {"show-matrix", no_argument, NULL, 'm'},
+        {"trace", no_argument, NULL, 't'},
+        {"help", no_argument, NULL, 'h'},
+        {NULL, 0, NULL, 0},
+    };
+
+    sim_time_init();
+
+    int opt;
+    while ((opt = getopt_long(argc, argv, "h", OPTIONS, NULL)) != -1)
+    {
+        switch (opt)
+        {
+        case 's':
+            sim_opts.speed = atof(optarg);
+            break;
+        case 'd':
+            sim_opts.duration_s = atof(optarg);
+            break;
+        case 'e':
+            sim_opts.script = optarg;
+            break;
+        case 'f':
+            sim_opts.flash = optarg;
+            break;
+        case 'p':
+            sim_opts.http_port = (uint16_t)atoi(optarg);
+            break;
+        case 'S':
+            if (!sim_i2c_add_sensor(optarg))
+            {
+                fprintf(stderr, "sensor inválido: %s\n", optarg);
+                return 2;
+            }
+            break;
+        case 'o':
+            sim_opts.screen = optarg;
+            break;
+        case 'm':
+            sim_opts.show_matrix = true;
+            break;
+        case 't':
+            sim_opts.trace = true;
+            break;
+        default:
+            usage(argv[0]);
+            return opt == 'h' ? 0 : 2;
+        }
+    }
+
+    // Depois de um reboot pelo watchdog, a RAM preservada e o instante do ambiente
+    sim_opts.argv = argv;
+    sim_reboot_restore();
+
+    if (sim_opts.script && !sim_env_load(sim_opts.script))
+        return 2;
+    if (!sim_flash_init(sim_opts.flash))
+    {
+        fprintf(stderr, "não foi possível abrir a flash %s\n", sim_opts.flash ? sim_opts.flash : "(memória)");
+        return 2;
+    }
+    sim_i2c_init();
+
+    sim_board_start();
+
+    if (sim_opts.speed > 0)
+        fprintf(stderr, "servidor HTTP em http://127.0.0.1:%u/ quando o Wi-Fi simulado conectar\n",
+                sim_opts.http_port);
+    firmware_main();
+    sim_exit(0);
+}
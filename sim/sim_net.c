@@ -0,0 +1,855 @@
+#define _GNU_SOURCE
+
+#include <errno.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "lwip/netif.h"
+#include "lwip/stats.h"
+#include "lwip/tcp.h"
+#include "lwip/udp.h"
+#include "pico/cyw43_arch.h"
+#include "sim.h"
+
+// Rádio e pilha de rede do simulador. A API "raw" do lwIP usada pelo firmware
+// roda sobre sockets não bloqueantes do host; os callbacks são chamados em
+// sim_net_pump, fora de qualquer seção crítica, como o lwIP em segundo plano
+// faz na placa. O servidor TCP escuta só no loopback, na porta --http-port no
+// lugar da 80. Um pcb liberado (tcp_close, tcp_abort, erro) só é desalocado no
+// fim do pump, então um callback pode liberar o próprio pcb.
+
+// Tempo da associação ao ponto de acesso até o endereço IP
+#define JOIN_US 1500000
+#define RECV_CHUNK (2 * TCP_MSS)
+
+typedef enum
+{
+    PCB_NEW,
+    PCB_LISTEN,
+    PCB_CONNECTING,
+    PCB_OPEN,
+    PCB_CLOSING, // Fechado pelo firmware, esvaziando a saída
+} pcb_state_t;
+
+struct tcp_pcb
+{
+    int fd;
+    pcb_state_t state;
+    bool freed;
+    bool remote_closed;
+    int connect_error;
+    void *arg;
+    tcp_accept_fn accept;
+    tcp_recv_fn recv;
+    tcp_sent_fn sent;
+    tcp_err_fn errf;
+    tcp_connected_fn connected;
+    memp_t pool;
+    uint8_t *out;
+    size_t out_len;
+    size_t unacked; // Já entregue ao socket, ainda sem o callback de envio
+    struct tcp_pcb *next;
+};
+
+struct udp_pcb
+{
+    int fd;
+    bool freed;
+    udp_recv_fn recv;
+    void *recv_arg;
+    struct udp_pcb *next;
+};
+
+static struct tcp_pcb *tcp_pcbs;
+static struct udp_pcb *udp_pcbs;
+
+static struct
+{
+    uint32_t accepted, connects, bytes_in, bytes_out;
+    uint32_t datagrams_out, datagrams_in, send_errors;
+    uint32_t joins, link_losses;
+} net_stats;
+
+// --- Heap e pools do lwIP: só a contabilidade, os dados ficam no malloc do host ---
+
+static struct stats_mem memp_stats[MEMP_MAX] = {
+#define LWIP_MEMPOOL(name, num, size, desc) [MEMP_##name] = {.avail = num},
+#include "lwip/priv/memp_std.h"
+};
+
+struct stats_ lwip_stats = {
+    .mem = {.avail = MEM_SIZE},
+    .memp = {
+#define LWIP_MEMPOOL(name, num, size, desc) [MEMP_##name] = &memp_stats[MEMP_##name],
+#include "lwip/priv/memp_std.h"
+    },
+};
+
+static bool take(struct stats_mem *s, size_t n)
+{
+    if (s->used + n > s->avail)
+    {
+        s->err++;
+        return false;
+    }
+    s->used += (u16_t)n;
+    if (s->used > s->max)
+        s->max = s->used;
+    return true;
+}
+
+static void give(struct stats_mem *s, size_t n)
+{
+    s->used -= (u16_t)n;
+}
+
+// --- Rádio ---
+
+cyw43_t cyw43_state;
+struct netif *netif_default = &cyw43_state.netif[CYW43_ITF_STA];
+const ip_addr_t ip_addr_any = {0};
+
+static bool sta_enabled;
+static bool ap_available = true;
+static int link_status = CYW43_LINK_DOWN;
+static uint32_t join_generation;
+static uint32_t power_mode = CYW43_DEFAULT_PM;
+
+static void netif_changed(bool up)
+{
+    struct netif *netif = &cyw43_state.netif[CYW43_ITF_STA];
+    if (netif_is_up(netif) == up)
+        return;
+    netif->flags = up ? NETIF_FLAG_UP | NETIF_FLAG_LINK_UP : 0;
+    netif->ip_addr.addr = up ? htonl(INADDR_LOOPBACK) : 0;
+    if (netif->link_callback)
+        netif->link_callback(netif);
+    if (netif->status_callback)
+        netif->status_callback(netif);
+    sim_note_irq();
+}
+
+static void on_join_done(void *arg)
+{
+    if ((uint32_t)(uintptr_t)arg != join_generation || link_status != CYW43_LINK_JOIN)
+        return;
+    if (!ap_available)
+    {
+        link_status = CYW43_LINK_NONET;
+        SIM_TRACE("wifi: rede não encontrada");
+        return;
+    }
+    link_status = CYW43_LINK_UP;
+    net_stats.joins++;
+    SIM_TRACE("wifi: conectado");
+    netif_changed(true);
+}
+
+void sim_wifi_set_available(bool available)
+{
+    ap_available = available;
+    SIM_TRACE("wifi: ponto de acesso %s", available ? "no ar" : "fora do ar");
+    if (!available && link_status == CYW43_LINK_UP)
+    {
+        link_status = CYW43_LINK_DOWN;
+        net_stats.link_losses++;
+        netif_changed(false);
+    }
+}
+
+int cyw43_arch_init(void)
+{
+    return 0;
+}
+
+void cyw43_arch_deinit(void)
+{
+}
+
+void cyw43_arch_enable_sta_mode(void)
+{
+    sta_enabled = true;
+}
+
+int cyw43_arch_wifi_connect_async(const char *ssid, const char *pw, uint32_t auth)
+{
+    if (!sta_enabled)
+        return PICO_ERROR_GENERIC;
+    link_status = CYW43_LINK_JOIN;
+    join_generation++;
+    sim_schedule(sim_now_us() + JOIN_US, on_join_done, (void *)(uintptr_t)join_generation);
+    return 0;
+}
+
+int cyw43_tcpip_link_status(cyw43_t *self, int itf)
+{
+    return link_status;
+}
+
+int cyw43_wifi_leave(cyw43_t *self, int itf)
+{
+    join_generation++;
+    link_status = CYW43_LINK_DOWN;
+    netif_changed(false);
+    return 0;
+}
+
+int cyw43_wifi_pm(cyw43_t *self, uint32_t pm)
+{
+    if (pm != power_mode)
+        SIM_TRACE("wifi: economia de energia 0x%06lx", (unsigned long)pm);
+    power_mode = pm;
+    return 0;
+}
+
+void cyw43_arch_poll(void)
+{
+    sim_net_pump(0);
+}
+
+void netif_set_status_callback(struct netif *netif, netif_status_callback_fn status_callback)
+{
+    netif->status_callback = status_callback;
+}
+
+void netif_set_link_callback(struct netif *netif, netif_status_callback_fn link_callback)
+{
+    netif->link_callback = link_callback;
+}
+
+char *ip4addr_ntoa(const ip4_addr_t *addr)
+{
+    static char buf[16];
+    struct in_addr in = {.s_addr = addr->addr};
+    return strcpy(buf, inet_ntoa(in));
+}
+
+int ip4addr_aton(const char *cp, ip4_addr_t *addr)
+{
+    struct in_addr in;
+    if (!inet_aton(cp, &in))
+        return 0;
+    addr->addr = in.s_addr;
+    return 1;
+}
+
+static bool link_up(void)
+{
+    return link_status == CYW43_LINK_UP;
+}
+
+// --- pbuf: um segmento só, com um '\0' depois dos dados ---
+
+// Um pbuf do pool conta como um elemento; os demais ocupam o heap do lwIP
+static struct stats_mem *pbuf_stats(pbuf_type type)
+{
+    return type == PBUF_POOL ? &memp_stats[MEMP_PBUF_POOL] : &lwip_stats.mem;
+}
+
+static size_t pbuf_units(pbuf_type type, u16_t length)
+{
+    return type == PBUF_POOL ? 1 : sizeof(struct pbuf) + length;
+}
+
+struct pbuf *pbuf_alloc(pbuf_layer layer, u16_t length, pbuf_type type)
+{
+    if (!take(pbuf_stats(type), pbuf_units(type, length)))
+        return NULL;
+    struct pbuf *p = malloc(sizeof(struct pbuf) + length + 1);
+    if (!p)
+        return NULL;
+    p->type_internal = (u8_t)type;
+    p->alloc_len = length;
+    p->next = NULL;
+    p->payload = p + 1;
+    p->len = p->tot_len = length;
+    ((char *)p->payload)[length] = '\0';
+    return p;
+}
+
+u8_t pbuf_free(struct pbuf *p)
+{
+    give(pbuf_stats((pbuf_type)p->type_internal), pbuf_units((pbuf_type)p->type_internal, p->alloc_len));
+    free(p);
+    return 1;
+}
+
+err_t pbuf_take(struct pbuf *buf, const void *dataptr, u16_t len)
+{
+    if (len > buf->tot_len)
+        return ERR_ARG;
+    memcpy(buf->payload, dataptr, len);
+    return ERR_OK;
+}
+
+u16_t pbuf_copy_partial(const struct pbuf *p, void *dataptr, u16_t len, u16_t offset)
+{
+    if (offset >= p->tot_len)
+        return 0;
+    u16_t n = MIN(len, (u16_t)(p->tot_len - offset));
+    memcpy(dataptr, (const char *)p->payload + offset, n);
+    return n;
+}
+
+// --- TCP ---
+
+static int new_socket(int type)
+{
+    int fd = socket(AF_INET, type | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    return fd;
+}
+
+static void release(struct tcp_pcb *pcb)
+{
+    pcb->freed = true;
+    if (pcb->fd >= 0)
+        close(pcb->fd);
+    pcb->fd = -1;
+}
+
+// O pcb já foi liberado quando o callback de erro roda, como no lwIP
+static void fail(struct tcp_pcb *pcb, err_t err)
+{
+    tcp_err_fn errf = pcb->errf;
+    void *arg = pcb->arg;
+    release(pcb);
+    if (errf)
+    {
+        errf(arg, err);
+        sim_note_irq();
+    }
+}
+
+struct tcp_pcb *tcp_new(void)
+{
+    if (!take(&memp_stats[MEMP_TCP_PCB], 1))
+        return NULL;
+    struct tcp_pcb *pcb = calloc(1, sizeof(*pcb));
+    if (!pcb)
+        return NULL;
+    pcb->pool = MEMP_TCP_PCB;
+    pcb->fd = -1;
+    pcb->next = tcp_pcbs;
+    tcp_pcbs = pcb;
+    return pcb;
+}
+
+err_t tcp_bind(struct tcp_pcb *pcb, const ip_addr_t *ipaddr, u16_t port)
+{
+    pcb->fd = new_socket(SOCK_STREAM);
+    if (pcb->fd < 0)
+        return ERR_MEM;
+    int one = 1;
+    setsockopt(pcb->fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    struct sockaddr_in sa = {
+        .sin_family = AF_INET,
+        .sin_port = htons(port == 80 ? sim_opts.http_port : port),
+        .sin_addr.s_addr = htonl(INADDR_LOOPBACK),
+    };
+    if (bind(pcb->fd, (struct sockaddr *)&sa, sizeof(sa)) != 0)
+    {
+        sim_log("tcp_bind na porta %u: %s", ntohs(sa.sin_port), strerror(errno));
+        close(pcb->fd);
+        pcb->fd = -1;
+        return ERR_USE;
+    }
+    return ERR_OK;
+}
+
+struct tcp_pcb *tcp_listen(struct tcp_pcb *pcb)
+{
+    if (pcb->fd < 0 || listen(pcb->fd, 8) != 0)
+        return NULL;
+    // Como no lwIP, o pcb de escuta troca de pool
+    if (take(&memp_stats[MEMP_TCP_PCB_LISTEN], 1))
+    {
+        give(&memp_stats[pcb->pool], 1);
+        pcb->pool = MEMP_TCP_PCB_LISTEN;
+    }
+    pcb->state = PCB_LISTEN;
+    return pcb;
+}
+
+void tcp_accept(struct tcp_pcb *pcb, tcp_accept_fn accept)
+{
+    pcb->accept = accept;
+}
+
+err_t tcp_connect(struct tcp_pcb *pcb, const ip_addr_t *ipaddr, u16_t port, tcp_connected_fn connected)
+{
+    if (!link_up())
+        return ERR_RTE;
+    if (pcb->fd < 0)
+        pcb->fd = new_socket(SOCK_STREAM);
+    if (pcb->fd < 0)
+        return ERR_MEM;
+    struct sockaddr_in sa = {.sin_family = AF_INET, .sin_port = htons(port), .sin_addr.s_addr = ipaddr->addr};
+    pcb->connected = connected;
+    pcb->state = PCB_CONNECTING;
+    net_stats.connects++;
+    // Falhas imediatas do host chegam depois, pelo callback de erro, como no lwIP
+    if (connect(pcb->fd, (struct sockaddr *)&sa, sizeof(sa)) != 0 && errno != EINPROGRESS)
+        pcb->connect_error = errno;
+    return ERR_OK;
+}
+
+void tcp_arg(struct tcp_pcb *pcb, void *arg)
+{
+    pcb->arg = arg;
+}
+
+void tcp_recv(struct tcp_pcb *pcb, tcp_recv_fn recv)
+{
+    pcb->recv = recv;
+}
+
+void tcp_sent(struct tcp_pcb *pcb, tcp_sent_fn sent)
+{
+    pcb->sent = sent;
+}
+
+void tcp_err(struct tcp_pcb *pcb, tcp_err_fn err)
+{
+    pcb->errf = err;
+}
+
+void tcp_poll(struct tcp_pcb *pcb, tcp_poll_fn poll, u8_t interval)
+{
+}
+
+u16_t tcp_sndbuf(const struct tcp_pcb *pcb)
+{
+    size_t used = pcb->out_len + pcb->unacked;
+    return used >= TCP_SND_BUF ? 0 : (u16_t)(TCP_SND_BUF - used);
+}
+
+err_t tcp_write(struct tcp_pcb *pcb, const void *dataptr, u16_t len, u8_t apiflags)
+{
+    if (pcb->state != PCB_OPEN)
+        return ERR_CONN;
+    if (len > tcp_sndbuf(pcb))
+        return ERR_MEM;
+    // A cópia dos dados ocupa o heap do lwIP até sair pelo socket
+    if (!take(&lwip_stats.mem, len))
+        return ERR_MEM;
+    uint8_t *out = realloc(pcb->out, pcb->out_len + len);
+    if (!out)
+    {
+        give(&lwip_stats.mem, len);
+        return ERR_MEM;
+    }
+    memcpy(out + pcb->out_len, dataptr, len);
+    pcb->out = out;
+    pcb->out_len += len;
+    return ERR_OK;
+}
+
+// Entrega ao socket o que couber; false se a conexão caiu
+static bool flush(struct tcp_pcb *pcb)
+{
+    while (pcb->out_len)
+    {
+        ssize_t n = send(pcb->fd, pcb->out, pcb->out_len, MSG_NOSIGNAL | MSG_DONTWAIT);
+        if (n < 0)
+            return errno == EAGAIN || errno == EWOULDBLOCK;
+        memmove(pcb->out, pcb->out + n, pcb->out_len - (size_t)n);
+        pcb->out_len -= (size_t)n;
+        give(&lwip_stats.mem, (size_t)n);
+        net_stats.bytes_out += (uint32_t)n;
+        if (pcb->state == PCB_OPEN)
+            pcb->unacked += (size_t)n;
+    }
+    return true;
+}
+
+err_t tcp_output(struct tcp_pcb *pcb)
+{
+    if (pcb->state == PCB_OPEN && !flush(pcb))
+        fail(pcb, ERR_RST);
+    return ERR_OK;
+}
+
+void tcp_recved(struct tcp_pcb *pcb, u16_t len)
+{
+}
+
+err_t tcp_close(struct tcp_pcb *pcb)
+{
+    if (pcb->state != PCB_OPEN)
+    {
+        release(pcb);
+        return ERR_OK;
+    }
+    // Os dados já escritos ainda saem; o firmware não recebe mais callbacks
+    pcb->state = PCB_CLOSING;
+    pcb->recv = NULL;
+    pcb->sent = NULL;
+    pcb->errf = NULL;
+    pcb->unacked = 0;
+    return ERR_OK;
+}
+
+void tcp_abort(struct tcp_pcb *pcb)
+{
+    if (pcb->fd >= 0)
+    {
+        // Fecha com RST
+        struct linger lg = {.l_onoff = 1, .l_linger = 0};
+        setsockopt(pcb->fd, SOL_SOCKET, SO_LINGER, &lg, sizeof(lg));
+    }
+    fail(pcb, ERR_ABRT);
+}
+
+// --- UDP ---
+
+struct udp_pcb *udp_new(void)
+{
+    if (!take(&memp_stats[MEMP_UDP_PCB], 1))
+        return NULL;
+    struct udp_pcb *pcb = calloc(1, sizeof(*pcb));
+    if (!pcb)
+        return NULL;
+    pcb->fd = new_socket(SOCK_DGRAM);
+    if (pcb->fd < 0)
+    {
+        give(&memp_stats[MEMP_UDP_PCB], 1);
+        free(pcb);
+        return NULL;
+    }
+    pcb->next = udp_pcbs;
+    udp_pcbs = pcb;
+    return pcb;
+}
+
+void udp_remove(struct udp_pcb *pcb)
+{
+    close(pcb->fd);
+    pcb->fd = -1;
+    pcb->freed = true;
+}
+
+err_t udp_bind(struct udp_pcb *pcb, const ip_addr_t *ipaddr, u16_t port)
+{
+    struct sockaddr_in sa = {.sin_family = AF_INET, .sin_port = htons(port), .sin_addr.s_addr = ipaddr->addr};
+    return bind(pcb->fd, (struct sockaddr *)&sa, sizeof(sa)) == 0 ? ERR_OK : ERR_USE;
+}
+
+void udp_recv(struct udp_pcb *pcb, udp_recv_fn recv, void *recv_arg)
+{
+    pcb->recv = recv;
+    pcb->recv_arg = recv_arg;
+}
+
+err_t udp_sendto(struct udp_pcb *pcb, struct pbuf *p, const ip_addr_t *dst_ip, u16_t dst_port)
+{
+    if (!link_up())
+        return ERR_RTE;
+    struct sockaddr_in sa = {.sin_family = AF_INET, .sin_port = htons(dst_port), .sin_addr.s_addr = dst_ip->addr};
+    if (sendto(pcb->fd, p->payload, p->len, 0, (struct sockaddr *)&sa, sizeof(sa)) < 0)
+    {
+        net_stats.send_errors++;
+        return errno == EACCES ? ERR_VAL : errno == ENOBUFS || errno == EAGAIN ? ERR_MEM : ERR_RTE;
+    }
+    net_stats.datagrams_out++;
+    return ERR_OK;
+}
+
+void udp_set_multicast_ttl(struct udp_pcb *pcb, u8_t ttl)
+{
+    int value = ttl;
+    setsockopt(pcb->fd, IPPROTO_IP, IP_MULTICAST_TTL, &value, sizeof(value));
+}
+
+void sim_udp_set_option(struct udp_pcb *pcb, u8_t opt)
+{
+    int one = 1;
+    if (opt & SOF_BROADCAST)
+        setsockopt(pcb->fd, SOL_SOCKET, SO_BROADCAST, &one, sizeof(one));
+}
+
+// --- Despacho ---
+
+static bool on_accept(struct tcp_pcb *listener)
+{
+    int fd = accept4(listener->fd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+    if (fd < 0)
+        return false;
+    struct tcp_pcb *pcb = tcp_new();
+    if (!pcb)
+    {
+        close(fd);
+        return false;
+    }
+    pcb->fd = fd;
+    pcb->state = PCB_OPEN;
+    pcb->arg = listener->arg;
+    net_stats.accepted++;
+    if (!listener->accept)
+    {
+        release(pcb);
+        return false;
+    }
+    if (listener->accept(listener->arg, pcb, ERR_OK) != ERR_OK && !pcb->freed)
+        tcp_abort(pcb);
+    return true;
+}
+
+static void on_connected(struct tcp_pcb *pcb)
+{
+    int error = pcb->connect_error;
+    socklen_t len = sizeof(error);
+    if (!error)
+        getsockopt(pcb->fd, SOL_SOCKET, SO_ERROR, &error, &len);
+    if (error)
+    {
+        fail(pcb, ERR_RST);
+        return;
+    }
+    pcb->state = PCB_OPEN;
+    if (pcb->connected)
+        pcb->connected(pcb->arg, pcb, ERR_OK);
+}
+
+static void on_readable(struct tcp_pcb *pcb)
+{
+    // Na placa, o driver do CYW43 recebe em pbufs do pool
+    struct pbuf *p = pbuf_alloc(PBUF_TRANSPORT, RECV_CHUNK, PBUF_POOL);
+    if (!p)
+        return;
+    ssize_t n = recv(pcb->fd, p->payload, RECV_CHUNK, 0);
+    if (n < 0)
+    {
+        pbuf_free(p);
+        if (errno != EAGAIN && errno != EWOULDBLOCK)
+            fail(pcb, ERR_RST);
+        return;
+    }
+    if (n == 0)
+    {
+        // Fim do lado remoto: p == NULL; sem callback, o lwIP fecha sozinho
+        pbuf_free(p);
+        pcb->remote_closed = true;
+        if (pcb->recv)
+            pcb->recv(pcb->arg, pcb, NULL, ERR_OK);
+        else
+            tcp_close(pcb);
+        return;
+    }
+    p->len = p->tot_len = (u16_t)n;
+    ((char *)p->payload)[n] = '\0';
+    net_stats.bytes_in += (uint32_t)n;
+    if (pcb->recv)
+        pcb->recv(pcb->arg, pcb, p, ERR_OK);
+    else
+        pbuf_free(p);
+}
+
+// Dados que saíram pelo socket contam como confirmados
+static bool deliver_acks(void)
+{
+    bool fired = false;
+    for (struct tcp_pcb *pcb = tcp_pcbs; pcb; pcb = pcb->next)
+    {
+        while (!pcb->freed && pcb->state == PCB_OPEN && pcb->unacked)
+        {
+            u16_t n = (u16_t)MIN(pcb->unacked, 0xFFFFu);
+            pcb->unacked -= n;
+            if (pcb->sent)
+            {
+                pcb->sent(pcb->arg, pcb, n);
+                fired = true;
+            }
+        }
+    }
+    return fired;
+}
+
+static void on_udp_readable(struct udp_pcb *pcb)
+{
+    struct pbuf *p = pbuf_alloc(PBUF_TRANSPORT, 1472, PBUF_POOL);
+    if (!p)
+        return;
+    struct sockaddr_in sa;
+    socklen_t len = sizeof(sa);
+    ssize_t n = recvfrom(pcb->fd, p->payload, 1472, 0, (struct sockaddr *)&sa, &len);
+    if (n < 0)
+    {
+        pbuf_free(p);
+        return;
+    }
+    p->len = p->tot_len = (u16_t)n;
+    ((char *)p->payload)[n] = '\0';
+    net_stats.datagrams_in++;
+    if (!pcb->recv)
+    {
+        pbuf_free(p);
+        return;
+    }
+    ip_addr_t addr = {.addr = sa.sin_addr.s_addr};
+    pcb->recv(pcb->recv_arg, pcb, p, &addr, ntohs(sa.sin_port));
+}
+
+static void reap(void)
+{
+    for (struct tcp_pcb **pp = &tcp_pcbs; *pp;)
+    {
+        struct tcp_pcb *pcb = *pp;
+        if (pcb->state == PCB_CLOSING && !pcb->out_len && !pcb->freed)
+        {
+            // Lê o que sobrou antes de fechar, senão o host responde com RST
+            char scratch[512];
+            while (recv(pcb->fd, scratch, sizeof(scratch), 0) > 0)
+                ;
+            release(pcb);
+        }
+        if (pcb->freed)
+        {
+            *pp = pcb->next;
+            give(&lwip_stats.mem, pcb->out_len);
+            give(&memp_stats[pcb->pool], 1);
+            free(pcb->out);
+            free(pcb);
+        }
+        else
+        {
+            pp = &pcb->next;
+        }
+    }
+    for (struct udp_pcb **pp = &udp_pcbs; *pp;)
+    {
+        struct udp_pcb *pcb = *pp;
+        if (pcb->freed)
+        {
+            *pp = pcb->next;
+            give(&memp_stats[MEMP_UDP_PCB], 1);
+            free(pcb);
+        }
+        else
+        {
+            pp = &pcb->next;
+        }
+    }
+}
+
+#define MAX_FDS 64
+
+bool sim_net_pump(int timeout_ms)
+{
+    if (!sim_irqs_enabled())
+        return false;
+
+    bool fired = deliver_acks();
+    for (struct tcp_pcb *pcb = tcp_pcbs; pcb; pcb = pcb->next)
+    {
+        if (!pcb->freed && pcb->state == PCB_CONNECTING && pcb->connect_error)
+        {
+            on_connected(pcb);
+            fired = true;
+        }
+    }
+
+    struct pollfd fds[MAX_FDS];
+    void *owners[MAX_FDS];
+    bool is_udp[MAX_FDS];
+    nfds_t n = 0;
+    for (struct tcp_pcb *pcb = tcp_pcbs; pcb && n < MAX_FDS; pcb = pcb->next)
+    {
+        if (pcb->freed || pcb->fd < 0 || pcb->state == PCB_NEW)
+            continue;
+        short events = 0;
+        if (pcb->state == PCB_LISTEN)
+            events = POLLIN;
+        else if (pcb->state == PCB_CONNECTING)
+            events = POLLOUT;
+        else if (pcb->state == PCB_OPEN)
+            events = (pcb->remote_closed ? 0 : POLLIN) | (pcb->out_len ? POLLOUT : 0);
+        else
+            events = pcb->out_len ? POLLOUT : 0;
+        // Sem nada a esperar, o POLLHUP de uma conexão encerrada acordaria o poll sem parar
+        if (!events)
+            continue;
+        fds[n] = (struct pollfd){.fd = pcb->fd, .events = events};
+        owners[n] = pcb;
+        is_udp[n++] = false;
+    }
+    for (struct udp_pcb *pcb = udp_pcbs; pcb && n < MAX_FDS; pcb = pcb->next)
+    {
+        if (pcb->freed)
+            continue;
+        fds[n] = (struct pollfd){.fd = pcb->fd, .events = POLLIN};
+        owners[n] = pcb;
+        is_udp[n++] = true;
+    }
+
+    if (poll(fds, n, fired ? 0 : timeout_ms) > 0)
+    {
+        for (nfds_t i = 0; i < n; i++)
+        {
+            short re = fds[i].revents;
+            if (!re)
+                continue;
+            if (is_udp[i])
+            {
+                struct udp_pcb *pcb = owners[i];
+                if (!pcb->freed && (re & POLLIN))
+                {
+                    on_udp_readable(pcb);
+                    fired = true;
+                }
+                continue;
+            }
+            struct tcp_pcb *pcb = owners[i];
+            if (pcb->freed)
+                continue;
+            fired |= pcb->state != PCB_CLOSING;
+            switch (pcb->state)
+            {
+            case PCB_LISTEN:
+                on_accept(pcb);
+                break;
+            case PCB_CONNECTING:
+                on_connected(pcb);
+                break;
+            case PCB_OPEN:
+            case PCB_CLOSING:
+                if ((re & POLLOUT) && !flush(pcb))
+                {
+                    if (pcb->state == PCB_OPEN)
+                        fail(pcb, ERR_RST);
+                    else
+                        release(pcb);
+                    break;
+                }
+                if (pcb->state == PCB_OPEN && !pcb->remote_closed && (re & (POLLIN | POLLHUP | POLLERR)))
+                    on_readable(pcb);
+                else if (pcb->state == PCB_CLOSING && (re & (POLLHUP | POLLERR)))
+                    release(pcb);
+                break;
+            default:
+                break;
+            }
+        }
+    }
+
+    fired |= deliver_acks();
+    reap();
+    if (fired)
+        sim_note_irq();
+    return fired;
+}
+
+void sim_net_report(FILE *out)
+{
+    fprintf(out, "  wifi: %lu conexões, %lu quedas, economia 0x%06lx\n", (unsigned long)net_stats.joins,
+            (unsigned long)net_stats.link_losses, (unsigned long)power_mode);
+    fprintf(out, "  tcp: %lu aceitas, %lu abertas, %lu bytes recebidos, %lu enviados\n",
+            (unsigned long)net_stats.accepted, (unsigned long)net_stats.connects, (unsigned long)net_stats.bytes_in,
+            (unsigned long)net_stats.bytes_out);
+    fprintf(out, "  udp: %lu datagramas enviados, %lu recebidos, %lu erros\n", (unsigned long)net_stats.datagrams_out,
+            (unsigned long)net_stats.datagrams_in, (unsigned long)net_stats.send_errors);
+}
@@ -0,0 +1,209 @@
+#include <string.h>
+
+#include "sim.h"
+
+// Controlador SSD1306 de 128x64: interpreta o fluxo de controle (Co, D/C),
+// os comandos com argumentos e os três modos de endereçamento, e guarda a RAM
+// de vídeo. A imagem sai como texto (meios blocos, duas linhas por caractere) ou PBM.
+
+#define COLS 128
+#define PAGES 8
+
+static struct
+{
+    uint8_t ram[PAGES][COLS];
+    bool on;
+    uint8_t mode; // 0 horizontal, 1 vertical, 2 por página
+    uint8_t col, page;
+    uint8_t col_lo, col_hi, page_lo, page_hi;
+    uint8_t cmd;     // Comando esperando argumentos
+    uint8_t args[2];
+    uint8_t nargs, want;
+    uint32_t data_bytes;
+    uint32_t transactions;
+    uint32_t power_changes;
+} oled = {.mode = 2, .col_hi = COLS - 1, .page_hi = PAGES - 1};
+
+static uint8_t arg_count(uint8_t cmd)
+{
+    switch (cmd)
+    {
+    case 0x21: // Faixa de colunas
+    case 0x22: // Faixa de páginas
+        return 2;
+    case 0x20: // Modo de endereçamento
+    case 0x81: // Contraste
+    case 0x8D: // Bomba de carga
+    case 0xA8: // Multiplex
+    case 0xD3: // Deslocamento
+    case 0xD5: // Divisor do relógio
+    case 0xD9: // Pré-carga
+    case 0xDA: // Pinos COM
+    case 0xDB: // VCOMH
+        return 1;
+    default:
+        return 0;
+    }
+}
+
+static void run_command(uint8_t cmd, const uint8_t *args)
+{
+    switch (cmd)
+    {
+    case 0xAE:
+    case 0xAF:
+        if (oled.on != (cmd == 0xAF))
+        {
+            oled.on = cmd == 0xAF;
+            oled.power_changes++;
+            SIM_TRACE("oled %s", oled.on ? "ligado" : "desligado");
+        }
+        break;
+    case 0x20:
+        oled.mode = args[0] & 3;
+        break;
+    case 0x21:
+        oled.col_lo = oled.col = args[0] & 0x7F;
+        oled.col_hi = args[1] & 0x7F;
+        break;
+    case 0x22:
+        oled.page_lo = oled.page = args[0] & 7;
+        oled.page_hi = args[1] & 7;
+        break;
+    default:
+        // Endereços do modo por página
+        if (oled.mode == 2 && cmd <= 0x0F)
+            oled.col = (oled.col & 0xF0) | cmd;
+        else if (oled.mode == 2 && cmd >= 0x10 && cmd <= 0x1F)
+            oled.col = (uint8_t)((oled.col & 0x0F) | ((cmd & 0x07) << 4));
+        else if (oled.mode == 2 && cmd >= 0xB0 && cmd <= 0xB7)
+            oled.page = cmd & 7;
+        break;
+    }
+}
+
+static void command_byte(uint8_t b)
+{
+    if (oled.nargs < oled.want)
+    {
+        oled.args[oled.nargs++] = b;
+        if (oled.nargs == oled.want)
+            run_command(oled.cmd, oled.args);
+        return;
+    }
+    oled.cmd = b;
+    oled.nargs = 0;
+    oled.want = arg_count(b);
+    if (!oled.want)
+        run_command(b, NULL);
+}
+
+static void data_byte(uint8_t b)
+{
+    oled.ram[oled.page & 7][oled.col & 0x7F] = b;
+    oled.data_bytes++;
+    switch (oled.mode)
+    {
+    case 0: // Horizontal: coluna, depois página
+        if (oled.col++ >= oled.col_hi)
+        {
+            oled.col = oled.col_lo;
+            oled.page = oled.page >= oled.page_hi ? oled.page_lo : oled.page + 1;
+        }
+        break;
+    case 1: // Vertical: página, depois coluna
+        if (oled.page++ >= oled.page_hi)
+        {
+            oled.page = oled.page_lo;
+            oled.col = oled.col >= oled.col_hi ? oled.col_lo : oled.col + 1;
+        }
+        break;
+    default:
+        oled.col = (oled.col + 1) & 0x7F;
+        break;
+    }
+}
+
+// Byte de controle: Co=1 vale só para o próximo byte; Co=0 vale para o resto
+// da transação. D/C escolhe entre comando e dado.
+static int ssd1306_write(sim_i2c_dev_t *dev, const uint8_t *src, size_t len)
+{
+    oled.transactions++;
+    size_t i = 0;
+    while (i < len)
+    {
+        uint8_t control = src[i++];
+        bool data = control & 0x40;
+        if (control & 0x80)
+        {
+            if (i < len)
+                data ? data_byte(src[i++]) : command_byte(src[i++]);
+            continue;
+        }
+        for (; i < len; i++)
+            data ? data_byte(src[i]) : command_byte(src[i]);
+    }
+    return (int)len;
+}
+
+void sim_ssd1306_attach(sim_i2c_dev_t *dev)
+{
+    dev->write = ssd1306_write;
+    dev->read = NULL;
+}
+
+static bool pixel(uint x, uint y)
+{
+    return oled.ram[y / 8][x] & (1u << (y % 8));
+}
+
+uint8_t sim_ssd1306_ram(uint page, uint col)
+{
+    return oled.ram[page & 7][col & 0x7F];
+}
+
+void sim_ssd1306_dump_ascii(FILE *out)
+{
+    // Cada caractere cobre uma coluna e duas linhas (meios blocos em UTF-8)
+    static const char *const HALVES[4] = {" ", "\u2580", "\u2584", "\u2588"};
+    fprintf(out, "+");
+    for (uint x = 0; x < COLS; x++)
+        fputc('-', out);
+    fprintf(out, "+ oled %s\n", oled.on ? "ligado" : "desligado");
+    for (uint y = 0; y < PAGES * 8; y += 2)
+    {
+        fputc('|', out);
+        for (uint x = 0; x < COLS; x++)
+            fputs(HALVES[pixel(x, y) | pixel(x, y + 1) << 1], out);
+        fprintf(out, "|\n");
+    }
+    fprintf(out, "+");
+    for (uint x = 0; x < COLS; x++)
+        fputc('-', out);
+    fprintf(out, "+\n");
+}
+
+bool sim_ssd1306_write_pbm(const char *path)
+{
+    FILE *f = fopen(path, "wb");
+    if (!f)
+        return false;
+    fprintf(f, "P4\n%d %d\n", COLS, PAGES * 8);
+    for (uint y = 0; y < PAGES * 8; y++)
+    {
+        for (uint x = 0; x < COLS; x += 8)
+        {
+            uint8_t b = 0;
+            for (uint i = 0; i < 8; i++)
+                b |= (uint8_t)(pixel(x + i, y) << (7 - i));
+            fputc(b, f);
+        }
+    }
+    return fclose(f) == 0;
+}
+
+void sim_ssd1306_report(FILE *out)
+{
+    fprintf(out, "  oled: %lu transações, %lu bytes de dados, %lu trocas de energia\n",
+            (unsigned long)oled.transactions, (unsigned long)oled.data_bytes, (unsigned long)oled.power_changes);
+}
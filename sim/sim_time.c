@@ -0,0 +1,438 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdarg.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "hardware/watchdog.h"
+#include "pico/stdlib.h"
+#include "sim.h"
+
+// Relógio virtual: só anda nas esperas do firmware (sleep_*, WFE), no custo
+// modelado dos periféricos bloqueantes (I2C, flash) e em 1 us por leitura, o
+// que evita laços presos esperando o tempo passar. Alarmes do SDK e eventos do
+// simulador disparam no instante agendado, na ordem em que foram criados.
+
+#define MAX_ENTRIES 128
+#define CLOCK_READ_US 1
+// Espera máxima por atividade de rede antes de olhar os sinais de novo
+#define PACE_SLICE_MS 100
+
+typedef struct
+{
+    bool used;
+    uint64_t t;
+    uint64_t seq;
+    alarm_id_t id; // 0: evento interno
+    alarm_callback_t callback;
+    void *user_data;
+    sim_event_fn event;
+    void *arg;
+} entry_t;
+
+static entry_t entries[MAX_ENTRIES];
+static uint64_t next_seq;
+static alarm_id_t next_id = 1;
+static uint64_t now_us;
+static bool irq_enabled = true;
+static bool irq_fired;
+
+// Correspondência entre o relógio virtual e o do host no modo em tempo real
+static uint64_t pace_virtual_us;
+static uint64_t pace_host_us;
+
+// Prazo do watchdog; 0 = desligado
+static uint64_t watchdog_deadline_us;
+static uint64_t watchdog_delay_us;
+
+static gpio_irq_callback_t gpio_callback;
+static uint32_t gpio_irq_mask[32];
+static bool gpio_level[32];
+static bool gpio_output[32];
+
+static uint64_t host_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000u + (uint64_t)ts.tv_nsec / 1000u;
+}
+
+void sim_time_init(void)
+{
+    now_us = 0;
+    pace_virtual_us = 0;
+    pace_host_us = host_us();
+    for (uint i = 0; i < 32; i++)
+        gpio_level[i] = true;
+}
+
+void sim_log(const char *fmt, ...)
+{
+    va_list ap;
+    va_start(ap, fmt);
+    fprintf(stderr, "[%12.6f] ", sim_world_us() / 1e6);
+    vfprintf(stderr, fmt, ap);
+    fputc('\n', stderr);
+    va_end(ap);
+}
+
+uint64_t sim_now_us(void)
+{
+    return now_us;
+}
+
+// O relógio passou do prazo do watchdog: a placa reinicia no instante do prazo
+static void check_watchdog(void)
+{
+    if (watchdog_deadline_us && now_us >= watchdog_deadline_us)
+    {
+        now_us = watchdog_deadline_us;
+        sim_reboot();
+    }
+}
+
+void sim_spend_us(uint64_t us)
+{
+    now_us += us;
+    check_watchdog();
+}
+
+void watchdog_enable(uint32_t delay_ms, bool pause_on_debug)
+{
+    watchdog_delay_us = (uint64_t)delay_ms * 1000;
+    watchdog_update();
+}
+
+void watchdog_update(void)
+{
+    if (watchdog_delay_us)
+        watchdog_deadline_us = now_us + watchdog_delay_us;
+}
+
+void sim_note_irq(void)
+{
+    irq_fired = true;
+}
+
+bool sim_irqs_enabled(void)
+{
+    return irq_enabled;
+}
+
+static entry_t *new_entry(uint64_t t)
+{
+    for (uint i = 0; i < MAX_ENTRIES; i++)
+    {
+        if (!entries[i].used)
+        {
+            entries[i] = (entry_t){.used = true, .t = t, .seq = next_seq++};
+            return &entries[i];
+        }
+    }
+    return NULL;
+}
+
+static entry_t *earliest(void)
+{
+    entry_t *best = NULL;
+    for (uint i = 0; i < MAX_ENTRIES; i++)
+    {
+        entry_t *e = &entries[i];
+        if (e->used && (!best || e->t < best->t || (e->t == best->t && e->seq < best->seq)))
+            best = e;
+    }
+    return best;
+}
+
+void sim_schedule(uint64_t t_us, sim_event_fn fn, void *arg)
+{
+    entry_t *e = new_entry(t_us);
+    if (!e)
+    {
+        sim_log("fila de eventos cheia");
+        sim_exit(1);
+    }
+    e->event = fn;
+    e->arg = arg;
+}
+
+// Dispara tudo o que venceu até agora, como as interrupções do timer
+static void fire_due(void)
+{
+    entry_t *e;
+    while (irq_enabled && (e = earliest()) && e->t <= now_us)
+    {
+        entry_t fired = *e;
+        e->used = false;
+        if (!fired.id)
+        {
+            fired.event(fired.arg);
+            continue;
+        }
+        int64_t ret = fired.callback(fired.id, fired.user_data);
+        irq_fired = true;
+        if (ret == 0)
+            continue;
+        // < 0: a partir do instante agendado anterior; > 0: a partir de agora
+        entry_t *again = new_entry(ret < 0 ? fired.t + (uint64_t)(-ret) : now_us + (uint64_t)ret);
+        if (again)
+        {
+            again->id = fired.id;
+            again->callback = fired.callback;
+            again->user_data = fired.user_data;
+        }
+    }
+}
+
+// No modo em tempo real, espera o host alcançar o instante virtual t atendendo
+// a rede. Se algum callback rodou antes disso, o relógio virtual vai para o
+// instante correspondente e a função retorna false.
+static bool pace_until(uint64_t t)
+{
+    if (sim_opts.speed <= 0)
+        return true;
+    for (;;)
+    {
+        sim_check_signals();
+        uint64_t deadline = pace_host_us + (uint64_t)((t - pace_virtual_us) / sim_opts.speed);
+        uint64_t host = host_us();
+        if (host >= deadline)
+            return true;
+        uint64_t wait_ms = (deadline - host + 999) / 1000;
+        if (sim_net_pump((int)MIN(wait_ms, PACE_SLICE_MS)))
+        {
+            uint64_t at = pace_virtual_us + (uint64_t)((host_us() - pace_host_us) * sim_opts.speed);
+            if (at > now_us)
+                now_us = MIN(at, t);
+            return false;
+        }
+    }
+}
+
+static void check_end(void)
+{
+    sim_check_signals();
+    check_watchdog();
+    if (sim_opts.duration_s > 0 && sim_world_us() >= (uint64_t)(sim_opts.duration_s * 1e6))
+        sim_exit(0);
+}
+
+// Avança até t. Com wake_on_irq, volta antes (false) quando algum callback do
+// firmware rodou, como o WFE acordado por uma interrupção.
+static bool wait_until(uint64_t t, bool wake_on_irq)
+{
+    irq_fired = false;
+    for (;;)
+    {
+        check_end();
+        if (irq_enabled)
+        {
+            fire_due();
+            sim_net_pump(0);
+        }
+        if (wake_on_irq && irq_fired)
+            return false;
+        if (now_us >= t)
+            return true;
+
+        uint64_t step = t;
+        entry_t *next = earliest();
+        if (irq_enabled && next && next->t < step)
+            step = MAX(next->t, now_us);
+        if (watchdog_deadline_us && watchdog_deadline_us < step)
+            step = MAX(watchdog_deadline_us, now_us);
+        if (!pace_until(step))
+            continue;
+        now_us = MAX(now_us, step);
+    }
+}
+
+uint64_t time_us_64(void)
+{
+    now_us += CLOCK_READ_US;
+    check_watchdog();
+    return now_us;
+}
+
+uint32_t time_us_32(void)
+{
+    return (uint32_t)time_us_64();
+}
+
+void sleep_until(absolute_time_t t)
+{
+    wait_until(t, false);
+}
+
+void sleep_us(uint64_t us)
+{
+    wait_until(now_us + us, false);
+}
+
+void sleep_ms(uint32_t ms)
+{
+    sleep_us((uint64_t)ms * 1000);
+}
+
+bool best_effort_wfe_or_timeout(absolute_time_t t)
+{
+    return wait_until(t, true);
+}
+
+alarm_id_t add_alarm_at(absolute_time_t t, alarm_callback_t callback, void *user_data, bool fire_if_past)
+{
+    // Instante já passado: dispara na próxima oportunidade (o SDK chamaria na hora)
+    if (t <= now_us && !fire_if_past)
+        return 0;
+    entry_t *e = new_entry(MAX(t, now_us));
+    if (!e)
+        return -1;
+    e->id = next_id++;
+    if (next_id <= 0)
+        next_id = 1;
+    e->callback = callback;
+    e->user_data = user_data;
+    return e->id;
+}
+
+alarm_id_t add_alarm_in_us(uint64_t us, alarm_callback_t callback, void *user_data, bool fire_if_past)
+{
+    return add_alarm_at(now_us + us, callback, user_data, fire_if_past);
+}
+
+alarm_id_t add_alarm_in_ms(uint32_t ms, alarm_callback_t callback, void *user_data, bool fire_if_past)
+{
+    return add_alarm_in_us((uint64_t)ms * 1000, callback, user_data, fire_if_past);
+}
+
+bool cancel_alarm(alarm_id_t id)
+{
+    for (uint i = 0; i < MAX_ENTRIES; i++)
+    {
+        if (entries[i].used && entries[i].id == id && id != 0)
+        {
+            entries[i].used = false;
+            return true;
+        }
+    }
+    return false;
+}
+
+// Mesma semântica do SDK: atraso > 0 conta do fim do callback, < 0 do início
+static int64_t repeating_timer_callback(alarm_id_t id, void *user_data)
+{
+    repeating_timer_t *rt = (repeating_timer_t *)user_data;
+    if (rt->callback(rt))
+        return rt->delay_us;
+    rt->alarm_id = 0;
+    return 0;
+}
+
+bool add_repeating_timer_us(int64_t delay_us, repeating_timer_callback_t callback, void *user_data, repeating_timer_t *out)
+{
+    out->delay_us = delay_us;
+    out->callback = callback;
+    out->user_data = user_data;
+    out->alarm_id = add_alarm_in_us((uint64_t)(delay_us < 0 ? -delay_us : delay_us), repeating_timer_callback, out, true);
+    return out->alarm_id > 0;
+}
+
+bool cancel_repeating_timer(repeating_timer_t *timer)
+{
+    bool ok = timer->alarm_id && cancel_alarm(timer->alarm_id);
+    timer->alarm_id = 0;
+    return ok;
+}
+
+uint32_t save_and_disable_interrupts(void)
+{
+    uint32_t status = irq_enabled;
+    irq_enabled = false;
+    return status;
+}
+
+void restore_interrupts(uint32_t status)
+{
+    irq_enabled = status != 0;
+}
+
+void gpio_init(uint gpio)
+{
+    gpio_output[gpio & 31] = false;
+    gpio_level[gpio & 31] = true;
+}
+
+void gpio_set_dir(uint gpio, bool out)
+{
+    gpio_output[gpio & 31] = out;
+}
+
+void gpio_put(uint gpio, bool value)
+{
+    gpio &= 31;
+    if (gpio_output[gpio] && gpio_level[gpio] != value)
+        SIM_TRACE("gpio %u = %d", gpio, value);
+    gpio_level[gpio] = value;
+}
+
+bool gpio_get(uint gpio)
+{
+    return gpio_level[gpio & 31];
+}
+
+void gpio_pull_up(uint gpio)
+{
+    if (!gpio_output[gpio & 31])
+        gpio_level[gpio & 31] = true;
+}
+
+void gpio_set_function(uint gpio, enum gpio_function fn)
+{
+    (void)gpio;
+    (void)fn;
+}
+
+void gpio_set_irq_enabled(uint gpio, uint32_t events, bool enabled)
+{
+    if (enabled)
+        gpio_irq_mask[gpio & 31] |= events;
+    else
+        gpio_irq_mask[gpio & 31] &= ~events;
+}
+
+void gpio_set_irq_enabled_with_callback(uint gpio, uint32_t events, bool enabled, gpio_irq_callback_t callback)
+{
+    gpio_set_irq_enabled(gpio, events, enabled);
+    gpio_callback = callback;
+}
+
+static void gpio_edge(uint gpio, bool level)
+{
+    uint32_t event = level ? GPIO_IRQ_EDGE_RISE : GPIO_IRQ_EDGE_FALL;
+    gpio_level[gpio] = level;
+    if (gpio_callback && (gpio_irq_mask[gpio] & event))
+    {
+        gpio_callback(gpio, event);
+        irq_fired = true;
+    }
+}
+
+static void gpio_release(void *arg)
+{
+    gpio_edge((uint)(uintptr_t)arg, true);
+}
+
+// Botão com pull-up: desce agora e volta 100 ms depois
+void sim_gpio_press(unsigned gpio)
+{
+    gpio &= 31;
+    SIM_TRACE("botão no gpio %u", gpio);
+    gpio_edge(gpio, false);
+    sim_schedule(now_us + 100000, gpio_release, (void *)(uintptr_t)gpio);
+}
+
+bool stdio_init_all(void)
+{
+    setvbuf(stdout, NULL, _IOLBF, 0);
+    return true;
+}
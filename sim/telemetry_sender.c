@@ -0,0 +1,87 @@
+#include <stdlib.h>
+
+#include "sim.h"
+#include "pico/cyw43_arch.h"
+#include "hardware/i2c.h"
+#include "sensors.h"
+#include "bmp280.h"
+#include "aht20.h"
+#include "telemetry.h"
+
+// Emissor da telemetria UDP (lib/telemetry.c) para a verificação de ida e
+// volta em tools/telemetry_loopback.py: os canais do BMP280 e do AHT20 da
+// placa simulada, leituras de todos eles a rate_hz por duração segundos
+// virtuais, com valores que o receptor recalcula a partir do canal e do ts.
+// A rede simulada entrega os datagramas de verdade no host.
+//
+//   telemetry_sender porta [rate_hz] [segundos] [velocidade]
+//
+// Ao sair, imprime uma linha JSON com o que foi enviado.
+
+#define DEVICE_ID 0x4D4F4E31
+#define LOOP_MS 250 // Volta do laço principal do firmware
+
+// O mesmo cálculo está no receptor da verificação
+static float sample_value(uint channel, uint32_t ts)
+{
+    return (float)(channel * 100) + (float)(ts % 100000) / 1000.0f;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 2)
+    {
+        fprintf(stderr, "uso: %s porta [rate_hz] [segundos] [velocidade]\n", argv[0]);
+        return 2;
+    }
+    uint16_t port = (uint16_t)atoi(argv[1]);
+    double rate_hz = argc > 2 ? atof(argv[2]) : 1.0;
+    double seconds = argc > 3 ? atof(argv[3]) : 10.0;
+    sim_opts.speed = argc > 4 ? atof(argv[4]) : 0.0;
+    sim_time_init();
+
+    sim_i2c_init();
+    i2c_init(i2c0, 400 * 1000);
+    sensors_add(SENSOR_BMP280, i2c0, BMP280_I2C_ADDR, SENSOR_NO_MUX, 0);
+    sensors_add(SENSOR_AHT20, i2c0, AHT20_I2C_ADDR, SENSOR_NO_MUX, 0);
+    uint channels = sensors_channel_count();
+
+    cyw43_arch_enable_sta_mode();
+    cyw43_arch_wifi_connect_async("sim", "sim", CYW43_AUTH_WPA2_AES_PSK);
+    while (cyw43_tcpip_link_status(&cyw43_state, CYW43_ITF_STA) != CYW43_LINK_UP)
+        sleep_ms(10);
+    if (!telemetry_init(DEVICE_ID))
+        return 2;
+    telemetry_set_destination(0x7F000001, port);
+
+    // Leituras na agenda do relógio virtual, a partir de ts 0, e o
+    // telemetry_task a cada volta do laço, como no main.c
+    uint64_t interval_us = (uint64_t)(1e6 / rate_hz);
+    uint64_t start_us = sim_now_us(), next_tick_us = start_us;
+    uint64_t readings = (uint64_t)(seconds * rate_hz);
+    uint32_t ts = 0;
+    for (uint64_t r = 0; r < readings; r++)
+    {
+        uint64_t at_us = start_us + r * interval_us;
+        for (; next_tick_us < at_us; next_tick_us += LOOP_MS * 1000)
+        {
+            sleep_until(next_tick_us);
+            telemetry_task((uint32_t)((next_tick_us - start_us) / 1000));
+        }
+        sleep_until(at_us);
+        ts = (uint32_t)(r * interval_us / 1000);
+        for (uint c = 0; c < channels; c++)
+            telemetry_add_sample((uint8_t)c, ts, sample_value(c, ts));
+        telemetry_task(ts);
+    }
+    // Esvazia o último lote
+    telemetry_task(ts + TELEMETRY_BATCH_MS);
+
+    telemetry_stats_t st;
+    telemetry_get_stats(&st);
+    printf("{\"device\":%lu,\"channels\":%u,\"rate_hz\":%.1f,\"readings\":%llu,\"datagrams\":%lu,\"samples\":%lu,"
+           "\"send_errors\":%lu}\n",
+           (unsigned long)DEVICE_ID, channels, rate_hz, (unsigned long long)readings, (unsigned long)st.datagrams,
+           (unsigned long)st.samples, (unsigned long)st.send_errors);
+    return st.send_errors ? 1 : 0;
+}
@@ -0,0 +1,291 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "sim.h"
+#include "sensors.h"
+#include "sensor_trace.h"
+#include "alarm_rules.h"
+#include "settings.h"
+
+// Reprodução no host de um traço de sensores gravado na placa (lib/sensor_trace.h):
+// as leituras brutas passam pela compensação, pelos offsets e pelas regras de
+// alarme do firmware, na velocidade do host, e cada avaliação é comparada com
+// a máscara que a placa calculou. Termina com status 1 se alguma divergir.
+//
+//   curl -o trace.bin http://<placa>/trace.bin          (traço da flash)
+//   cat /dev/ttyACM0 > captura.txt                       (traço pelo USB, linhas "@st")
+//   trace_replay [-q] [-n repetições] trace.bin|captura.txt
+
+static settings_t settings;
+
+typedef struct
+{
+    uint32_t records;
+    uint32_t evals;
+    uint32_t transitions;
+    uint32_t mismatches;
+    uint32_t unknown;
+} replay_stats_t;
+
+static uint8_t *read_file(const char *path, size_t *len)
+{
+    FILE *f = fopen(path, "rb");
+    if (!f)
+        return NULL;
+    size_t cap = 1 << 16, n = 0;
+    uint8_t *buf = malloc(cap);
+    size_t got;
+    while (buf && (got = fread(buf + n, 1, cap - n, f)) > 0)
+    {
+        n += got;
+        if (n == cap)
+            buf = realloc(buf, cap *= 2);
+    }
+    fclose(f);
+    *len = n;
+    return buf;
+}
+
+static int hex_value(char c)
+{
+    if (c >= '0' && c <= '9')
+        return c - '0';
+    if (c >= 'a' && c <= 'f')
+        return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F')
+        return c - 'A' + 10;
+    return -1;
+}
+
+// Captura do USB: junta o conteúdo das linhas "@st <hex>" e ignora o resto da saída
+static size_t decode_capture(uint8_t *buf, size_t len)
+{
+    size_t out = 0, i = 0;
+    while (i < len)
+    {
+        size_t end = i;
+        while (end < len && buf[end] != '\n')
+            end++;
+        if (end - i > 4 && memcmp(buf + i, "@st ", 4) == 0)
+        {
+            for (size_t j = i + 4; j + 1 < end; j += 2)
+            {
+                int hi = hex_value((char)buf[j]), lo = hex_value((char)buf[j + 1]);
+                if (hi < 0 || lo < 0)
+                    break;
+                buf[out++] = (uint8_t)(hi << 4 | lo);
+            }
+        }
+        i = end + 1;
+    }
+    return out;
+}
+
+static void current_offsets(float offsets[CHANNEL_KIND_COUNT])
+{
+    // Os mesmos offsets que o laço principal passa para sensors_poll
+    memset(offsets, 0, CHANNEL_KIND_COUNT * sizeof(float));
+    offsets[CHANNEL_TEMPERATURE] = settings.temp_offset;
+    offsets[CHANNEL_PRESSURE] = settings.pressure_offset_kpa;
+}
+
+static void print_transition(uint32_t ts, alarm_mask_t before, alarm_mask_t after)
+{
+    printf("%10lu ms ", (unsigned long)ts);
+    for (uint i = 0; i < alarms_rule_count(); i++)
+    {
+        alarm_mask_t bit = (alarm_mask_t)1 << i;
+        if ((before ^ after) & bit)
+        {
+            const alarm_rule_t *rule = alarms_rule(i);
+            const sensor_channel_t *ch = sensors_channel(rule->channel);
+            printf(" %c%s:%s(%s)", after & bit ? '+' : '-', sensors_instance(ch->instance)->label,
+                   sensors_kind_name(ch->kind), rule->type == ALARM_RULE_RATE ? "taxa" : "faixa");
+        }
+    }
+    printf("\n");
+}
+
+// As regras só dependem dos canais: montadas quando as instâncias estão completas
+static void ensure_rules(bool *ready)
+{
+    if (!*ready)
+    {
+        alarm_rules_register(&settings);
+        *ready = true;
+    }
+}
+
+static bool replay(const uint8_t *buf, size_t len, bool quiet, replay_stats_t *st)
+{
+    settings_reset(&settings);
+    alarm_rules_register(&settings);
+    alarm_mask_t last = 0;
+    bool rules_ready = sensors_instance_count() > 0;
+
+    size_t pos = SENSOR_TRACE_HEADER_SIZE;
+    sensor_trace_record_t rec;
+    int n;
+    float offsets[CHANNEL_KIND_COUNT];
+    while ((n = sensor_trace_next(buf + pos, len - pos, &rec)) > 0)
+    {
+        pos += (size_t)n;
+        st->records++;
+        const uint8_t *p = rec.payload;
+        switch (rec.type)
+        {
+        case TRACE_INSTANCE:
+            // Nas repetições as instâncias já existem, com os mesmos índices
+            if (p[0] == sensors_instance_count() &&
+                !sensors_replay_add((sensor_type_t)p[1], p[2], p[3], p[4]))
+            {
+                fprintf(stderr, "instância %u não cabe no registro\n", p[0]);
+                return false;
+            }
+            rules_ready = false;
+            break;
+        case TRACE_CALIB:
+        {
+            struct bmp280_calib_param calib;
+            sensor_trace_unpack_calib(p, &calib);
+            sensors_replay_calib(p[0], &calib);
+            break;
+        }
+        case TRACE_BMP280:
+        {
+            int32_t raw_temp, raw_press;
+            sensor_trace_unpack_bmp280(p, &raw_temp, &raw_press);
+            current_offsets(offsets);
+            sensors_replay_bmp280(p[0], raw_temp, raw_press, offsets);
+            break;
+        }
+        case TRACE_AHT20:
+            current_offsets(offsets);
+            sensors_replay_aht20(p[0], p + 1, offsets);
+            break;
+        case TRACE_FAIL:
+            sensors_replay_fail(p[0]);
+            break;
+        case TRACE_SETTINGS:
+            for (uint i = 0; i < rec.len / sizeof(float) && i < settings_field_count(); i++)
+            {
+                float v;
+                memcpy(&v, p + i * sizeof(float), sizeof(v));
+                settings_set(&settings, i, v);
+            }
+            break;
+        case TRACE_CHANNEL:
+        {
+            float value;
+            memcpy(&value, p + 2, sizeof(value));
+            sensors_replay_channel(p[0], p[1] != 0, value);
+            break;
+        }
+        case TRACE_RULE:
+        {
+            ensure_rules(&rules_ready);
+            alarm_rule_t state = {.active = p[1] & 1, .has_ref = (p[1] >> 1) & 1, .streak = p[2]};
+            state.ref_ts = (uint32_t)p[3] | (uint32_t)p[4] << 8 | (uint32_t)p[5] << 16 | (uint32_t)p[6] << 24;
+            memcpy(&state.ref_value, p + 7, sizeof(float));
+            memcpy(&state.rate, p + 11, sizeof(float));
+            alarms_restore_rule(p[0], &state);
+            last = alarms_active();
+            break;
+        }
+        case TRACE_EVAL:
+        {
+            ensure_rules(&rules_ready);
+            alarm_mask_t expected = 0;
+            for (uint i = 0; i < 8; i++)
+                expected |= (alarm_mask_t)p[i] << (8 * i);
+            alarm_mask_t active = alarms_evaluate(rec.ts_ms);
+            st->evals++;
+            if (active != last)
+            {
+                st->transitions++;
+                if (!quiet)
+                    print_transition(rec.ts_ms, last, active);
+                last = active;
+            }
+            if (active != expected)
+            {
+                if (st->mismatches++ < 10)
+                    printf("%10lu ms  divergência: placa 0x%016llx, host 0x%016llx\n", (unsigned long)rec.ts_ms,
+                           (unsigned long long)expected, (unsigned long long)active);
+            }
+            break;
+        }
+        default:
+            st->unknown++;
+            break;
+        }
+    }
+    if (n < 0)
+        fprintf(stderr, "traço truncado em %zu bytes\n", pos);
+    return true;
+}
+
+static double host_ms(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+}
+
+int main(int argc, char **argv)
+{
+    bool quiet = false;
+    uint repeat = 1;
+    int arg = 1;
+    for (; arg < argc && argv[arg][0] == '-'; arg++)
+    {
+        if (strcmp(argv[arg], "-q") == 0)
+            quiet = true;
+        else if (strcmp(argv[arg], "-n") == 0 && arg + 1 < argc)
+            repeat = (uint)atoi(argv[++arg]);
+        else
+            break;
+    }
+    if (arg != argc - 1 || repeat == 0)
+    {
+        fprintf(stderr, "uso: %s [-q] [-n repetições] traço.bin|captura.txt\n", argv[0]);
+        return 2;
+    }
+
+    size_t len;
+    uint8_t *buf = read_file(argv[arg], &len);
+    if (!buf)
+    {
+        fprintf(stderr, "não foi possível ler %s\n", argv[arg]);
+        return 2;
+    }
+    if (!sensor_trace_check_header(buf, len))
+        len = decode_capture(buf, len);
+    if (!sensor_trace_check_header(buf, len))
+    {
+        fprintf(stderr, "%s: não é um traço versão %d\n", argv[arg], SENSOR_TRACE_VERSION);
+        return 2;
+    }
+
+    sim_time_init();
+    replay_stats_t st = {0};
+    double start = host_ms();
+    for (uint i = 0; i < repeat; i++)
+    {
+        if (!replay(buf, len, quiet || i > 0, &st))
+            return 2;
+    }
+    double elapsed = host_ms() - start;
+
+    fprintf(stderr, "%lu registros, %lu avaliações, %lu transições em %.1f ms (%.0f registros/s)",
+            (unsigned long)st.records, (unsigned long)st.evals, (unsigned long)st.transitions, elapsed,
+            elapsed > 0 ? st.records / (elapsed / 1e3) : 0.0);
+    if (st.unknown)
+        fprintf(stderr, "; %lu registros de tipo desconhecido", (unsigned long)st.unknown);
+    fprintf(stderr, "\n%s\n", st.mismatches ? "DECISÕES DIVERGENTES" : "decisões idênticas às da placa");
+    free(buf);
+    return st.mismatches ? 1 : 0;
+}
@@ -0,0 +1,146 @@
+#!/usr/bin/env python3
+"""Teste dos eventos de alarme do firmware contra um coletor UDP local.
+
+O emissor é o lib/alarm_events.c rodando no simulador
+(sim/alarm_events_sender.c); o coletor fica neste script e responde
+`ACK <seq>` na tentativa escolhida em cada cenário, ou nunca. Confere o JSON
+de cada datagrama (campos, boot, seq, ts, regra, disparo e limpeza
+alternados), que os reenvios são cópias idênticas, o intervalo entre as
+tentativas (dobrando de 250 ms até 30 s), o limite de 10 tentativas e a
+contagem de eventos confirmados e descartados do dispositivo. Termina com
+status 1 se algo falhar.
+
+    python3 tools/alarm_events_collector_test.py --sender build-sim/sim/alarm_events_sender
+"""
+import argparse
+import json
+import socket
+import subprocess
+import sys
+import time
+
+CAPACITY = 64
+RETRY_MIN_MS = 250
+RETRY_MAX_MS = 30000
+MAX_ATTEMPTS = 10
+# Desvio aceito no intervalo entre tentativas: ms do dispositivo mais o atraso
+# do host (em ms do host), que a velocidade do simulador multiplica
+GAP_TOLERANCE_MS = 100
+HOST_JITTER_MS = 10
+FIELDS = ["boot", "seq", "ts", "event", "type", "rule", "ch", "kind", "sensor", "value", "threshold"]
+
+# (nome, eventos, intervalo em ms, velocidade do simulador, ACK na tentativa n; 0: nunca)
+SCENARIOS = [
+    ("coletor confirma", 20, 1000, 20, 1),
+    ("confirmação na 4ª tentativa", 10, 2000, 5, 4),
+    ("confirmação na última tentativa", 3, 5000, 40, 10),
+    ("coletor mudo", 4, 5000, 40, 0),
+    ("registro cheio", 100, 250, 40, 0),
+]
+
+
+def expected_gap_ms(attempt):
+    """Intervalo entre a tentativa attempt e a seguinte, como no alarm_events.c."""
+    return min(RETRY_MIN_MS << (attempt - 1), RETRY_MAX_MS) if attempt <= 8 else RETRY_MAX_MS
+
+
+def run(sender, name, events, interval_ms, speed, ack_on):
+    sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM, socket.IPPROTO_UDP)
+    sock.bind(("127.0.0.1", 0))
+    sock.settimeout(0.2)
+    port = sock.getsockname()[1]
+
+    proc = subprocess.Popen([sender, str(port), str(events), str(interval_ms), str(speed)],
+                            stdout=subprocess.PIPE, stderr=subprocess.DEVNULL, text=True)
+    received = {}  # seq -> [(instante do host, datagrama)]
+    datagrams = 0
+    errors = []
+    while True:
+        try:
+            data, addr = sock.recvfrom(512)
+        except socket.timeout:
+            if proc.poll() is not None:
+                break
+            continue
+        datagrams += 1
+        try:
+            msg = json.loads(data)
+            seq = msg["seq"]
+        except (ValueError, KeyError, TypeError):
+            errors.append(f"datagrama inválido: {data[:60]!r}")
+            continue
+        copies = received.setdefault(seq, [])
+        copies.append((time.monotonic(), data))
+        if len(copies) == ack_on:
+            sock.sendto(f"ACK {seq}".encode(), addr)
+    sent = json.loads(proc.stdout.read() or "{}")
+    sock.close()
+    if proc.returncode != 0:
+        errors.append(f"emissor terminou com status {proc.returncode} ({sent.get('pending')} eventos pendentes)")
+
+    # Formato e conteúdo: o ts e a regra saem da agenda do emissor
+    rules = sent.get("rules", [])
+    if sorted(received) != list(range(1, events + 1)):
+        errors.append(f"seqs recebidos: {sorted(received)[:10]}...")
+    for seq, copies in sorted(received.items()):
+        msg = json.loads(copies[0][1])
+        if list(msg) != FIELDS:
+            errors.append(f"seq {seq}: campos {list(msg)}")
+            continue
+        rule = (seq - 1) % len(rules) if rules else 0
+        toggles = (seq - 1) // len(rules) if rules else 0
+        want = dict(rules[rule]) if rules else {}
+        want.update(boot=sent.get("boot"), ts=(seq - 1) * interval_ms, rule=rule,
+                    event="raise" if toggles % 2 == 0 else "clear")
+        wrong = {k: msg[k] for k, v in want.items() if msg[k] != v}
+        if wrong:
+            errors.append(f"seq {seq}: {wrong}, esperava {want}")
+        if not all(isinstance(msg[k], (int, float)) for k in ("value", "threshold")):
+            errors.append(f"seq {seq}: value/threshold {msg['value']!r} {msg['threshold']!r}")
+        if any(data != copies[0][1] for _, data in copies):
+            errors.append(f"seq {seq}: reenvio diferente do original")
+
+    # Tentativas por evento e o intervalo entre elas, no relógio do dispositivo
+    overwritten = events > CAPACITY and not ack_on
+    worst = 0
+    for seq, copies in sorted(received.items()):
+        want = ack_on or MAX_ATTEMPTS
+        if len(copies) != want and not (overwritten and 1 <= len(copies) <= MAX_ATTEMPTS):
+            errors.append(f"seq {seq}: {len(copies)} tentativas, esperava {want}")
+        if overwritten:
+            continue
+        for attempt in range(1, len(copies)):
+            gap = (copies[attempt][0] - copies[attempt - 1][0]) * speed * 1000
+            want_gap = expected_gap_ms(attempt)
+            worst = max(worst, abs(gap - want_gap))
+            if abs(gap - want_gap) > GAP_TOLERANCE_MS + HOST_JITTER_MS * speed:
+                errors.append(f"seq {seq}: {gap:.0f} ms entre as tentativas {attempt} e {attempt + 1}, "
+                              f"esperava {want_gap}")
+
+    # Contagem do dispositivo contra o que o coletor viu
+    acked = len(received) if ack_on else 0
+    stats = {"recorded": events, "sent": datagrams, "retries": datagrams - events, "acked": acked,
+             "dropped": events - acked, "send_errors": 0, "pending": 0}
+    wrong = {k: sent.get(k) for k, v in stats.items() if sent.get(k) != v}
+    if wrong:
+        errors.append(f"estatísticas {wrong}, esperava {stats}")
+
+    print(f"{name}: {len(received)} eventos em {datagrams} datagramas, {sent.get('acked')} confirmados, "
+          f"{sent.get('dropped')} descartados, maior desvio do intervalo de reenvio {worst:.0f} ms")
+    for e in errors[:5]:
+        print(f"  {e}", file=sys.stderr)
+    return not errors
+
+
+def main():
+    ap = argparse.ArgumentParser()
+    ap.add_argument("--sender", default="build-sim/sim/alarm_events_sender", help="executável do emissor")
+    args = ap.parse_args()
+
+    ok = all([run(args.sender, *scenario) for scenario in SCENARIOS])
+    print("eventos, confirmações e reenvios de acordo em todos os cenários" if ok else "FALHAS")
+    sys.exit(0 if ok else 1)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,67 @@
+#!/usr/bin/env python3
+"""Compara duas saídas do monitor_bench (uma linha JSON por kernel).
+
+Mostra a mediana e o mínimo de cada kernel nas duas rodadas e a razão
+depois/antes das medianas; com --threshold, termina com status 1 se algum
+kernel ficou mais lento que o limite.
+
+    ./build-sim/bench/monitor_bench > antes.jsonl
+    ... (muda o código e recompila)
+    ./build-sim/bench/monitor_bench > depois.jsonl
+    python3 tools/bench_compare.py antes.jsonl depois.jsonl --threshold 1.10
+"""
+import argparse
+import json
+import sys
+
+
+def load(path):
+    """Retorna (cabeçalho, {kernel: resultado}); ignora linhas que não são JSON."""
+    header, kernels = {}, {}
+    with open(path) as f:
+        for line in f:
+            try:
+                entry = json.loads(line)
+            except ValueError:
+                continue
+            if "kernel" in entry:
+                kernels[entry["kernel"]] = entry
+            elif "bench" in entry:
+                header = entry
+    return header, kernels
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("before")
+    parser.add_argument("after")
+    parser.add_argument("--threshold", type=float, default=0.0,
+                        help="razão máxima aceita entre as medianas (ex.: 1.10)")
+    args = parser.parse_args()
+
+    head_a, before = load(args.before)
+    head_b, after = load(args.after)
+    if head_a.get("platform") != head_b.get("platform"):
+        print(f"aviso: plataformas diferentes ({head_a.get('platform')} x {head_b.get('platform')})",
+              file=sys.stderr)
+
+    print(f"{'kernel':<26}{'mediana antes':>15}{'mediana depois':>16}{'mín depois':>12}{'razão':>8}")
+    slower = []
+    for name in list(before) + [k for k in after if k not in before]:
+        a, b = before.get(name), after.get(name)
+        if not a or not b:
+            print(f"{name:<26}{'(só em ' + ('antes' if a else 'depois') + ')':>51}")
+            continue
+        ratio = b["median_ns"] / a["median_ns"] if a["median_ns"] else float("inf")
+        print(f"{name:<26}{a['median_ns']:>12.1f} ns{b['median_ns']:>13.1f} ns{b['min_ns']:>9.1f} ns{ratio:>8.2f}")
+        if args.threshold and ratio > args.threshold:
+            slower.append(name)
+
+    if slower:
+        print(f"mais lentos que {args.threshold:.2f}x: {', '.join(slower)}", file=sys.stderr)
+        return 1
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
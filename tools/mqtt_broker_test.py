@@ -0,0 +1,274 @@
+#!/usr/bin/env python3
+"""Teste do cliente MQTT do firmware contra um broker MQTT 3.1.1 mínimo.
+
+O cliente é o lib/mqtt.c rodando no simulador (sim/mqtt_sender.c). O broker
+fica neste script e atende só o que o cliente usa: CONNECT com will,
+SUBSCRIBE, PUBLISH QoS 0 e 1, PINGREQ e DISCONNECT. Cada cenário confere o
+CONNECT, o status retido, o formato e o valor de cada amostra, a entrega de
+todas as amostras que o cliente deu como confirmadas, e o ajuste recebido em
+settings/set. Mostra as amostras/s que o dispositivo sustenta (no relógio
+dele) e, no cenário com queda do broker, a latência da reconexão. Termina com
+status 1 se algo falhar.
+
+    python3 tools/mqtt_broker_test.py --sender build-sim/sim/mqtt_sender
+
+Contra um mosquitto local, o mesmo cliente roda sozinho:
+    build-sim/sim/mqtt_sender 1883 5 60 1 & mosquitto_sub -t 'monitor/#' -v
+"""
+import argparse
+import json
+import selectors
+import socket
+import struct
+import subprocess
+import sys
+import time
+
+DEVICE = "4d4f4e31"
+BATCH_SAMPLES = 32
+SETTINGS_QUERY = "temp_max=35"
+
+# (nome, leituras/s, segundos virtuais, velocidade, amostras recebidas antes da queda, queda em s do host)
+SCENARIOS = [
+    ("1 leitura/s", 1, 30, 20, None, 0),
+    ("queda do broker", 5, 40, 10, 100, 0.5),
+    ("vazão máxima", 200, 10, 5, None, 0),
+]
+
+
+def sample_value(channel, ts):
+    """O mesmo cálculo do cliente (sample_value em sim/mqtt_sender.c)."""
+    return channel * 100 + (ts % 100000) / 1000.0
+
+
+def mqtt_string(body, pos):
+    (length,) = struct.unpack_from(">H", body, pos)
+    return body[pos + 2:pos + 2 + length].decode(), pos + 2 + length
+
+
+def packet(first_byte, body=b""):
+    header = bytearray([first_byte])
+    remaining = len(body)
+    while True:
+        digit, remaining = remaining % 128, remaining // 128
+        header.append(digit | (0x80 if remaining else 0))
+        if not remaining:
+            return bytes(header) + body
+
+
+class Broker:
+    """Uma conexão por vez; registra o que o cliente mandou."""
+
+    def __init__(self):
+        self.sel = selectors.DefaultSelector()
+        self.listener = self.conn = None
+        self.port = 0
+        self.listen()
+        self.buf = b""
+        self.errors = []
+        self.connects = []    # Instante (host) de cada CONNACK
+        self.reopened = None  # Instante em que o broker voltou da queda
+        self.status = []      # (mensagem, retido)
+        self.samples = {}     # (canal, ts) -> valor
+        self.duplicates = 0
+        self.publishes = 0
+        self.settings_sent = self.settings_acked = False
+
+    def listen(self):
+        self.listener = socket.socket(socket.AF_INET, socket.SOCK_STREAM)
+        self.listener.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
+        self.listener.bind(("127.0.0.1", self.port))
+        self.listener.listen(1)
+        self.port = self.listener.getsockname()[1]
+        self.sel.register(self.listener, selectors.EVENT_READ)
+
+    def go_down(self):
+        """Fecha a conexão e para de aceitar outras, como um broker reiniciando."""
+        self.close_conn()
+        self.sel.unregister(self.listener)
+        self.listener.close()
+        self.listener = None
+
+    def close_conn(self):
+        if self.conn:
+            self.sel.unregister(self.conn)
+            self.conn.close()
+            self.conn = None
+
+    def poll(self, timeout):
+        for key, _ in self.sel.select(timeout):
+            if key.fileobj is self.listener:
+                conn, _ = self.listener.accept()
+                self.close_conn()
+                self.conn, self.buf = conn, b""
+                self.sel.register(conn, selectors.EVENT_READ)
+            elif key.fileobj is self.conn:
+                data = self.conn.recv(65536)
+                if not data:
+                    self.close_conn()
+                    continue
+                self.buf += data
+                self.parse()
+
+    def parse(self):
+        while len(self.buf) >= 2:
+            remaining, multiplier, pos = 0, 1, 1
+            while True:
+                if pos >= len(self.buf):
+                    return
+                digit = self.buf[pos]
+                pos += 1
+                remaining += (digit & 0x7F) * multiplier
+                multiplier *= 128
+                if not digit & 0x80:
+                    break
+            if len(self.buf) < pos + remaining:
+                return
+            first, body = self.buf[0], self.buf[pos:pos + remaining]
+            self.buf = self.buf[pos + remaining:]
+            self.handle(first, body)
+            if not self.conn:
+                return
+
+    def send(self, data):
+        self.conn.sendall(data)
+
+    def handle(self, first, body):
+        kind = first >> 4
+        if kind == 1:
+            self.on_connect(body)
+        elif kind == 3:
+            self.on_publish(first, body)
+        elif kind == 4:
+            self.settings_acked = True
+        elif kind == 8:
+            (pid,) = struct.unpack_from(">H", body)
+            topic, pos = mqtt_string(body, 2)
+            if topic != f"monitor/{DEVICE}/settings/set" or first & 0x0F != 0x02:
+                self.errors.append(f"SUBSCRIBE inesperado: {topic}")
+            self.send(packet(0x90, struct.pack(">HB", pid, body[pos])))
+            if not self.settings_sent:
+                # Ajuste de configuração com QoS 1, como um mosquitto_pub -q 1
+                topic = f"monitor/{DEVICE}/settings/set".encode()
+                self.send(packet(0x32, struct.pack(">H", len(topic)) + topic + struct.pack(">H", 7)
+                                 + SETTINGS_QUERY.encode()))
+                self.settings_sent = True
+        elif kind == 12:
+            self.send(packet(0xD0))
+        elif kind == 14:
+            self.close_conn()
+        else:
+            self.errors.append(f"pacote inesperado do tipo {kind}")
+
+    def on_connect(self, body):
+        proto, pos = mqtt_string(body, 0)
+        level, flags = body[pos], body[pos + 1]
+        client_id, pos = mqtt_string(body, pos + 4)
+        will = None
+        if flags & 0x04:
+            will_topic, pos = mqtt_string(body, pos)
+            will_msg, pos = mqtt_string(body, pos)
+            will = (will_topic, will_msg, bool(flags & 0x20))
+        if proto != "MQTT" or level != 4 or not flags & 0x02:
+            self.errors.append(f"CONNECT: protocolo {proto} {level}, flags {flags:#x}")
+        if client_id != f"monitor-{DEVICE}":
+            self.errors.append(f"CONNECT: id {client_id}")
+        if will != (f"monitor/{DEVICE}/status", "offline", True):
+            self.errors.append(f"CONNECT: will {will}")
+        self.send(packet(0x20, b"\x00\x00"))
+        self.connects.append(time.monotonic())
+
+    def on_publish(self, first, body):
+        qos, retain = (first >> 1) & 3, bool(first & 1)
+        topic, pos = mqtt_string(body, 0)
+        if qos:
+            (pid,) = struct.unpack_from(">H", body, pos)
+            pos += 2
+            self.send(packet(0x40, struct.pack(">H", pid)))
+        payload = body[pos:].decode()
+        if topic == f"monitor/{DEVICE}/status":
+            self.status.append((payload, retain))
+            return
+        if topic != f"monitor/{DEVICE}/samples":
+            self.errors.append(f"PUBLISH em {topic}")
+            return
+        self.publishes += 1
+        if qos != 1:
+            self.errors.append(f"amostras com QoS {qos}")
+        try:
+            msg = json.loads(payload)
+        except ValueError:
+            self.errors.append(f"JSON inválido: {payload[:60]}")
+            return
+        if msg.get("dev") != DEVICE or not 1 <= len(msg.get("samples", [])) <= BATCH_SAMPLES:
+            self.errors.append(f"lote inválido: {payload[:60]}")
+        for ch, ts, value in msg.get("samples", []):
+            if abs(value - sample_value(ch, ts)) > 0.006:
+                self.errors.append(f"canal {ch} ts {ts}: valor {value}")
+            if (ch, ts) in self.samples:
+                self.duplicates += 1  # Reenvio de uma publicação sem PUBACK
+            self.samples[(ch, ts)] = value
+
+
+def run(sender, name, rate_hz, seconds, speed, drop_after, outage_s):
+    broker = Broker()
+    proc = subprocess.Popen([sender, str(broker.port), str(rate_hz), str(seconds), str(speed)],
+                            stdout=subprocess.PIPE, stderr=subprocess.DEVNULL, text=True)
+    reopen_at = None
+    while proc.poll() is None or broker.conn:
+        broker.poll(0.05)
+        if drop_after and broker.listener and not reopen_at and len(broker.samples) >= drop_after:
+            broker.go_down()
+            reopen_at = time.monotonic() + outage_s
+        if reopen_at and not broker.listener and time.monotonic() >= reopen_at:
+            broker.listen()
+            broker.reopened = time.monotonic()
+        if proc.poll() is not None and broker.conn:
+            broker.poll(0.2)
+            broker.close_conn()
+    sent = json.loads(proc.stdout.read() or "{}")
+    errors = broker.errors
+    if proc.returncode != 0:
+        errors.append(f"cliente terminou com status {proc.returncode} (fila: {sent.get('queued')})")
+
+    expected_connects = 2 if drop_after else 1
+    if sent.get("connects") != expected_connects or len(broker.connects) != expected_connects:
+        errors.append(f"{len(broker.connects)} conexões, o cliente contou {sent.get('connects')}")
+    if broker.status.count(("online", True)) != expected_connects:
+        errors.append(f"status: {broker.status}")
+    if len(broker.samples) != sent.get("samples_acked"):
+        errors.append(f"{len(broker.samples)} amostras no broker, {sent.get('samples_acked')} confirmadas no cliente")
+    generated = sent.get("readings", 0) * sent.get("channels", 0)
+    if len(broker.samples) + sent.get("samples_dropped", 0) != generated:
+        errors.append(f"{generated} amostras geradas, {len(broker.samples)} entregues e "
+                      f"{sent.get('samples_dropped')} descartadas")
+    if not broker.settings_acked or sent.get("settings") != "?" + SETTINGS_QUERY:
+        errors.append(f"settings/set: PUBACK {broker.settings_acked}, cliente recebeu {sent.get('settings')!r}")
+
+    elapsed_s = sent.get("elapsed_ms", 0) / 1000
+    line = (f"{name}: {len(broker.samples)} de {generated} amostras entregues "
+            f"({sent.get('samples_dropped')} descartadas com a fila cheia, {broker.duplicates} reenviadas) "
+            f"em {broker.publishes} publicações, "
+            f"{len(broker.samples) / elapsed_s if elapsed_s else 0:.0f} amostras/s do dispositivo")
+    if drop_after and broker.reopened and len(broker.connects) > 1:
+        back_ms = (broker.connects[-1] - broker.reopened) * speed * 1000
+        line += (f"; reconexão {sent.get('last_connect_ms')} ms depois da queda, "
+                 f"{back_ms:.0f} ms depois do broker voltar")
+    print(line)
+    for e in errors[:5]:
+        print(f"  {e}", file=sys.stderr)
+    return not errors
+
+
+def main():
+    ap = argparse.ArgumentParser()
+    ap.add_argument("--sender", default="build-sim/sim/mqtt_sender", help="executável do cliente")
+    args = ap.parse_args()
+
+    ok = all([run(args.sender, *scenario) for scenario in SCENARIOS])
+    print("cliente e broker de acordo em todos os cenários" if ok else "FALHAS")
+    sys.exit(0 if ok else 1)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,99 @@
+// Simulação no host da agenda do laço e do modelo de consumo, com relógio
+// virtual: mostra o ciclo de trabalho e a estimativa de mAh/dia de uma
+// configuração sem precisar da placa.
+//
+//   cc -O2 -Ilib tools/power_sim.c lib/duty_cycle.c lib/power.c -o power_sim
+//   ./power_sim [baixo_consumo 0|1] [intervalo_s] [dias]
+//
+// Os tempos de cada tarefa abaixo são os do firmware na placa (leitura dos
+// sensores com a conversão do AHT20, envio das páginas alteradas do OLED,
+// tarefas de rede); ajuste-os quando uma medição na placa mudar.
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "duty_cycle.h"
+#include "power.h"
+
+#define SAMPLE_CPU_US 4000      // Transações I2C e conversões de ponto flutuante
+#define SAMPLE_CONVERT_US 80000 // Conversão do AHT20, com o núcleo em WFE
+#define SERVICE_CPU_US 3000     // Wi-Fi, OLED, envios de rede e configurações
+
+static uint64_t now_us = 0;
+
+static uint32_t now_ms(void)
+{
+    return (uint32_t)(now_us / 1000);
+}
+
+static void run(uint64_t us)
+{
+    now_us += us;
+}
+
+int main(int argc, char **argv)
+{
+    duty_config_t config = {
+        .low_power = argc > 1 && atoi(argv[1]) != 0,
+        .sample_interval_ms = (uint32_t)((argc > 2 ? atof(argv[2]) : 30.0) * 1000),
+    };
+    double days = argc > 3 ? atof(argv[3]) : 1.0;
+    uint64_t end_us = (uint64_t)(days * 24 * 3600 * 1e6);
+
+    duty_init(&config, now_ms());
+    power_init(now_us);
+    // Associado o tempo todo; a matriz fica apagada sem alarme no baixo consumo
+    power_set(POWER_RADIO, config.low_power ? POWER_MA_RADIO_PM_AGGRESSIVE : POWER_MA_RADIO_PM_DEFAULT, now_us);
+    power_set(POWER_MATRIX, config.low_power ? POWER_MA_MATRIX_DARK : POWER_MA_MATRIX_LIT, now_us);
+
+    uint64_t wakes = 0, samples = 0;
+    bool display_on = true;
+    power_set(POWER_OLED, POWER_MA_OLED_ON, now_us);
+    while (now_us < end_us)
+    {
+        wakes++;
+        power_set(POWER_CPU, POWER_MA_CPU_RUN, now_us);
+        uint32_t due = duty_due(now_ms());
+
+        if (due & DUTY_SAMPLE)
+        {
+            samples++;
+            power_set(POWER_SENSORS, POWER_MA_SENSORS_MEASURING, now_us);
+            run(SAMPLE_CPU_US);
+            power_set(POWER_CPU, POWER_MA_CPU_WFE, now_us);
+            run(SAMPLE_CONVERT_US);
+            power_set(POWER_SENSORS, POWER_MA_SENSORS_IDLE, now_us);
+            power_set(POWER_CPU, POWER_MA_CPU_RUN, now_us);
+        }
+        if (due & DUTY_SERVICE)
+        {
+            bool on = duty_display_on(now_ms());
+            if (on != display_on)
+            {
+                display_on = on;
+                power_set(POWER_OLED, on ? POWER_MA_OLED_ON : POWER_MA_OLED_OFF, now_us);
+            }
+            run(SERVICE_CPU_US);
+        }
+
+        power_set(POWER_CPU, POWER_MA_CPU_WFE, now_us);
+        int32_t wait_ms = (int32_t)(duty_next_wake_ms() - now_ms());
+        run(wait_ms > 0 ? (uint64_t)wait_ms * 1000 : 1000);
+    }
+
+    power_report_t report;
+    power_get_report(now_us, &report);
+    printf("modo: %s, leitura a cada %u ms, %.1f dias simulados\n", config.low_power ? "baixo consumo" : "normal",
+           duty_sample_interval_ms(), report.elapsed_us / 86400e6);
+    printf("despertares: %llu (%.2f/s), leituras: %llu\n", (unsigned long long)wakes, wakes / (report.elapsed_us / 1e6),
+           (unsigned long long)samples);
+    printf("%-10s %10s %9s %11s\n", "subsistema", "media (mA)", "ativo", "mAh/dia");
+    for (int i = 0; i < POWER_SUBSYSTEM_COUNT; i++)
+    {
+        const power_usage_t *u = &report.subsystems[i];
+        printf("%-10s %10.3f %8.2f%% %11.1f\n", power_subsystem_name((power_subsystem_t)i), u->avg_ma,
+               u->active_fraction * 100, u->mah_per_day);
+    }
+    printf("%-10s %10.3f %9s %11.1f\n", "total", report.total_ma, "", report.total_mah_per_day);
+    return 0;
+}
@@ -0,0 +1,124 @@
+#!/usr/bin/env python3
+"""Tamanho estático por módulo, a partir do mapa do linker (GNU ld).
+
+Soma as seções de entrada de cada arquivo objeto em flash (código, constantes
+e a imagem inicial do .data) e RAM (.data, .bss e scratch), agrupando os
+fontes do projeto pelo nome do arquivo e o Pico SDK, o lwIP, o driver do
+CYW43 e as bibliotecas do compilador por componente. Também mostra quanto da
+RAM sobra para o heap. O build do firmware gera o relatório em
+build/Monitoramento.size.txt; à mão:
+
+    python3 tools/size_report.py build/Monitoramento.elf.map
+    python3 tools/size_report.py build/Monitoramento.elf.map --json
+"""
+import argparse
+import json
+import re
+import sys
+
+# Seções de saída do memmap_default.ld do Pico SDK
+RAM_ONLY = {".bss", ".uninitialized_data", ".ram_vector_table", ".tbss"}
+RAM_AND_FLASH = {".data", ".scratch_x", ".scratch_y", ".tdata"}
+FLASH_ONLY = {".boot2", ".text", ".rodata", ".binary_info", ".ARM.extab", ".ARM.exidx"}
+SCRATCH = {".scratch_x", ".scratch_y"}
+
+# RAM principal do RP2040 (SRAM0-3); os bancos de scratch de 4 KB ficam à parte
+RAM_SIZE = 256 * 1024
+
+INPUT = re.compile(r"^ (\S+)\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)\s+(\S.*)$")
+INPUT_CONT = re.compile(r"^\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)\s+(\S.*)$")
+
+
+def module_of(path):
+    """Nome do grupo de um arquivo objeto do mapa."""
+    path = path.replace("\\", "/")
+    archive = re.search(r"([^/]+)\.a\(", path)
+    if archive:
+        return archive.group(1).removeprefix("lib")
+    external = re.search(r"/lib/(lwip|cyw43-driver|tinyusb|btstack|mbedtls)/", path)
+    if external:
+        return external.group(1)
+    sdk = re.search(r"/src/(?:rp2_common|rp2040|common|host)/([^/]+)/", path)
+    if sdk:
+        return "sdk/" + sdk.group(1)
+    # Fontes do projeto: lib/rollup.c.obj -> rollup
+    return re.sub(r"(\.c)?\.(obj|o)$", "", path.rsplit("/", 1)[-1])
+
+
+def parse(lines):
+    """Retorna {módulo: {"flash": n, "ram": n, "scratch": n}}."""
+    modules = {}
+    output = None
+    pending = None
+    in_map = False
+    for line in lines:
+        line = line.rstrip("\n")
+        if not in_map:
+            in_map = line.startswith("Linker script and memory map")
+            continue
+        if line and not line[0].isspace():
+            # Seção de saída, com o endereço na mesma linha ou na seguinte
+            output = line.split()[0]
+            pending = None
+            continue
+        m = INPUT.match(line)
+        if m:
+            name, size, obj = m.group(1), int(m.group(3), 16), m.group(4)
+        elif pending and INPUT_CONT.match(line):
+            m = INPUT_CONT.match(line)
+            name, size, obj = pending, int(m.group(2), 16), m.group(3)
+        else:
+            # Nome longo de seção de entrada: endereço, tamanho e arquivo na linha seguinte
+            lone = re.match(r"^ (\S+)$", line)
+            pending = lone.group(1) if lone and not lone.group(1).startswith("*") else None
+            continue
+        pending = None
+        if size == 0 or name == "*fill*" or output is None:
+            continue
+        entry = modules.setdefault(module_of(obj), {"flash": 0, "ram": 0, "scratch": 0})
+        if output in SCRATCH:
+            entry["scratch"] += size
+            entry["flash"] += size
+        elif output in RAM_ONLY:
+            entry["ram"] += size
+        elif output in RAM_AND_FLASH:
+            entry["ram"] += size
+            entry["flash"] += size
+        elif output in FLASH_ONLY:
+            entry["flash"] += size
+    return modules
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("map")
+    parser.add_argument("-o", "--output", help="arquivo de saída (padrão: a saída padrão)")
+    parser.add_argument("--json", action="store_true", help="JSON em vez da tabela")
+    args = parser.parse_args()
+
+    with open(args.map, errors="replace") as f:
+        modules = parse(f)
+    if not modules:
+        print(f"{args.map}: nenhuma seção encontrada (é um mapa do GNU ld?)", file=sys.stderr)
+        return 1
+
+    total = {k: sum(m[k] for m in modules.values()) for k in ("flash", "ram", "scratch")}
+    report = {"total": total, "heap": RAM_SIZE - total["ram"], "modules": modules}
+    out = open(args.output, "w") if args.output else sys.stdout
+    if args.json:
+        json.dump(report, out, indent=1, sort_keys=True)
+        out.write("\n")
+    else:
+        out.write(f"{'modulo':<28} {'flash':>9} {'ram':>9} {'scratch':>8}\n")
+        for name, m in sorted(modules.items(), key=lambda kv: (-kv[1]["ram"], -kv[1]["flash"], kv[0])):
+            out.write(f"{name:<28} {m['flash']:>9} {m['ram']:>9} {m['scratch']:>8}\n")
+        out.write(f"{'total':<28} {total['flash']:>9} {total['ram']:>9} {total['scratch']:>8}\n")
+        out.write(f"\nRAM estatica {total['ram']} de {RAM_SIZE}; sobram {report['heap']} "
+                  "para o heap\n")
+    if args.output:
+        out.close()
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
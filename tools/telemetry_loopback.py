@@ -0,0 +1,130 @@
+#!/usr/bin/env python3
+"""Verificação de ida e volta da telemetria UDP: o emissor do simulador
+(sim/telemetry_sender.c, com o lib/telemetry.c do firmware) manda para este
+receptor em 127.0.0.1, que decodifica com o parse do tools/telemetry_rx.py.
+
+Confere cada datagrama (formato, dispositivo, seq sem saltos, lote de no
+máximo 58 amostras, nenhuma amostra esperando mais que o lote permite), que
+toda leitura chegou uma vez com todos os canais e o valor certo, e mostra
+datagramas e amostras por segundo em cada cenário. Termina com status 1 se
+algo falhar.
+
+    python3 tools/telemetry_loopback.py --sender build-sim/sim/telemetry_sender
+"""
+import argparse
+import json
+import os
+import socket
+import subprocess
+import sys
+import time
+
+sys.path.insert(0, os.path.dirname(os.path.abspath(__file__)))
+from telemetry_rx import parse  # noqa: E402
+
+DEVICE_ID = 0x4D4F4E31
+MAX_RECORDS = 58
+BATCH_MS = 500
+
+# (nome, leituras por segundo, segundos virtuais, velocidade do simulador)
+SCENARIOS = [
+    ("1 leitura/s", 1, 20, 20),
+    ("1000 leituras/s", 1000, 20, 10),
+]
+
+
+def sample_value(channel, ts):
+    """O mesmo cálculo do emissor (sample_value em sim/telemetry_sender.c)."""
+    return channel * 100 + (ts % 100000) / 1000.0
+
+
+def run(sender, name, rate_hz, seconds, speed):
+    sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM, socket.IPPROTO_UDP)
+    sock.setsockopt(socket.SOL_SOCKET, socket.SO_RCVBUF, 4 << 20)
+    sock.bind(("127.0.0.1", 0))
+    sock.settimeout(0.5)
+    port = sock.getsockname()[1]
+
+    proc = subprocess.Popen([sender, str(port), str(rate_hz), str(seconds), str(speed)],
+                            stdout=subprocess.PIPE, stderr=subprocess.DEVNULL, text=True)
+    errors = []
+    datagrams = []
+    first = last = None
+    while True:
+        try:
+            data, _ = sock.recvfrom(2048)
+        except socket.timeout:
+            if proc.poll() is not None:
+                break
+            continue
+        last = time.monotonic()
+        if first is None:
+            first = last
+        datagrams.append(data)
+    sent = json.loads(proc.stdout.read() or "{}")
+    sock.close()
+    if proc.returncode != 0:
+        errors.append(f"emissor terminou com status {proc.returncode}")
+
+    interval_ms = 1000 / rate_hz
+    readings = {}
+    kinds = {}
+    samples = 0
+    max_wait = 0
+    for i, data in enumerate(datagrams):
+        parsed = parse(data)
+        if parsed is None:
+            errors.append(f"datagrama {i} inválido ({len(data)} bytes)")
+            continue
+        device, seq, records = parsed
+        if device != DEVICE_ID:
+            errors.append(f"datagrama {i}: dispositivo {device:08x}")
+        if seq != i:
+            errors.append(f"datagrama {i}: seq {seq}")
+        if not 1 <= len(records) <= MAX_RECORDS:
+            errors.append(f"datagrama {i}: {len(records)} amostras")
+        base_ts = records[0][2] if records else 0
+        for ch, kind, ts, value in records:
+            max_wait = max(max_wait, ts - base_ts)
+            if kinds.setdefault(ch, kind) != kind:
+                errors.append(f"datagrama {i}: canal {ch} trocou de grandeza ({kind})")
+            if abs(value - sample_value(ch, ts)) > 1e-3:
+                errors.append(f"datagrama {i}: canal {ch} ts {ts}: valor {value}")
+            readings.setdefault(ts, []).append(ch)
+            samples += 1
+
+    channels = sent.get("channels", 0)
+    if len(readings) != sent.get("readings"):
+        errors.append(f"{len(readings)} leituras recebidas de {sent.get('readings')} enviadas")
+    incomplete = [ts for ts, chs in readings.items() if sorted(chs) != list(range(channels))]
+    if incomplete:
+        errors.append(f"{len(incomplete)} leituras sem todos os canais ou repetidas (ts {incomplete[0]})")
+    if len(datagrams) != sent.get("datagrams"):
+        errors.append(f"{len(datagrams)} datagramas recebidos de {sent.get('datagrams')} enviados")
+    if max_wait > BATCH_MS + interval_ms:
+        errors.append(f"amostra esperou {max_wait} ms no lote")
+    if interval_ms >= BATCH_MS and channels and samples != len(datagrams) * channels:
+        errors.append("com leituras mais espaçadas que o lote, cada datagrama deve levar uma leitura")
+
+    elapsed = (last - first) if first is not None and last > first else 0
+    per_datagram = samples / len(datagrams) if datagrams else 0
+    rate = f"{len(datagrams) / elapsed:.0f} datagramas/s, {samples / elapsed:.0f} amostras/s" if elapsed else "-"
+    print(f"{name}: {len(datagrams)} datagramas, {samples} amostras ({per_datagram:.1f} por datagrama, "
+          f"espera máxima no lote {max_wait} ms), {rate}")
+    for e in errors[:5]:
+        print(f"  {e}", file=sys.stderr)
+    return not errors
+
+
+def main():
+    ap = argparse.ArgumentParser()
+    ap.add_argument("--sender", default="build-sim/sim/telemetry_sender", help="executável do emissor")
+    args = ap.parse_args()
+
+    ok = all([run(args.sender, *scenario) for scenario in SCENARIOS])
+    print("todos os datagramas no formato e sem perdas" if ok else "FALHAS")
+    sys.exit(0 if ok else 1)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,92 @@
+#!/usr/bin/env python3
+"""Receptor da telemetria UDP (multicast ou broadcast) dos nós de monitoramento.
+
+Decodifica os datagramas versão 1 (formato em lib/telemetry.h), detecta perdas
+pelo seq de cada dispositivo e mostra, a cada segundo, datagramas e amostras
+por segundo.
+
+    python3 tools/telemetry_rx.py --group 239.255.42.1 --port 5005
+    python3 tools/telemetry_rx.py --port 5005 --group '' --print   # broadcast/unicast
+"""
+import argparse
+import socket
+import struct
+import time
+
+HEADER = struct.Struct("<2sBBIII")
+RECORD = struct.Struct("<BBHf")
+KINDS = ["temp", "pressure", "altitude", "humidity"]
+
+
+def parse(data):
+    """Retorna (device, seq, [(canal, grandeza, ts, valor), ...]) ou None."""
+    if len(data) < HEADER.size:
+        return None
+    magic, version, count, device, seq, base_ts = HEADER.unpack_from(data)
+    if magic != b"MA" or version != 1 or len(data) != HEADER.size + count * RECORD.size:
+        return None
+    samples = []
+    for i in range(count):
+        ch, kind, dt, value = RECORD.unpack_from(data, HEADER.size + i * RECORD.size)
+        samples.append((ch, KINDS[kind] if kind < len(KINDS) else "?", base_ts + dt, value))
+    return device, seq, samples
+
+
+def main():
+    ap = argparse.ArgumentParser()
+    ap.add_argument("--group", default="239.255.42.1", help="grupo multicast ('' para broadcast/unicast)")
+    ap.add_argument("--port", type=int, default=5005)
+    ap.add_argument("--print", action="store_true", help="mostra cada amostra")
+    ap.add_argument("--duration", type=float, default=0, help="segundos até sair (0: sem fim)")
+    args = ap.parse_args()
+
+    sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM, socket.IPPROTO_UDP)
+    sock.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
+    sock.bind(("", args.port))
+    if args.group:
+        mreq = struct.pack("4s4s", socket.inet_aton(args.group), socket.inet_aton("0.0.0.0"))
+        sock.setsockopt(socket.IPPROTO_IP, socket.IP_ADD_MEMBERSHIP, mreq)
+    sock.settimeout(0.2)
+
+    next_seq = {}
+    totals = {"datagrams": 0, "samples": 0, "lost": 0, "bad": 0, "restarts": 0}
+    window = [0, 0]
+    start = last_report = time.monotonic()
+    while not args.duration or time.monotonic() - start < args.duration:
+        try:
+            data, addr = sock.recvfrom(2048)
+        except socket.timeout:
+            data = None
+        if data:
+            parsed = parse(data)
+            if parsed is None:
+                totals["bad"] += 1
+            else:
+                device, seq, samples = parsed
+                expected = next_seq.get(device)
+                if expected is not None:
+                    if seq == 0 and expected != 0:
+                        totals["restarts"] += 1
+                    elif seq > expected:
+                        totals["lost"] += seq - expected
+                next_seq[device] = seq + 1
+                totals["datagrams"] += 1
+                totals["samples"] += len(samples)
+                window[0] += 1
+                window[1] += len(samples)
+                if args.print:
+                    for ch, kind, ts, value in samples:
+                        print(f"{device:08x} seq={seq} ch={ch} {kind}={value:.2f} ts={ts}")
+
+        now = time.monotonic()
+        if now - last_report >= 1.0:
+            rate = 1.0 / (now - last_report)
+            print(f"{window[0] * rate:.0f} datagramas/s, {window[1] * rate:.0f} amostras/s, "
+                  f"dispositivos={len(next_seq)} perdidos={totals['lost']} inválidos={totals['bad']}", flush=True)
+            window = [0, 0]
+            last_report = now
+    print("total:", totals)
+
+
+if __name__ == "__main__":
+    main()
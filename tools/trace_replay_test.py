@@ -0,0 +1,135 @@
+#!/usr/bin/env python3
+"""Gravação e reprodução de um traço de sensores de ponta a ponta.
+
+O firmware inteiro roda no simulador (monitor_sim) com um ambiente que cruza
+os limites de temperatura e umidade o tempo todo. O traço é pedido pela rota
+/trace no meio da execução, como na placa, primeiro na flash (baixado em
+/trace.bin) e depois pelo USB (linhas "@st" na saída do simulador). Cada
+traço passa pelo trace_replay, que refaz a compensação e as regras de alarme
+no host: o teste exige decisões idênticas às do firmware e um traço com
+avaliações e transições de alarme. Termina com status 1 se algo falhar.
+
+    python3 tools/trace_replay_test.py --sim build-sim/sim/monitor_sim --replay build-sim/sim/trace_replay
+"""
+import argparse
+import json
+import os
+import re
+import socket
+import subprocess
+import sys
+import tempfile
+import time
+import urllib.request
+
+SPEED = 20
+DURATION_S = 600
+TRACE_HOST_S = 3.0  # Duração de cada traço no relógio do host
+
+
+def environment(path):
+    """Temperatura e umidade oscilando em volta de temp_max (40 °C) e
+    humidity_max (90 %) a cada 20 s, com uma falha curta do BMP280."""
+    with open(path, "w") as f:
+        f.write("# t_s temp_c pressão_kpa umidade_pct\n")
+        for t in range(0, DURATION_S + 1, 10):
+            hot = (t // 10) % 2
+            f.write(f"{t} {42.5 if hot else 37.5} {101.3 - 0.2 * hot} {92 if hot else 85}\n")
+        for t in range(45, DURATION_S, 120):
+            f.write(f"fail {t} 0x76 3\n")
+
+
+def free_port():
+    with socket.socket() as s:
+        s.bind(("127.0.0.1", 0))
+        return s.getsockname()[1]
+
+
+def get(port, path, timeout=2.0):
+    with urllib.request.urlopen(f"http://127.0.0.1:{port}{path}", timeout=timeout) as r:
+        return r.read()
+
+
+def wait_for(port, path, check, seconds):
+    deadline = time.monotonic() + seconds
+    while time.monotonic() < deadline:
+        try:
+            body = get(port, path)
+            if check(body):
+                return body
+        except OSError:
+            pass
+        time.sleep(0.1)
+    return None
+
+
+def record(port, mode):
+    """Pede o traço, espera ele começar, deixa gravar e encerra."""
+    get(port, f"/trace?mode={mode}")
+    if not wait_for(port, "/trace", lambda b: json.loads(b)["mode"] == mode, 10):
+        return f"o traço {mode} não começou"
+    time.sleep(TRACE_HOST_S)
+    get(port, "/trace?mode=off")
+    if not wait_for(port, "/trace", lambda b: json.loads(b)["mode"] == "off", 10):
+        return f"o traço {mode} não terminou"
+    return None
+
+
+def replay(replay_bin, path, name):
+    proc = subprocess.run([replay_bin, "-q", path], capture_output=True, text=True)
+    summary = proc.stderr.strip().splitlines()
+    m = re.search(r"(\d+) registros, (\d+) avaliações, (\d+) transições", proc.stderr)
+    print(f"{name}: {summary[-2] if len(summary) > 1 else proc.stderr.strip()}")
+    errors = []
+    if proc.returncode != 0:
+        errors.append(f"{name}: trace_replay terminou com status {proc.returncode}: {summary[-1:]}")
+    elif not m or int(m.group(2)) < 10 or int(m.group(3)) < 2:
+        errors.append(f"{name}: traço sem avaliações ou transições suficientes")
+    return errors
+
+
+def main():
+    ap = argparse.ArgumentParser()
+    ap.add_argument("--sim", default="build-sim/sim/monitor_sim", help="executável do simulador")
+    ap.add_argument("--replay", default="build-sim/sim/trace_replay", help="executável da reprodução")
+    args = ap.parse_args()
+
+    errors = []
+    with tempfile.TemporaryDirectory() as tmp:
+        env, flash = os.path.join(tmp, "ambiente.txt"), os.path.join(tmp, "flash.bin")
+        trace_bin, capture = os.path.join(tmp, "trace.bin"), os.path.join(tmp, "captura.txt")
+        environment(env)
+        port = free_port()
+        with open(capture, "w") as out:
+            sim = subprocess.Popen([args.sim, "--speed", str(SPEED), "--duration", str(DURATION_S), "--script", env,
+                                    "--flash", flash, "--http-port", str(port)],
+                                   stdout=out, stderr=subprocess.DEVNULL)
+            try:
+                if not wait_for(port, "/trace", lambda b: b.startswith(b"{"), 20):
+                    errors.append("o servidor HTTP do simulador não respondeu")
+                else:
+                    # Algumas voltas antes do traço, para ele começar no meio da execução
+                    time.sleep(1.0)
+                    for mode in ("flash", "usb"):
+                        err = record(port, mode)
+                        if err:
+                            errors.append(err)
+                        elif mode == "flash":
+                            with open(trace_bin, "wb") as f:
+                                f.write(get(port, "/trace.bin", timeout=10))
+            finally:
+                sim.terminate()
+                sim.wait()
+
+        if not errors:
+            errors += replay(args.replay, trace_bin, "flash")
+            errors += replay(args.replay, capture, "usb")
+
+    for e in errors:
+        print(f"  {e}", file=sys.stderr)
+    print("decisões reproduzidas idênticas nos dois traços" if not errors else "FALHAS")
+    sys.exit(1 if errors else 0)
+
+
+if __name__ == "__main__":
+    main()